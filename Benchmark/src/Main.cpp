@@ -0,0 +1,1417 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "DX12Lib/ActorStore.h"
+#include "DX12Lib/ActorView.h"
+#include "DX12Lib/DrawList.h"
+#include "DX12Lib/FrustumCulling.h"
+#include "DX12Lib/LodSelection.h"
+#include "DX12Lib/MeshData.h"
+#include "DX12Lib/MockCommandRecorder.h"
+#include "DX12Lib/OcclusionCuller.h"
+#include "DX12Lib/SceneBVH.h"
+#include "DX12Lib/SceneFormat.h"
+#include "DX12Lib/SceneGenerator.h"
+#include "DX12Lib/StreamCopy.h"
+#include "DX12Lib/VisibilityCache.h"
+
+// The upload heap section needs a Direct3D 12 device, everything else runs on DX12LibCore.
+#ifdef _WIN32
+#include "DX12Lib/FrameResource.h"
+#include "DX12Lib/UploadBuffer.h"
+#endif
+
+// Every allocation of the process goes through here, so each stage can report what it allocated.
+namespace
+{
+	std::atomic<uint64_t> gAllocations(0);
+	std::atomic<uint64_t> gAllocatedBytes(0);
+}
+
+void* operator new(size_t size)
+{
+	++gAllocations;
+	gAllocatedBytes += size;
+
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+	using namespace DX12Lib;
+
+	enum Stage
+	{
+		Stage_Cull,
+		Stage_Occlusion,
+		Stage_DrawList,
+		Stage_InstanceFill,
+		Stage_MaterialUpdate,
+		Stage_Submit,
+		Stage_Count,
+	};
+
+	const char* StageNames[Stage_Count] = { "cull", "occlusion", "draw_list", "instance_fill", "material_update", "submit" };
+
+	struct StageSample
+	{
+		double Milliseconds = 0.0;
+		uint64_t Allocations = 0;
+		uint64_t AllocatedBytes = 0;
+	};
+
+	// Time and allocations between Begin and End.
+	class StageMeter
+	{
+	public:
+		void Begin()
+		{
+			mAllocations = gAllocations;
+			mAllocatedBytes = gAllocatedBytes;
+			mStart = std::chrono::steady_clock::now();
+		}
+
+		StageSample End() const
+		{
+			StageSample sample;
+			sample.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+			sample.Allocations = gAllocations - mAllocations;
+			sample.AllocatedBytes = gAllocatedBytes - mAllocatedBytes;
+			return sample;
+		}
+
+	private:
+		std::chrono::steady_clock::time_point mStart;
+		uint64_t mAllocations = 0;
+		uint64_t mAllocatedBytes = 0;
+	};
+
+	struct FrameCounts
+	{
+		size_t VisibleMain = 0;
+		size_t VisibleShadow = 0;
+		size_t OccludedMain = 0;
+		size_t Packets = 0;
+		size_t Batches = 0;
+		size_t Draws = 0;
+		size_t Issued = 0;
+		size_t Filtered = 0;
+		size_t UploadedBytes = 0;
+		size_t PerDrawDraws = 0;
+	};
+
+	// Game's gNumFrameResources, which lives with the Direct3D code.
+	const int FrameResourceCount = 3;
+
+	// The layouts of InstanceData, MaterialData and SkinnedConstant in FrameResource.h, for the
+	// bytes a frame writes to the upload buffers.
+	struct InstanceRecord
+	{
+		DirectX::XMFLOAT4X4 World;
+		DirectX::XMFLOAT4X4 TexTransform;
+		uint32_t MaterialCBIndex = -1;
+		uint32_t Pad0 = 0;
+		uint32_t Pad1 = 0;
+		uint32_t Pad2 = 0;
+	};
+
+	struct MaterialRecord
+	{
+		DirectX::XMFLOAT4 DiffuseAlbedo;
+		DirectX::XMFLOAT3 FresnelR0;
+		float Roughness = 0.0f;
+		DirectX::XMFLOAT4X4 MatTransform;
+		uint32_t DiffuseMapIndex = -1;
+		uint32_t NormalMapIndex = -1;
+		uint32_t Pad0 = 0;
+		uint32_t Pad1 = 0;
+	};
+
+	struct BonePaletteRecord
+	{
+		DirectX::XMFLOAT4X4 BoneTransforms[96];
+	};
+
+#ifdef _WIN32
+	static_assert(sizeof(InstanceRecord) == sizeof(InstanceData), "InstanceRecord has to match InstanceData");
+	static_assert(sizeof(MaterialRecord) == sizeof(MaterialData), "MaterialRecord has to match MaterialData");
+	static_assert(sizeof(BonePaletteRecord) == sizeof(SkinnedConstant), "BonePaletteRecord has to match SkinnedConstant");
+#endif
+
+	// The parts of Material the frame loop reads.
+	struct BenchmarkMaterial
+	{
+		DirectX::XMFLOAT4 DiffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
+		DirectX::XMFLOAT3 FresnelR0 = { 0.01f, 0.01f, 0.01f };
+		float Roughness = 0.25f;
+		DirectX::XMFLOAT4X4 MatTransform = DirectX::XMFLOAT4X4(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+		int NumFramesDirty = FrameResourceCount;
+	};
+
+	// The parts of MeshGroup its buffer views are built from, with made up addresses.
+	struct BenchmarkMeshGroup
+	{
+		GpuVirtualAddress VertexBufferAddress = 0x10000000ull;
+		uint32_t VertexByteStride = 32;
+		uint32_t VertexBufferByteSize = 1 << 20;
+		GpuVirtualAddress IndexBufferAddress = 0x20000000ull;
+		IndexFormat Format = Index_Format_Uint16;
+		uint32_t IndexBufferByteSize = 1 << 18;
+	};
+
+	// The CPU side of Game's frame for the main and shadow views, without a device. The scene
+	// is the device-free part of the actors: the store columns and an ActorView each. Culling,
+	// packets, batches and submission run through the same DrawList as Game. Instance and
+	// material data go to plain arrays standing in for the mapped upload buffers of the frame
+	// resource ring, and submission goes to a MockCommandRecorder.
+	class HeadlessFrame
+	{
+	public:
+		enum View : uint32_t
+		{
+			View_Main = 0,
+			View_Shadow = 1,
+			View_Count = 2,
+		};
+
+		enum Pipeline : uint32_t
+		{
+			Pipeline_Opaque = 0,
+			Pipeline_Shadow = 1,
+		};
+
+		// Render_Layer_Opaque.
+		static const uint32_t Layer_Opaque = 0x1;
+
+		static const uint32_t MaterialCount = 32;
+		static constexpr float ViewportHeight = 1080.0f;
+		static constexpr float FarZ = 1000.0f;
+		// Half size of the light box, centered in front of the camera so it stays the same
+		// for every scene size.
+		static constexpr float ShadowRadius = 150.0f;
+
+		HeadlessFrame();
+
+		// Returns the scene as it was generated, for writing it out.
+		std::vector<SceneActorDesc> Build(SceneGeneratorSettings settings, double& generateMs, double& createMs);
+
+		// perDrawSubmit times SubmitPerDraw, which is not part of the frame.
+		void Run(uint32_t frame, uint32_t frameCount, StageSample* samples, FrameCounts& counts, StageSample& perDrawSubmit);
+
+		inline size_t GetActorCount() const { return mStore.Size(); }
+		inline int GetBVHHeight() const { return mSceneBVH.GetHeight(); }
+		inline float GetSkippedFraction() const { return mVisibilityCache.GetSkippedFraction(); }
+
+	private:
+		void SetViews(uint32_t frame, uint32_t frameCount);
+		void Cull();
+		void FillInstances(uint32_t frame);
+		void UpdateMaterials(uint32_t frame);
+		void Submit();
+		// What Game did before the cached draws: per visible actor and view, the submesh is
+		// looked up by draw arg and the buffer views are built from the group again. Draws
+		// the same actors as Submit, one at a time, into a recorder of its own.
+		void SubmitPerDraw();
+
+	private:
+		JobSystem mJobs;
+		ActorStore mStore;
+		// The primitives of Game's default group.
+		SubmeshMap mSubmeshes;
+		BenchmarkMeshGroup mGroup;
+		std::vector<ActorView> mActors;
+		// By handle index, the only instance data the store has no column for.
+		std::vector<DirectX::XMFLOAT4X4> mTexTransforms;
+		// By handle index, Actor::DrawArg for SubmitPerDraw.
+		std::vector<std::wstring> mDrawArgs;
+		std::vector<BenchmarkMaterial> mMaterials;
+
+		SceneBVH mSceneBVH;
+		VisibilityCache mVisibilityCache;
+		OcclusionCuller mOcclusionCuller;
+		DrawList mDrawList;
+		LodSelector mLodSelector;
+		MockCommandRecorder mRecorder;
+		MockCommandRecorder mPerDrawRecorder;
+		float mExtent = 0.0f;
+
+		FrustumPlanes mViews[View_Count];
+		// Both views sort by the distance to the camera.
+		DirectX::XMFLOAT3 mEyes[View_Count];
+		DirectX::XMFLOAT4X4 mViewProj;
+		LodView mLodViews[View_Count];
+		size_t mOccluded = 0;
+
+		// One slot per actor and one index per packet, for each frame resource.
+		std::vector<InstanceRecord> mInstances[FrameResourceCount];
+		std::vector<uint32_t> mInstanceIndices[FrameResourceCount];
+		std::vector<MaterialRecord> mMaterialRecords;
+		size_t mUploadedBytes = 0;
+	};
+
+	HeadlessFrame::HeadlessFrame() :
+		mOcclusionCuller(mJobs),
+		mDrawList(mJobs)
+	{
+		mDrawList.SetPassSlots(View_Main, { { Layer_Opaque, Pipeline_Opaque, false } });
+		mDrawList.SetPassSlots(View_Shadow, { { Layer_Opaque, Pipeline_Shadow, false } });
+		mLodSelector.SetLayerSettings(Layer_Opaque, { 1.5f, 0.1f });
+	}
+
+	std::vector<SceneActorDesc> HeadlessFrame::Build(SceneGeneratorSettings settings, double& generateMs, double& createMs)
+	{
+		// The primitives of Game's default group, with the same levels of detail.
+		std::vector<Mesh> meshes;
+		meshes.emplace_back(Mesh(L"sphere", MeshGenerator::Sphere(0.5f, 20, 20)));
+		meshes.emplace_back(Mesh(L"cylinder", MeshGenerator::Cylinder(0.5f, 0.3f, 3.0f, 20, 20)));
+		meshes.emplace_back(Mesh(L"grid", MeshGenerator::Grid(20.0f, 20.0f, 40, 40)));
+		meshes.emplace_back(Mesh(L"box", MeshGenerator::Box(1.0f, 1.0f, 1.0f, 0)));
+		meshes.emplace_back(Mesh(L"quad", MeshGenerator::Quad(0.0f, 0.0f, 1.0f, 1.0f, 0.0f)));
+		meshes.emplace_back(Mesh(L"sphere_lod1", MeshGenerator::Sphere(0.5f, 10, 10)));
+		meshes.emplace_back(Mesh(L"sphere_lod2", MeshGenerator::Sphere(0.5f, 6, 5)));
+		meshes.emplace_back(Mesh(L"cylinder_lod1", MeshGenerator::Cylinder(0.5f, 0.3f, 3.0f, 8, 4)));
+		LayoutSubmeshes(meshes, mSubmeshes);
+
+		// Numbered like AssetManager::CreateMeshGroup does for the first group.
+		uint32_t submeshId = 0;
+		for (auto& [name, submesh] : mSubmeshes)
+			submesh.Id = submeshId++;
+
+		mSubmeshes[L"sphere"].Lods = { { L"sphere_lod1", 40.0f }, { L"sphere_lod2", 12.0f } };
+		mSubmeshes[L"cylinder"].Lods = { { L"cylinder_lod1", 20.0f } };
+
+		settings.MeshGroup = L"default";
+		settings.RenderLayer = Layer_Opaque;
+		for (const wchar_t* drawArg : { L"box", L"sphere", L"cylinder" })
+			settings.Shapes.push_back({ drawArg, mSubmeshes[drawArg].Bound });
+
+		mMaterials.resize(MaterialCount);
+		for (uint32_t i = 0; i < MaterialCount; ++i)
+		{
+			mMaterials[i].DiffuseAlbedo = DirectX::XMFLOAT4((i % 4) / 3.0f, (i / 4 % 4) / 3.0f, (float)(i / 16), 1.0f);
+			settings.Materials.push_back(L"mat_" + std::to_wstring(i));
+		}
+		mMaterialRecords.resize(MaterialCount);
+
+		StageMeter meter;
+		meter.Begin();
+		std::vector<SceneActorDesc> descs = SceneGenerator::Generate(settings);
+		mExtent = SceneGenerator::GetExtent(settings);
+		generateMs = meter.End().Milliseconds;
+
+		meter.Begin();
+		// Materials are named by their index, as in the loop above.
+		std::unordered_map<std::wstring, uint32_t> materialIndices;
+		for (uint32_t i = 0; i < MaterialCount; ++i)
+			materialIndices.emplace(settings.Materials[i], i);
+
+		// The BVH keeps pointers to the views, so they never move once created.
+		mActors.resize(descs.size());
+		mTexTransforms.resize(descs.size());
+		mDrawArgs.resize(descs.size());
+		for (size_t i = 0; i < descs.size(); ++i)
+		{
+			const SceneActorDesc& desc = descs[i];
+			const Submesh& submesh = mSubmeshes.at(desc.DrawArg);
+
+			ActorView& actor = mActors[i];
+			actor.Handle = mStore.Create(nullptr, desc.Name);
+			actor.RenderLayer = desc.RenderLayer;
+			actor.Occluder = (desc.Flags & Actor_Flag_Occluder) != 0;
+			actor.Visible = false;
+			actor.Submeshes = &mSubmeshes;
+			actor.VertexBuffer = { mGroup.VertexBufferAddress, mGroup.VertexBufferByteSize, mGroup.VertexByteStride };
+			actor.IndexBuffer = { mGroup.IndexBufferAddress, mGroup.IndexBufferByteSize, mGroup.Format };
+
+			// Same as AssetManager::UpdateActor.
+			DirectX::BoundingBox bound;
+			submesh.Bound.Transform(bound, DirectX::XMLoadFloat4x4(&desc.World));
+			mStore.SetMesh(actor.Handle, nullptr, &submesh);
+			mStore.SetMaterial(actor.Handle, materialIndices.at(desc.Material));
+			mStore.SetLayer(actor.Handle, desc.RenderLayer);
+			mStore.SetFlags(actor.Handle, actor.Occluder ? Actor_Flag_Occluder : Actor_Flag_None);
+			mStore.SetTransform(actor.Handle, desc.World, bound);
+			mStore.MarkDirty(actor.Handle, FrameResourceCount);
+			mTexTransforms[actor.Handle.Index()] = desc.TexTransform;
+			mDrawArgs[actor.Handle.Index()] = desc.DrawArg;
+
+			actor.ProxyId = mSceneBVH.CreateProxy(bound, &actor);
+		}
+		mSceneBVH.Rebuild();
+
+		// Every actor can take a slot in every view, so the frame loop never grows these.
+		for (int i = 0; i < FrameResourceCount; ++i)
+		{
+			mInstances[i].resize(mStore.GetSlotCount());
+			mInstanceIndices[i].assign(descs.size() * View_Count, (uint32_t)-1);
+		}
+		mDrawList.Reserve(descs.size(), View_Count);
+		createMs = meter.End().Milliseconds;
+
+		return descs;
+	}
+
+	void HeadlessFrame::Run(uint32_t frame, uint32_t frameCount, StageSample* samples, FrameCounts& counts, StageSample& perDrawSubmit)
+	{
+		StageMeter meter;
+
+		meter.Begin();
+		SetViews(frame, frameCount);
+		Cull();
+		samples[Stage_Cull] = meter.End();
+
+		meter.Begin();
+		mOccluded = mDrawList.CullOccluded(mOcclusionCuller, mStore, DirectX::XMLoadFloat4x4(&mViewProj), View_Main);
+		samples[Stage_Occlusion] = meter.End();
+
+		meter.Begin();
+		mDrawList.BuildDrawPackets(mStore, mLodSelector, mEyes, mLodViews);
+		samples[Stage_DrawList] = meter.End();
+
+		meter.Begin();
+		mUploadedBytes = 0;
+		FillInstances(frame);
+		samples[Stage_InstanceFill] = meter.End();
+
+		meter.Begin();
+		UpdateMaterials(frame);
+		samples[Stage_MaterialUpdate] = meter.End();
+
+		meter.Begin();
+		Submit();
+		samples[Stage_Submit] = meter.End();
+
+		meter.Begin();
+		SubmitPerDraw();
+		perDrawSubmit = meter.End();
+
+		counts.VisibleMain = mDrawList.GetViewActors(View_Main).size();
+		counts.VisibleShadow = mDrawList.GetViewActors(View_Shadow).size();
+		counts.OccludedMain = mOccluded;
+		counts.Packets = mDrawList.GetDrawPackets().size();
+		counts.Batches = mDrawList.GetDrawBatches().size();
+		counts.Draws = mRecorder.GetStats().Draws;
+		counts.Issued = mRecorder.GetStats().Issued;
+		counts.Filtered = mRecorder.GetStats().Filtered;
+		counts.PerDrawDraws = mPerDrawRecorder.GetStats().Draws;
+		counts.UploadedBytes = mUploadedBytes;
+	}
+
+	void HeadlessFrame::SetViews(uint32_t frame, uint32_t frameCount)
+	{
+		// One lap around a circle at a quarter of the scene size, looking along it.
+		float angle = DirectX::XM_2PI * frame / frameCount;
+		float radius = 0.25f * mExtent;
+		DirectX::XMVECTOR eye = DirectX::XMVectorSet(radius * cosf(angle), 10.0f, radius * sinf(angle), 1.0f);
+		DirectX::XMVECTOR forward = DirectX::XMVector3Normalize(DirectX::XMVectorSet(-sinf(angle), -0.1f, cosf(angle), 0.0f));
+		DirectX::XMVECTOR up = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		DirectX::XMStoreFloat3(&mEyes[View_Main], eye);
+		mEyes[View_Shadow] = mEyes[View_Main];
+
+		DirectX::XMMATRIX view = DirectX::XMMatrixLookToLH(eye, forward, up);
+		DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(0.25f * DirectX::XM_PI, 16.0f / 9.0f, 1.0f, FarZ);
+		DirectX::XMMATRIX viewProj = DirectX::XMMatrixMultiply(view, proj);
+		DirectX::XMStoreFloat4x4(&mViewProj, viewProj);
+		mViews[View_Main] = FrustumPlanes::FromViewProj(viewProj);
+
+		DirectX::XMVECTOR lightDir = DirectX::XMVector3Normalize(DirectX::XMVectorSet(0.57735f, -0.57735f, 0.57735f, 0.0f));
+		DirectX::XMVECTOR lightTarget = DirectX::XMVectorAdd(eye, DirectX::XMVectorScale(forward, ShadowRadius));
+		DirectX::XMVECTOR lightPos = DirectX::XMVectorSubtract(lightTarget, DirectX::XMVectorScale(lightDir, 2.0f * ShadowRadius));
+		DirectX::XMMATRIX lightView = DirectX::XMMatrixLookAtLH(lightPos, lightTarget, up);
+		DirectX::XMMATRIX lightProj = DirectX::XMMatrixOrthographicOffCenterLH(-ShadowRadius, ShadowRadius, -ShadowRadius, ShadowRadius, 0.0f, 4.0f * ShadowRadius);
+		mViews[View_Shadow] = FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(lightView, lightProj));
+
+		DirectX::XMFLOAT4X4 proj4x4;
+		DirectX::XMStoreFloat4x4(&proj4x4, proj);
+		mLodViews[View_Main] = LodView::Perspective(mEyes[View_Main], proj4x4(1, 1), ViewportHeight, 1.0f);
+		mLodViews[View_Shadow] = LodView::Ortho(2.0f * ShadowRadius, 2048.0f, 0.5f);
+	}
+
+	void HeadlessFrame::Cull()
+	{
+		mDrawList.Cull(mSceneBVH, mVisibilityCache, mStore, mViews, View_Count, mEyes[View_Main]);
+		mDrawList.FinishCull(View_Main);
+	}
+
+	void HeadlessFrame::FillInstances(uint32_t frame)
+	{
+		std::vector<InstanceRecord>& instances = mInstances[frame % FrameResourceCount];
+		std::vector<uint32_t>& indices = mInstanceIndices[frame % FrameResourceCount];
+
+		// Same as Game: changed actors rewrite their own slot, packets only write the slot index
+		// when a different actor lands on them.
+		mStore.FlushDirty([&](ActorHandle handle)
+		{
+			uint32_t dense = mStore.IndexOf(handle);
+
+			InstanceRecord& data = instances[handle.Index()];
+			DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&mStore.GetWorlds()[dense]);
+			DirectX::XMStoreFloat4x4(&data.World, DirectX::XMMatrixTranspose(world));
+			DirectX::XMMATRIX texTransform = DirectX::XMLoadFloat4x4(&mTexTransforms[handle.Index()]);
+			DirectX::XMStoreFloat4x4(&data.TexTransform, DirectX::XMMatrixTranspose(texTransform));
+			data.MaterialCBIndex = mStore.GetMaterials()[dense];
+			mUploadedBytes += sizeof(InstanceRecord);
+		});
+
+		mDrawList.BuildBatches(indices, [&](uint32_t, uint32_t)
+		{
+			mUploadedBytes += sizeof(uint32_t);
+		});
+	}
+
+	void HeadlessFrame::UpdateMaterials(uint32_t frame)
+	{
+		// A quarter of the materials scroll their texture every frame, like animated water.
+		for (uint32_t id = frame % 4; id < MaterialCount; id += 4)
+		{
+			BenchmarkMaterial& mat = mMaterials[id];
+			mat.MatTransform(3, 0) += 0.01f;
+			mat.NumFramesDirty = FrameResourceCount;
+		}
+
+		for (uint32_t id = 0; id < MaterialCount; ++id)
+		{
+			BenchmarkMaterial& mat = mMaterials[id];
+			if (mat.NumFramesDirty <= 0)
+				continue;
+
+			MaterialRecord& matData = mMaterialRecords[id];
+			matData.DiffuseAlbedo = mat.DiffuseAlbedo;
+			matData.FresnelR0 = mat.FresnelR0;
+			matData.Roughness = mat.Roughness;
+			DirectX::XMMATRIX matTransform = DirectX::XMLoadFloat4x4(&mat.MatTransform);
+			DirectX::XMStoreFloat4x4(&matData.MatTransform, DirectX::XMMatrixTranspose(matTransform));
+			mUploadedBytes += sizeof(MaterialRecord);
+
+			mat.NumFramesDirty--;
+		}
+	}
+
+	void HeadlessFrame::Submit()
+	{
+		mRecorder.Clear();
+		mRecorder.ResetStats();
+
+		// Fake but distinct handles and addresses, the recorder only compares them.
+		const GpuObjectHandle pipelines[] = { { 0x10 }, { 0x20 } };
+
+		DrawSubmitState state;
+		state.Pipelines = pipelines;
+		state.InstanceIndicesParameter = 8;
+		state.InstanceIndices = 0x100000000ull;
+		state.InstanceIndexStride = sizeof(uint32_t);
+		state.SkinnedCBParameter = 3;
+
+		for (uint32_t view = 0; view < View_Count; ++view)
+			mDrawList.Submit(mRecorder, view, 0, DrawList::MaxSlots - 1, state);
+	}
+
+	void HeadlessFrame::SubmitPerDraw()
+	{
+		mPerDrawRecorder.Clear();
+		mPerDrawRecorder.ResetStats();
+
+		const GpuObjectHandle pipelines[] = { { 0x10 }, { 0x20 } };
+		const GpuVirtualAddress instances = 0x200000000ull;
+
+		for (uint32_t view = 0; view < View_Count; ++view)
+		{
+			mPerDrawRecorder.SetPipelineState(pipelines[view == View_Main ? Pipeline_Opaque : Pipeline_Shadow]);
+
+			for (const ActorView* actor : mDrawList.GetViewActors(view))
+			{
+				const Submesh& submesh = mSubmeshes.at(mDrawArgs[actor->Handle.Index()]);
+
+				VertexBufferBinding vertexBuffer = { mGroup.VertexBufferAddress, mGroup.VertexBufferByteSize, mGroup.VertexByteStride };
+				IndexBufferBinding indexBuffer = { mGroup.IndexBufferAddress, mGroup.IndexBufferByteSize, mGroup.Format };
+				mPerDrawRecorder.SetVertexBuffer(vertexBuffer);
+				mPerDrawRecorder.SetIndexBuffer(indexBuffer);
+				mPerDrawRecorder.SetPrimitiveTopology(actor->Topology);
+				mPerDrawRecorder.SetGraphicsRootShaderResourceView(8, instances + actor->Handle.Index() * sizeof(InstanceRecord));
+				mPerDrawRecorder.DrawIndexedInstanced(submesh.IndexCount, 1, submesh.StartIndexLocation, submesh.BaseVertexLocation, 0);
+			}
+		}
+	}
+
+	struct BenchmarkSettings
+	{
+		std::vector<uint32_t> ActorCounts = { 1000, 10000, 100000, 1000000 };
+		std::vector<SceneDistribution> Distributions = { Scene_Distribution_Uniform, Scene_Distribution_Clustered, Scene_Distribution_CityGrid };
+		uint32_t Frames = 120;
+		uint32_t Warmup = 10;
+		uint32_t Seed = 1;
+		std::string OutputFile;
+		// Written from the first run, so the demo can stream the same scene.
+		std::string SceneFile;
+		// Timed copies per upload method, 0 skips the upload benchmark.
+		uint32_t UploadRepeats = 20;
+		// Scene sizes for the BVH against the linear loop it replaced, empty skips them.
+		std::vector<uint32_t> QueryActorCounts = { 10000, 100000 };
+		// Boxes for the culling kernels, 0 skips them.
+		uint32_t CullBoxCount = 100000;
+		// City sizes for the occlusion culler, with as many props among the buildings, empty
+		// skips them.
+		std::vector<uint32_t> OcclusionActorCounts = { 10000, 100000 };
+		// Packet counts for the radix sort against std::sort, empty skips them.
+		std::vector<uint32_t> SortPacketCounts = { 10000, 100000, 1000000 };
+	};
+
+	const char* GetDistributionName(SceneDistribution distribution)
+	{
+		switch (distribution)
+		{
+		case Scene_Distribution_Clustered: return "clustered";
+		case Scene_Distribution_CityGrid: return "city";
+		default: return "uniform";
+		}
+	}
+
+	bool ParseDistribution(const std::string& name, SceneDistribution& distribution)
+	{
+		for (SceneDistribution d : { Scene_Distribution_Uniform, Scene_Distribution_Clustered, Scene_Distribution_CityGrid })
+		{
+			if (name == GetDistributionName(d))
+			{
+				distribution = d;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::vector<std::string> Split(const std::string& list)
+	{
+		std::vector<std::string> items;
+		std::stringstream stream(list);
+		std::string item;
+		while (std::getline(stream, item, ','))
+		{
+			if (!item.empty())
+				items.push_back(item);
+		}
+		return items;
+	}
+
+	bool ParseArguments(int argc, char** argv, BenchmarkSettings& settings)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			if (i + 1 >= argc)
+				return false;
+			std::string value = argv[++i];
+
+			if (arg == "--actors")
+			{
+				settings.ActorCounts.clear();
+				for (const std::string& count : Split(value))
+					settings.ActorCounts.push_back((uint32_t)std::strtoul(count.c_str(), nullptr, 10));
+			}
+			else if (arg == "--distributions")
+			{
+				settings.Distributions.clear();
+				for (const std::string& name : Split(value))
+				{
+					SceneDistribution distribution;
+					if (!ParseDistribution(name, distribution))
+						return false;
+					settings.Distributions.push_back(distribution);
+				}
+			}
+			else if (arg == "--frames")
+				settings.Frames = (uint32_t)std::strtoul(value.c_str(), nullptr, 10);
+			else if (arg == "--warmup")
+				settings.Warmup = (uint32_t)std::strtoul(value.c_str(), nullptr, 10);
+			else if (arg == "--seed")
+				settings.Seed = (uint32_t)std::strtoul(value.c_str(), nullptr, 10);
+			else if (arg == "--out")
+				settings.OutputFile = value;
+			else if (arg == "--write-scene")
+				settings.SceneFile = value;
+			else if (arg == "--upload-repeats")
+				settings.UploadRepeats = (uint32_t)std::strtoul(value.c_str(), nullptr, 10);
+			else if (arg == "--cull-boxes")
+				settings.CullBoxCount = (uint32_t)std::strtoul(value.c_str(), nullptr, 10);
+			else if (arg == "--sort-packets")
+			{
+				settings.SortPacketCounts.clear();
+				for (const std::string& count : Split(value))
+				{
+					uint32_t packetCount = (uint32_t)std::strtoul(count.c_str(), nullptr, 10);
+					if (packetCount > 0)
+						settings.SortPacketCounts.push_back(packetCount);
+				}
+			}
+			else if (arg == "--occlusion-actors")
+			{
+				settings.OcclusionActorCounts.clear();
+				for (const std::string& count : Split(value))
+				{
+					uint32_t actorCount = (uint32_t)std::strtoul(count.c_str(), nullptr, 10);
+					if (actorCount > 0)
+						settings.OcclusionActorCounts.push_back(actorCount);
+				}
+			}
+			else if (arg == "--query-actors")
+			{
+				settings.QueryActorCounts.clear();
+				for (const std::string& count : Split(value))
+				{
+					uint32_t actorCount = (uint32_t)std::strtoul(count.c_str(), nullptr, 10);
+					if (actorCount > 0)
+						settings.QueryActorCounts.push_back(actorCount);
+				}
+			}
+			else
+				return false;
+		}
+
+		return settings.Frames > 0 && !settings.ActorCounts.empty() && !settings.Distributions.empty();
+	}
+
+	void WriteStage(std::ostream& out, const char* name, std::vector<StageSample>& samples)
+	{
+		std::sort(samples.begin(), samples.end(), [](const StageSample& a, const StageSample& b) { return a.Milliseconds < b.Milliseconds; });
+
+		double total = 0.0;
+		uint64_t allocations = 0;
+		uint64_t allocatedBytes = 0;
+		for (const StageSample& sample : samples)
+		{
+			total += sample.Milliseconds;
+			allocations += sample.Allocations;
+			allocatedBytes += sample.AllocatedBytes;
+		}
+
+		size_t count = samples.size();
+		out << "        \"" << name << "\": { "
+			<< "\"mean_ms\": " << total / count
+			<< ", \"min_ms\": " << samples.front().Milliseconds
+			<< ", \"p50_ms\": " << samples[count / 2].Milliseconds
+			<< ", \"p95_ms\": " << samples[(count * 95) / 100].Milliseconds
+			<< ", \"max_ms\": " << samples.back().Milliseconds
+			<< ", \"allocations_per_frame\": " << (double)allocations / count
+			<< ", \"allocated_bytes_per_frame\": " << (double)allocatedBytes / count
+			<< " }";
+	}
+
+	void RunBenchmark(const BenchmarkSettings& settings, uint32_t actorCount, SceneDistribution distribution, bool writeScene, std::ostream& out)
+	{
+		SceneGeneratorSettings sceneSettings;
+		sceneSettings.ActorCount = actorCount;
+		sceneSettings.Distribution = distribution;
+		sceneSettings.Seed = settings.Seed;
+
+		HeadlessFrame frame;
+		double generateMs = 0.0;
+		double createMs = 0.0;
+		std::vector<SceneActorDesc> scene = frame.Build(sceneSettings, generateMs, createMs);
+
+		if (writeScene && !SceneWriter::Write(settings.SceneFile, scene, 32.0f))
+			std::cerr << "Could not write " << settings.SceneFile << std::endl;
+		scene.clear();
+		scene.shrink_to_fit();
+
+		uint32_t frameCount = settings.Warmup + settings.Frames;
+		std::vector<StageSample> stages[Stage_Count];
+		std::vector<StageSample> frames;
+		std::vector<StageSample> perDrawSubmits;
+		FrameCounts totals;
+		double skipped = 0.0;
+
+		for (uint32_t i = 0; i < frameCount; ++i)
+		{
+			StageSample samples[Stage_Count];
+			FrameCounts counts;
+			StageSample perDrawSubmit;
+			frame.Run(i, frameCount, samples, counts, perDrawSubmit);
+
+			if (i < settings.Warmup)
+				continue;
+
+			StageSample frameSample;
+			for (int s = 0; s < Stage_Count; ++s)
+			{
+				stages[s].push_back(samples[s]);
+				frameSample.Milliseconds += samples[s].Milliseconds;
+				frameSample.Allocations += samples[s].Allocations;
+				frameSample.AllocatedBytes += samples[s].AllocatedBytes;
+			}
+			frames.push_back(frameSample);
+			perDrawSubmits.push_back(perDrawSubmit);
+
+			totals.VisibleMain += counts.VisibleMain;
+			totals.VisibleShadow += counts.VisibleShadow;
+			totals.OccludedMain += counts.OccludedMain;
+			totals.Packets += counts.Packets;
+			totals.Batches += counts.Batches;
+			totals.Draws += counts.Draws;
+			totals.Issued += counts.Issued;
+			totals.Filtered += counts.Filtered;
+			totals.UploadedBytes += counts.UploadedBytes;
+			totals.PerDrawDraws += counts.PerDrawDraws;
+			skipped += frame.GetSkippedFraction();
+		}
+
+		double n = settings.Frames;
+		double cullMs = 0.0;
+		double packetMs = 0.0;
+		for (const StageSample& sample : stages[Stage_Cull])
+			cullMs += sample.Milliseconds / n;
+		for (int s : { Stage_DrawList, Stage_InstanceFill })
+		{
+			for (const StageSample& sample : stages[s])
+				packetMs += sample.Milliseconds / n;
+		}
+		double frameMs = 0.0;
+		for (const StageSample& sample : frames)
+			frameMs += sample.Milliseconds / n;
+
+		// Per actor and view: the cached draws pay for packets and batches up front, so both
+		// the walk alone and the walk with packets are set against the per draw lookup.
+		double submitMs = 0.0;
+		double perDrawMs = 0.0;
+		for (const StageSample& sample : stages[Stage_Submit])
+			submitMs += sample.Milliseconds / n;
+		for (const StageSample& sample : perDrawSubmits)
+			perDrawMs += sample.Milliseconds / n;
+		double drawsPerFrame = totals.PerDrawDraws / n;
+		auto perDrawNs = [&](double ms) { return drawsPerFrame > 0.0 ? ms * 1.0e6 / drawsPerFrame : 0.0; };
+
+		out << "    {\n"
+			<< "      \"distribution\": \"" << GetDistributionName(distribution) << "\",\n"
+			<< "      \"actors\": " << frame.GetActorCount() << ",\n"
+			<< "      \"generate_ms\": " << generateMs << ",\n"
+			<< "      \"create_ms\": " << createMs << ",\n"
+			<< "      \"bvh_height\": " << frame.GetBVHHeight() << ",\n"
+			<< "      \"per_frame\": { "
+			<< "\"visible_main\": " << totals.VisibleMain / n
+			<< ", \"visible_shadow\": " << totals.VisibleShadow / n
+			<< ", \"occluded_main\": " << totals.OccludedMain / n
+			<< ", \"packets\": " << totals.Packets / n
+			<< ", \"batches\": " << totals.Batches / n
+			<< ", \"draws\": " << totals.Draws / n
+			<< ", \"commands_issued\": " << totals.Issued / n
+			<< ", \"commands_filtered\": " << totals.Filtered / n
+			<< ", \"uploaded_bytes\": " << totals.UploadedBytes / n
+			<< ", \"cull_tests_skipped\": " << skipped / n
+			<< " },\n"
+			<< "      \"throughput\": { "
+			<< "\"frames_per_second\": " << (frameMs > 0.0 ? 1000.0 / frameMs : 0.0)
+			<< ", \"actors_culled_per_second\": " << (cullMs > 0.0 ? actorCount * 1000.0 / cullMs : 0.0)
+			<< ", \"packets_per_second\": " << (packetMs > 0.0 ? totals.Packets / n * 1000.0 / packetMs : 0.0)
+			<< " },\n"
+			<< "      \"submission\": { "
+			<< "\"actor_draws\": " << drawsPerFrame
+			<< ", \"cached_walk_ms\": " << submitMs
+			<< ", \"cached_walk_with_packets_ms\": " << submitMs + packetMs
+			<< ", \"per_draw_lookup_ms\": " << perDrawMs
+			<< ", \"cached_walk_ns_per_draw\": " << perDrawNs(submitMs)
+			<< ", \"cached_walk_with_packets_ns_per_draw\": " << perDrawNs(submitMs + packetMs)
+			<< ", \"per_draw_lookup_ns_per_draw\": " << perDrawNs(perDrawMs)
+			<< " },\n"
+			<< "      \"stages\": {\n";
+
+		for (int s = 0; s < Stage_Count; ++s)
+		{
+			WriteStage(out, StageNames[s], stages[s]);
+			out << ",\n";
+		}
+		WriteStage(out, "frame", frames);
+		out << "\n      }\n    }";
+	}
+
+	// Bounds of a uniform scene of unit boxes, and the side of the square it covers.
+	std::vector<DirectX::BoundingBox> GenerateBounds(uint32_t actorCount, uint32_t seed, float& extent)
+	{
+		SceneGeneratorSettings sceneSettings;
+		sceneSettings.ActorCount = actorCount;
+		sceneSettings.Seed = seed;
+		sceneSettings.Shapes.push_back({ L"box", DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(0.5f, 0.5f, 0.5f)) });
+		sceneSettings.Materials.push_back(L"default");
+
+		std::vector<DirectX::BoundingBox> bounds;
+		for (const SceneActorDesc& desc : SceneGenerator::Generate(sceneSettings))
+			bounds.push_back(desc.Bound);
+		extent = SceneGenerator::GetExtent(sceneSettings);
+		return bounds;
+	}
+
+	// The camera of HeadlessFrame::SetViews, optionally at another height.
+	DirectX::XMMATRIX LapView(uint32_t frame, uint32_t frameCount, float extent, float height = 10.0f)
+	{
+		float angle = DirectX::XM_2PI * frame / frameCount;
+		float radius = 0.25f * extent;
+		DirectX::XMVECTOR eye = DirectX::XMVectorSet(radius * cosf(angle), height, radius * sinf(angle), 1.0f);
+		DirectX::XMVECTOR forward = DirectX::XMVector3Normalize(DirectX::XMVectorSet(-sinf(angle), -0.1f, cosf(angle), 0.0f));
+		return DirectX::XMMatrixLookToLH(eye, forward, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	}
+
+	DirectX::XMMATRIX LapProj()
+	{
+		return DirectX::XMMatrixPerspectiveFovLH(0.25f * DirectX::XM_PI, 16.0f / 9.0f, 1.0f, HeadlessFrame::FarZ);
+	}
+
+	// Times the camera frustum query over the scene BVH against the loop it replaced, which
+	// tested every actor bound in turn.
+	void RunQueryBenchmark(const BenchmarkSettings& settings, std::ostream& out)
+	{
+		out << "  \"queries\": [\n";
+
+		for (size_t run = 0; run < settings.QueryActorCounts.size(); ++run)
+		{
+			float extent;
+			std::vector<DirectX::BoundingBox> bounds = GenerateBounds(settings.QueryActorCounts[run], settings.Seed, extent);
+
+			SceneBVH tree;
+			for (const DirectX::BoundingBox& bound : bounds)
+				tree.CreateProxy(bound, nullptr);
+			tree.Rebuild();
+
+			DirectX::BoundingFrustum viewFrustum(LapProj());
+
+			double linearMs = 0.0;
+			double treeMs = 0.0;
+			uint64_t linearVisible = 0;
+			uint64_t treeVisible = 0;
+
+			for (uint32_t frame = 0; frame < settings.Frames; ++frame)
+			{
+				DirectX::XMMATRIX view = LapView(frame, settings.Frames, extent);
+				DirectX::XMVECTOR viewDeterminant = DirectX::XMMatrixDeterminant(view);
+
+				DirectX::BoundingFrustum frustum;
+				viewFrustum.Transform(frustum, DirectX::XMMatrixInverse(&viewDeterminant, view));
+
+				StageMeter meter;
+				meter.Begin();
+				for (const DirectX::BoundingBox& bound : bounds)
+				{
+					if (frustum.Contains(bound) != DirectX::DISJOINT)
+						++linearVisible;
+				}
+				linearMs += meter.End().Milliseconds;
+
+				meter.Begin();
+				tree.QueryFrustum(frustum, [&treeVisible](void*, bool) { ++treeVisible; });
+				treeMs += meter.End().Milliseconds;
+			}
+
+			double n = settings.Frames;
+			out << "    { \"actors\": " << bounds.size()
+				<< ", \"bvh_height\": " << tree.GetHeight()
+				<< ", \"linear_ms\": " << linearMs / n
+				<< ", \"bvh_ms\": " << treeMs / n
+				<< ", \"speedup\": " << (treeMs > 0.0 ? linearMs / treeMs : 0.0)
+				// The tree tests fattened leaf bounds, so it may report a few more.
+				<< ", \"linear_visible\": " << linearVisible / n
+				<< ", \"bvh_visible\": " << treeVisible / n
+				<< " }" << (run + 1 < settings.QueryActorCounts.size() ? ",\n" : "\n");
+		}
+
+		out << "  ]";
+	}
+
+	// Times the plane test kernels over one set of bounds: the scalar reference, the SIMD
+	// kernel once per view, and the multi-view kernel for all views in one pass. The views are
+	// two cameras half a lap apart. The six faces of a cube map at the camera are timed once per
+	// face frustum and in the single pass of CullBoxesCubeFaces.
+	void RunCullingBenchmark(const BenchmarkSettings& settings, std::ostream& out)
+	{
+		const int viewCount = 2;
+
+		float extent;
+		std::vector<DirectX::BoundingBox> boxes = GenerateBounds(settings.CullBoxCount, settings.Seed, extent);
+
+		BoundsSoA bounds;
+		bounds.Reserve(boxes.size());
+		for (const DirectX::BoundingBox& box : boxes)
+			bounds.Push(box);
+
+		std::vector<uint32_t> visibleMask(CullMaskWordCount(bounds.Size()));
+		std::vector<uint32_t> viewMasks(bounds.Size());
+		std::vector<uint8_t> faceMasks(bounds.Size());
+
+		const DirectX::XMFLOAT3 faceLooks[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		const DirectX::XMFLOAT3 faceUps[6] = { { 0, 1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { 0, 1, 0 }, { 0, 1, 0 } };
+		DirectX::XMMATRIX faceProj = DirectX::XMMatrixPerspectiveFovLH(0.5f * DirectX::XM_PI, 1.0f, 0.1f, 100.0f);
+
+		double scalarMs = 0.0;
+		double simdMs = 0.0;
+		double multiViewMs = 0.0;
+		double faceFrustumsMs = 0.0;
+		double cubeFacesMs = 0.0;
+		uint64_t visible = 0;
+
+		for (uint32_t frame = 0; frame < settings.Frames; ++frame)
+		{
+			FrustumPlanes views[viewCount];
+			for (int v = 0; v < viewCount; ++v)
+			{
+				DirectX::XMMATRIX view = LapView(frame + v * settings.Frames / viewCount, settings.Frames, extent);
+				views[v] = FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(view, LapProj()));
+			}
+
+			StageMeter meter;
+			meter.Begin();
+			for (int v = 0; v < viewCount; ++v)
+				CullBoxesScalar(views[v], bounds, visibleMask.data());
+			scalarMs += meter.End().Milliseconds;
+
+			meter.Begin();
+			for (int v = 0; v < viewCount; ++v)
+				CullBoxes(views[v], bounds, visibleMask.data());
+			simdMs += meter.End().Milliseconds;
+
+			meter.Begin();
+			CullBoxesMultiView(views, viewCount, bounds, viewMasks.data());
+			multiViewMs += meter.End().Milliseconds;
+
+			for (uint32_t viewMask : viewMasks)
+				visible += viewMask != 0 ? 1 : 0;
+
+			DirectX::XMMATRIX view = LapView(frame, settings.Frames, extent);
+			DirectX::XMVECTOR viewDeterminant = DirectX::XMMatrixDeterminant(view);
+			DirectX::XMVECTOR eye = DirectX::XMMatrixInverse(&viewDeterminant, view).r[3];
+
+			FrustumPlanes faces[6];
+			for (int f = 0; f < 6; ++f)
+			{
+				DirectX::XMMATRIX faceView = DirectX::XMMatrixLookToLH(eye, DirectX::XMLoadFloat3(&faceLooks[f]), DirectX::XMLoadFloat3(&faceUps[f]));
+				faces[f] = FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(faceView, faceProj));
+			}
+
+			meter.Begin();
+			for (int f = 0; f < 6; ++f)
+				CullBoxes(faces[f], bounds, visibleMask.data());
+			faceFrustumsMs += meter.End().Milliseconds;
+
+			DirectX::XMFLOAT3 origin;
+			DirectX::XMStoreFloat3(&origin, eye);
+
+			meter.Begin();
+			CullBoxesCubeFaces(origin, 0.1f, 100.0f, bounds, faceMasks.data());
+			cubeFacesMs += meter.End().Milliseconds;
+		}
+
+		double n = settings.Frames;
+		out << "  \"culling\": { \"boxes\": " << bounds.Size()
+			<< ", \"views\": " << viewCount
+			<< ", \"scalar_ms\": " << scalarMs / n
+			<< ", \"simd_ms\": " << simdMs / n
+			<< ", \"multiview_ms\": " << multiViewMs / n
+			<< ", \"simd_speedup\": " << (simdMs > 0.0 ? scalarMs / simdMs : 0.0)
+			<< ", \"multiview_speedup\": " << (multiViewMs > 0.0 ? simdMs / multiViewMs : 0.0)
+			<< ", \"visible\": " << visible / n
+			<< ", \"face_frustums_ms\": " << faceFrustumsMs / n
+			<< ", \"cube_faces_ms\": " << cubeFacesMs / n
+			<< ", \"cube_faces_speedup\": " << (cubeFacesMs > 0.0 ? faceFrustumsMs / cubeFacesMs : 0.0)
+			<< " }";
+	}
+
+	// Times the software occlusion culler over a city whose buildings hide as many props spread
+	// across the same square, once on the calling thread alone and once on the job system. Each
+	// frame does what DrawList::CullOccluded does for the main view: the buildings in the
+	// frustum are clipped and binned, rasterized into the depth pyramid, and the props in the
+	// frustum are tested against it.
+	void RunOcclusionBenchmark(const BenchmarkSettings& settings, std::ostream& out)
+	{
+		// Occluders draw the triangles of their collision BVH, so lay the box out like a group.
+		std::vector<Mesh> meshes;
+		meshes.emplace_back(Mesh(L"box", MeshGenerator::Box(1.0f, 1.0f, 1.0f, 0)));
+		SubmeshMap submeshes;
+		LayoutSubmeshes(meshes, submeshes);
+		const Submesh& box = submeshes[L"box"];
+
+		JobSystem serialJobs(0);
+		JobSystem jobs;
+		OcclusionCuller serialCuller(serialJobs);
+		OcclusionCuller culler(jobs);
+
+		out << "  \"occlusion\": [\n";
+
+		for (size_t run = 0; run < settings.OcclusionActorCounts.size(); ++run)
+		{
+			SceneGeneratorSettings citySettings;
+			citySettings.ActorCount = settings.OcclusionActorCounts[run];
+			citySettings.Distribution = Scene_Distribution_CityGrid;
+			citySettings.Seed = settings.Seed;
+			citySettings.Shapes.push_back({ L"box", box.Bound });
+			citySettings.Materials.push_back(L"default");
+			std::vector<SceneActorDesc> buildings = SceneGenerator::Generate(citySettings);
+			float extent = SceneGenerator::GetExtent(citySettings);
+
+			SceneGeneratorSettings propSettings = citySettings;
+			propSettings.Distribution = Scene_Distribution_Uniform;
+			propSettings.Density = citySettings.ActorCount / (extent * extent);
+			propSettings.Seed = settings.Seed + 1;
+			std::vector<SceneActorDesc> props = SceneGenerator::Generate(propSettings);
+
+			// Buildings first, then props.
+			BoundsSoA bounds;
+			bounds.Reserve(buildings.size() + props.size());
+			for (const SceneActorDesc& building : buildings)
+				bounds.Push(building.Bound);
+			for (const SceneActorDesc& prop : props)
+				bounds.Push(prop.Bound);
+
+			std::vector<uint32_t> visibleMask(CullMaskWordCount(bounds.Size()));
+			std::vector<uint32_t> visibleBuildings;
+			std::vector<uint32_t> visibleProps;
+			visibleBuildings.reserve(buildings.size());
+			visibleProps.reserve(props.size());
+
+			// Setup, raster and test times, on one thread and on the job system.
+			double ms[2][3] = {};
+			uint64_t triangles = 0;
+			uint64_t tested = 0;
+			uint64_t occluded[2] = {};
+
+			for (uint32_t frame = 0; frame < settings.Frames; ++frame)
+			{
+				// Above the roofs, at street level the lap would pass through buildings.
+				DirectX::XMMATRIX viewProj = DirectX::XMMatrixMultiply(LapView(frame, settings.Frames, extent, citySettings.MaxBuildingHeight + 5.0f), LapProj());
+				CullBoxes(FrustumPlanes::FromViewProj(viewProj), bounds, visibleMask.data());
+
+				visibleBuildings.clear();
+				visibleProps.clear();
+				for (uint32_t i = 0; i < (uint32_t)bounds.Size(); ++i)
+				{
+					if (!IsBitSet(visibleMask.data(), i))
+						continue;
+					if (i < buildings.size())
+						visibleBuildings.push_back(i);
+					else
+						visibleProps.push_back(i - (uint32_t)buildings.size());
+				}
+				tested += visibleProps.size();
+
+				for (int pass = 0; pass < 2; ++pass)
+				{
+					OcclusionCuller& passCuller = pass == 0 ? serialCuller : culler;
+					StageMeter meter;
+
+					meter.Begin();
+					passCuller.BeginFrame(viewProj);
+					for (uint32_t i : visibleBuildings)
+						passCuller.AddOccluder(box.Collision->GetTriangleVertices(), box.Collision->GetTriangleCount(), DirectX::XMLoadFloat4x4(&buildings[i].World));
+					ms[pass][0] += meter.End().Milliseconds;
+
+					meter.Begin();
+					passCuller.Render();
+					ms[pass][1] += meter.End().Milliseconds;
+
+					meter.Begin();
+					for (uint32_t i : visibleProps)
+						occluded[pass] += passCuller.IsVisible(props[i].Bound) ? 0 : 1;
+					ms[pass][2] += meter.End().Milliseconds;
+				}
+				triangles += culler.GetTriangleCount();
+			}
+
+			double n = settings.Frames;
+			out << "    { \"buildings\": " << buildings.size()
+				<< ", \"props\": " << props.size()
+				<< ", \"threads\": " << jobs.GetThreadCount()
+				<< ", \"occluder_triangles\": " << triangles / n
+				<< ", \"props_tested\": " << tested / n
+				// Both cullers rasterize the same triangles, so these have to agree.
+				<< ", \"props_occluded\": " << occluded[1] / n
+				<< ", \"props_occluded_serial\": " << occluded[0] / n
+				<< ", \"setup_ms\": " << ms[0][0] / n
+				<< ", \"raster_ms\": " << ms[0][1] / n
+				<< ", \"test_ms\": " << ms[0][2] / n
+				<< ", \"raster_parallel_ms\": " << ms[1][1] / n
+				<< ", \"raster_speedup\": " << (ms[1][1] > 0.0 ? ms[0][1] / ms[1][1] : 0.0)
+				<< " }" << (run + 1 < settings.OcclusionActorCounts.size() ? ",\n" : "\n");
+		}
+
+		out << "  ]";
+	}
+
+	// Times the draw packet radix sort, alone and on the job system, against std::sort and
+	// std::stable_sort. Keys have a few passes, pipelines and materials and random depths, like
+	// a frame's packets, and every run sorts the same unsorted copy.
+	void RunSortBenchmark(const BenchmarkSettings& settings, std::ostream& out)
+	{
+		JobSystem serialJobs(0);
+		JobSystem jobs;
+		DrawPacketSorter serialSorter(serialJobs);
+		DrawPacketSorter sorter(jobs);
+		auto byKey = [](const DrawPacket& a, const DrawPacket& b) { return a.Key < b.Key; };
+
+		out << "  \"sorting\": [\n";
+
+		for (size_t run = 0; run < settings.SortPacketCounts.size(); ++run)
+		{
+			std::mt19937 random(settings.Seed);
+			std::vector<DrawPacket> unsorted(settings.SortPacketCounts[run]);
+			for (size_t i = 0; i < unsorted.size(); ++i)
+			{
+				uint32_t pass = random() % 2;
+				uint32_t slot = random() % 3;
+				uint32_t pipeline = random() % 4;
+				uint32_t submesh = random() % 500;
+				uint32_t material = random() % 64;
+				float depth = std::uniform_real_distribution<float>(1.0f, HeadlessFrame::FarZ)(random);
+				unsorted[i] = { DrawKey::Make(pass, slot, pipeline, submesh, material, depth), nullptr, 0 };
+			}
+
+			double serialMs = 0.0;
+			double parallelMs = 0.0;
+			double sortMs = 0.0;
+			double stableSortMs = 0.0;
+			std::vector<DrawPacket> packets;
+
+			for (uint32_t repeat = 0; repeat < settings.Frames; ++repeat)
+			{
+				StageMeter meter;
+
+				packets = unsorted;
+				meter.Begin();
+				serialSorter.Sort(packets);
+				serialMs += meter.End().Milliseconds;
+
+				packets = unsorted;
+				meter.Begin();
+				sorter.Sort(packets);
+				parallelMs += meter.End().Milliseconds;
+
+				packets = unsorted;
+				meter.Begin();
+				std::sort(packets.begin(), packets.end(), byKey);
+				sortMs += meter.End().Milliseconds;
+
+				packets = unsorted;
+				meter.Begin();
+				std::stable_sort(packets.begin(), packets.end(), byKey);
+				stableSortMs += meter.End().Milliseconds;
+			}
+
+			double n = settings.Frames;
+			out << "    { \"packets\": " << unsorted.size()
+				<< ", \"threads\": " << jobs.GetThreadCount()
+				<< ", \"radix_ms\": " << serialMs / n
+				<< ", \"radix_parallel_ms\": " << parallelMs / n
+				<< ", \"std_sort_ms\": " << sortMs / n
+				<< ", \"std_stable_sort_ms\": " << stableSortMs / n
+				<< ", \"speedup\": " << (parallelMs > 0.0 ? sortMs / parallelMs : 0.0)
+				<< " }" << (run + 1 < settings.SortPacketCounts.size() ? ",\n" : "\n");
+		}
+
+		out << "  ]";
+	}
+
+	// Best of the repeats of copy, written as one result of the upload section.
+	template<typename Copy>
+	void MeasureCopy(const char* name, uint32_t count, size_t byteSize, const char* method, uint32_t repeats, Copy copy, std::ostream& out, bool& first)
+	{
+		// The first copy also faults the pages in.
+		copy();
+
+		double best = 0.0;
+		for (uint32_t r = 0; r < repeats; ++r)
+		{
+			StageMeter meter;
+			meter.Begin();
+			copy();
+			double ms = meter.End().Milliseconds;
+			best = (r == 0 || ms < best) ? ms : best;
+		}
+
+		if (!first)
+			out << ",\n";
+		first = false;
+		out << "      { \"data\": \"" << name << "\", \"elements\": " << count << ", \"bytes\": " << byteSize
+			<< ", \"method\": \"" << method << "\", \"best_ms\": " << best
+			<< ", \"gb_per_second\": " << (best > 0.0 ? byteSize / (best * 1.0e6) : 0.0) << " }";
+	}
+
+	template<typename T>
+	std::vector<T> UploadSource(uint32_t count)
+	{
+		std::vector<T> source(count);
+		uint8_t* sourceBytes = reinterpret_cast<uint8_t*>(source.data());
+		for (size_t i = 0; i < source.size() * sizeof(T); ++i)
+			sourceBytes[i] = (uint8_t)i;
+		return source;
+	}
+
+	// Without a device memcpy races StreamCopy in ordinary memory; this runs on any platform.
+	template<typename T>
+	void MeasureSystemCopies(const char* name, uint32_t count, uint32_t repeats, std::ostream& out, bool& first)
+	{
+		std::vector<T> source = UploadSource<T>(count);
+		std::vector<T> system(count);
+		size_t byteSize = source.size() * sizeof(T);
+
+		MeasureCopy(name, count, byteSize, "memcpy", repeats, [&]() { memcpy(system.data(), source.data(), byteSize); }, out, first);
+		MeasureCopy(name, count, byteSize, "stream", repeats, [&]() { StreamCopy(system.data(), source.data(), byteSize); }, out, first);
+	}
+
+#ifdef _WIN32
+	// Times filling count elements of T through every upload buffer path.
+	template<typename T>
+	void MeasureUploads(ID3D12Device* device, const char* name, uint32_t count, bool isConstantBuffer, uint32_t repeats, std::ostream& out, bool& first)
+	{
+		std::vector<T> source = UploadSource<T>(count);
+		size_t byteSize = source.size() * sizeof(T);
+		UploadBuffer<T> buffer(device, count, isConstantBuffer);
+
+		MeasureCopy(name, count, byteSize, "upload_data", repeats, [&]() { for (uint32_t i = 0; i < count; ++i) buffer.UploadData(i, &source[i]); }, out, first);
+		MeasureCopy(name, count, byteSize, "upload_range", repeats, [&]() { buffer.UploadRange(0, source.data(), count); }, out, first);
+		MeasureCopy(name, count, byteSize, "upload_range_stream", repeats, [&]() { buffer.UploadRange(0, source.data(), count, Upload_Copy_Stream); }, out, first);
+		MeasureCopy(name, count, byteSize, "writer", repeats, [&]()
+		{
+			auto writer = buffer.GetWriter();
+			for (uint32_t i = 0; i < count; ++i)
+				writer.Push(source[i]);
+		}, out, first);
+	}
+#endif
+
+	void RunUploadBenchmark(uint32_t repeats, std::ostream& out)
+	{
+		// Upload heap memory is write combined, which is what the streaming path is for.
+#ifdef _WIN32
+		Microsoft::WRL::ComPtr<ID3D12Device> device;
+		if (FAILED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+			device.Reset();
+		bool uploadHeap = device != nullptr;
+#else
+		bool uploadHeap = false;
+#endif
+
+		out << "  \"uploads\": {\n"
+			<< "    \"memory\": \"" << (uploadHeap ? "upload_heap" : "system") << "\",\n"
+			<< "    \"results\": [\n";
+
+		// Instance slots are plain structured buffer elements, the bone palette a constant buffer.
+		auto measure = [&](auto record, const char* name, uint32_t count, bool isConstantBuffer, bool& first)
+		{
+			using T = decltype(record);
+#ifdef _WIN32
+			if (uploadHeap)
+			{
+				MeasureUploads<T>(device.Get(), name, count, isConstantBuffer, repeats, out, first);
+				return;
+			}
+#endif
+			(void)isConstantBuffer;
+			MeasureSystemCopies<T>(name, count, repeats, out, first);
+		};
+
+		bool first = true;
+		for (uint32_t count : { 1024u, 16384u, 131072u })
+			measure(InstanceRecord(), "instance", count, false, first);
+		for (uint32_t count : { 1u, 64u })
+			measure(BonePaletteRecord(), "bone_palette", count, true, first);
+
+		out << "\n    ]\n  }";
+	}
+}
+
+// Runs Game's CPU frame path over generated scenes and prints per stage timings,
+// allocations, throughput and the cached draw submission against the per draw lookup it
+// replaced as JSON, followed by the BVH against a linear culling loop, the
+// culling kernels, the occlusion culler, the draw packet sort and the copy speed of each
+// upload path; without a Direct3D 12 device only memcpy and StreamCopy in system memory.
+//   Benchmark [--actors 1000,10000] [--distributions uniform,clustered,city] [--frames 120]
+//             [--warmup 10] [--seed 1] [--out results.json] [--write-scene assets/world.scene]
+//             [--query-actors 10000,100000] [--cull-boxes 100000] [--occlusion-actors 10000,100000]
+//             [--sort-packets 10000,100000,1000000] [--upload-repeats 20]
+int main(int argc, char** argv)
+{
+	BenchmarkSettings settings;
+	if (!ParseArguments(argc, argv, settings))
+	{
+		std::cerr << "usage: Benchmark [--actors N,...] [--distributions uniform,clustered,city] [--frames N] [--warmup N] [--seed N] [--out file] [--write-scene file] [--query-actors N,...] [--cull-boxes N] [--occlusion-actors N,...] [--sort-packets N,...] [--upload-repeats N]" << std::endl;
+		return 1;
+	}
+
+	std::ostringstream out;
+	out << "{\n"
+		<< "  \"frames\": " << settings.Frames << ",\n"
+		<< "  \"warmup\": " << settings.Warmup << ",\n"
+		<< "  \"seed\": " << settings.Seed << ",\n"
+		<< "  \"runs\": [\n";
+
+	bool first = true;
+	for (SceneDistribution distribution : settings.Distributions)
+	{
+		for (uint32_t actorCount : settings.ActorCounts)
+		{
+			if (!first)
+				out << ",\n";
+			RunBenchmark(settings, actorCount, distribution, first && !settings.SceneFile.empty(), out);
+			first = false;
+		}
+	}
+
+	out << "\n  ]";
+
+	if (!settings.QueryActorCounts.empty())
+	{
+		out << ",\n";
+		RunQueryBenchmark(settings, out);
+	}
+
+	if (settings.CullBoxCount > 0)
+	{
+		out << ",\n";
+		RunCullingBenchmark(settings, out);
+	}
+
+	if (!settings.OcclusionActorCounts.empty())
+	{
+		out << ",\n";
+		RunOcclusionBenchmark(settings, out);
+	}
+
+	if (!settings.SortPacketCounts.empty())
+	{
+		out << ",\n";
+		RunSortBenchmark(settings, out);
+	}
+
+	if (settings.UploadRepeats > 0)
+	{
+		out << ",\n";
+		RunUploadBenchmark(settings.UploadRepeats, out);
+	}
+
+	out << "\n}\n";
+
+	if (settings.OutputFile.empty())
+	{
+		std::cout << out.str();
+		return 0;
+	}
+
+	std::ofstream fout(settings.OutputFile);
+	fout << out.str();
+	return fout ? 0 : 1;
+}
@@ -2,13 +2,15 @@
 #include "Util.h"
 #include "FrameResource.h"
 #include "Mesh.h"
+#include "ActorStore.h"
+#include "ActorView.h"
 
 namespace DX12Lib
 {
-	class Actor
+	class Actor : public ActorView
 	{
 	public:
-		Actor(const std::wstring& name) : Name(name) {}
+		Actor(const std::wstring& name) : Name(name) { RenderLayer = Render_Layer_Opaque; }
 		Actor(const Actor& other) = delete;
 		Actor& operator=(const Actor& ohter) = delete;
 		~Actor() = default;
@@ -23,29 +25,28 @@ namespace DX12Lib
 			str += L", GroupName: " + (Group ? Group->Name : L"null");
 			str += L", DrawArg: " + DrawArg;
 			str += L", MaterialCBIndex: " + std::to_wstring(Instance.MaterialCBIndex);
-			//str += L", InstanceBufferOffset: " + std::to_wstring(InstanceBufferOffset);
 			//str += L", StartIndexLocation: " + std::to_wstring(submesh.StartIndexLocation);
 			//str += L", IndexCount: " + std::to_wstring(submesh.IndexCount);
 
 			return str;
 		}
 
+		// Recomputed from the submesh; the copy in the actor store is cheaper once it is current.
+		DirectX::BoundingBox GetWorldBound() const
+		{
+			DirectX::BoundingBox bound;
+			Group->DrawArgs[DrawArg].Bound.Transform(bound, DirectX::XMLoadFloat4x4(&Instance.World));
+			return bound;
+		}
+
 	public:
 		std::wstring Name;
-		//int NumFramesDirty = gNumFrameResources;
 
 		MeshGroup* Group = nullptr;
 		std::wstring DrawArg;
-		D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		InstanceData Instance;
-		UINT InstanceBufferOffset = 0;
-
-		bool Visible = true;
-		bool Hidden = false;
-		UINT RenderLayer = Render_Layer_Opaque;
 
 		// Only applicable to skinned render-items.
-		UINT SkinnedCBIndex = -1;
 		SkinnedMesh* mSkinnedMesh = nullptr;
 	};
 }
@@ -0,0 +1,228 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <DirectXCollision.h>
+
+namespace DX12Lib
+{
+	class Actor;
+	class MeshGroup;
+	struct Submesh;
+
+	// 24 bit slot index and 8 bit generation. A slot's generation changes every time it is
+	// reused, so handles to destroyed actors stop resolving. Zero is never a live handle.
+	struct ActorHandle
+	{
+		static const uint32_t IndexBits = 24;
+		static const uint32_t IndexMask = (1u << IndexBits) - 1;
+
+		uint32_t Value = 0;
+
+		inline uint32_t Index() const { return Value & IndexMask; }
+		inline uint32_t Generation() const { return Value >> IndexBits; }
+		inline bool IsNull() const { return Value == 0; }
+
+		inline bool operator==(const ActorHandle& other) const { return Value == other.Value; }
+		inline bool operator!=(const ActorHandle& other) const { return Value != other.Value; }
+	};
+
+	enum ActorFlag : uint32_t
+	{
+		Actor_Flag_None = 0x0,
+		Actor_Flag_Hidden = 0x1,
+		Actor_Flag_Occluder = 0x2,
+		Actor_Flag_Skinned = 0x4,
+	};
+
+	// Per actor data the frame loop reads, kept in dense parallel arrays. Removal swaps the
+	// last actor into the hole, so dense indices are only stable until the next Destroy;
+	// handles stay valid for the lifetime of the actor. Names live in a side index that only
+	// tools should query.
+	class ActorStore
+	{
+	public:
+		// Matches every actor, including those with no layer bit set.
+		static const uint32_t AllLayers = ~0u;
+
+		// Actors sharing one exact layer value. Every actor is in exactly one bucket, so a
+		// union of layers never yields an actor twice.
+		struct LayerBucket
+		{
+			uint32_t Layer = 0;
+			std::vector<Actor*> Actors;
+			std::vector<ActorHandle> Handles;
+		};
+
+		// The actors of every bucket whose layer shares a bit with the mask. Walks the buckets
+		// in place, nothing is allocated. Invalidated by Create, Destroy and layer changes.
+		class LayerRange
+		{
+		public:
+			class Iterator
+			{
+			public:
+				Iterator(const LayerBucket* bucket, const LayerBucket* end, uint32_t mask) :
+					mBucket(bucket), mEnd(end), mMask(mask)
+				{
+					SkipEmpty();
+				}
+
+				inline Actor* operator*() const { return mBucket->Actors[mIndex]; }
+				inline Iterator& operator++() { ++mIndex; SkipEmpty(); return *this; }
+				inline bool operator==(const Iterator& other) const { return mBucket == other.mBucket && mIndex == other.mIndex; }
+				inline bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+			private:
+				void SkipEmpty()
+				{
+					while (mBucket != mEnd && (mIndex >= mBucket->Actors.size() || !Matches(mBucket->Layer, mMask)))
+					{
+						++mBucket;
+						mIndex = 0;
+					}
+				}
+
+				const LayerBucket* mBucket;
+				const LayerBucket* mEnd;
+				size_t mIndex = 0;
+				uint32_t mMask;
+			};
+
+			LayerRange(const LayerBucket* first, const LayerBucket* last, uint32_t mask) : mFirst(first), mLast(last), mMask(mask) {}
+
+			inline Iterator begin() const { return Iterator(mFirst, mLast, mMask); }
+			inline Iterator end() const { return Iterator(mLast, mLast, mMask); }
+			size_t Size() const;
+
+		private:
+			const LayerBucket* mFirst;
+			const LayerBucket* mLast;
+			uint32_t mMask;
+		};
+
+		static inline bool Matches(uint32_t layer, uint32_t mask) { return mask == AllLayers || (layer & mask) != 0; }
+
+		ActorStore() = default;
+		ActorStore(const ActorStore&) = delete;
+		ActorStore& operator=(const ActorStore&) = delete;
+		~ActorStore() = default;
+
+		// Returns a null handle if the name is taken or the slots are exhausted.
+		ActorHandle Create(Actor* actor, const std::wstring& name);
+		void Destroy(ActorHandle handle);
+		// Destroys every actor. Handles from before stay invalid, also once slots are reused.
+		void Clear();
+
+		bool IsValid(ActorHandle handle) const;
+		ActorHandle Find(const std::wstring& name) const;
+
+		// Dense index of a live actor.
+		inline uint32_t IndexOf(ActorHandle handle) const { return mSlots[handle.Index()].Dense; }
+		inline ActorHandle HandleAt(uint32_t index) const { return mHandles[index]; }
+		inline size_t Size() const { return mHandles.size(); }
+		// Handle indices of live actors stay below this.
+		inline size_t GetSlotCount() const { return mSlots.size(); }
+
+		void SetTransform(ActorHandle handle, const DirectX::XMFLOAT4X4& world, const DirectX::BoundingBox& worldBound);
+		void SetMesh(ActorHandle handle, MeshGroup* group, const Submesh* submesh);
+		void SetMaterial(ActorHandle handle, uint32_t materialIndex);
+		void SetLayer(ActorHandle handle, uint32_t layer);
+		void SetFlags(ActorHandle handle, uint32_t flags);
+
+		inline const DirectX::XMFLOAT4X4& GetWorld(ActorHandle handle) const { return mWorlds[IndexOf(handle)]; }
+		inline const DirectX::BoundingBox& GetBound(ActorHandle handle) const { return mBounds[IndexOf(handle)]; }
+		inline const Submesh* GetSubmesh(ActorHandle handle) const { return mSubmeshes[IndexOf(handle)]; }
+
+		// Changes whenever the mesh, material, layer or flags of the actor change, so data
+		// derived from them can be cached until it moves. Revisions come from one counter for
+		// the whole store, so an actor created in a reused slot, even one whose handle repeats
+		// after the generation wraps, never matches a revision cached for an earlier actor.
+		inline uint32_t GetRevision(ActorHandle handle) const { return mRevisions[IndexOf(handle)]; }
+
+		// Columns, all Size() long and in dense order.
+		inline Actor* const* GetActors() const { return mActors.data(); }
+		inline const DirectX::XMFLOAT4X4* GetWorlds() const { return mWorlds.data(); }
+		inline const DirectX::BoundingBox* GetBounds() const { return mBounds.data(); }
+		inline MeshGroup* const* GetGroups() const { return mGroups.data(); }
+		inline const Submesh* const* GetSubmeshes() const { return mSubmeshes.data(); }
+		inline const uint32_t* GetMaterials() const { return mMaterials.data(); }
+		inline const uint32_t* GetLayers() const { return mLayers.data(); }
+		inline const uint32_t* GetFlags() const { return mFlags.data(); }
+		inline const uint32_t* GetRevisions() const { return mRevisions.data(); }
+
+		inline LayerRange GetActorsInLayers(uint32_t layerMask) const { return LayerRange(mBuckets.data(), mBuckets.data() + mBuckets.size(), layerMask); }
+		inline const std::vector<LayerBucket>& GetLayerBuckets() const { return mBuckets; }
+
+		// Per actor data in a ring of frameCount buffers, one written per frame, has to be
+		// rewritten in each of them once it changes. The next frameCount calls of FlushDirty
+		// report the actor; marking it again before then starts the count over. Destroying the
+		// actor drops it. frameCount must be at least one.
+		void MarkDirty(ActorHandle handle, uint32_t frameCount);
+
+		// Calls write with the handle of every dirty actor, then counts one frame off each.
+		// write must not create, destroy or mark actors.
+		template<typename Write>
+		void FlushDirty(Write write)
+		{
+			size_t count = 0;
+			for (ActorHandle handle : mDirty)
+			{
+				write(handle);
+
+				Slot& slot = mSlots[handle.Index()];
+				if (--slot.FramesDirty > 0)
+				{
+					slot.DirtyPosition = (uint32_t)count;
+					mDirty[count++] = handle;
+				}
+			}
+			mDirty.resize(count);
+		}
+
+		inline size_t GetDirtyCount() const { return mDirty.size(); }
+
+	private:
+		struct Slot
+		{
+			uint32_t Dense = 0;
+			uint32_t Generation = 1;
+			bool Live = false;
+			std::wstring Name;
+			// Flushes left before the actor is clean, and its entry in mDirty while it isn't.
+			uint32_t FramesDirty = 0;
+			uint32_t DirtyPosition = 0;
+		};
+
+		// Marks a slot free, drops it from the dirty list and moves its generation on.
+		void ReleaseSlot(uint32_t index);
+
+		uint32_t FindBucket(uint32_t layer);
+		void AddToBucket(uint32_t dense, uint32_t layer);
+		void RemoveFromBucket(uint32_t dense);
+
+		std::vector<Slot> mSlots;
+		std::vector<uint32_t> mFreeSlots;
+		std::unordered_map<std::wstring, ActorHandle> mNames;
+		std::vector<ActorHandle> mDirty;
+
+		std::vector<ActorHandle> mHandles;
+		std::vector<Actor*> mActors;
+		std::vector<DirectX::XMFLOAT4X4> mWorlds;
+		std::vector<DirectX::BoundingBox> mBounds;
+		std::vector<MeshGroup*> mGroups;
+		std::vector<const Submesh*> mSubmeshes;
+		std::vector<uint32_t> mMaterials;
+		std::vector<uint32_t> mLayers;
+		std::vector<uint32_t> mFlags;
+		std::vector<uint32_t> mRevisions;
+		// Not reset by Clear, caches must not match actors created afterwards either.
+		uint32_t mNextRevision = 1;
+
+		// Bucket of each dense actor and its position in it.
+		std::vector<LayerBucket> mBuckets;
+		std::vector<uint32_t> mBucketIndices;
+		std::vector<uint32_t> mBucketPositions;
+	};
+}
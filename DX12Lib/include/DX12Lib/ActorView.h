@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include "ActorStore.h"
+#include "CommandRecorder.h"
+#include "Submesh.h"
+
+namespace DX12Lib
+{
+	// The part of an actor that culling and draw building touch, without device types, so
+	// DrawList builds and runs without Direct3D. Actor derives from it. Scene BVH leaves point
+	// at this base, cast from the user data to ActorView before going on to Actor.
+	class ActorView
+	{
+	public:
+		ActorHandle Handle;
+
+		// Visible in the main camera; ViewMask holds one bit per culling view.
+		bool Visible = true;
+		uint32_t ViewMask = 0;
+		bool Hidden = false;
+		uint32_t RenderLayer = 0;
+
+		// Rasterized into the software depth buffer to hide the actors behind it.
+		bool Occluder = false;
+
+		// Leaf in the scene BVH, -1 if the actor is not in the tree.
+		int ProxyId = -1;
+
+		// What a draw of the actor binds, copied from its mesh group by AssetManager::UpdateActor.
+		// The levels of detail a submesh names are looked up in Submeshes.
+		VertexBufferBinding VertexBuffer;
+		IndexBufferBinding IndexBuffer;
+		PrimitiveTopology Topology = Primitive_Topology_TriangleList;
+		const SubmeshMap* Submeshes = nullptr;
+
+		// Bone palette of a skinned actor, the store flags it with Actor_Flag_Skinned.
+		uint32_t SkinnedCBIndex = -1;
+	};
+}
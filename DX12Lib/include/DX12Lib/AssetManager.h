@@ -3,6 +3,8 @@
 #include <memory>
 #include "Mesh.h"
 #include "Actor.h"
+#include "ActorStore.h"
+#include "StringTable.h"
 #include "Util.h"
 
 namespace DX12Lib
@@ -15,15 +17,23 @@ namespace DX12Lib
 		AssetManager& operator=(const AssetManager&) = delete;
 		~AssetManager() = default;
 
+		// Mesh groups, materials and textures get dense ids in creation order. Resolve names
+		// to ids or pointers at load time; the by id getters are plain array reads.
+
 		// Mesh
 		Mesh CreateMesh(const std::wstring& name, const MeshData& data);
 		MeshGroup* CreateMeshGroup(const std::wstring& name, std::vector<Mesh>& meshes);
 		MeshGroup* CreateMeshGroup(std::unique_ptr<MeshGroup>& group);
+		// Submeshes, bounds and collision only, no GPU buffers. For tools that run without a device.
+		MeshGroup* CreateMeshGroupWithoutBuffers(const std::wstring& name, std::vector<Mesh>& meshes);
 		MeshGroup* GetMeshGroup(const std::wstring& name) const;
+		inline MeshGroup* GetMeshGroupById(UINT id) const { return mMeshGroups[id].get(); }
+		inline size_t GetMeshGroupsCount() const { return mMeshGroups.size(); }
 
 		// Material
 		Material* CreateMaterial(const std::wstring& name);
 		Material* GetMaterial(const std::wstring& name) const;
+		inline Material* GetMaterialById(UINT id) const { return mMaterials[id].get(); }
 		std::vector<Material*> GetAllMaterials() const;
 		inline size_t GetMaterialsCount() const { return mMaterials.size(); }
 		int FindMaterialIndex(const std::wstring& name) const;
@@ -31,6 +41,7 @@ namespace DX12Lib
 		// Texture
 		Texture* CreateTexture(const std::wstring& name, const std::wstring& filename);
 		Texture* GetTexture(const std::wstring& name) const;
+		inline Texture* GetTextureById(UINT id) const { return mTextures[id].get(); }
 		std::vector<Texture*> GetAllTextures() const;
 		inline size_t GetTexturesCount() const { return mTextures.size(); }
 		int FindTextureIndex(const std::wstring& name) const;
@@ -41,15 +52,42 @@ namespace DX12Lib
 
 		// Actor
 		Actor* CreateActor(const std::wstring& name);
+		// The caller removes the actor from the scene BVH and any draw lists first.
+		void DestroyActor(Actor* actor);
 		Actor* GetActor(const std::wstring& name) const;
 		std::vector<Actor*> GetActors(UINT layer = Render_Layer_All) const;
-		inline size_t GetActorsCount(UINT layer = Render_Layer_All) const;
+		// Same actors as GetActors without building a vector; use this on the frame path.
+		inline ActorStore::LayerRange GetActorsInLayers(UINT layer = Render_Layer_All) const { return mActorStore.GetActorsInLayers(layer == Render_Layer_All ? ActorStore::AllLayers : layer); }
+		size_t GetActorsCount(UINT layer = Render_Layer_All) const;
+		// Copies the actor's transform, mesh, material, layer and flags into the store.
+		void UpdateActor(Actor* actor);
+		// Copies only the transform and the world bound, for synced actors that just moved.
+		void UpdateActorTransform(Actor* actor);
+		inline const ActorStore& GetActorStore() const { return mActorStore; }
+
+		// Calls write for every actor whose transform or material changed in the last
+		// gNumFrameResources calls. Call it once per frame with that frame's resource, so each
+		// resource in the ring gets the new instance data once.
+		template<typename Write>
+		void FlushDirtyActors(Write write)
+		{
+			mActorStore.FlushDirty([&](ActorHandle handle) { write(mActors[handle.Index()].get()); });
+		}
+		inline size_t GetDirtyActorsCount() const { return mActorStore.GetDirtyCount(); }
 
 	private:
-		std::unordered_map<std::wstring, std::unique_ptr<MeshGroup>> mMeshGroups;
-		std::unordered_map<std::wstring, std::unique_ptr<Material>> mMaterials;
-		std::unordered_map<std::wstring, std::unique_ptr<Texture>> mTextures;
+		UINT mSubmeshCount = 0;
+		StringTable mMeshGroupNames;
+		StringTable mMaterialNames;
+		StringTable mTextureNames;
+		std::vector<std::unique_ptr<MeshGroup>> mMeshGroups;
+		std::vector<std::unique_ptr<Material>> mMaterials;
+		std::vector<std::unique_ptr<Texture>> mTextures;
 		std::unordered_map<std::wstring, Microsoft::WRL::ComPtr<ID3DBlob>> mShaders;
-		std::unordered_map<std::wstring, std::unique_ptr<Actor>> mActors;
+
+		// Actors are owned per store slot, so their addresses stay put while the store moves
+		// their data around.
+		ActorStore mActorStore;
+		std::vector<std::unique_ptr<Actor>> mActors;
 	};
 }
@@ -0,0 +1,129 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace DX12Lib
+{
+	using GpuVirtualAddress = uint64_t;
+
+	// An API object as the recorder sees it: a pipeline state, root signature, command signature
+	// or buffer. It is only compared and passed on; the backend knows what it points to. Zero is
+	// null.
+	struct GpuObjectHandle
+	{
+		uintptr_t Value = 0;
+
+		inline bool IsNull() const { return Value == 0; }
+
+		inline bool operator==(const GpuObjectHandle& other) const { return Value == other.Value; }
+		inline bool operator!=(const GpuObjectHandle& other) const { return Value != other.Value; }
+	};
+
+	// The values are those of D3D_PRIMITIVE_TOPOLOGY, so a backend can cast them through.
+	enum PrimitiveTopology : uint32_t
+	{
+		Primitive_Topology_Undefined = 0,
+		Primitive_Topology_PointList = 1,
+		Primitive_Topology_LineList = 2,
+		Primitive_Topology_LineStrip = 3,
+		Primitive_Topology_TriangleList = 4,
+		Primitive_Topology_TriangleStrip = 5,
+	};
+
+	// The values are those of the matching DXGI_FORMAT.
+	enum IndexFormat : uint32_t
+	{
+		Index_Format_Uint32 = 42,
+		Index_Format_Uint16 = 57,
+	};
+
+	struct VertexBufferBinding
+	{
+		GpuVirtualAddress Location = 0;
+		uint32_t SizeInBytes = 0;
+		uint32_t StrideInBytes = 0;
+	};
+
+	struct IndexBufferBinding
+	{
+		GpuVirtualAddress Location = 0;
+		uint32_t SizeInBytes = 0;
+		IndexFormat Format = Index_Format_Uint16;
+	};
+
+	// Front end for recording draws. It shadows the state bound through it and drops calls that
+	// would set what is already set; the backend only sees the calls that change something.
+	// Anything bound on the command list behind the recorder's back must be followed by Reset.
+	// It uses no graphics API itself, the D3D12 backend lives in D3D12CommandRecorder.h.
+	class CommandRecorder
+	{
+	public:
+		static const uint32_t MaxRootParameters = 16;
+
+		struct Stats
+		{
+			uint32_t Issued = 0;
+			uint32_t Filtered = 0;
+			uint32_t Draws = 0;
+		};
+
+		CommandRecorder() = default;
+		CommandRecorder(const CommandRecorder&) = delete;
+		CommandRecorder& operator=(const CommandRecorder&) = delete;
+		virtual ~CommandRecorder() = default;
+
+		// Forgets the shadowed state, the next call of each kind always goes through.
+		void Reset();
+
+		// A different root signature unbinds the root views, so their shadows are dropped.
+		void SetGraphicsRootSignature(GpuObjectHandle rootSignature);
+		void SetPipelineState(GpuObjectHandle pipelineState);
+		void SetVertexBuffer(const VertexBufferBinding& binding);
+		void SetIndexBuffer(const IndexBufferBinding& binding);
+		void SetPrimitiveTopology(PrimitiveTopology topology);
+		void SetGraphicsRootShaderResourceView(uint32_t rootParameterIndex, GpuVirtualAddress address);
+		void SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, GpuVirtualAddress address);
+		void DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation);
+
+		// The arguments may rebind buffers and root views, so their shadows are dropped.
+		void ExecuteIndirect(GpuObjectHandle commandSignature, uint32_t maxCommandCount, GpuObjectHandle argumentBuffer, uint64_t argumentBufferOffset);
+
+		inline const Stats& GetStats() const { return mStats; }
+		inline void ResetStats() { mStats = Stats(); }
+
+	protected:
+		virtual void RecordGraphicsRootSignature(GpuObjectHandle rootSignature) = 0;
+		virtual void RecordPipelineState(GpuObjectHandle pipelineState) = 0;
+		virtual void RecordVertexBuffer(const VertexBufferBinding& binding) = 0;
+		virtual void RecordIndexBuffer(const IndexBufferBinding& binding) = 0;
+		virtual void RecordPrimitiveTopology(PrimitiveTopology topology) = 0;
+		virtual void RecordGraphicsRootShaderResourceView(uint32_t rootParameterIndex, GpuVirtualAddress address) = 0;
+		virtual void RecordGraphicsRootConstantBufferView(uint32_t rootParameterIndex, GpuVirtualAddress address) = 0;
+		virtual void RecordDrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) = 0;
+		virtual void RecordExecuteIndirect(GpuObjectHandle commandSignature, uint32_t maxCommandCount, GpuObjectHandle argumentBuffer, uint64_t argumentBufferOffset) = 0;
+
+	private:
+		// Records the call if the shadowed value differs, and updates the shadow.
+		template<typename T>
+		bool Changes(T& shadow, bool& known, const T& value);
+
+		void SetRootView(uint32_t rootParameterIndex, GpuVirtualAddress address, bool constantBuffer);
+
+	private:
+		GpuObjectHandle mRootSignature;
+		GpuObjectHandle mPipelineState;
+		VertexBufferBinding mVertexBuffer;
+		IndexBufferBinding mIndexBuffer;
+		PrimitiveTopology mTopology = Primitive_Topology_Undefined;
+		std::array<GpuVirtualAddress, MaxRootParameters> mRootViews = {};
+
+		bool mRootSignatureKnown = false;
+		bool mPipelineStateKnown = false;
+		bool mVertexBufferKnown = false;
+		bool mIndexBufferKnown = false;
+		bool mTopologyKnown = false;
+		std::array<bool, MaxRootParameters> mRootViewsKnown = {};
+
+		Stats mStats;
+	};
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <d3d12.h>
+#include "CommandRecorder.h"
+
+namespace DX12Lib
+{
+	static_assert((uint32_t)Primitive_Topology_TriangleList == (uint32_t)D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, "Topologies have to match D3D");
+	static_assert((uint32_t)Primitive_Topology_TriangleStrip == (uint32_t)D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, "Topologies have to match D3D");
+	static_assert((uint32_t)Index_Format_Uint16 == (uint32_t)DXGI_FORMAT_R16_UINT, "Index formats have to match DXGI");
+	static_assert((uint32_t)Index_Format_Uint32 == (uint32_t)DXGI_FORMAT_R32_UINT, "Index formats have to match DXGI");
+	static_assert(sizeof(VertexBufferBinding) == sizeof(D3D12_VERTEX_BUFFER_VIEW), "Bindings are copied into indirect arguments as D3D views");
+	static_assert(sizeof(IndexBufferBinding) == sizeof(D3D12_INDEX_BUFFER_VIEW), "Bindings are copied into indirect arguments as D3D views");
+
+	template<typename T>
+	inline GpuObjectHandle ToHandle(T* object) { return { reinterpret_cast<uintptr_t>(object) }; }
+
+	template<typename T>
+	inline T* FromHandle(GpuObjectHandle handle) { return reinterpret_cast<T*>(handle.Value); }
+
+	inline D3D12_VERTEX_BUFFER_VIEW ToView(const VertexBufferBinding& binding)
+	{
+		return { binding.Location, binding.SizeInBytes, binding.StrideInBytes };
+	}
+
+	inline D3D12_INDEX_BUFFER_VIEW ToView(const IndexBufferBinding& binding)
+	{
+		return { binding.Location, binding.SizeInBytes, (DXGI_FORMAT)binding.Format };
+	}
+
+	inline PrimitiveTopology ToTopology(D3D12_PRIMITIVE_TOPOLOGY topology) { return (PrimitiveTopology)topology; }
+	inline D3D12_PRIMITIVE_TOPOLOGY ToD3D12Topology(PrimitiveTopology topology) { return (D3D12_PRIMITIVE_TOPOLOGY)topology; }
+
+	// Forwards to a D3D12 graphics command list. Handles passed to it have to come from
+	// ToHandle of the interface the call expects.
+	class D3D12CommandRecorder : public CommandRecorder
+	{
+	public:
+		explicit D3D12CommandRecorder(ID3D12GraphicsCommandList* commandList = nullptr) : mCommandList(commandList) {}
+
+		// Switching lists resets the shadowed state.
+		void SetCommandList(ID3D12GraphicsCommandList* commandList);
+		inline ID3D12GraphicsCommandList* GetCommandList() const { return mCommandList; }
+
+	protected:
+		void RecordGraphicsRootSignature(GpuObjectHandle rootSignature) override;
+		void RecordPipelineState(GpuObjectHandle pipelineState) override;
+		void RecordVertexBuffer(const VertexBufferBinding& binding) override;
+		void RecordIndexBuffer(const IndexBufferBinding& binding) override;
+		void RecordPrimitiveTopology(PrimitiveTopology topology) override;
+		void RecordGraphicsRootShaderResourceView(uint32_t rootParameterIndex, GpuVirtualAddress address) override;
+		void RecordGraphicsRootConstantBufferView(uint32_t rootParameterIndex, GpuVirtualAddress address) override;
+		void RecordDrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) override;
+		void RecordExecuteIndirect(GpuObjectHandle commandSignature, uint32_t maxCommandCount, GpuObjectHandle argumentBuffer, uint64_t argumentBufferOffset) override;
+
+	private:
+		ID3D12GraphicsCommandList* mCommandList;
+	};
+}
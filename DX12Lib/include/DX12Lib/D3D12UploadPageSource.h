@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include "LinearUploadAllocator.h"
+#include "Util.h"
+
+namespace DX12Lib
+{
+	// Upload pages as committed buffers on the upload heap, mapped for as long as the source lives.
+	class D3D12UploadPageSource : public UploadPageSource
+	{
+	public:
+		explicit D3D12UploadPageSource(Microsoft::WRL::ComPtr<ID3D12Device> device) : mDevice(device) {}
+		D3D12UploadPageSource(const D3D12UploadPageSource&) = delete;
+		D3D12UploadPageSource& operator=(const D3D12UploadPageSource&) = delete;
+		~D3D12UploadPageSource() override;
+
+		UploadAllocation CreatePage(size_t byteSize) override;
+
+	private:
+		Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+		std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> mResources;
+	};
+}
@@ -0,0 +1,206 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+#include "ActorStore.h"
+#include "ActorView.h"
+#include "CommandRecorder.h"
+#include "DrawPacket.h"
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+#include "LodSelection.h"
+#include "OcclusionCuller.h"
+#include "SceneBVH.h"
+#include "VisibilityCache.h"
+
+namespace DX12Lib
+{
+	// A pass draws its layer slots in order, every slot with one pipeline; an actor goes to the
+	// first slot that shares a layer bit with it.
+	struct PassSlot
+	{
+		uint32_t Layers;
+		uint32_t Pipeline;
+		bool Translucent;
+	};
+
+	// What the batches of a pass are recorded with: the pipeline for each pipeline field of the
+	// keys, and where the root views of a draw find its instance indices and bone palette.
+	struct DrawSubmitState
+	{
+		// Indexed by the pipeline field of the keys. A non-null override replaces them all.
+		const GpuObjectHandle* Pipelines = nullptr;
+		GpuObjectHandle PipelineOverride;
+
+		uint32_t InstanceIndicesParameter = 0;
+		GpuVirtualAddress InstanceIndices = 0;
+		uint32_t InstanceIndexStride = 0;
+
+		// Unskinned draws bind a null view here.
+		uint32_t SkinnedCBParameter = 0;
+		GpuVirtualAddress SkinnedCB = 0;
+		uint32_t SkinnedCBStride = 0;
+	};
+
+	// The CPU side of a frame's draws, from culling to instanced batches, without a device.
+	// Every view is a pass: bit v of ActorView::ViewMask and the pass field of the draw keys. A
+	// frame runs Cull, FinishCull, optionally CullOccluded, BuildDrawPackets and BuildBatches;
+	// between Cull and FinishCull the caller can still narrow the masks of GetVisibleActors.
+	class DrawList
+	{
+	public:
+		static const uint32_t MaxViews = 1u << DrawKey::PassBits;
+		static const uint32_t MaxSlots = 1u << DrawKey::SlotBits;
+		static const uint32_t MaxLods = 4;
+		static const uint64_t NoDrawKey = ~0ull;
+
+		struct CachedLod
+		{
+			uint32_t SubmeshId;
+			uint32_t IndexCount;
+			uint32_t StartIndexLocation;
+			int32_t BaseVertexLocation;
+		};
+
+		// Everything submission needs from an actor, POD only. Rebuilt when the actor's revision
+		// in the store moves; packets point at these instead of at the actor.
+		struct CachedDraw
+		{
+			ActorHandle Handle;
+			uint32_t Revision;
+			ActorView* Owner;
+
+			// Sort key without depth for every pass, NoDrawKey where the pass skips the actor.
+			uint64_t Keys[MaxViews];
+
+			VertexBufferBinding VertexBuffer;
+			IndexBufferBinding IndexBuffer;
+			PrimitiveTopology Topology;
+			// Levels of detail, finest first; LodSwitchRadii[i] is where level i + 1 takes over.
+			CachedLod Lods[MaxLods];
+			float LodSwitchRadii[MaxLods - 1];
+			uint32_t LodCount;
+			// Level picked last frame in each pass, -1 when it was too small to draw.
+			int8_t LastLod[MaxViews];
+			bool Skinned;
+			uint32_t SkinnedCBIndex;
+		};
+
+		// Consecutive packets of one pass slot that share pipeline and submesh, drawn as one
+		// instanced draw. Their instance indices are contiguous from InstanceOffset.
+		struct DrawBatch
+		{
+			uint32_t FirstPacket;
+			uint32_t InstanceCount;
+			uint32_t InstanceOffset;
+		};
+
+		explicit DrawList(JobSystem& jobs);
+
+		// Views without slots draw nothing. Cached keys are rebuilt as actors change, so the
+		// slots are meant to be set once, before the first frame.
+		void SetPassSlots(uint32_t view, const std::vector<PassSlot>& slots);
+		inline const std::vector<PassSlot>& GetPassSlots(uint32_t view) const { return mPassSlots[view]; }
+
+		// Clears the last frame and sets the masks of the actors inside the first viewCount
+		// views: one walk over the tree, with the views that only intersect a leaf retested
+		// against the exact bounds unless the cache still knows the answer. Hidden actors are
+		// skipped. The user data of the leaves are ActorView pointers.
+		void Cull(const SceneBVH& bvh, VisibilityCache& cache, const ActorStore& store, const FrustumPlanes* views, uint32_t viewCount, const DirectX::XMFLOAT3& eye);
+
+		// Drops the actors left without a view, sets Visible from mainView and fills the per
+		// view lists.
+		void FinishCull(uint32_t mainView);
+
+		// Drops the actors of one view that the occluders among them hide. Returns how many.
+		size_t CullOccluded(OcclusionCuller& culler, const ActorStore& store, DirectX::FXMMATRIX viewProj, uint32_t view);
+
+		// One packet per actor and pass at the level of detail it picks, sorted. eyes and
+		// lodViews are indexed by view.
+		void BuildDrawPackets(const ActorStore& store, const LodSelector& lodSelector, const DirectX::XMFLOAT3* eyes, const LodView* lodViews);
+
+		// Cuts the sorted packets into batches. indices holds the instance slot last written for
+		// every packet and must have room for all of them; write(i, slot) is called for the
+		// entries that change, after indices[i] is updated. Skinned draws are never batched,
+		// each binds its own bone palette.
+		template<typename Write>
+		void BuildBatches(std::vector<uint32_t>& indices, const Write& write);
+
+		// Records the batches of layer slots firstSlot to lastSlot of a pass, one instanced draw
+		// each. The recorder filters what the batches before it already bound.
+		void Submit(CommandRecorder& recorder, uint32_t pass, uint32_t firstSlot, uint32_t lastSlot, const DrawSubmitState& state) const;
+
+		// The actors visible in any view. Between Cull and FinishCull their masks may be
+		// narrowed; the list itself may only lose actors, such as ones about to be destroyed.
+		inline std::vector<ActorView*>& GetVisibleActors() { return mVisibleActors; }
+		inline const std::vector<ActorView*>& GetViewActors(uint32_t view) const { return mViewActors[view]; }
+		inline const std::vector<DrawPacket>& GetDrawPackets() const { return mDrawPackets; }
+		inline const std::vector<DrawBatch>& GetDrawBatches() const { return mDrawBatches; }
+
+		// Reserves the packet and cached draw storage for this many actors in every view.
+		void Reserve(size_t actorCount, uint32_t viewCount);
+
+	private:
+		void UpdateCachedDraw(const ActorStore& store, ActorView* actor);
+
+	private:
+		std::vector<PassSlot> mPassSlots[MaxViews];
+
+		std::vector<ActorView*> mVisibleActors;
+		std::vector<ActorView*> mViewActors[MaxViews];
+		uint32_t mMainView = 0;
+
+		// Leaves the BVH reports as partially visible, tested in batches.
+		std::vector<ActorView*> mCullCandidates;
+		std::vector<uint32_t> mCandidateMasks;
+		BoundsSoA mCullBounds;
+		std::vector<uint32_t> mCullViewMasks;
+
+		// Indexed by the slot index of the actor handle.
+		std::vector<CachedDraw> mCachedDraws;
+		std::vector<DrawPacket> mDrawPackets;
+		std::vector<DrawBatch> mDrawBatches;
+		DrawPacketSorter mDrawPacketSorter;
+	};
+
+	template<typename Write>
+	void DrawList::BuildBatches(std::vector<uint32_t>& indices, const Write& write)
+	{
+		mDrawBatches.clear();
+
+		// Index entries are assigned in sorted order, so every batch gets a contiguous run.
+		uint32_t batchSubmesh = 0;
+		uint64_t batchState = 0;
+		bool batchOpen = false;
+
+		for (uint32_t i = 0; i < mDrawPackets.size(); ++i)
+		{
+			const DrawPacket& packet = mDrawPackets[i];
+			const CachedDraw* draw = static_cast<const CachedDraw*>(packet.Item);
+			const CachedLod& lod = draw->Lods[packet.Variant];
+
+			// Pass, slot and pipeline.
+			uint64_t state = packet.Key >> DrawKey::PipelineShift;
+
+			if (batchOpen && !draw->Skinned && state == batchState && lod.SubmeshId == batchSubmesh)
+			{
+				++mDrawBatches.back().InstanceCount;
+			}
+			else
+			{
+				mDrawBatches.push_back({ i, 1, i });
+				batchSubmesh = lod.SubmeshId;
+				batchState = state;
+				batchOpen = !draw->Skinned;
+			}
+
+			// Only entries whose actor moved in the sorted order are written.
+			uint32_t slot = draw->Handle.Index();
+			if (indices[i] != slot)
+			{
+				indices[i] = slot;
+				write(i, slot);
+			}
+		}
+	}
+}
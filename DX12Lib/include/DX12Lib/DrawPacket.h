@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "JobSystem.h"
+
+namespace DX12Lib
+{
+	// One draw of one pass. The key decides the submission order, Item is whatever the
+	// submitter needs to record the draw and Variant picks between versions of it, such as
+	// levels of detail.
+	struct DrawPacket
+	{
+		uint64_t Key;
+		void* Item;
+		uint32_t Variant;
+	};
+
+	// Sort key layout, most significant field first:
+	//   pass | layer slot | pipeline | opaque:      submesh | material | depth
+	//                                | translucent: inverted depth | submesh | material
+	// Passes and the layer slots inside a pass are drawn in order. Opaque draws within a slot
+	// are grouped by state and go front to back inside a state; translucent draws go back to
+	// front. Every field must fit its bits. A wider one fails an assert; release builds mask it
+	// so it can at worst sort wrong, never spill into the next field.
+	struct DrawKey
+	{
+		static const int PassBits = 4;
+		static const int SlotBits = 4;
+		static const int PipelineBits = 6;
+		static const int SubmeshBits = 16;
+		static const int MaterialBits = 10;
+		static const int DepthBits = 24;
+
+		static const int DepthShift = 0;
+		static const int MaterialShift = DepthShift + DepthBits;
+		static const int SubmeshShift = MaterialShift + MaterialBits;
+		static const int PipelineShift = SubmeshShift + SubmeshBits;
+		static const int SlotShift = PipelineShift + PipelineBits;
+		static const int PassShift = SlotShift + SlotBits;
+
+		// depth is any non-negative distance from the viewer.
+		static uint64_t Make(uint32_t pass, uint32_t slot, uint32_t pipeline, uint32_t submesh, uint32_t material, float depth, bool translucent = false);
+
+		// Make split in two: the state part can be kept while only the depth changes.
+		static uint64_t State(uint32_t pass, uint32_t slot, uint32_t pipeline, uint32_t submesh, uint32_t material, bool translucent = false);
+		static uint64_t WithDepth(uint64_t state, float depth, bool translucent = false);
+		// The same key drawing another submesh, such as a coarser level of detail.
+		static uint64_t WithSubmesh(uint64_t key, uint32_t submesh, bool translucent = false);
+
+		// Key of the first packet of a pass, or of a layer slot in it.
+		static inline uint64_t Begin(uint32_t pass, uint32_t slot = 0) { return ((uint64_t)pass << PassShift) | ((uint64_t)slot << SlotShift); }
+
+		static inline uint32_t Pass(uint64_t key) { return (uint32_t)(key >> PassShift) & ((1u << PassBits) - 1); }
+		static inline uint32_t Slot(uint64_t key) { return (uint32_t)(key >> SlotShift) & ((1u << SlotBits) - 1); }
+		static inline uint32_t Pipeline(uint64_t key) { return (uint32_t)(key >> PipelineShift) & ((1u << PipelineBits) - 1); }
+
+	};
+
+	// Stable LSD radix sort of draw packets on their keys, 8 bits per pass. Bytes that are the
+	// same in every key are skipped. Large batches are split across the threads of a job
+	// system; each pass histograms the chunks in parallel and then scatters them in parallel.
+	class DrawPacketSorter
+	{
+	public:
+		// Below this many packets the calling thread sorts alone.
+		static const size_t ParallelThreshold = 16 * 1024;
+
+		explicit DrawPacketSorter(JobSystem& jobs);
+
+		void Sort(std::vector<DrawPacket>& packets);
+
+	private:
+		void Histogram(unsigned part);
+		void Scatter(unsigned part);
+
+	private:
+		JobSystem& mJobs;
+		std::vector<DrawPacket> mScratch;
+
+		// Per part byte counts, turned into scatter offsets between the two jobs.
+		std::vector<std::array<uint32_t, 256>> mCounts;
+
+		const DrawPacket* mSource = nullptr;
+		DrawPacket* mDestination = nullptr;
+		size_t mCount = 0;
+		unsigned mPartCount = 1;
+		int mShift = 0;
+	};
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include <memory>
+#include <vector>
+#include "D3D12UploadPageSource.h"
+#include "IndirectDraw.h"
+#include "LinearUploadAllocator.h"
 #include "UploadBuffer.h"
 #include "Util.h"
 
@@ -87,15 +91,20 @@ namespace DX12Lib
 	class FrameResource
 	{
 	public:
-		FrameResource(ID3D12Device* device, UINT passCount, UINT maxInstanceCount, UINT skinnedObjectCount, UINT materialCount)
+		FrameResource(ID3D12Device* device, UINT maxActorCount, UINT maxInstanceCount, UINT materialCount)
 		{
 			ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&CmdListAlloc)));
 
-			PassCB = std::make_unique<UploadBuffer<PassConstant>>(device, passCount, true);
-			SsaoCB = std::make_unique<UploadBuffer<SsaoConstant>>(device, 1, true);
-			SkinnedCB = std::make_unique<UploadBuffer<SkinnedConstant>>(device, skinnedObjectCount, true);
+			Uploads = std::make_unique<LinearUploadAllocator>(std::make_unique<D3D12UploadPageSource>(device));
 
-			InstanceBuffer = std::make_unique<UploadBuffer<InstanceData>>(device, maxInstanceCount, false);
+			// One slot per actor handle index, rewritten only when the actor changes.
+			InstanceBuffer = std::make_unique<UploadBuffer<InstanceData>>(device, maxActorCount, false);
+			// Per instance, the actor slot it reads. The mirror starts with no valid slot, so every
+			// entry is written once.
+			InstanceIndexBuffer = std::make_unique<UploadBuffer<UINT>>(device, maxInstanceCount, false);
+			InstanceIndices.assign(maxInstanceCount, (UINT)-1);
+			// A draw covers at least one instance.
+			IndirectArgsBuffer = std::make_unique<UploadBuffer<IndirectDrawArguments>>(device, maxInstanceCount, false);
 			MaterialBuffer = std::make_unique<UploadBuffer<MaterialData>>(device, materialCount, false);
 		}
 
@@ -105,11 +114,15 @@ namespace DX12Lib
 
 		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
 
-		std::unique_ptr<UploadBuffer<PassConstant>> PassCB = nullptr;
-		std::unique_ptr<UploadBuffer<SsaoConstant>> SsaoCB = nullptr;
-		std::unique_ptr<UploadBuffer<SkinnedConstant>> SkinnedCB = nullptr;
+		// Data written anew every frame, such as pass, SSAO and skinned constants. Reset once
+		// the fence shows the GPU is done with this frame resource.
+		std::unique_ptr<LinearUploadAllocator> Uploads = nullptr;
 
 		std::unique_ptr<UploadBuffer<InstanceData>> InstanceBuffer = nullptr;
+		std::unique_ptr<UploadBuffer<UINT>> InstanceIndexBuffer = nullptr;
+		// What InstanceIndexBuffer holds, so unchanged entries aren't read back or written again.
+		std::vector<UINT> InstanceIndices;
+		std::unique_ptr<UploadBuffer<IndirectDrawArguments>> IndirectArgsBuffer = nullptr;
 		std::unique_ptr<UploadBuffer<MaterialData>> MaterialBuffer = nullptr;
 
 		UINT64 Fence = 0;
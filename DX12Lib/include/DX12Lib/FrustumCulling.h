@@ -0,0 +1,97 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <DirectXCollision.h>
+
+namespace DX12Lib
+{
+	// Six culling planes in SoA form. Normals point out of the volume, so a point p is
+	// outside a plane when dot(N, p) + D > 0.
+	struct FrustumPlanes
+	{
+		static const int PlaneCount = 6;
+
+		float NormalX[PlaneCount];
+		float NormalY[PlaneCount];
+		float NormalZ[PlaneCount];
+		float Distance[PlaneCount];
+
+		static FrustumPlanes FromFrustum(const DirectX::BoundingFrustum& frustum);
+
+		// Works for both perspective and orthographic projections.
+		static FrustumPlanes FromViewProj(DirectX::FXMMATRIX viewProj);
+
+		// The six faces of an axis aligned box.
+		static FrustumPlanes FromBox(const DirectX::BoundingBox& box);
+	};
+
+	static const int MaxCullViews = 32;
+
+	// World space boxes in SoA form. Storage is padded to a multiple of
+	// BoundsSoA::Alignment so the kernels can always read full batches.
+	class BoundsSoA
+	{
+	public:
+		static const size_t Alignment = 8;
+
+		void Clear();
+		void Reserve(size_t count);
+		void Push(const DirectX::BoundingBox& box);
+
+		inline size_t Size() const { return mSize; }
+		inline size_t PaddedSize() const { return CenterX.size(); }
+
+		std::vector<float> CenterX, CenterY, CenterZ;
+		std::vector<float> ExtentX, ExtentY, ExtentZ;
+
+	private:
+		size_t mSize = 0;
+	};
+
+	// Tests every box against the planes and sets bit (i % 32) of visibleMask[i / 32] for
+	// each box that is not fully outside any plane. visibleMask must hold
+	// CullMaskWordCount(bounds.Size()) words.
+	//
+	// This is the usual conservative plane test: it never rejects a box that
+	// BoundingFrustum::Contains reports as intersecting, but may keep boxes near the
+	// frustum edges that the exact test would reject.
+	void CullBoxes(const FrustumPlanes& planes, const BoundsSoA& bounds, uint32_t* visibleMask);
+
+	// Tests every box against up to MaxCullViews plane sets in a single pass over the bounds.
+	// Bit v of viewMasks[i] is set when box i is visible in views[v]. viewMasks must hold
+	// bounds.Size() entries.
+	void CullBoxesMultiView(const FrustumPlanes* views, int viewCount, const BoundsSoA& bounds, uint32_t* viewMasks);
+
+	// The six 90-degree frustums of a cube map around origin share their side planes (x = +-y,
+	// x = +-z, y = +-z), so one pass over those diagonals classifies each box against every face.
+	// Bit f of faceMasks[i] is set when box i may be visible in face f, in CubeMapFace order
+	// (+X, -X, +Y, -Y, +Z, -Z). The result matches testing each face frustum separately.
+	void CullBoxesCubeFaces(const DirectX::XMFLOAT3& origin, float nearZ, float farZ, const BoundsSoA& bounds, uint8_t* faceMasks);
+
+	// Reference path, also used for hardware without SIMD support.
+	void CullBoxesScalar(const FrustumPlanes& planes, const BoundsSoA& bounds, uint32_t* visibleMask);
+
+	// Exact classification of a single box against the planes, used for BVH nodes.
+	inline DirectX::ContainmentType ClassifyBox(const FrustumPlanes& planes, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents)
+	{
+		bool inside = true;
+		for (int p = 0; p < FrustumPlanes::PlaneCount; ++p)
+		{
+			float dist = planes.NormalX[p] * center.x + planes.NormalY[p] * center.y + planes.NormalZ[p] * center.z + planes.Distance[p];
+			float radius = fabsf(planes.NormalX[p]) * extents.x + fabsf(planes.NormalY[p]) * extents.y + fabsf(planes.NormalZ[p]) * extents.z;
+
+			if (dist > radius)
+				return DirectX::DISJOINT;
+
+			if (dist > -radius)
+				inside = false;
+		}
+
+		return inside ? DirectX::CONTAINS : DirectX::INTERSECTS;
+	}
+
+	inline size_t CullMaskWordCount(size_t boxCount) { return (boxCount + 31) / 32; }
+
+	inline bool IsBitSet(const uint32_t* mask, size_t index) { return (mask[index / 32] >> (index % 32)) & 1u; }
+}
@@ -8,6 +8,21 @@
 #include "CubeRenderTarget.h"
 #include "ShadowMap.h"
 #include "Ssao.h"
+#include "JobSystem.h"
+#include "SceneBVH.h"
+#include "FrustumCulling.h"
+#include "ShadowCasterCulling.h"
+#include "OcclusionCuller.h"
+#include "VisibilityCache.h"
+#include "RayQuery.h"
+#include "DrawList.h"
+#include "D3D12CommandRecorder.h"
+#include "IndirectDraw.h"
+#include "TransformHierarchy.h"
+#include "LodSelection.h"
+#include "Hlod.h"
+#include "Pvs.h"
+#include "WorldStreamer.h"
 
 namespace DX12Lib
 {
@@ -18,6 +33,9 @@ namespace DX12Lib
 		~Game();
 		bool Init() override;
 
+		// Bakes the PVS of the static scene and writes it over assets/scene.pvs. Call after Init.
+		bool BakePvs();
+
 	private:
 		virtual void Update(const Timer& timer) override;
 		virtual void Render(const Timer& timer) override;
@@ -37,9 +55,16 @@ namespace DX12Lib
 		void InitMaterials();
 		void InitMeshes();
 		void InitActors();
+		void InitHlods();
 		void InitRootSignature();
+		void InitCommandSignature();
 		void InitPSOs();
 		void InitFrameResources();
+		void InitSceneBVH();
+		// Loads the baked PVS; a missing or stale file leaves the scene without one.
+		void InitPvs();
+		void InitStreaming();
+		void InitDrawPasses();
 
 	private:
 		void InitSkullMesh();
@@ -50,8 +75,25 @@ namespace DX12Lib
 
 		void OnInput(const Timer& timer);
 		void Tick(const Timer& timer);
+		void AttachActor(Actor* actor, uint32_t node);
+		void UpdateTransforms();
+		void UpdateActorBound(Actor* actor);
+		void UpdateHlods();
+		void UpdateStreaming();
+		// Opaque actors that are neither skinned, hidden nor attached to a transform node.
+		std::vector<Actor*> GetStaticActors() const;
+		bool ResolveRayTarget(void* userData, RayTarget& target) const;
+		// The static actors in PVS target order, filling mPvsTargets on the way.
+		std::vector<PvsTarget> InitPvsTargets();
+		PvsBakeSettings GetPvsBakeSettings() const;
 
+		void UpdateVisibility(const Timer& timer);
+		void CullOccludedActors();
 		void UpdateInstanceBuffer(const Timer& timer);
+		void BuildDrawPackets();
+		void UploadDirtyInstances(UploadBuffer<InstanceData>* instanceBuffer);
+		void BuildDrawBatches(FrameResource* frameResource);
+		void BuildIndirectDraws(FrameResource* frameResource);
 		void UpdateMaterialBuffer(const Timer& timer);
 		void UpdateShadowTransform(const Timer& timer);
 		void UpdateMainPassCB(const Timer& timer);
@@ -61,7 +103,8 @@ namespace DX12Lib
 		void UpdateSsaoPassCB(const Timer& timer);
 		void UpdateSkinnedCBs(const Timer& timer);
 
-		void RenderActors(ID3D12GraphicsCommandList* cmdList, const FrameResource* frameResource, const std::vector<Actor*>& actors);
+		// Draws the sorted packets of one pass, from the first to the last layer slot.
+		void SubmitDrawPackets(CommandRecorder& recorder, const FrameResource* frameResource, UINT pass, UINT firstSlot = 0, UINT lastSlot = DrawList::MaxSlots - 1, ID3D12PipelineState* pipelineOverride = nullptr);
 		void RenderSceneToCubeMap();
 		void RenderSceneToShadowMap();
 		void RenderSceneToBackbuffer();
@@ -71,8 +114,65 @@ namespace DX12Lib
 		void Pick(int screenX, int screenY);
 
 	private:
+		// Shared by everything below that splits work across threads, so it goes first.
+		JobSystem mJobs;
+
 		AssetManager mAssetManager;
 		Actor* mPickedActor = nullptr;
+		// Actors attached to a node get its world matrix whenever it changes.
+		TransformHierarchy mTransforms;
+		std::vector<std::vector<Actor*>> mNodeActors;
+		// The car orbits the origin by turning this node every tick.
+		uint32_t mCarPivotNode = TransformHierarchy::NullNode;
+
+		// Static opaque actors merged per cluster into one proxy actor, which replaces them
+		// while the camera is far from the whole cluster.
+		HlodSwitch mHlodSwitch;
+		std::vector<Actor*> mHlodProxies;
+		std::vector<std::vector<Actor*>> mHlodMembers;
+
+		// Static actors the camera's PVS cell cannot see are dropped from the main view.
+		// mPvsTargets maps an actor handle slot to its PVS target, -1 if it has none.
+		PvsData mPvs;
+		std::vector<int> mPvsTargets;
+		int mPvsCell = -1;
+		std::vector<uint8_t> mPvsBits;
+
+		// Cells of the world file around the camera, with the actors created for each resident
+		// cell. Records name their assets by hash, resolved through the maps below.
+		WorldStreamer mWorldStreamer;
+		std::vector<std::vector<Actor*>> mStreamedActors;
+		std::unordered_map<uint64_t, MeshGroup*> mStreamedGroups;
+		std::unordered_map<uint64_t, std::wstring> mStreamedDrawArgs;
+		std::unordered_map<uint64_t, int> mStreamedMaterials;
+
+		SceneBVH mSceneBVH;
+		std::unique_ptr<RayQuery> mRayQuery;
+
+		// Every pass that draws the scene culls against its own view. The BVH and the batch test
+		// only see the plane views; CV_Cube bounds all cube faces and the face bits are filled
+		// in afterwards by a single classification.
+		enum CullView : UINT
+		{
+			CV_Main = 0,
+			CV_Shadow = 1,
+			CV_Cube = 2,
+			CV_PlaneViewCount = 3,
+			CV_CubeFace0 = 3,
+			CV_Count = 9,
+		};
+
+		std::array<FrustumPlanes, CV_PlaneViewCount> mCullViews;
+		VisibilityCache mVisibilityCache;
+		size_t mCaptionVisibleCount = SIZE_MAX;
+		int mCaptionSkippedPercent = -1;
+
+		// Actors inside the cube map bound, classified into faces.
+		std::vector<ActorView*> mCubeActors;
+		BoundsSoA mCubeBounds;
+		std::vector<uint8_t> mCubeFaceMasks;
+
+		OcclusionCuller mOcclusionCuller;
 
 		std::wstring mSkinnedModelFilename = L"assets/models/soldier.m3d";
 		std::unique_ptr<SkinnedMesh> mSkinnedModelInst;
@@ -95,12 +195,71 @@ namespace DX12Lib
 			RSP_ShadowMap = 5,
 			RSP_SsaoMap = 6,
 			RSP_AllTextures = 7,
+			RSP_InstanceIndices = 8,
 		};
 
 		Microsoft::WRL::ComPtr<ID3D12RootSignature> mPostProcessRootSignature;
 		Microsoft::WRL::ComPtr<ID3D12RootSignature> mSsaoRootSignature;
 
-		std::unordered_map<std::wstring, Microsoft::WRL::ComPtr<ID3D12PipelineState>> mPSOs;
+		// Pipeline states are looked up per pass, so they live in a table indexed by id.
+		enum PipelineStateId : UINT
+		{
+			PSO_Opaque = 0,
+			PSO_SkinnedOpaque = 1,
+			PSO_Sky = 2,
+			PSO_Shadow = 3,
+			PSO_Debug = 4,
+			PSO_DrawNormals = 5,
+			PSO_Ssao = 6,
+			PSO_SsaoBlur = 7,
+			PSO_Count = 8,
+		};
+
+		std::array<Microsoft::WRL::ComPtr<ID3D12PipelineState>, PSO_Count> mPSOs;
+
+		// Layer slots of the main pass, in draw order.
+		enum MainPassSlot : UINT
+		{
+			MainSlot_Reflectors = 0,
+			MainSlot_Opaque = 1,
+			MainSlot_SkinnedOpaque = 2,
+			MainSlot_Debug = 3,
+			MainSlot_Sky = 4,
+		};
+
+		// Culling, cached draws, sorted packets and batches; the same code the benchmark runs.
+		DrawList mDrawList;
+
+		// Bytes written into the upload buffers of the current frame resource.
+		struct UploadStats
+		{
+			size_t InstanceBytes = 0;
+			size_t IndexBytes = 0;
+			size_t MaterialBytes = 0;
+		};
+		UploadStats mUploadStats;
+		size_t mCaptionUploadedKB = SIZE_MAX;
+
+		// Constants of this frame in the frame resource's upload allocator: main, shadow and
+		// the six cube faces.
+		D3D12_GPU_VIRTUAL_ADDRESS mPassCBAddresses[2 + 6] = {};
+		D3D12_GPU_VIRTUAL_ADDRESS mSsaoCBAddress = 0;
+		// Indexed by SkinnedCBIndex in constant buffer sized steps.
+		D3D12_GPU_VIRTUAL_ADDRESS mSkinnedCBAddress = 0;
+
+		// Screen size LOD: cull size and hysteresis per layer, bias per pass so the shadow and
+		// cube passes can go coarser than the main view.
+		LodSelector mLodSelector;
+		float mLodBias[CV_Count];
+		D3D12CommandRecorder mCommandRecorder;
+
+		// Draw batches go out as one ExecuteIndirect per pipeline bucket instead of one draw each.
+		bool mIndirectDraws = true;
+		Microsoft::WRL::ComPtr<ID3D12CommandSignature> mDrawCommandSignature;
+		std::vector<IndirectDrawInput> mIndirectDrawInputs;
+		IndirectDrawBuilder mIndirectDrawBuilder;
+		// SRV heap slot of the sky cube map, resolved once the heap is built.
+		UINT mSkyTexSrvIndex = 0;
 
 		const float mClearColor[4] = { 0.7f, 0.7f, 0.7f, 1.0f };
 
@@ -128,6 +287,7 @@ namespace DX12Lib
 		DirectX::XMFLOAT3 mLightPosW;
 		float mLightNearZ, mLightFarZ;
 		DirectX::XMFLOAT4X4 mLightView, mLightProj;
+		DirectX::BoundingBox mLightBound;
 	};
 }
  
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <DirectXCollision.h>
+#include "MeshData.h"
+
+namespace DX12Lib
+{
+	// One static actor as the HLOD builder sees it: a triangle soup in local space, three
+	// positions per triangle, the same layout TriangleBVH keeps.
+	struct HlodSource
+	{
+		const DirectX::XMFLOAT3* TriangleVertices = nullptr;
+		uint32_t TriangleCount = 0;
+		DirectX::XMFLOAT4X4 World;
+		DirectX::BoundingBox Bound;
+		uint32_t Material = 0;
+	};
+
+	struct HlodSettings
+	{
+		// Sources are grouped by the grid cell their bound center falls in.
+		float ClusterCellSize = 40.0f;
+		// A proxy for fewer sources saves no draws.
+		uint32_t MinClusterSize = 2;
+		// Vertices closer than this are welded by the simplification.
+		float WeldCellSize = 0.5f;
+		// World units per texture repeat of the planar mapping on the proxy.
+		float TexCoordScale = 0.25f;
+		// The proxy is drawn once the camera is this far from the cluster bound.
+		float SwitchDistance = 80.0f;
+	};
+
+	struct HlodCluster
+	{
+		// Indices into the source list.
+		std::vector<uint32_t> Members;
+		DirectX::BoundingBox Bound;
+		// Material of the member with the most triangles, used for the whole proxy.
+		uint32_t Material = 0;
+		float SwitchDistance = 0.0f;
+		// Merged and simplified in world space.
+		MeshData Proxy;
+	};
+
+	// Offline part of hierarchical LOD: clusters static actors on a grid, merges every cluster
+	// into one mesh and simplifies it by vertex clustering. No GPU work, the caller uploads the
+	// proxies into a mesh group of its own.
+	class HlodBuilder
+	{
+	public:
+		static std::vector<HlodCluster> Build(const std::vector<HlodSource>& sources, const HlodSettings& settings);
+
+		static MeshData Merge(const std::vector<HlodSource>& sources, const std::vector<uint32_t>& members);
+		// Welds vertices on a grid of cellSize, drops collapsed triangles and recomputes normals.
+		static MeshData Simplify(const MeshData& mesh, float cellSize, float texCoordScale);
+	};
+
+	// Runtime part: per cluster, whether the proxy stands in for the members this frame.
+	class HlodSwitch
+	{
+	public:
+		void Clear();
+		uint32_t AddCluster(const DirectX::BoundingBox& bound, float switchDistance);
+
+		// hysteresis is the fraction of the switch distance the camera has to move past it
+		// before the cluster flips back.
+		void Update(const DirectX::XMFLOAT3& eye, float hysteresis = 0.1f);
+
+		inline bool IsProxyActive(uint32_t cluster) const { return mProxyActive[cluster] != 0; }
+		inline size_t Size() const { return mBounds.size(); }
+
+		// Clusters that flipped in the last Update.
+		inline const std::vector<uint32_t>& GetChangedClusters() const { return mChanged; }
+
+	private:
+		std::vector<DirectX::BoundingBox> mBounds;
+		std::vector<float> mSwitchDistances;
+		std::vector<uint8_t> mProxyActive;
+		std::vector<uint32_t> mChanged;
+	};
+}
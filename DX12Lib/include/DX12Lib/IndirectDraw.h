@@ -0,0 +1,129 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "CommandRecorder.h"
+#include "JobSystem.h"
+
+namespace DX12Lib
+{
+	// The fields of D3D12_DRAW_INDEXED_ARGUMENTS.
+	struct IndirectDrawIndexedArguments
+	{
+		uint32_t IndexCountPerInstance;
+		uint32_t InstanceCount;
+		uint32_t StartIndexLocation;
+		int32_t BaseVertexLocation;
+		uint32_t StartInstanceLocation;
+	};
+
+	// One record of the indirect argument buffer, in the order of GetArguments. The bindings
+	// have the layout of the matching D3D12 views.
+	struct IndirectDrawArguments
+	{
+		VertexBufferBinding VertexBuffer;
+		IndexBufferBinding IndexBuffer;
+		GpuVirtualAddress InstanceIndices;
+		GpuVirtualAddress SkinnedCB;
+		IndirectDrawIndexedArguments Draw;
+		uint32_t Padding;
+	};
+
+	// A command signature argument; the backend turns them into D3D12_INDIRECT_ARGUMENT_DESC.
+	enum IndirectArgumentType : uint32_t
+	{
+		Indirect_Argument_VertexBuffer,
+		Indirect_Argument_IndexBuffer,
+		Indirect_Argument_ShaderResourceView,
+		Indirect_Argument_ConstantBufferView,
+		Indirect_Argument_DrawIndexed,
+	};
+
+	struct IndirectArgument
+	{
+		IndirectArgumentType Type;
+		// Vertex buffer slot or root parameter, unused for the rest.
+		uint32_t Index;
+	};
+
+	// Everything a draw needs, before the GPU addresses of the frame are known.
+	struct IndirectDrawInput
+	{
+		// Adjacent draws with equal keys, pipelines and topologies share one ExecuteIndirect.
+		// Keys must not decrease along the input.
+		uint64_t BucketKey;
+		uint32_t Pipeline;
+		PrimitiveTopology Topology;
+
+		VertexBufferBinding VertexBuffer;
+		IndexBufferBinding IndexBuffer;
+		uint32_t IndexCount;
+		uint32_t StartIndexLocation;
+		int32_t BaseVertexLocation;
+		uint32_t InstanceCount;
+		uint32_t InstanceOffset;
+
+		// NoSkinnedCB binds a null skinned constant buffer.
+		uint32_t SkinnedCBIndex;
+	};
+
+	// Where the per draw root views of a frame point.
+	struct IndirectDrawAddresses
+	{
+		GpuVirtualAddress InstanceIndices = 0;
+		uint32_t InstanceIndexStride = 0;
+		GpuVirtualAddress SkinnedCB = 0;
+		uint32_t SkinnedCBStride = 0;
+	};
+
+	// Draws sharing pipeline and topology, FirstDraw and DrawCount index the argument buffer.
+	struct IndirectBucket
+	{
+		uint64_t Key;
+		uint32_t Pipeline;
+		PrimitiveTopology Topology;
+		uint32_t FirstDraw;
+		uint32_t DrawCount;
+	};
+
+	// Packs draws into indirect argument records and groups them into buckets. Large batches
+	// are packed across the threads of a job system; nothing here touches the device, so the
+	// output can be checked on the CPU.
+	class IndirectDrawBuilder
+	{
+	public:
+		static const uint32_t ArgumentCount = 5;
+		// Byte stride of the command signature, one IndirectDrawArguments.
+		static const uint32_t ArgumentStride = 72;
+		static const uint32_t NoSkinnedCB = UINT32_MAX;
+
+		// Below this many draws the calling thread packs alone.
+		static const size_t ParallelThreshold = 4096;
+
+		// Command signature layout matching IndirectDrawArguments.
+		static std::array<IndirectArgument, ArgumentCount> GetArguments(uint32_t instanceIndicesParameter, uint32_t skinnedCBParameter);
+
+		explicit IndirectDrawBuilder(JobSystem& jobs);
+
+		// arguments needs room for inputs.size() records and may be mapped upload memory.
+		void Build(const std::vector<IndirectDrawInput>& inputs, const IndirectDrawAddresses& addresses, IndirectDrawArguments* arguments);
+
+		inline const std::vector<IndirectBucket>& GetBuckets() const { return mBuckets; }
+
+	private:
+		void BuildBuckets();
+		void Pack(unsigned part);
+
+	private:
+		JobSystem& mJobs;
+		std::vector<IndirectBucket> mBuckets;
+
+		const IndirectDrawInput* mInputs = nullptr;
+		size_t mCount = 0;
+		IndirectDrawAddresses mAddresses;
+		IndirectDrawArguments* mArguments = nullptr;
+		unsigned mPartCount = 1;
+	};
+
+	static_assert(sizeof(IndirectDrawArguments) == IndirectDrawBuilder::ArgumentStride, "The command signature stride has to match the argument record");
+}
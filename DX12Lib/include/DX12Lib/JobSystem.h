@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DX12Lib
+{
+	// One pool of persistent worker threads shared by every module that splits work across
+	// threads. ParallelFor hands out the parts of a job to the workers and to the calling
+	// thread, which always takes part and then sleeps until the parts it did not run are done.
+	// Run and Async queue single tasks, such as file reads, on the same workers.
+	class JobSystem
+	{
+	public:
+		// Worker threads besides the calling thread: one per remaining hardware thread.
+		static unsigned DefaultWorkerCount();
+
+		explicit JobSystem(unsigned workerCount = DefaultWorkerCount());
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		// Runs whatever is still queued, then joins the workers.
+		~JobSystem();
+
+		inline unsigned GetWorkerCount() const { return (unsigned)mWorkers.size(); }
+		// The calling thread included; a sensible part count for evenly sized work.
+		inline unsigned GetThreadCount() const { return GetWorkerCount() + 1; }
+
+		// Calls work(part) once for every part in [0, partCount) and returns when all of them
+		// are done. Safe to call from several threads at once and from inside a job. Nothing is
+		// allocated once the pool has seen as many jobs in flight as it ever will.
+		template<typename Work>
+		void ParallelFor(unsigned partCount, const Work& work)
+		{
+			if (partCount == 0)
+				return;
+
+			if (partCount == 1 || mWorkers.empty())
+			{
+				for (unsigned part = 0; part < partCount; ++part)
+					work(part);
+				return;
+			}
+
+			Dispatch(partCount, [](const void* context, unsigned part) { (*static_cast<const Work*>(context))(part); }, &work);
+		}
+
+		// Queues a task and returns at once.
+		void Run(std::function<void()> task);
+
+		// Queues a task; the future holds its result or exception.
+		template<typename Task>
+		auto Async(Task&& task) -> std::future<decltype(task())>
+		{
+			using Result = decltype(task());
+			auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+			std::future<Result> result = packaged->get_future();
+			Run([packaged]() { (*packaged)(); });
+			return result;
+		}
+
+	private:
+		using Invoke = void (*)(const void* context, unsigned part);
+
+		struct Job
+		{
+			Invoke Function = nullptr;
+			const void* Context = nullptr;
+			unsigned PartCount = 0;
+			std::atomic<unsigned> NextPart;
+			std::atomic<unsigned> PartsDone;
+			// The caller and every queued helper, guarded by mMutex. Back to the free list at zero.
+			unsigned References = 0;
+		};
+
+		// A job helper or a single task, whichever is set.
+		struct Entry
+		{
+			Job* Helper = nullptr;
+			std::function<void()> Task;
+		};
+
+		void Dispatch(unsigned partCount, Invoke function, const void* context);
+		void RunParts(Job& job);
+		void Release(Job* job);
+		void WorkerLoop();
+
+	private:
+		std::vector<std::thread> mWorkers;
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::condition_variable mJobDone;
+		std::deque<Entry> mQueue;
+		bool mQuit = false;
+
+		std::vector<std::unique_ptr<Job>> mJobs;
+		std::vector<Job*> mFreeJobs;
+	};
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "CommandRecorder.h"
+
+namespace DX12Lib
+{
+	// A piece of upload memory: written through Data, bound through GpuAddress.
+	struct UploadAllocation
+	{
+		uint8_t* Data = nullptr;
+		GpuVirtualAddress GpuAddress = 0;
+
+		template<typename T>
+		inline T* As() const { return reinterpret_cast<T*>(Data); }
+	};
+
+	// Where LinearUploadAllocator gets its pages from. The backend maps a buffer of upload
+	// memory; the source owns it and keeps it mapped until the source is destroyed.
+	class UploadPageSource
+	{
+	public:
+		virtual ~UploadPageSource() = default;
+
+		// At least byteSize bytes, with Data and GpuAddress both Alignment aligned.
+		virtual UploadAllocation CreatePage(size_t byteSize) = 0;
+	};
+
+	// Transient upload memory of one frame resource. Allocations are bumped off persistently
+	// mapped pages without taking a lock; when a page runs out the next one is chained on, so
+	// there is no fixed cap per kind of data. Pages are kept and handed out again after Reset.
+	class LinearUploadAllocator
+	{
+	public:
+		// Constant buffer views need this (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT), so
+		// every allocation gets it.
+		static const size_t Alignment = 256;
+		static const size_t DefaultPageSize = 256 * 1024;
+
+		explicit LinearUploadAllocator(std::unique_ptr<UploadPageSource> pages, size_t pageSize = DefaultPageSize);
+		LinearUploadAllocator(const LinearUploadAllocator&) = delete;
+		LinearUploadAllocator& operator=(const LinearUploadAllocator&) = delete;
+		~LinearUploadAllocator() = default;
+
+		// Safe to call from several threads at once. Larger than a page gets a page of its own.
+		UploadAllocation Allocate(size_t byteSize);
+
+		// Copies data into a new constant buffer and returns its address.
+		template<typename T>
+		GpuVirtualAddress UploadConstants(const T& data)
+		{
+			UploadAllocation allocation = Allocate(sizeof(T));
+			memcpy(allocation.Data, &data, sizeof(T));
+			return allocation.GpuAddress;
+		}
+
+		// Gives back every allocation. Only once the GPU is done with them and nothing allocates.
+		void Reset();
+
+		// Bytes taken since the last Reset, alignment and unused page tails included. Both take the
+		// page lock, so they may be called while other threads still allocate.
+		size_t GetAllocatedBytes() const;
+		size_t GetPageCount() const;
+
+	private:
+		struct Page
+		{
+			uint8_t* Data = nullptr;
+			GpuVirtualAddress GpuAddress = 0;
+			size_t Size = 0;
+			// Runs past Size once the page is full.
+			std::atomic<size_t> Offset;
+		};
+
+		void NextPage(Page* full, size_t byteSize);
+
+	private:
+		std::unique_ptr<UploadPageSource> mSource;
+		size_t mPageSize;
+
+		std::atomic<Page*> mCurrent;
+		// Pages before mPagesInUse have been handed out since the last Reset.
+		mutable std::mutex mMutex;
+		std::vector<std::unique_ptr<Page>> mPages;
+		size_t mPagesInUse = 0;
+	};
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <DirectXCollision.h>
+
+namespace DX12Lib
+{
+	// How a view maps world size to pixels.
+	struct LodView
+	{
+		DirectX::XMFLOAT3 Eye = { 0.0f, 0.0f, 0.0f };
+		// Perspective: viewport height / (2 tan(fovY / 2)). Orthographic: viewport height / view height.
+		float PixelScale = 1.0f;
+		bool Orthographic = false;
+		// Scales the projected size before selection; below 1 picks coarser levels for this view.
+		float Bias = 1.0f;
+
+		// projScaleY is element (1, 1) of the projection matrix, 1 / tan(fovY / 2).
+		static LodView Perspective(const DirectX::XMFLOAT3& eye, float projScaleY, float viewportHeight, float bias = 1.0f);
+		static LodView Ortho(float viewHeight, float viewportHeight, float bias = 1.0f);
+	};
+
+	struct LodLayerSettings
+	{
+		// Objects whose projected radius falls below this many pixels are not drawn at all.
+		float CullPixelRadius = 0.0f;
+		// Fraction a projected radius has to move past a boundary before the level changes.
+		float Hysteresis = 0.1f;
+	};
+
+	// Screen size based level of detail selection, pure math with no scene dependency.
+	class LodSelector
+	{
+	public:
+		static const int MaxLayers = 32;
+
+		// Radius in pixels of the bounding sphere of box, FLT_MAX when the eye is inside it.
+		static float ProjectedPixelRadius(const LodView& view, const DirectX::BoundingBox& box);
+
+		// switchPixelRadii holds lodCount - 1 descending boundaries: level i is drawn down to
+		// switchPixelRadii[i], the last level down to the layer's cull radius. previousLod is
+		// last frame's pick (-1 if culled) and only feeds the hysteresis. Returns -1 to cull.
+		static int Select(float pixelRadius, const float* switchPixelRadii, int lodCount, const LodLayerSettings& settings, int previousLod);
+
+		// Settings for every layer bit set in layerMask.
+		void SetLayerSettings(uint32_t layerMask, const LodLayerSettings& settings);
+		// An actor's layer uses the settings of its lowest set bit.
+		const LodLayerSettings& GetLayerSettings(uint32_t layer) const;
+
+	private:
+		LodLayerSettings mLayers[MaxLayers];
+		LodLayerSettings mNoLayer;
+	};
+}
@@ -5,39 +5,14 @@
 #include <wrl.h>
 #include <string>
 #include <unordered_map>
+#include <memory>
 #include <DirectXCollision.h>
+#include "CommandRecorder.h"
+#include "MeshData.h"
+#include "Submesh.h"
 
 namespace DX12Lib
 {
-	struct Vertex
-	{
-		//Vertex() = default;
-		Vertex() {}
-		Vertex(
-			const DirectX::XMFLOAT3& p,
-			const DirectX::XMFLOAT3& n,
-			const DirectX::XMFLOAT3& t,
-			const DirectX::XMFLOAT2& uv) :
-			Position(p),
-			Normal(n),
-			TexCoord(uv),
-			TangentU(t) {}
-		Vertex(
-			float px, float py, float pz,
-			float nx, float ny, float nz,
-			float tx, float ty, float tz,
-			float u, float v) :
-			Position(px, py, pz),
-			Normal(nx, ny, nz),
-			TexCoord(u, v),
-			TangentU(tx, ty, tz) {}
-
-		DirectX::XMFLOAT3 Position;
-		DirectX::XMFLOAT3 Normal;
-		DirectX::XMFLOAT2 TexCoord;
-		DirectX::XMFLOAT3 TangentU;
-	};
-
 	struct SkinnedVertex
 	{
 		DirectX::XMFLOAT3 Position;
@@ -48,70 +23,14 @@ namespace DX12Lib
 		BYTE BoneIndices[4];
 	};
 
-	struct MeshData
-	{
-		std::vector<Vertex> Vertices;
-		std::vector<uint32_t> Indices32;
-
-		std::vector<uint16_t>& GetIndices16()
-		{
-			if (mIndices16.empty())
-			{
-				mIndices16.resize(Indices32.size());
-				for (size_t i = 0; i < Indices32.size(); ++i)
-					mIndices16[i] = static_cast<uint16_t>(Indices32[i]);
-			}
-
-			return mIndices16;
-		}
-	private:
-		std::vector<uint16_t> mIndices16;
-	};
-
-
-	class MeshGenerator
-	{
-	public:
-		static MeshData Box(float width, float height, float depth, uint32_t numSubdivisions = 0);
-		static MeshData Sphere(float radius, uint32_t sliceCount, uint32_t stackCount);
-		static MeshData Cylinder(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount);
-		static MeshData Grid(float width, float depth, uint32_t m, uint32_t n);
-		static MeshData Quad(float x, float y, float width, float height, float depth);
-
-	private:
-		static void Subdivide(MeshData& meshData);
-		static Vertex MidPoint(const Vertex& v0, const Vertex& v1);
-		static void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount, MeshData& meshData);
-		static void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount, MeshData& meshData);
-	};
-
-	class Mesh
-	{
-	public:
-		Mesh(const std::wstring& name, const MeshData& data)
-			: Name(name)
-			, Data(data)
-		{
-		}
-
-		std::wstring Name;
-		MeshData Data;
-	};
-
-	struct Submesh
-	{
-		UINT IndexCount = 0;
-		UINT StartIndexLocation = 0;
-		INT BaseVertexLocation = 0;
-		DirectX::BoundingBox Bound;
-	};
-
 	class MeshGroup
 	{
 	public:
 		MeshGroup(const std::wstring& name) : Name(name) {}
 
 		std::wstring Name;
+		// Index in the asset manager's mesh group table.
+		UINT Id = -1;
 
 		Microsoft::WRL::ComPtr<ID3DBlob> VertexBufferCPU = nullptr;
 		Microsoft::WRL::ComPtr<ID3DBlob> IndexBufferCPU = nullptr;
@@ -128,7 +47,7 @@ namespace DX12Lib
 		DXGI_FORMAT IndexFormat = DXGI_FORMAT_R16_UINT;
 		UINT IndexBufferByteSize = 0;
 
-		std::unordered_map<std::wstring, Submesh> DrawArgs;
+		SubmeshMap DrawArgs;
 
 		D3D12_VERTEX_BUFFER_VIEW VertexBufferView() const
 		{
@@ -150,6 +69,20 @@ namespace DX12Lib
 			return ibv;
 		}
 
+		// The views as the command recorder takes them. A group created without GPU buffers
+		// binds address zero, which is enough for recording without a device.
+		VertexBufferBinding VertexBinding() const
+		{
+			GpuVirtualAddress location = VertexBufferGPU ? VertexBufferGPU->GetGPUVirtualAddress() : 0;
+			return { location, VertexBufferByteSize, VertexByteStride };
+		}
+
+		IndexBufferBinding IndexBinding() const
+		{
+			GpuVirtualAddress location = IndexBufferGPU ? IndexBufferGPU->GetGPUVirtualAddress() : 0;
+			return { location, IndexBufferByteSize, (DX12Lib::IndexFormat)IndexFormat };
+		}
+
 		// We can free this memory after we finish upload to the GPU.
 		void DisposeUploaders()
 		{
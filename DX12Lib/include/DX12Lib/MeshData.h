@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+#include "Submesh.h"
+
+namespace DX12Lib
+{
+	struct Vertex
+	{
+		//Vertex() = default;
+		Vertex() {}
+		Vertex(
+			const DirectX::XMFLOAT3& p,
+			const DirectX::XMFLOAT3& n,
+			const DirectX::XMFLOAT3& t,
+			const DirectX::XMFLOAT2& uv) :
+			Position(p),
+			Normal(n),
+			TexCoord(uv),
+			TangentU(t) {}
+		Vertex(
+			float px, float py, float pz,
+			float nx, float ny, float nz,
+			float tx, float ty, float tz,
+			float u, float v) :
+			Position(px, py, pz),
+			Normal(nx, ny, nz),
+			TexCoord(u, v),
+			TangentU(tx, ty, tz) {}
+
+		DirectX::XMFLOAT3 Position;
+		DirectX::XMFLOAT3 Normal;
+		DirectX::XMFLOAT2 TexCoord;
+		DirectX::XMFLOAT3 TangentU;
+	};
+
+	struct MeshData
+	{
+		std::vector<Vertex> Vertices;
+		std::vector<uint32_t> Indices32;
+
+		std::vector<uint16_t>& GetIndices16()
+		{
+			if (mIndices16.empty())
+			{
+				mIndices16.resize(Indices32.size());
+				for (size_t i = 0; i < Indices32.size(); ++i)
+					mIndices16[i] = static_cast<uint16_t>(Indices32[i]);
+			}
+
+			return mIndices16;
+		}
+	private:
+		std::vector<uint16_t> mIndices16;
+	};
+
+	class MeshGenerator
+	{
+	public:
+		static MeshData Box(float width, float height, float depth, uint32_t numSubdivisions = 0);
+		static MeshData Sphere(float radius, uint32_t sliceCount, uint32_t stackCount);
+		static MeshData Cylinder(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount);
+		static MeshData Grid(float width, float depth, uint32_t m, uint32_t n);
+		static MeshData Quad(float x, float y, float width, float height, float depth);
+
+	private:
+		static void Subdivide(MeshData& meshData);
+		static Vertex MidPoint(const Vertex& v0, const Vertex& v1);
+		static void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount, MeshData& meshData);
+		static void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount, MeshData& meshData);
+	};
+
+	class Mesh
+	{
+	public:
+		Mesh(const std::wstring& name, const MeshData& data)
+			: Name(name)
+			, Data(data)
+		{
+		}
+
+		std::wstring Name;
+		MeshData Data;
+	};
+
+	// Places the meshes one after another in a shared vertex and index buffer and adds a
+	// submesh for each, with its bound and collision BVH. Submesh ids are left to the caller.
+	void LayoutSubmeshes(const std::vector<Mesh>& meshes, SubmeshMap& submeshes);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "CommandRecorder.h"
+
+namespace DX12Lib
+{
+	// Keeps every call that gets past the state filter instead of recording it on a GPU list,
+	// so the command stream of a frame can be inspected without a device.
+	class MockCommandRecorder : public CommandRecorder
+	{
+	public:
+		enum CommandType
+		{
+			Command_RootSignature,
+			Command_PipelineState,
+			Command_VertexBuffer,
+			Command_IndexBuffer,
+			Command_PrimitiveTopology,
+			Command_RootShaderResourceView,
+			Command_RootConstantBufferView,
+			Command_DrawIndexedInstanced,
+			Command_ExecuteIndirect,
+			Command_Count,
+		};
+
+		// Only the fields of the command's type are meaningful.
+		struct Command
+		{
+			CommandType Type;
+			// The root signature, pipeline state or command signature.
+			GpuObjectHandle Object;
+			VertexBufferBinding VertexBuffer;
+			IndexBufferBinding IndexBuffer;
+			PrimitiveTopology Topology = Primitive_Topology_Undefined;
+			uint32_t RootParameterIndex = 0;
+			GpuVirtualAddress Address = 0;
+			uint32_t IndexCountPerInstance = 0;
+			uint32_t InstanceCount = 0;
+			uint32_t StartIndexLocation = 0;
+			int32_t BaseVertexLocation = 0;
+			uint32_t StartInstanceLocation = 0;
+			uint32_t MaxCommandCount = 0;
+			GpuObjectHandle ArgumentBuffer;
+			uint64_t ArgumentBufferOffset = 0;
+		};
+
+		// Drops the recorded commands and the shadowed state.
+		void Clear();
+
+		inline const std::vector<Command>& GetCommands() const { return mCommands; }
+		inline uint32_t GetCount(CommandType type) const { return mCounts[type]; }
+
+	protected:
+		void RecordGraphicsRootSignature(GpuObjectHandle rootSignature) override;
+		void RecordPipelineState(GpuObjectHandle pipelineState) override;
+		void RecordVertexBuffer(const VertexBufferBinding& binding) override;
+		void RecordIndexBuffer(const IndexBufferBinding& binding) override;
+		void RecordPrimitiveTopology(PrimitiveTopology topology) override;
+		void RecordGraphicsRootShaderResourceView(uint32_t rootParameterIndex, GpuVirtualAddress address) override;
+		void RecordGraphicsRootConstantBufferView(uint32_t rootParameterIndex, GpuVirtualAddress address) override;
+		void RecordDrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) override;
+		void RecordExecuteIndirect(GpuObjectHandle commandSignature, uint32_t maxCommandCount, GpuObjectHandle argumentBuffer, uint64_t argumentBufferOffset) override;
+
+	private:
+		Command& Push(CommandType type);
+
+	private:
+		std::vector<Command> mCommands;
+		uint32_t mCounts[Command_Count] = {};
+	};
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <DirectXCollision.h>
+#include "JobSystem.h"
+
+namespace DX12Lib
+{
+	// Low resolution software depth buffer for occlusion culling. Occluder triangles are
+	// binned into screen tiles and the tiles are rasterized across the threads of a job system,
+	// then reduced into a max depth pyramid that occludee bounds are tested against. Runs
+	// entirely on the CPU and has no D3D dependency.
+	class OcclusionCuller
+	{
+	public:
+		static const int Width = 256;
+		static const int Height = 144;
+		static const int TileWidth = 32;
+		static const int TileHeight = 16;
+		static const int TilesX = Width / TileWidth;
+		static const int TilesY = Height / TileHeight;
+		static const int TileCount = TilesX * TilesY;
+
+		explicit OcclusionCuller(JobSystem& jobs);
+
+		void BeginFrame(DirectX::FXMMATRIX viewProj);
+
+		// positions points at the position of the first vertex, vertexStride bytes apart.
+		void AddOccluder(const void* positions, uint32_t vertexStride, const uint16_t* indices, uint32_t indexCount, int32_t baseVertex, DirectX::FXMMATRIX world);
+
+		// Unindexed triangle list, three positions per triangle.
+		void AddOccluder(const DirectX::XMFLOAT3* triangleVertices, uint32_t triangleCount, DirectX::FXMMATRIX world);
+
+		// Rasterizes every occluder added since BeginFrame and builds the depth pyramid. Pixel
+		// centers exactly on an edge follow the top-left rule, so they belong to one triangle.
+		void Render();
+
+		// False only if the box is certainly hidden behind the occluders.
+		bool IsVisible(const DirectX::BoundingBox& worldBound) const;
+
+		inline const float* GetDepth() const { return mDepth[0].data(); }
+		inline size_t GetTriangleCount() const { return mTriangles.size(); }
+
+	private:
+		struct ScreenTriangle
+		{
+			float X[3];
+			float Y[3];
+			float Z[3];
+		};
+
+		void AddClippedTriangle(const DirectX::XMFLOAT4& v0, const DirectX::XMFLOAT4& v1, const DirectX::XMFLOAT4& v2);
+		void AddScreenTriangle(const DirectX::XMFLOAT4& v0, const DirectX::XMFLOAT4& v1, const DirectX::XMFLOAT4& v2);
+
+		void RasterizeTile(int tile);
+		void BuildDepthPyramid();
+
+	private:
+		JobSystem& mJobs;
+		DirectX::XMFLOAT4X4 mViewProj;
+
+		std::vector<DirectX::XMFLOAT4> mClipVertices;
+		std::vector<ScreenTriangle> mTriangles;
+		std::vector<uint32_t> mBins[TileCount];
+
+		// Level 0 is the depth buffer, each level above holds the farthest depth of 2x2 texels below.
+		std::vector<std::vector<float>> mDepth;
+		std::vector<int> mLevelWidth;
+		std::vector<int> mLevelHeight;
+	};
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <DirectXCollision.h>
+#include "JobSystem.h"
+#include "RayQuery.h"
+
+namespace DX12Lib
+{
+	// A static actor the PVS tracks. UserData is what the tracer reports for hits on it, Key
+	// identifies it in the baked file across runs.
+	struct PvsTarget
+	{
+		DirectX::BoundingBox Bound;
+		void* UserData = nullptr;
+		uint64_t Key = 0;
+
+		// A key covering everything the bake depends on, so a target that was moved or given
+		// another mesh no longer matches its baked key. The hashes are StringTable::Hash values.
+		static uint64_t MakeKey(uint64_t nameHash, uint64_t meshHash, const DirectX::BoundingBox& bound);
+	};
+
+	struct PvsBakeSettings
+	{
+		// Space the camera can be in, split into cubic cells.
+		DirectX::BoundingBox Region;
+		float CellSize = 4.0f;
+		// Random viewpoints per cell, each casting RaysPerTarget rays at every target bound
+		// that is not yet known to be visible.
+		uint32_t SamplesPerCell = 16;
+		uint32_t RaysPerTarget = 8;
+		uint32_t Seed = 1;
+	};
+
+	// Potentially visible set: for every cell of a grid, which targets can be seen from
+	// anywhere inside it. Cells are stored as zero run length encoded bitsets over the targets.
+	//
+	// File layout, little endian:
+	//   header   magic 'PVS1', version, origin xyz, cell size, dims xyz, target count, data size
+	//   uint64   key per target
+	//   uint32   byte offset per cell into the data, plus the end offset
+	//   uint8    cell data; a zero byte is followed by the count of zero bytes it stands for
+	class PvsData
+	{
+	public:
+		static const uint32_t Magic = 0x31535650;
+		static const uint32_t Version = 1;
+
+		bool Save(const std::string& filename) const;
+		bool Load(const std::string& filename);
+		void Clear();
+
+		// Whether the grid is the one a bake with these settings would produce.
+		bool MatchesGrid(const PvsBakeSettings& settings) const;
+
+		// -1 outside the grid.
+		int FindCell(const DirectX::XMFLOAT3& position) const;
+		// Expands a cell into a bitset with one bit per target.
+		void DecompressCell(uint32_t cell, std::vector<uint8_t>& bits) const;
+
+		static inline bool TestBit(const std::vector<uint8_t>& bits, uint32_t target) { return (bits[target >> 3] >> (target & 7)) & 1; }
+
+		static void Compress(const uint8_t* bits, size_t byteCount, std::vector<uint8_t>& data);
+
+		inline uint32_t GetCellCount() const { return mDims[0] * mDims[1] * mDims[2]; }
+		inline uint32_t GetTargetCount() const { return (uint32_t)mTargetKeys.size(); }
+		inline const std::vector<uint64_t>& GetTargetKeys() const { return mTargetKeys; }
+		inline size_t GetDataSize() const { return mData.size(); }
+
+	private:
+		friend class PvsBaker;
+
+		void SetGrid(const PvsBakeSettings& settings);
+
+		DirectX::XMFLOAT3 mOrigin = { 0.0f, 0.0f, 0.0f };
+		float mCellSize = 1.0f;
+		uint32_t mDims[3] = { 0, 0, 0 };
+		std::vector<uint64_t> mTargetKeys;
+		std::vector<uint32_t> mCellOffsets;
+		std::vector<uint8_t> mData;
+	};
+
+	class PvsBaker
+	{
+	public:
+		// Closest hits for a batch of rays; called from several threads at once.
+		using TraceRays = std::function<void(const RayDesc* rays, size_t count, RayHit* hits)>;
+
+		// Sampled, so it can miss what is only visible through gaps narrower than the
+		// ray spacing; more samples and rays make that less likely. Cells are baked in
+		// parallel on jobs.
+		static PvsData Bake(const std::vector<PvsTarget>& targets, const PvsBakeSettings& settings, const TraceRays& trace, JobSystem& jobs);
+	};
+}
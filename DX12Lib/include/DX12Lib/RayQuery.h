@@ -0,0 +1,65 @@
+#pragma once
+#include <functional>
+#include <future>
+#include <vector>
+#include "JobSystem.h"
+#include "SceneBVH.h"
+#include "TriangleBVH.h"
+
+namespace DX12Lib
+{
+	struct RayDesc
+	{
+		DirectX::XMFLOAT3 Origin;
+		float MaxDistance = FLT_MAX;
+
+		// Needs no normalization, hit distances are in units of its length.
+		DirectX::XMFLOAT3 Direction;
+
+		// Targets that share no layer bit with the mask are ignored.
+		uint32_t LayerMask = ~0u;
+	};
+
+	struct RayHit
+	{
+		void* UserData = nullptr;
+		float Distance = FLT_MAX;
+		uint32_t TriangleIndex = TriangleBVH::InvalidTriangle;
+
+		inline bool IsHit() const { return UserData != nullptr; }
+	};
+
+	// A triangle BVH placed in the world, resolved from the user data of a scene proxy.
+	struct RayTarget
+	{
+		const TriangleBVH* Mesh = nullptr;
+		DirectX::XMFLOAT4X4 WorldToLocal;
+		uint32_t Layers = ~0u;
+	};
+
+	// Closest hit ray queries against the scene BVH and the triangle BVHs of its proxies.
+	// Rays are traced in packets of four: each packet visits the union of the proxies its rays
+	// reach and traverses every triangle BVH once for all of them.
+	class RayQuery
+	{
+	public:
+		// Fills target and returns true if the proxy can be hit. Must be thread safe when
+		// TraceAsync is used.
+		using ResolveTarget = std::function<bool(void* userData, RayTarget& target)>;
+
+		RayQuery(const SceneBVH& scene, ResolveTarget resolve);
+		RayQuery(const RayQuery&) = delete;
+		RayQuery& operator=(const RayQuery&) = delete;
+		~RayQuery() = default;
+
+		void Trace(const RayDesc* rays, size_t count, RayHit* hits) const;
+
+		// Traces as a task of jobs. The scene and the resolved meshes must not change until
+		// the result is retrieved.
+		std::future<std::vector<RayHit>> TraceAsync(JobSystem& jobs, std::vector<RayDesc> rays) const;
+
+	private:
+		const SceneBVH& mScene;
+		ResolveTarget mResolve;
+	};
+}
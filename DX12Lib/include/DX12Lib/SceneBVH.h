@@ -0,0 +1,282 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <DirectXCollision.h>
+#include "FrustumCulling.h"
+
+namespace DX12Lib
+{
+	// Dynamic AABB tree over scene proxies (one per actor).
+	// Leaves store a fattened bound so small movements don't touch the topology;
+	// larger movements remove the leaf and reinsert it with a SAH cost descent.
+	// Rebuild() does a full top-down binned SAH build over the current leaves.
+	class SceneBVH
+	{
+	public:
+		static const int NullNode = -1;
+
+		SceneBVH() = default;
+		SceneBVH(const SceneBVH&) = delete;
+		SceneBVH& operator=(const SceneBVH&) = delete;
+		~SceneBVH() = default;
+
+		int CreateProxy(const DirectX::BoundingBox& bound, void* userData);
+		void DestroyProxy(int proxyId);
+
+		// Returns true if the proxy was reinserted.
+		bool MoveProxy(int proxyId, const DirectX::BoundingBox& bound);
+
+		void Rebuild();
+		void Clear();
+
+		inline void* GetUserData(int proxyId) const { return mNodes[proxyId].UserData; }
+		inline int GetProxyCount() const { return mProxyCount; }
+		inline int GetHeight() const { return mRoot == NullNode ? 0 : mNodes[mRoot].Height; }
+		DirectX::BoundingBox GetFatBound(int proxyId) const;
+
+		// Sum of internal node areas over root area; grows as the tree degrades.
+		float GetAreaRatio() const;
+
+		// callback(void* userData, bool fullyInside)
+		template<typename Callback>
+		void QueryFrustum(const DirectX::BoundingFrustum& frustum, Callback&& callback) const;
+
+		// callback(void* userData, bool fullyInside)
+		template<typename Callback>
+		void QueryOrientedBox(const DirectX::BoundingOrientedBox& box, Callback&& callback) const;
+
+		// Walks the tree once for several views at the same time.
+		// callback(void* userData, uint32_t intersectMask, uint32_t insideMask): bit v of insideMask is set
+		// when the leaf is fully inside views[v], bit v of intersectMask when it only intersects it.
+		template<typename Callback>
+		void QueryViews(const FrustumPlanes* views, int viewCount, Callback&& callback) const;
+
+		// callback(void* userData, float tEnter), origin and direction in world space.
+		template<typename Callback>
+		void QueryRay(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDist, Callback&& callback) const;
+
+		// Same as above with a caller owned stack, so queries can run on other threads while
+		// the tree is not being modified.
+		template<typename Callback>
+		void QueryRay(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDist, std::vector<int>& stack, Callback&& callback) const;
+
+	private:
+		struct Node
+		{
+			DirectX::XMFLOAT3 Min;
+			DirectX::XMFLOAT3 Max;
+
+			// Free list link when the node is unused.
+			int Parent = NullNode;
+			int Child1 = NullNode;
+			int Child2 = NullNode;
+
+			// Leaf = 0, free node = -1.
+			int Height = -1;
+
+			void* UserData = nullptr;
+
+			inline bool IsLeaf() const { return Child1 == NullNode; }
+		};
+
+		int AllocateNode();
+		void FreeNode(int node);
+
+		void InsertLeaf(int leaf);
+		void RemoveLeaf(int leaf);
+		void RefitAncestors(int node);
+
+		int BuildRange(int* leaves, int count);
+
+		template<typename TestNode, typename Callback>
+		void Query(TestNode&& test, Callback&& callback) const;
+
+		inline DirectX::BoundingBox ToBoundingBox(const Node& node) const
+		{
+			DirectX::BoundingBox box;
+			box.Center = DirectX::XMFLOAT3((node.Min.x + node.Max.x) * 0.5f, (node.Min.y + node.Max.y) * 0.5f, (node.Min.z + node.Max.z) * 0.5f);
+			box.Extents = DirectX::XMFLOAT3((node.Max.x - node.Min.x) * 0.5f, (node.Max.y - node.Min.y) * 0.5f, (node.Max.z - node.Min.z) * 0.5f);
+			return box;
+		}
+
+	private:
+		// Enlarges leaf bounds so small movements don't trigger a reinsert.
+		static constexpr float FatMargin = 0.1f;
+
+		std::vector<Node> mNodes;
+		int mRoot = NullNode;
+		int mFreeList = NullNode;
+		int mProxyCount = 0;
+
+		struct ViewStackEntry
+		{
+			int Node;
+			uint32_t Active;
+			uint32_t Inside;
+		};
+
+		mutable std::vector<int> mStack;
+		mutable std::vector<ViewStackEntry> mViewStack;
+	};
+
+	template<typename TestNode, typename Callback>
+	void SceneBVH::Query(TestNode&& test, Callback&& callback) const
+	{
+		if (mRoot == NullNode)
+			return;
+
+		// Bit 30 marks a subtree that is known to be fully inside the query volume.
+		const int insideFlag = 1 << 30;
+
+		mStack.clear();
+		mStack.push_back(mRoot);
+
+		while (!mStack.empty())
+		{
+			int entry = mStack.back();
+			mStack.pop_back();
+
+			int index = entry & ~insideFlag;
+			bool inside = (entry & insideFlag) != 0;
+			const Node& node = mNodes[index];
+
+			if (!inside)
+			{
+				DirectX::ContainmentType result = test(ToBoundingBox(node));
+				if (result == DirectX::DISJOINT)
+					continue;
+
+				inside = result == DirectX::CONTAINS;
+			}
+
+			if (node.IsLeaf())
+			{
+				callback(node.UserData, inside);
+			}
+			else
+			{
+				mStack.push_back(node.Child1 | (inside ? insideFlag : 0));
+				mStack.push_back(node.Child2 | (inside ? insideFlag : 0));
+			}
+		}
+	}
+
+	template<typename Callback>
+	void SceneBVH::QueryFrustum(const DirectX::BoundingFrustum& frustum, Callback&& callback) const
+	{
+		Query([&frustum](const DirectX::BoundingBox& box) { return frustum.Contains(box); }, callback);
+	}
+
+	template<typename Callback>
+	void SceneBVH::QueryOrientedBox(const DirectX::BoundingOrientedBox& box, Callback&& callback) const
+	{
+		Query([&box](const DirectX::BoundingBox& nodeBox) { return box.Contains(nodeBox); }, callback);
+	}
+
+	template<typename Callback>
+	void SceneBVH::QueryViews(const FrustumPlanes* views, int viewCount, Callback&& callback) const
+	{
+		if (mRoot == NullNode || viewCount <= 0)
+			return;
+
+		const uint32_t allViews = viewCount >= MaxCullViews ? ~0u : (1u << viewCount) - 1u;
+
+		mViewStack.clear();
+		mViewStack.push_back({ mRoot, allViews, 0u });
+
+		while (!mViewStack.empty())
+		{
+			ViewStackEntry entry = mViewStack.back();
+			mViewStack.pop_back();
+
+			const Node& node = mNodes[entry.Node];
+			DirectX::BoundingBox box = ToBoundingBox(node);
+
+			// Views that already contain a parent contain its children too and are not retested.
+			uint32_t pending = entry.Active & ~entry.Inside;
+			for (int v = 0; pending != 0; ++v, pending >>= 1)
+			{
+				if ((pending & 1u) == 0)
+					continue;
+
+				DirectX::ContainmentType result = ClassifyBox(views[v], box.Center, box.Extents);
+				if (result == DirectX::DISJOINT)
+					entry.Active &= ~(1u << v);
+				else if (result == DirectX::CONTAINS)
+					entry.Inside |= 1u << v;
+			}
+
+			if (entry.Active == 0)
+				continue;
+
+			if (node.IsLeaf())
+			{
+				callback(node.UserData, entry.Active & ~entry.Inside, entry.Inside);
+			}
+			else
+			{
+				mViewStack.push_back({ node.Child1, entry.Active, entry.Inside });
+				mViewStack.push_back({ node.Child2, entry.Active, entry.Inside });
+			}
+		}
+	}
+
+	template<typename Callback>
+	void SceneBVH::QueryRay(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDist, Callback&& callback) const
+	{
+		QueryRay(origin, direction, maxDist, mStack, callback);
+	}
+
+	template<typename Callback>
+	void SceneBVH::QueryRay(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDist, std::vector<int>& stack, Callback&& callback) const
+	{
+		if (mRoot == NullNode)
+			return;
+
+		DirectX::XMFLOAT3 o, d;
+		DirectX::XMStoreFloat3(&o, origin);
+		DirectX::XMStoreFloat3(&d, direction);
+
+		// Division by zero yields +/-inf which the slab test handles correctly.
+		const float invD[3] = { 1.0f / d.x, 1.0f / d.y, 1.0f / d.z };
+		const float org[3] = { o.x, o.y, o.z };
+
+		stack.clear();
+		stack.push_back(mRoot);
+
+		while (!stack.empty())
+		{
+			const Node& node = mNodes[stack.back()];
+			stack.pop_back();
+
+			const float nodeMin[3] = { node.Min.x, node.Min.y, node.Min.z };
+			const float nodeMax[3] = { node.Max.x, node.Max.y, node.Max.z };
+
+			float tMin = 0.0f;
+			float tMax = maxDist;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float t0 = (nodeMin[axis] - org[axis]) * invD[axis];
+				float t1 = (nodeMax[axis] - org[axis]) * invD[axis];
+				if (t0 > t1)
+					std::swap(t0, t1);
+
+				tMin = t0 > tMin ? t0 : tMin;
+				tMax = t1 < tMax ? t1 : tMax;
+			}
+
+			if (tMin > tMax)
+				continue;
+
+			if (node.IsLeaf())
+			{
+				callback(node.UserData, tMin);
+			}
+			else
+			{
+				stack.push_back(node.Child1);
+				stack.push_back(node.Child2);
+			}
+		}
+	}
+}
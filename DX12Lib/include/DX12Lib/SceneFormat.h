@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXCollision.h>
+
+namespace DX12Lib
+{
+	// Binary scene file, little endian:
+	//   SceneFileHeader
+	//   SceneCellEntry per cell
+	//   one blob per cell: SceneCellHeader, SceneActorRecord per actor, then the actor names
+	// Names are UTF-16 in char16_t code units whatever the size of wchar_t on the platform.
+	// A blob holds no absolute addresses, only offsets from its own start, so loading a cell
+	// is a single read of the blob into memory followed by FixupSceneCell.
+	struct SceneFileHeader
+	{
+		static const uint32_t MagicValue = 0x314E4353;
+		static const uint32_t CurrentVersion = 2;
+
+		uint32_t Magic;
+		uint32_t Version;
+		float CellSize;
+		uint32_t CellCount;
+	};
+
+	struct SceneCellEntry
+	{
+		// Union of the bounds of the actors in the cell.
+		DirectX::BoundingBox Bound;
+		uint32_t ActorCount;
+		uint32_t Size;
+		uint64_t Offset;
+	};
+
+	struct SceneCellHeader
+	{
+		static const uint32_t MagicValue = 0x4C4C4543;
+
+		uint32_t Magic;
+		uint32_t ActorCount;
+		uint64_t NamesOffset;
+		uint64_t NamesSize;
+	};
+
+	// Assets are referenced by StringTable::Hash of their names and resolved at load time.
+	struct SceneActorRecord
+	{
+		DirectX::XMFLOAT4X4 World;
+		DirectX::XMFLOAT4X4 TexTransform;
+		uint64_t MeshGroup;
+		uint64_t DrawArg;
+		uint64_t Material;
+		uint32_t RenderLayer;
+		// Actor_Flag_* bits.
+		uint32_t Flags;
+		// An offset from the start of the blob on disk, a pointer after the fixup.
+		union
+		{
+			uint64_t NameOffset;
+			const char16_t* Name;
+		};
+		// In UTF-16 code units.
+		uint32_t NameLength;
+		uint32_t Padding;
+	};
+
+	// Records of a fixed up cell blob, valid as long as the blob.
+	struct SceneCellView
+	{
+		const SceneActorRecord* Actors = nullptr;
+		uint32_t ActorCount = 0;
+	};
+
+	// Validates the blob and patches its name offsets into pointers, in place.
+	bool FixupSceneCell(uint8_t* blob, size_t size, SceneCellView& view);
+
+	// The name of a fixed up record as a wide string.
+	std::wstring GetSceneActorName(const SceneActorRecord& record);
+
+	// An actor before it is written, with its assets still named.
+	struct SceneActorDesc
+	{
+		std::wstring Name;
+		std::wstring MeshGroup;
+		std::wstring DrawArg;
+		std::wstring Material;
+		uint32_t RenderLayer = 0;
+		uint32_t Flags = 0;
+		DirectX::XMFLOAT4X4 World;
+		DirectX::XMFLOAT4X4 TexTransform;
+		// World space, decides the cell.
+		DirectX::BoundingBox Bound;
+	};
+
+	class SceneWriter
+	{
+	public:
+		// Actors go to the cell of a square grid on the xz plane that holds their bound center.
+		static bool Write(const std::string& filename, const std::vector<SceneActorDesc>& actors, float cellSize);
+	};
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXCollision.h>
+#include "SceneFormat.h"
+
+namespace DX12Lib
+{
+	enum SceneDistribution
+	{
+		Scene_Distribution_Uniform,
+		Scene_Distribution_Clustered,
+		// Blocks of buildings separated by streets; buildings are occluders.
+		Scene_Distribution_CityGrid,
+	};
+
+	// A draw arg the generator may place, with its bound in mesh space.
+	struct SceneGeneratorShape
+	{
+		std::wstring DrawArg;
+		DirectX::BoundingBox Bound;
+	};
+
+	struct SceneGeneratorSettings
+	{
+		uint32_t ActorCount = 1000;
+		SceneDistribution Distribution = Scene_Distribution_Uniform;
+		// Actors per square unit. The scene is a square on the xz plane centered at the origin,
+		// sized so every actor count gets the same density.
+		float Density = 0.02f;
+
+		// Clustered: cluster centers are uniform, actors scatter around them.
+		uint32_t ClusterCount = 0;
+		float ClusterRadius = 10.0f;
+
+		// City grid: square blocks of LotsPerSide x LotsPerSide lots, one building each.
+		uint32_t LotsPerSide = 4;
+		float LotSize = 8.0f;
+		float StreetWidth = 10.0f;
+		float MinBuildingHeight = 4.0f;
+		float MaxBuildingHeight = 40.0f;
+
+		float MinScale = 0.5f;
+		float MaxScale = 2.0f;
+
+		std::wstring MeshGroup;
+		// Uniform and clustered scenes pick shapes at random, city buildings use the first.
+		std::vector<SceneGeneratorShape> Shapes;
+		std::vector<std::wstring> Materials;
+		uint32_t RenderLayer = 0;
+		uint32_t Seed = 1;
+	};
+
+	// Procedural scenes for scaling tests. The same settings always give the same scene.
+	class SceneGenerator
+	{
+	public:
+		static std::vector<SceneActorDesc> Generate(const SceneGeneratorSettings& settings);
+
+		// Side of the square the actors are placed in.
+		static float GetExtent(const SceneGeneratorSettings& settings);
+	};
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <DirectXCollision.h>
+#include "FrustumCulling.h"
+
+namespace DX12Lib
+{
+	// Everything needed to decide whether an object can cast a visible shadow from a
+	// directional light. Receivers are the part of the camera frustum inside the light's
+	// ortho volume; a caster matters only if its bound, swept along the light direction,
+	// reaches that region.
+	struct ShadowCasterVolume
+	{
+		// Camera planes the sweep can never cross back over (normal faces along the light).
+		FrustumPlanes SweptPlanes;
+		int SweptPlaneCount = 0;
+
+		DirectX::XMFLOAT4X4 LightView;
+
+		// Receiver region and light volume in light space, light direction along +Z.
+		DirectX::XMFLOAT3 ReceiverMin;
+		DirectX::XMFLOAT3 ReceiverMax;
+		float LightNearZ = 0.0f;
+
+		bool Empty = true;
+	};
+
+	// cameraFrustum is in world space, lightView looks along lightDir and lightBound is the
+	// light's ortho volume in light space.
+	ShadowCasterVolume BuildShadowCasterVolume(
+		const DirectX::BoundingFrustum& cameraFrustum,
+		DirectX::FXMVECTOR lightDir,
+		DirectX::CXMMATRIX lightView,
+		const DirectX::BoundingBox& lightBound);
+
+	bool IsShadowCaster(const ShadowCasterVolume& volume, const DirectX::BoundingBox& worldBound);
+}
@@ -43,7 +43,7 @@ namespace DX12Lib
 		/// main depth buffer binded to the pipeline, but depth buffer read/writes
 		/// are disabled, as we do not need the depth buffer computing the Ambient map.
 		///</summary>
-		void ComputeSsao(ID3D12GraphicsCommandList* cmdList, FrameResource* currFrame, int blurCount);
+		void ComputeSsao(ID3D12GraphicsCommandList* cmdList, D3D12_GPU_VIRTUAL_ADDRESS ssaoCBAddress, int blurCount);
 
 	private:
 		void InitDescriptorHeap();
@@ -64,7 +64,7 @@ namespace DX12Lib
 		/// few random samples per pixel.  We use an edge preserving blur so that 
 		/// we do not blur across discontinuities--we want edges to remain edges.
 		///</summary>
-		void BlurAmbientMap(ID3D12GraphicsCommandList* cmdList, FrameResource* currFrame, int blurCount);
+		void BlurAmbientMap(ID3D12GraphicsCommandList* cmdList, D3D12_GPU_VIRTUAL_ADDRESS ssaoCBAddress, int blurCount);
 		void BlurAmbientMap(ID3D12GraphicsCommandList* cmdList, bool horzBlur);
 
 	private:
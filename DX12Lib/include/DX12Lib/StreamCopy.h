@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+
+namespace DX12Lib
+{
+	enum UploadCopyMode
+	{
+		Upload_Copy_Memcpy,
+		// Non-temporal stores that bypass the cache and never read the destination. Pays off
+		// for large copies into write-combined upload memory; small ones are fine with memcpy.
+		Upload_Copy_Stream,
+	};
+
+	// memcpy with SSE2 streaming stores where available, fenced before it returns.
+	void StreamCopy(void* destination, const void* source, size_t byteSize);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace DX12Lib
+{
+	// Maps names to dense ids in the order they were first seen. Names are resolved once at
+	// load time, after that the ids index plain arrays and no string is hashed per frame.
+	class StringTable
+	{
+	public:
+		static const uint32_t InvalidId = UINT32_MAX;
+
+		// Id of the name, added if it is new.
+		uint32_t Intern(const std::wstring& name);
+		// InvalidId if the name was never interned.
+		uint32_t Find(const std::wstring& name) const;
+		void Clear();
+
+		inline const std::wstring& GetString(uint32_t id) const { return mStrings[id]; }
+		inline size_t Size() const { return mStrings.size(); }
+
+		// FNV-1a over the UTF-16 code units. Unlike std::hash it is the same on every run,
+		// so it can be written to baked data.
+		static uint64_t Hash(const std::wstring& name);
+
+	private:
+		std::vector<std::wstring> mStrings;
+		std::unordered_map<std::wstring, uint32_t> mIds;
+	};
+}
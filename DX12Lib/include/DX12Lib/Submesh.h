@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <DirectXCollision.h>
+#include "TriangleBVH.h"
+
+namespace DX12Lib
+{
+	// A coarser draw arg of the same group that replaces a submesh once its projected radius
+	// drops below SwitchPixelRadius.
+	struct SubmeshLod
+	{
+		std::wstring DrawArg;
+		float SwitchPixelRadius = 0.0f;
+	};
+
+	struct Submesh
+	{
+		// Unique across all mesh groups and contiguous within one, used to order draws.
+		uint32_t Id = -1;
+		uint32_t IndexCount = 0;
+		uint32_t StartIndexLocation = 0;
+		int32_t BaseVertexLocation = 0;
+		DirectX::BoundingBox Bound;
+
+		// CPU side triangles for ray queries, null for meshes that can't be hit.
+		std::shared_ptr<const TriangleBVH> Collision;
+
+		// Levels after this one, finest first with descending switch radii.
+		std::vector<SubmeshLod> Lods;
+	};
+
+	// The submeshes of a mesh group by draw arg.
+	using SubmeshMap = std::unordered_map<std::wstring, Submesh>;
+}
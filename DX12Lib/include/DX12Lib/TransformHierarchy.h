@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+namespace DX12Lib
+{
+	// Scene graph transforms in flat arrays. A node is created after its parent and never
+	// reparented, so the arrays are always in topological order. Update makes one forward
+	// pass in which dirty flags flow from parents to children, then only the dirty nodes
+	// recompute their world matrix: the local matrices four nodes at a time, one node per SIMD
+	// lane, then the parent products in order, since a child needs its parent's final world.
+	// World = local * parent world, local = scale * rotation * translation.
+	class TransformHierarchy
+	{
+	public:
+		static const uint32_t NullNode = UINT32_MAX;
+
+		TransformHierarchy() = default;
+		TransformHierarchy(const TransformHierarchy&) = delete;
+		TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+		~TransformHierarchy() = default;
+
+		// parent has to be an existing node or NullNode.
+		uint32_t CreateNode(uint32_t parent = NullNode);
+		void Clear();
+
+		// rotation is a quaternion.
+		void SetLocal(uint32_t node, const DirectX::XMFLOAT3& scale, const DirectX::XMFLOAT4& rotation, const DirectX::XMFLOAT3& translation);
+		void SetScale(uint32_t node, const DirectX::XMFLOAT3& scale);
+		void SetRotation(uint32_t node, const DirectX::XMFLOAT4& rotation);
+		void SetTranslation(uint32_t node, const DirectX::XMFLOAT3& translation);
+
+		// Recomputes the world matrices of dirty nodes and everything below them.
+		void Update();
+
+		inline uint32_t GetParent(uint32_t node) const { return mParents[node]; }
+		inline const DirectX::XMFLOAT4X4& GetWorld(uint32_t node) const { return mWorlds[node]; }
+		inline size_t Size() const { return mParents.size(); }
+
+		// Nodes whose world matrix was recomputed by the last Update, parents first.
+		inline const std::vector<uint32_t>& GetChangedNodes() const { return mChanged; }
+
+	private:
+		// Writes the local matrices of four nodes into their world matrices.
+		void ComposeLocals(const uint32_t* nodes);
+
+	private:
+		std::vector<uint32_t> mParents;
+		std::vector<DirectX::XMFLOAT3> mScales;
+		std::vector<DirectX::XMFLOAT4> mRotations;
+		std::vector<DirectX::XMFLOAT3> mTranslations;
+		std::vector<DirectX::XMFLOAT4X4> mWorlds;
+		std::vector<uint8_t> mDirty;
+
+		std::vector<uint32_t> mChanged;
+	};
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+#include <DirectXCollision.h>
+
+namespace DX12Lib
+{
+	// Four rays traced together, in the local space of the mesh being tested. Lanes with
+	// their bit clear in Active are ignored.
+	struct RayPacket
+	{
+		static const int Size = 4;
+
+		float OriginX[Size], OriginY[Size], OriginZ[Size];
+		float DirectionX[Size], DirectionY[Size], DirectionZ[Size];
+
+		// In: farthest distance to accept. Out: distance to the closest hit.
+		float MaxDistance[Size];
+		uint32_t TriangleIndex[Size];
+		uint32_t Active = 0;
+	};
+
+	// Static triangle BVH for one submesh, the CPU side collision proxy used for ray queries.
+	// Only positions are kept, three per triangle in leaf order so a leaf is read front to back.
+	// For indexed meshes this is larger than the shared vertices it came from (36 bytes per
+	// triangle against roughly 12 per vertex plus 12 per triangle of indices); the copy trades
+	// that memory for not chasing indices through the vertex blob during traversal.
+	class TriangleBVH
+	{
+	public:
+		static const uint32_t InvalidTriangle = UINT32_MAX;
+
+		// indices are relative to positions; baseVertex is added to each of them.
+		void Build(const DirectX::XMFLOAT3* positions, uint32_t vertexStride, const uint32_t* indices, uint32_t indexCount, int32_t baseVertex = 0);
+
+		// Closest hit along the ray, t is in units of direction, which needs no normalization.
+		// triangleIndex is the position of the triangle in the source index list.
+		bool Intersect(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float& t, uint32_t& triangleIndex, float maxDistance = FLT_MAX) const;
+
+		// Traces the active lanes together, updating MaxDistance and TriangleIndex of the lanes that hit.
+		void IntersectPacket(RayPacket& packet) const;
+
+		inline uint32_t GetTriangleCount() const { return (uint32_t)mTriangleIds.size(); }
+		inline const DirectX::XMFLOAT3* GetTriangleVertices() const { return mVertices.data(); }
+		inline DirectX::BoundingBox GetBound() const { return mBound; }
+		size_t GetMemorySize() const;
+
+	private:
+		struct Node
+		{
+			DirectX::XMFLOAT3 Min;
+			// Inner node: index of the second child, the first one follows the node.
+			// Leaf: first triangle.
+			uint32_t Start;
+			DirectX::XMFLOAT3 Max;
+			// Zero for inner nodes.
+			uint32_t Count;
+		};
+
+		uint32_t BuildRange(uint32_t begin, uint32_t end, int depth);
+
+	private:
+		static const uint32_t MaxLeafTriangles = 4;
+		static const int BinCount = 12;
+
+		std::vector<Node> mNodes;
+		std::vector<DirectX::XMFLOAT3> mVertices;
+		std::vector<uint32_t> mTriangleIds;
+		DirectX::BoundingBox mBound;
+
+		// Build only.
+		std::vector<DirectX::XMFLOAT3> mCentroids;
+		std::vector<DirectX::XMFLOAT3> mTriMin, mTriMax;
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <wrl.h>
 #include <exception>
+#include "StreamCopy.h"
 #include "Util.h"
 
 namespace DX12Lib
@@ -50,11 +51,61 @@ namespace DX12Lib
 
 		inline uint32_t GetElementSizeInBytes() const { return mElementSizeInBytes; }
 
+		// Elements are only contiguous T's when this is not a constant buffer.
+		inline T* GetMappedData() const { return reinterpret_cast<T*>(mData); }
+
 		void UploadData(uint32_t offset, const T* data)
 		{
 			memcpy(&mData[offset * mElementSizeInBytes], data, sizeof(T));
 		}
 
+		// Copies count elements to offset and on. Padded constant buffer elements go one by
+		// one, anything else is a single copy.
+		void UploadRange(uint32_t offset, const T* data, uint32_t count, UploadCopyMode mode = Upload_Copy_Memcpy)
+		{
+			if (mElementSizeInBytes == sizeof(T))
+			{
+				Copy(&mData[offset * mElementSizeInBytes], data, count * sizeof(T), mode);
+				return;
+			}
+
+			for (uint32_t i = 0; i < count; ++i)
+				Copy(&mData[(offset + i) * mElementSizeInBytes], &data[i], sizeof(T), mode);
+		}
+
+		// Fills consecutive elements in place, for data that is built element by element.
+		// The memory is write combined: write each element front to back and never read it.
+		class Writer
+		{
+		public:
+			Writer(BYTE* data, uint32_t stride) : mData(data), mStride(stride) {}
+
+			// The next element; finish it before asking for another one.
+			inline T& Next()
+			{
+				T* element = reinterpret_cast<T*>(mData);
+				mData += mStride;
+				return *element;
+			}
+
+			inline void Push(const T& value) { Next() = value; }
+
+		private:
+			BYTE* mData;
+			uint32_t mStride;
+		};
+
+		inline Writer GetWriter(uint32_t offset = 0) { return Writer(&mData[offset * mElementSizeInBytes], mElementSizeInBytes); }
+
+	private:
+		static void Copy(BYTE* destination, const T* source, size_t byteSize, UploadCopyMode mode)
+		{
+			if (mode == Upload_Copy_Stream)
+				StreamCopy(destination, source, byteSize);
+			else
+				memcpy(destination, source, byteSize);
+		}
+
 	private:
 		Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
 		BYTE* mData = nullptr;
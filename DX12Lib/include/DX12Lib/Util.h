@@ -159,6 +159,8 @@ namespace DX12Lib
 		inline Microsoft::WRL::ComPtr<ID3D12Resource>& GetUploadHeap() { return mUploadHeap; }
 
 		UINT SrvHeapIndex = -1;
+		// Index in the asset manager's texture table.
+		UINT Id = -1;
 	private:
 		// Unique material name for lookup.
 		std::wstring mName;
@@ -174,6 +176,8 @@ namespace DX12Lib
 		Material(const std::wstring& name) : mName(name) {}
 
 		std::wstring mName;
+		// Index in the asset manager's material table.
+		UINT Id = -1;
 
 		int MatCBIndex = -1;
 		int DiffuseSrvHeapIndex = -1;
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <DirectXCollision.h>
+#include "FrustumCulling.h"
+
+namespace DX12Lib
+{
+	// Remembers the last multi-view culling result of each box together with how far the box
+	// was from changing it. A result is reused while that margin exceeds how much the views
+	// have moved since the test and the box itself hasn't moved. Every result is retested at
+	// least once per revalidation period.
+	class VisibilityCache
+	{
+	public:
+		explicit VisibilityCache(uint32_t revalidationPeriod = 8);
+
+		// Call once per frame before any Lookup or Store. The plane sets must stay in the
+		// same order from frame to frame.
+		void BeginFrame(const FrustumPlanes* views, int viewCount, const DirectX::XMFLOAT3& eye);
+
+		// Returns true and the cached view mask if the previous result is still exact.
+		bool Lookup(int key, uint32_t& viewMask);
+
+		// Records a result tested against this frame's views.
+		void Store(int key, const DirectX::BoundingBox& bound, uint32_t viewMask);
+
+		// The box moved, its result must be retested.
+		void Invalidate(int key);
+		void Clear();
+
+		inline uint32_t GetRevalidationPeriod() const { return mPeriod; }
+		inline uint64_t GetLookupCount() const { return mLookups; }
+		inline uint64_t GetSkippedCount() const { return mSkipped; }
+		inline float GetSkippedFraction() const { return mLookups ? (float)mSkipped / (float)mLookups : 0.0f; }
+		void ResetStats();
+
+	private:
+		struct Entry
+		{
+			DirectX::XMFLOAT3 Center;
+			float ExtentLength = 0.0f;
+			float Margin = -1.0f;
+			uint32_t Frame = 0;
+			uint32_t ViewMask = 0;
+			bool Valid = false;
+		};
+
+		// Views as they were on a given frame, and how far they have moved since.
+		struct Snapshot
+		{
+			std::vector<FrustumPlanes> Views;
+			DirectX::XMFLOAT3 Eye;
+			uint32_t Frame = 0;
+
+			// Bound on the change of dist - radius for a box: NormalDelta * (|center - Eye| + |extents|) + OffsetDelta.
+			float NormalDelta = 0.0f;
+			float OffsetDelta = 0.0f;
+		};
+
+		uint32_t mPeriod;
+		uint32_t mFrame = 0;
+		std::vector<Snapshot> mSnapshots;
+		std::vector<Entry> mEntries;
+		const FrustumPlanes* mViews = nullptr;
+		int mViewCount = 0;
+
+		uint64_t mLookups = 0;
+		uint64_t mSkipped = 0;
+	};
+}
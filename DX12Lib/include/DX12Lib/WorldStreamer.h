@@ -0,0 +1,112 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "JobSystem.h"
+#include "SceneFormat.h"
+
+namespace DX12Lib
+{
+	struct StreamingSettings
+	{
+		// Cells closer than LoadDistance to the camera are loaded, cells beyond UnloadDistance
+		// are dropped. The gap between them keeps cells on the boundary from flipping.
+		float LoadDistance = 60.0f;
+		float UnloadDistance = 80.0f;
+		// Loaded and in flight cells together stay within these.
+		size_t MemoryBudget = 16 * 1024 * 1024;
+		uint32_t MaxResidentActors = 4096;
+		// Cells read at the same time, each by a task of the job system.
+		unsigned MaxConcurrentReads = 2;
+	};
+
+	// Loads and unloads the cells of a scene file around the camera. Reads run as tasks of a
+	// job system, each cell being one read of its blob plus the fixup; everything else runs in
+	// Update on the calling thread, so the results need no locking.
+	class WorldStreamer
+	{
+	public:
+		explicit WorldStreamer(JobSystem& jobs, const StreamingSettings& settings = StreamingSettings());
+		WorldStreamer(const WorldStreamer&) = delete;
+		WorldStreamer& operator=(const WorldStreamer&) = delete;
+		~WorldStreamer();
+
+		// Reads the header and the cell directory.
+		bool Open(const std::string& filename);
+		// Waits for reads in flight, then drops every cell.
+		void Close();
+		inline bool IsOpen() const { return !mFilename.empty(); }
+
+		void Update(const DirectX::XMFLOAT3& eye);
+
+		// Cells that became resident or were dropped in the last Update.
+		inline const std::vector<uint32_t>& GetLoadedCells() const { return mLoaded; }
+		inline const std::vector<uint32_t>& GetUnloadedCells() const { return mUnloaded; }
+
+		// Only valid while the cell is resident.
+		inline const SceneCellView& GetCell(uint32_t cell) const { return mCells[cell].View; }
+		inline const SceneCellEntry& GetCellEntry(uint32_t cell) const { return mEntries[cell]; }
+		inline uint32_t GetCellCount() const { return (uint32_t)mEntries.size(); }
+
+		inline size_t GetResidentBytes() const { return mResidentBytes; }
+		inline uint32_t GetResidentActors() const { return mResidentActors; }
+		inline const StreamingSettings& GetSettings() const { return mSettings; }
+
+	private:
+		enum CellState
+		{
+			Cell_Unloaded,
+			Cell_Loading,
+			Cell_Resident,
+		};
+
+		struct Cell
+		{
+			CellState State = Cell_Unloaded;
+			// A cell that failed to load is not requested again.
+			bool Failed = false;
+			std::unique_ptr<uint8_t[]> Blob;
+			SceneCellView View;
+			float Distance = 0.0f;
+		};
+
+		struct Completed
+		{
+			uint32_t Cell;
+			std::unique_ptr<uint8_t[]> Blob;
+			SceneCellView View;
+			bool Ok;
+		};
+
+		void Unload(uint32_t cell);
+		void StartReads();
+		void ReadCells();
+
+	private:
+		StreamingSettings mSettings;
+		std::string mFilename;
+		std::vector<SceneCellEntry> mEntries;
+		std::vector<Cell> mCells;
+
+		// Resident plus loading, counted against the budget.
+		size_t mResidentBytes = 0;
+		uint32_t mResidentActors = 0;
+
+		std::vector<uint32_t> mLoaded;
+		std::vector<uint32_t> mUnloaded;
+		std::vector<uint32_t> mCandidates;
+
+		JobSystem& mJobs;
+		std::mutex mMutex;
+		std::condition_variable mReadsDone;
+		// Read tasks queued or running.
+		unsigned mReaders = 0;
+		bool mQuit = false;
+		std::deque<uint32_t> mRequests;
+		std::vector<Completed> mCompleted;
+	};
+}
@@ -0,0 +1,277 @@
+#include "DX12Lib/ActorStore.h"
+
+namespace DX12Lib
+{
+	ActorHandle ActorStore::Create(Actor* actor, const std::wstring& name)
+	{
+		if (mNames.find(name) != mNames.end())
+			return ActorHandle();
+
+		uint32_t index;
+		if (!mFreeSlots.empty())
+		{
+			index = mFreeSlots.back();
+			mFreeSlots.pop_back();
+		}
+		else
+		{
+			if (mSlots.size() > ActorHandle::IndexMask)
+				return ActorHandle();
+
+			index = (uint32_t)mSlots.size();
+			mSlots.emplace_back();
+		}
+
+		Slot& slot = mSlots[index];
+		slot.Dense = (uint32_t)mHandles.size();
+		slot.Live = true;
+		slot.Name = name;
+
+		ActorHandle handle;
+		handle.Value = (slot.Generation << ActorHandle::IndexBits) | index;
+		mNames[name] = handle;
+
+		DirectX::XMFLOAT4X4 identity;
+		DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+
+		mHandles.push_back(handle);
+		mActors.push_back(actor);
+		mWorlds.push_back(identity);
+		mBounds.push_back(DirectX::BoundingBox());
+		mGroups.push_back(nullptr);
+		mSubmeshes.push_back(nullptr);
+		mMaterials.push_back(0);
+		mLayers.push_back(0);
+		mFlags.push_back(Actor_Flag_None);
+		mRevisions.push_back(mNextRevision++);
+		mBucketIndices.push_back(0);
+		mBucketPositions.push_back(0);
+		AddToBucket(slot.Dense, 0);
+
+		return handle;
+	}
+
+	void ActorStore::Destroy(ActorHandle handle)
+	{
+		if (!IsValid(handle))
+			return;
+
+		Slot& slot = mSlots[handle.Index()];
+		uint32_t dense = slot.Dense;
+		uint32_t last = (uint32_t)mHandles.size() - 1;
+
+		RemoveFromBucket(dense);
+
+		if (dense != last)
+		{
+			mHandles[dense] = mHandles[last];
+			mActors[dense] = mActors[last];
+			mWorlds[dense] = mWorlds[last];
+			mBounds[dense] = mBounds[last];
+			mGroups[dense] = mGroups[last];
+			mSubmeshes[dense] = mSubmeshes[last];
+			mMaterials[dense] = mMaterials[last];
+			mLayers[dense] = mLayers[last];
+			mFlags[dense] = mFlags[last];
+			mRevisions[dense] = mRevisions[last];
+			mBucketIndices[dense] = mBucketIndices[last];
+			mBucketPositions[dense] = mBucketPositions[last];
+
+			mSlots[mHandles[dense].Index()].Dense = dense;
+		}
+
+		mHandles.pop_back();
+		mActors.pop_back();
+		mWorlds.pop_back();
+		mBounds.pop_back();
+		mGroups.pop_back();
+		mSubmeshes.pop_back();
+		mMaterials.pop_back();
+		mLayers.pop_back();
+		mFlags.pop_back();
+		mRevisions.pop_back();
+		mBucketIndices.pop_back();
+		mBucketPositions.pop_back();
+
+		mNames.erase(slot.Name);
+		ReleaseSlot(handle.Index());
+	}
+
+	void ActorStore::Clear()
+	{
+		// The slots stay, with their generations moved on, so handles from before the Clear
+		// can't resolve to actors created after it.
+		for (ActorHandle handle : mHandles)
+			ReleaseSlot(handle.Index());
+		mNames.clear();
+
+		mHandles.clear();
+		mActors.clear();
+		mWorlds.clear();
+		mBounds.clear();
+		mGroups.clear();
+		mSubmeshes.clear();
+		mMaterials.clear();
+		mLayers.clear();
+		mFlags.clear();
+		mRevisions.clear();
+
+		mBuckets.clear();
+		mBucketIndices.clear();
+		mBucketPositions.clear();
+	}
+
+	void ActorStore::ReleaseSlot(uint32_t index)
+	{
+		Slot& slot = mSlots[index];
+		slot.Name.clear();
+		slot.Live = false;
+
+		if (slot.FramesDirty > 0)
+		{
+			ActorHandle moved = mDirty.back();
+			mDirty[slot.DirtyPosition] = moved;
+			mSlots[moved.Index()].DirtyPosition = slot.DirtyPosition;
+			mDirty.pop_back();
+			slot.FramesDirty = 0;
+		}
+
+		// Generation zero is skipped so a null handle can never resolve.
+		slot.Generation = (slot.Generation + 1) & 0xff;
+		if (slot.Generation == 0)
+			slot.Generation = 1;
+
+		mFreeSlots.push_back(index);
+	}
+
+	bool ActorStore::IsValid(ActorHandle handle) const
+	{
+		if (handle.IsNull() || handle.Index() >= mSlots.size())
+			return false;
+
+		const Slot& slot = mSlots[handle.Index()];
+		return slot.Live && slot.Generation == handle.Generation();
+	}
+
+	ActorHandle ActorStore::Find(const std::wstring& name) const
+	{
+		auto it = mNames.find(name);
+		if (it != mNames.end())
+			return it->second;
+		return ActorHandle();
+	}
+
+	void ActorStore::MarkDirty(ActorHandle handle, uint32_t frameCount)
+	{
+		Slot& slot = mSlots[handle.Index()];
+		if (slot.FramesDirty == 0)
+		{
+			slot.DirtyPosition = (uint32_t)mDirty.size();
+			mDirty.push_back(handle);
+		}
+		slot.FramesDirty = frameCount;
+	}
+
+	void ActorStore::SetTransform(ActorHandle handle, const DirectX::XMFLOAT4X4& world, const DirectX::BoundingBox& worldBound)
+	{
+		uint32_t dense = IndexOf(handle);
+		mWorlds[dense] = world;
+		mBounds[dense] = worldBound;
+	}
+
+	void ActorStore::SetMesh(ActorHandle handle, MeshGroup* group, const Submesh* submesh)
+	{
+		uint32_t dense = IndexOf(handle);
+		if (mGroups[dense] == group && mSubmeshes[dense] == submesh)
+			return;
+
+		mGroups[dense] = group;
+		mSubmeshes[dense] = submesh;
+		mRevisions[dense] = mNextRevision++;
+	}
+
+	void ActorStore::SetMaterial(ActorHandle handle, uint32_t materialIndex)
+	{
+		uint32_t dense = IndexOf(handle);
+		if (mMaterials[dense] == materialIndex)
+			return;
+
+		mMaterials[dense] = materialIndex;
+		mRevisions[dense] = mNextRevision++;
+	}
+
+	void ActorStore::SetLayer(ActorHandle handle, uint32_t layer)
+	{
+		uint32_t dense = IndexOf(handle);
+		if (mLayers[dense] == layer)
+			return;
+
+		RemoveFromBucket(dense);
+		mLayers[dense] = layer;
+		AddToBucket(dense, layer);
+		mRevisions[dense] = mNextRevision++;
+	}
+
+	void ActorStore::SetFlags(ActorHandle handle, uint32_t flags)
+	{
+		uint32_t dense = IndexOf(handle);
+		if (mFlags[dense] == flags)
+			return;
+
+		mFlags[dense] = flags;
+		mRevisions[dense] = mNextRevision++;
+	}
+
+	size_t ActorStore::LayerRange::Size() const
+	{
+		size_t count = 0;
+		for (const LayerBucket* bucket = mFirst; bucket != mLast; ++bucket)
+		{
+			if (Matches(bucket->Layer, mMask))
+				count += bucket->Actors.size();
+		}
+		return count;
+	}
+
+	uint32_t ActorStore::FindBucket(uint32_t layer)
+	{
+		// Only a handful of distinct layer values exist, a linear search is fine.
+		for (uint32_t i = 0; i < mBuckets.size(); ++i)
+		{
+			if (mBuckets[i].Layer == layer)
+				return i;
+		}
+
+		mBuckets.emplace_back();
+		mBuckets.back().Layer = layer;
+		return (uint32_t)mBuckets.size() - 1;
+	}
+
+	void ActorStore::AddToBucket(uint32_t dense, uint32_t layer)
+	{
+		uint32_t bucketIndex = FindBucket(layer);
+		LayerBucket& bucket = mBuckets[bucketIndex];
+
+		mBucketIndices[dense] = bucketIndex;
+		mBucketPositions[dense] = (uint32_t)bucket.Actors.size();
+		bucket.Actors.push_back(mActors[dense]);
+		bucket.Handles.push_back(mHandles[dense]);
+	}
+
+	void ActorStore::RemoveFromBucket(uint32_t dense)
+	{
+		LayerBucket& bucket = mBuckets[mBucketIndices[dense]];
+		uint32_t position = mBucketPositions[dense];
+		uint32_t last = (uint32_t)bucket.Actors.size() - 1;
+
+		if (position != last)
+		{
+			bucket.Actors[position] = bucket.Actors[last];
+			bucket.Handles[position] = bucket.Handles[last];
+			mBucketPositions[IndexOf(bucket.Handles[position])] = position;
+		}
+
+		bucket.Actors.pop_back();
+		bucket.Handles.pop_back();
+	}
+}
@@ -1,4 +1,5 @@
 #include "DX12Lib/AssetManager.h"
+#include <algorithm>
 #include <d3dcompiler.h>
 #include "DX12Lib/FrameResource.h"
 #include "DX12Lib/Application.h"
@@ -16,52 +17,15 @@ namespace DX12Lib
 			return nullptr;
 
 		auto mesheGroup = std::make_unique<MeshGroup>(name);
+		LayoutSubmeshes(meshes, mesheGroup->DrawArgs);
 
-		UINT currentVertexOffset = 0;
-		UINT currentIndexOffset = 0;
-		for (auto& mesh : meshes)
-		{
-			Submesh submesh;
-			submesh.IndexCount = mesh.Data.Indices32.size();
-			submesh.StartIndexLocation = currentIndexOffset;
-			submesh.BaseVertexLocation = currentVertexOffset;
-			
-			DirectX::XMFLOAT3 vMinf3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
-			DirectX::XMFLOAT3 vMaxf3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-			DirectX::XMVECTOR vMin = DirectX::XMLoadFloat3(&vMinf3);
-			DirectX::XMVECTOR vMax = DirectX::XMLoadFloat3(&vMaxf3);
-
-			for (auto& v : mesh.Data.Vertices)
-			{
-				DirectX::XMVECTOR P = DirectX::XMLoadFloat3(&v.Position);
-				vMin = DirectX::XMVectorMin(vMin, P);
-				vMax = DirectX::XMVectorMax(vMax, P);
-			}
-
-			DirectX::BoundingBox bound;
-			DirectX::XMStoreFloat3(&bound.Center, DirectX::XMVectorScale(DirectX::XMVectorAdd(vMin, vMax), 0.5));
-			DirectX::XMStoreFloat3(&bound.Extents, DirectX::XMVectorScale(DirectX::XMVectorSubtract(vMax, vMin), 0.5));
-			submesh.Bound = bound;
-
-			currentIndexOffset += mesh.Data.Indices32.size();
-			currentVertexOffset += mesh.Data.Vertices.size();
-
-			mesheGroup->DrawArgs[mesh.Name] = submesh;
-		}
-
-		std::vector<Vertex> vertices(currentVertexOffset);
+		std::vector<Vertex> vertices;
 		std::vector<std::uint16_t> indices;
 
-		UINT k = 0;
 		for (auto& mesh : meshes)
 		{
-			for (size_t i = 0; i < mesh.Data.Vertices.size(); ++i, ++k)
-			{
-				vertices[k].Position = mesh.Data.Vertices[i].Position;
-				vertices[k].Normal = mesh.Data.Vertices[i].Normal;
-				vertices[k].TexCoord = mesh.Data.Vertices[i].TexCoord;
-				vertices[k].TangentU = mesh.Data.Vertices[i].TangentU;
-			}
+			for (auto& v : mesh.Data.Vertices)
+				vertices.push_back(v);
 
 			indices.insert(indices.end(), std::begin(mesh.Data.GetIndices16()), std::end(mesh.Data.GetIndices16()));
 		}
@@ -69,12 +33,7 @@ namespace DX12Lib
 		const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 		const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
 
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &mesheGroup->VertexBufferCPU));
-		CopyMemory(mesheGroup->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &mesheGroup->IndexBufferCPU));
-		CopyMemory(mesheGroup->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
+		// No CPU copy of the buffers is kept, the submesh collision BVHs hold what the CPU needs.
 		mesheGroup->VertexBufferGPU = CreateDefaultBuffer(Application::Get()->GetDevice().Get(), Application::Get()->GetDirectCommandList().Get(), vertices.data(), vbByteSize, mesheGroup->VertexBufferUploader);
 		mesheGroup->IndexBufferGPU = CreateDefaultBuffer(Application::Get()->GetDevice().Get(), Application::Get()->GetDirectCommandList().Get(), indices.data(), ibByteSize, mesheGroup->IndexBufferUploader);
 
@@ -83,9 +42,17 @@ namespace DX12Lib
 		mesheGroup->IndexFormat = DXGI_FORMAT_R16_UINT;
 		mesheGroup->IndexBufferByteSize = ibByteSize;
 
-		mMeshGroups[mesheGroup->Name] = std::move(mesheGroup);
+		return CreateMeshGroup(mesheGroup);
+	}
+
+	MeshGroup* AssetManager::CreateMeshGroupWithoutBuffers(const std::wstring& name, std::vector<Mesh>& meshes)
+	{
+		if (GetMeshGroup(name))
+			return nullptr;
 
-		return GetMeshGroup(name);
+		auto mesheGroup = std::make_unique<MeshGroup>(name);
+		LayoutSubmeshes(meshes, mesheGroup->DrawArgs);
+		return CreateMeshGroup(mesheGroup);
 	}
 
 	DX12Lib::MeshGroup* AssetManager::CreateMeshGroup(std::unique_ptr<MeshGroup>& group)
@@ -93,15 +60,20 @@ namespace DX12Lib
 		if (GetMeshGroup(group->Name))
 			return nullptr;
 
-		mMeshGroups[group->Name] = std::move(group);
+		group->Id = mMeshGroupNames.Intern(group->Name);
+		for (auto& [name, submesh] : group->DrawArgs)
+			submesh.Id = mSubmeshCount++;
+
+		mMeshGroups.push_back(std::move(group));
+		return mMeshGroups.back().get();
 	}
 
 	DX12Lib::MeshGroup* AssetManager::GetMeshGroup(const std::wstring& name) const
 	{
-		auto it = mMeshGroups.find(name);
-		if (it != mMeshGroups.end())
+		uint32_t id = mMeshGroupNames.Find(name);
+		if (id != StringTable::InvalidId)
 		{
-			return it->second.get();
+			return mMeshGroups[id].get();
 		}
 		return nullptr;
 	}
@@ -112,17 +84,18 @@ namespace DX12Lib
 			return nullptr;
 
 		auto material = std::make_unique<Material>(name);
+		material->Id = mMaterialNames.Intern(name);
 
-		mMaterials[name] = std::move(material);
-		return GetMaterial(name);
+		mMaterials.push_back(std::move(material));
+		return mMaterials.back().get();
 	}
 
 	Material* AssetManager::GetMaterial(const std::wstring& name) const
 	{
-		auto it = mMaterials.find(name);
-		if (it != mMaterials.end())
+		uint32_t id = mMaterialNames.Find(name);
+		if (id != StringTable::InvalidId)
 		{
-			return it->second.get();
+			return mMaterials[id].get();
 		}
 		return nullptr;
 	}
@@ -132,7 +105,7 @@ namespace DX12Lib
 		std::vector<Material*> materials;
 		materials.reserve(GetMaterialsCount());
 
-		for (auto& [name, material] : mMaterials)
+		for (auto& material : mMaterials)
 		{
 			materials.emplace_back(material.get());
 		}
@@ -142,21 +115,8 @@ namespace DX12Lib
 
 	int AssetManager::FindMaterialIndex(const std::wstring& name) const
 	{
-		auto it = mMaterials.find(name);
-
-		if (it != mMaterials.end())
-		{
-			int index = 0;
-			for (auto i = mMaterials.begin(); i != it; ++i)
-			{
-				++index;
-			}
-			return index;
-		}
-		else
-		{
-			return -1;
-		}
+		uint32_t id = mMaterialNames.Find(name);
+		return id != StringTable::InvalidId ? (int)id : -1;
 	}
 
 	Texture* AssetManager::CreateTexture(const std::wstring& name, const std::wstring& filename)
@@ -165,16 +125,18 @@ namespace DX12Lib
 			return nullptr;
 
 		auto texture = std::make_unique<Texture>(name, filename);
-		mTextures[name] = std::move(texture);
-		return GetTexture(name);
+		texture->Id = mTextureNames.Intern(name);
+
+		mTextures.push_back(std::move(texture));
+		return mTextures.back().get();
 	}
 
 	Texture* AssetManager::GetTexture(const std::wstring& name) const
 	{
-		auto it = mTextures.find(name);
-		if (it != mTextures.end())
+		uint32_t id = mTextureNames.Find(name);
+		if (id != StringTable::InvalidId)
 		{
-			return it->second.get();
+			return mTextures[id].get();
 		}
 		return nullptr;
 	}
@@ -184,7 +146,7 @@ namespace DX12Lib
 		std::vector<Texture*> textures;
 		textures.reserve(GetTexturesCount());
 
-		for (auto& [name, texture] : mTextures)
+		for (auto& texture : mTextures)
 		{
 			textures.emplace_back(texture.get());
 		}
@@ -194,21 +156,8 @@ namespace DX12Lib
 
 	int AssetManager::FindTextureIndex(const std::wstring& name) const
 	{
-		auto it = mTextures.find(name);
-
-		if (it != mTextures.end())
-		{
-			int index = 0;
-			for (auto i = mTextures.begin(); i != it; ++i)
-			{
-				++index;
-			}
-			return index;
-		}
-		else
-		{
-			return -1;
-		}
+		uint32_t id = mTextureNames.Find(name);
+		return id != StringTable::InvalidId ? (int)id : -1;
 	}
 
 	Microsoft::WRL::ComPtr<ID3DBlob> AssetManager::CreateShader(const std::wstring& name, const std::wstring& filename, const D3D_SHADER_MACRO* defines, const std::string& entrypoint, const std::string& target)
@@ -232,61 +181,94 @@ namespace DX12Lib
 
 	Actor* AssetManager::CreateActor(const std::wstring& name)
 	{
-		if (GetActor(name))
+		auto actor = std::make_unique<Actor>(name);
+		ActorHandle handle = mActorStore.Create(actor.get(), name);
+		if (handle.IsNull())
 			return nullptr;
 
-		auto actor = std::make_unique<Actor>(name);
-		mActors[name] = std::move(actor);
-		return GetActor(name);
+		actor->Handle = handle;
+		if (mActors.size() <= handle.Index())
+			mActors.resize(handle.Index() + 1);
+		mActors[handle.Index()] = std::move(actor);
+
+		UpdateActor(mActors[handle.Index()].get());
+		return mActors[handle.Index()].get();
 	}
 
-	Actor* AssetManager::GetActor(const std::wstring& name) const
+	void AssetManager::DestroyActor(Actor* actor)
 	{
-		auto it = mActors.find(name);
-		if (it != mActors.end())
-		{
-			return it->second.get();
-		}
-		return nullptr;
+		if (actor == nullptr || !mActorStore.IsValid(actor->Handle))
+			return;
+
+		uint32_t slot = actor->Handle.Index();
+		mActorStore.Destroy(actor->Handle);
+		mActors[slot].reset();
 	}
 
-	std::vector<Actor*> AssetManager::GetActors(UINT layer) const
+	Actor* AssetManager::GetActor(const std::wstring& name) const
 	{
-		std::vector<Actor*> actors;
+		ActorHandle handle = mActorStore.Find(name);
+		if (handle.IsNull())
+			return nullptr;
 
-		if (layer == Render_Layer_All)
-		{
-			actors.reserve(GetActorsCount());
-			for (auto& [name, actor] : mActors)
-			{
-				actors.emplace_back(actor.get());
-			}
-		}
-		else
-		{
-			for (auto& [name, actor] : mActors)
-			{
-				if (actor->RenderLayer & layer)
-					actors.emplace_back(actor.get());
-			}
-		}
+		return mActors[handle.Index()].get();
+	}
 
-		return actors;
+	std::vector<Actor*> AssetManager::GetActors(UINT layer) const
+	{
+		auto range = GetActorsInLayers(layer);
+		return std::vector<Actor*>(range.begin(), range.end());
 	}
 
 	size_t AssetManager::GetActorsCount(UINT layer) const
 	{
 		if (layer == Render_Layer_All)
-			return mActors.size();
+			return mActorStore.Size();
 
-		size_t count = 0;
-		for (auto& [name, actor] : mActors)
+		return GetActorsInLayers(layer).Size();
+	}
+
+	void AssetManager::UpdateActor(Actor* actor)
+	{
+		const Submesh* submesh = nullptr;
+		if (actor->Group)
 		{
-			if (actor->RenderLayer & layer)
-				count++;
+			auto it = actor->Group->DrawArgs.find(actor->DrawArg);
+			if (it != actor->Group->DrawArgs.end())
+				submesh = &it->second;
+
+			actor->VertexBuffer = actor->Group->VertexBinding();
+			actor->IndexBuffer = actor->Group->IndexBinding();
+			actor->Submeshes = &actor->Group->DrawArgs;
 		}
-		
-		return count;
+
+		uint32_t flags = Actor_Flag_None;
+		if (actor->Hidden)
+			flags |= Actor_Flag_Hidden;
+		if (actor->Occluder)
+			flags |= Actor_Flag_Occluder;
+		if (actor->mSkinnedMesh)
+			flags |= Actor_Flag_Skinned;
+
+		mActorStore.SetMesh(actor->Handle, actor->Group, submesh);
+		mActorStore.SetMaterial(actor->Handle, actor->Instance.MaterialCBIndex);
+		mActorStore.SetLayer(actor->Handle, actor->RenderLayer);
+		mActorStore.SetFlags(actor->Handle, flags);
+		UpdateActorTransform(actor);
 	}
 
+	void AssetManager::UpdateActorTransform(Actor* actor)
+	{
+		const DirectX::XMFLOAT4X4& world = actor->Instance.World;
+		DirectX::BoundingBox bound(DirectX::XMFLOAT3(world._41, world._42, world._43), DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+		const Submesh* submesh = mActorStore.GetSubmesh(actor->Handle);
+		if (submesh)
+			submesh->Bound.Transform(bound, DirectX::XMLoadFloat4x4(&world));
+
+		mActorStore.SetTransform(actor->Handle, world, bound);
+
+		// Everything in the instance data comes through here, the material with UpdateActor.
+		mActorStore.MarkDirty(actor->Handle, gNumFrameResources);
+	}
 }
@@ -0,0 +1,111 @@
+#include "DX12Lib/CommandRecorder.h"
+#include <cstring>
+
+namespace DX12Lib
+{
+	void CommandRecorder::Reset()
+	{
+		mRootSignatureKnown = false;
+		mPipelineStateKnown = false;
+		mVertexBufferKnown = false;
+		mIndexBufferKnown = false;
+		mTopologyKnown = false;
+		mRootViewsKnown.fill(false);
+	}
+
+	template<typename T>
+	bool CommandRecorder::Changes(T& shadow, bool& known, const T& value)
+	{
+		// The bindings are plain structs without padding, compare them bytewise.
+		if (known && std::memcmp(&shadow, &value, sizeof(T)) == 0)
+		{
+			++mStats.Filtered;
+			return false;
+		}
+
+		shadow = value;
+		known = true;
+		++mStats.Issued;
+		return true;
+	}
+
+	void CommandRecorder::SetGraphicsRootSignature(GpuObjectHandle rootSignature)
+	{
+		if (Changes(mRootSignature, mRootSignatureKnown, rootSignature))
+		{
+			RecordGraphicsRootSignature(rootSignature);
+			mRootViewsKnown.fill(false);
+		}
+	}
+
+	void CommandRecorder::SetPipelineState(GpuObjectHandle pipelineState)
+	{
+		if (Changes(mPipelineState, mPipelineStateKnown, pipelineState))
+			RecordPipelineState(pipelineState);
+	}
+
+	void CommandRecorder::SetVertexBuffer(const VertexBufferBinding& binding)
+	{
+		if (Changes(mVertexBuffer, mVertexBufferKnown, binding))
+			RecordVertexBuffer(binding);
+	}
+
+	void CommandRecorder::SetIndexBuffer(const IndexBufferBinding& binding)
+	{
+		if (Changes(mIndexBuffer, mIndexBufferKnown, binding))
+			RecordIndexBuffer(binding);
+	}
+
+	void CommandRecorder::SetPrimitiveTopology(PrimitiveTopology topology)
+	{
+		if (Changes(mTopology, mTopologyKnown, topology))
+			RecordPrimitiveTopology(topology);
+	}
+
+	void CommandRecorder::SetGraphicsRootShaderResourceView(uint32_t rootParameterIndex, GpuVirtualAddress address)
+	{
+		SetRootView(rootParameterIndex, address, false);
+	}
+
+	void CommandRecorder::SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, GpuVirtualAddress address)
+	{
+		SetRootView(rootParameterIndex, address, true);
+	}
+
+	void CommandRecorder::SetRootView(uint32_t rootParameterIndex, GpuVirtualAddress address, bool constantBuffer)
+	{
+		// A root parameter has a single type, so one shadow per index covers SRVs and CBVs.
+		if (rootParameterIndex < MaxRootParameters)
+		{
+			if (!Changes(mRootViews[rootParameterIndex], mRootViewsKnown[rootParameterIndex], address))
+				return;
+		}
+		else
+		{
+			++mStats.Issued;
+		}
+
+		if (constantBuffer)
+			RecordGraphicsRootConstantBufferView(rootParameterIndex, address);
+		else
+			RecordGraphicsRootShaderResourceView(rootParameterIndex, address);
+	}
+
+	void CommandRecorder::DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+	{
+		++mStats.Issued;
+		++mStats.Draws;
+		RecordDrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+	}
+
+	void CommandRecorder::ExecuteIndirect(GpuObjectHandle commandSignature, uint32_t maxCommandCount, GpuObjectHandle argumentBuffer, uint64_t argumentBufferOffset)
+	{
+		++mStats.Issued;
+		++mStats.Draws;
+		RecordExecuteIndirect(commandSignature, maxCommandCount, argumentBuffer, argumentBufferOffset);
+
+		mVertexBufferKnown = false;
+		mIndexBufferKnown = false;
+		mRootViewsKnown.fill(false);
+	}
+}
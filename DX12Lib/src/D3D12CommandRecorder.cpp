@@ -0,0 +1,57 @@
+#include "DX12Lib/D3D12CommandRecorder.h"
+
+namespace DX12Lib
+{
+	void D3D12CommandRecorder::SetCommandList(ID3D12GraphicsCommandList* commandList)
+	{
+		mCommandList = commandList;
+		Reset();
+	}
+
+	void D3D12CommandRecorder::RecordGraphicsRootSignature(GpuObjectHandle rootSignature)
+	{
+		mCommandList->SetGraphicsRootSignature(FromHandle<ID3D12RootSignature>(rootSignature));
+	}
+
+	void D3D12CommandRecorder::RecordPipelineState(GpuObjectHandle pipelineState)
+	{
+		mCommandList->SetPipelineState(FromHandle<ID3D12PipelineState>(pipelineState));
+	}
+
+	void D3D12CommandRecorder::RecordVertexBuffer(const VertexBufferBinding& binding)
+	{
+		D3D12_VERTEX_BUFFER_VIEW view = ToView(binding);
+		mCommandList->IASetVertexBuffers(0, 1, &view);
+	}
+
+	void D3D12CommandRecorder::RecordIndexBuffer(const IndexBufferBinding& binding)
+	{
+		D3D12_INDEX_BUFFER_VIEW view = ToView(binding);
+		mCommandList->IASetIndexBuffer(&view);
+	}
+
+	void D3D12CommandRecorder::RecordPrimitiveTopology(PrimitiveTopology topology)
+	{
+		mCommandList->IASetPrimitiveTopology(ToD3D12Topology(topology));
+	}
+
+	void D3D12CommandRecorder::RecordGraphicsRootShaderResourceView(uint32_t rootParameterIndex, GpuVirtualAddress address)
+	{
+		mCommandList->SetGraphicsRootShaderResourceView(rootParameterIndex, address);
+	}
+
+	void D3D12CommandRecorder::RecordGraphicsRootConstantBufferView(uint32_t rootParameterIndex, GpuVirtualAddress address)
+	{
+		mCommandList->SetGraphicsRootConstantBufferView(rootParameterIndex, address);
+	}
+
+	void D3D12CommandRecorder::RecordDrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+	{
+		mCommandList->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+	}
+
+	void D3D12CommandRecorder::RecordExecuteIndirect(GpuObjectHandle commandSignature, uint32_t maxCommandCount, GpuObjectHandle argumentBuffer, uint64_t argumentBufferOffset)
+	{
+		mCommandList->ExecuteIndirect(FromHandle<ID3D12CommandSignature>(commandSignature), maxCommandCount, FromHandle<ID3D12Resource>(argumentBuffer), argumentBufferOffset, nullptr, 0);
+	}
+}
@@ -0,0 +1,32 @@
+#include "DX12Lib/D3D12UploadPageSource.h"
+
+namespace DX12Lib
+{
+	D3D12UploadPageSource::~D3D12UploadPageSource()
+	{
+		for (auto& resource : mResources)
+			resource->Unmap(0, nullptr);
+	}
+
+	UploadAllocation D3D12UploadPageSource::CreatePage(size_t byteSize)
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+		CD3DX12_HEAP_PROPERTIES properties(D3D12_HEAP_TYPE_UPLOAD);
+		CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
+
+		ThrowIfFailed(mDevice->CreateCommittedResource(
+			&properties,
+			D3D12_HEAP_FLAG_NONE,
+			&desc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&resource)));
+
+		// Buffers start on a 64KB boundary, more than any constant buffer needs.
+		UploadAllocation page;
+		ThrowIfFailed(resource->Map(0, nullptr, reinterpret_cast<void**>(&page.Data)));
+		page.GpuAddress = resource->GetGPUVirtualAddress();
+		mResources.push_back(resource);
+		return page;
+	}
+}
@@ -0,0 +1,295 @@
+#include "DX12Lib/DrawList.h"
+#include <algorithm>
+#include <assert.h>
+
+namespace DX12Lib
+{
+	DrawList::DrawList(JobSystem& jobs) :
+		mDrawPacketSorter(jobs)
+	{
+	}
+
+	void DrawList::SetPassSlots(uint32_t view, const std::vector<PassSlot>& slots)
+	{
+		assert(view < MaxViews && "View out of range");
+		assert(slots.size() <= MaxSlots && "Too many layer slots for the draw key");
+		mPassSlots[view] = slots;
+	}
+
+	void DrawList::Reserve(size_t actorCount, uint32_t viewCount)
+	{
+		mCachedDraws.reserve(actorCount);
+		mDrawPackets.reserve(actorCount * viewCount);
+	}
+
+	void DrawList::Cull(const SceneBVH& bvh, VisibilityCache& cache, const ActorStore& store, const FrustumPlanes* views, uint32_t viewCount, const DirectX::XMFLOAT3& eye)
+	{
+		for (auto a : mVisibleActors)
+		{
+			a->Visible = false;
+			a->ViewMask = 0;
+		}
+		mVisibleActors.clear();
+
+		for (auto& viewActors : mViewActors)
+			viewActors.clear();
+
+		mCullCandidates.clear();
+		mCandidateMasks.clear();
+		mCullBounds.Clear();
+
+		cache.ResetStats();
+		cache.BeginFrame(views, (int)viewCount, eye);
+
+		// Views that fully contain a leaf are final, the rest are retested with the exact actor
+		// bound since leaves hold fattened bounds.
+		bvh.QueryViews(views, (int)viewCount, [&](void* userData, uint32_t intersectMask, uint32_t insideMask)
+		{
+			ActorView* a = static_cast<ActorView*>(userData);
+
+			if (a->Hidden)
+				return;
+
+			a->ViewMask = insideMask;
+
+			if (intersectMask == 0)
+			{
+				mVisibleActors.push_back(a);
+				return;
+			}
+
+			// Still exact if neither the actor nor the views moved far enough since the last test.
+			uint32_t cachedMask;
+			if (cache.Lookup(a->ProxyId, cachedMask))
+			{
+				a->ViewMask = cachedMask;
+				if (cachedMask != 0)
+					mVisibleActors.push_back(a);
+				return;
+			}
+
+			mCullCandidates.push_back(a);
+			mCandidateMasks.push_back(intersectMask);
+			mCullBounds.Push(store.GetBound(a->Handle));
+		});
+
+		mCullViewMasks.resize(mCullBounds.Size());
+		CullBoxesMultiView(views, (int)viewCount, mCullBounds, mCullViewMasks.data());
+
+		for (size_t i = 0; i < mCullCandidates.size(); ++i)
+		{
+			ActorView* a = mCullCandidates[i];
+			a->ViewMask |= mCullViewMasks[i] & mCandidateMasks[i];
+
+			DirectX::BoundingBox bound(
+				DirectX::XMFLOAT3(mCullBounds.CenterX[i], mCullBounds.CenterY[i], mCullBounds.CenterZ[i]),
+				DirectX::XMFLOAT3(mCullBounds.ExtentX[i], mCullBounds.ExtentY[i], mCullBounds.ExtentZ[i]));
+			cache.Store(a->ProxyId, bound, a->ViewMask);
+
+			if (a->ViewMask != 0)
+				mVisibleActors.push_back(a);
+		}
+	}
+
+	void DrawList::FinishCull(uint32_t mainView)
+	{
+		mMainView = mainView;
+
+		size_t visibleCount = 0;
+		for (auto a : mVisibleActors)
+		{
+			if (a->ViewMask != 0)
+				mVisibleActors[visibleCount++] = a;
+		}
+		mVisibleActors.resize(visibleCount);
+
+		for (auto a : mVisibleActors)
+		{
+			a->Visible = (a->ViewMask & (1u << mainView)) != 0;
+
+			for (uint32_t v = 0; v < MaxViews; ++v)
+			{
+				if (a->ViewMask & (1u << v))
+					mViewActors[v].push_back(a);
+			}
+		}
+	}
+
+	size_t DrawList::CullOccluded(OcclusionCuller& culler, const ActorStore& store, DirectX::FXMMATRIX viewProj, uint32_t view)
+	{
+		culler.BeginFrame(viewProj);
+
+		std::vector<ActorView*>& viewActors = mViewActors[view];
+		for (auto a : viewActors)
+		{
+			if (!a->Occluder)
+				continue;
+
+			const Submesh* submesh = store.GetSubmesh(a->Handle);
+			if (submesh && submesh->Collision)
+				culler.AddOccluder(submesh->Collision->GetTriangleVertices(), submesh->Collision->GetTriangleCount(), DirectX::XMLoadFloat4x4(&store.GetWorld(a->Handle)));
+		}
+
+		culler.Render();
+
+		// The other views keep their lists.
+		size_t visibleCount = 0;
+		for (auto a : viewActors)
+		{
+			if (!a->Occluder && !culler.IsVisible(store.GetBound(a->Handle)))
+			{
+				a->ViewMask &= ~(1u << view);
+				if (view == mMainView)
+					a->Visible = false;
+				continue;
+			}
+
+			viewActors[visibleCount++] = a;
+		}
+
+		size_t occluded = viewActors.size() - visibleCount;
+		viewActors.resize(visibleCount);
+		return occluded;
+	}
+
+	void DrawList::UpdateCachedDraw(const ActorStore& store, ActorView* actor)
+	{
+		uint32_t slotIndex = actor->Handle.Index();
+		if (slotIndex >= mCachedDraws.size())
+			mCachedDraws.resize(slotIndex + 1);
+
+		CachedDraw& draw = mCachedDraws[slotIndex];
+		uint32_t revision = store.GetRevision(actor->Handle);
+		if (draw.Handle == actor->Handle && draw.Revision == revision)
+			return;
+
+		draw.Handle = actor->Handle;
+		draw.Revision = revision;
+		draw.Owner = actor;
+
+		uint32_t dense = store.IndexOf(actor->Handle);
+		const Submesh* submesh = store.GetSubmeshes()[dense];
+
+		for (uint32_t pass = 0; pass < MaxViews; ++pass)
+		{
+			draw.Keys[pass] = NoDrawKey;
+			if (submesh == nullptr)
+				continue;
+
+			const std::vector<PassSlot>& slots = mPassSlots[pass];
+			for (uint32_t slot = 0; slot < slots.size(); ++slot)
+			{
+				if (slots[slot].Layers & actor->RenderLayer)
+				{
+					draw.Keys[pass] = DrawKey::State(pass, slot, slots[slot].Pipeline, submesh->Id, store.GetMaterials()[dense], slots[slot].Translucent);
+					break;
+				}
+			}
+		}
+
+		if (submesh == nullptr)
+			return;
+
+		draw.VertexBuffer = actor->VertexBuffer;
+		draw.IndexBuffer = actor->IndexBuffer;
+		draw.Topology = actor->Topology;
+
+		draw.Lods[0] = { submesh->Id, submesh->IndexCount, submesh->StartIndexLocation, submesh->BaseVertexLocation };
+		draw.LodCount = 1;
+		for (const SubmeshLod& lod : submesh->Lods)
+		{
+			if (draw.LodCount == MaxLods || actor->Submeshes == nullptr)
+				break;
+
+			auto it = actor->Submeshes->find(lod.DrawArg);
+			if (it == actor->Submeshes->end())
+				break;
+
+			const Submesh& level = it->second;
+			draw.LodSwitchRadii[draw.LodCount - 1] = lod.SwitchPixelRadius;
+			draw.Lods[draw.LodCount++] = { level.Id, level.IndexCount, level.StartIndexLocation, level.BaseVertexLocation };
+		}
+
+		for (uint32_t pass = 0; pass < MaxViews; ++pass)
+			draw.LastLod[pass] = -1;
+
+		draw.Skinned = (store.GetFlags()[dense] & Actor_Flag_Skinned) != 0;
+		draw.SkinnedCBIndex = actor->SkinnedCBIndex;
+	}
+
+	void DrawList::BuildDrawPackets(const ActorStore& store, const LodSelector& lodSelector, const DirectX::XMFLOAT3* eyes, const LodView* lodViews)
+	{
+		// Refresh first; packets keep pointers into mCachedDraws, which may grow here.
+		for (auto a : mVisibleActors)
+		{
+			if (a->ViewMask != 0)
+				UpdateCachedDraw(store, a);
+		}
+
+		mDrawPackets.clear();
+
+		for (uint32_t pass = 0; pass < MaxViews; ++pass)
+		{
+			const std::vector<PassSlot>& slots = mPassSlots[pass];
+			if (slots.empty())
+				continue;
+
+			DirectX::XMVECTOR eye = DirectX::XMLoadFloat3(&eyes[pass]);
+
+			for (auto a : mViewActors[pass])
+			{
+				CachedDraw& draw = mCachedDraws[a->Handle.Index()];
+				uint64_t state = draw.Keys[pass];
+				if (state == NoDrawKey)
+					continue;
+
+				const DirectX::BoundingBox& bound = store.GetBound(a->Handle);
+				bool translucent = slots[DrawKey::Slot(state)].Translucent;
+
+				float pixelRadius = LodSelector::ProjectedPixelRadius(lodViews[pass], bound);
+				int lod = LodSelector::Select(pixelRadius, draw.LodSwitchRadii, draw.LodCount, lodSelector.GetLayerSettings(a->RenderLayer), draw.LastLod[pass]);
+				draw.LastLod[pass] = (int8_t)lod;
+				if (lod < 0)
+					continue;
+
+				if (lod > 0)
+					state = DrawKey::WithSubmesh(state, draw.Lods[lod].SubmeshId, translucent);
+
+				DirectX::XMVECTOR center = DirectX::XMLoadFloat3(&bound.Center);
+				float depth = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(DirectX::XMVectorSubtract(center, eye)));
+
+				mDrawPackets.push_back({ DrawKey::WithDepth(state, depth, translucent), &draw, (uint32_t)lod });
+			}
+		}
+
+		mDrawPacketSorter.Sort(mDrawPackets);
+	}
+
+	void DrawList::Submit(CommandRecorder& recorder, uint32_t pass, uint32_t firstSlot, uint32_t lastSlot, const DrawSubmitState& state) const
+	{
+		uint64_t beginKey = DrawKey::Begin(pass, firstSlot);
+		uint64_t endKey = lastSlot + 1 < MaxSlots ? DrawKey::Begin(pass, lastSlot + 1) : DrawKey::Begin(pass + 1);
+
+		auto keyLess = [this](const DrawBatch& batch, uint64_t key) { return mDrawPackets[batch.FirstPacket].Key < key; };
+		auto first = std::lower_bound(mDrawBatches.begin(), mDrawBatches.end(), beginKey, keyLess);
+		auto last = std::lower_bound(first, mDrawBatches.end(), endKey, keyLess);
+
+		for (auto batch = first; batch != last; ++batch)
+		{
+			const DrawPacket& packet = mDrawPackets[batch->FirstPacket];
+			const CachedDraw* draw = static_cast<const CachedDraw*>(packet.Item);
+			const CachedLod& lod = draw->Lods[packet.Variant];
+
+			recorder.SetPipelineState(state.PipelineOverride.IsNull() ? state.Pipelines[DrawKey::Pipeline(packet.Key)] : state.PipelineOverride);
+
+			recorder.SetVertexBuffer(draw->VertexBuffer);
+			recorder.SetIndexBuffer(draw->IndexBuffer);
+			recorder.SetPrimitiveTopology(draw->Topology);
+
+			recorder.SetGraphicsRootShaderResourceView(state.InstanceIndicesParameter, state.InstanceIndices + (GpuVirtualAddress)batch->InstanceOffset * state.InstanceIndexStride);
+			recorder.SetGraphicsRootConstantBufferView(state.SkinnedCBParameter, draw->Skinned ? state.SkinnedCB + (GpuVirtualAddress)draw->SkinnedCBIndex * state.SkinnedCBStride : 0);
+
+			recorder.DrawIndexedInstanced(lod.IndexCount, batch->InstanceCount, lod.StartIndexLocation, lod.BaseVertexLocation, 0);
+		}
+	}
+}
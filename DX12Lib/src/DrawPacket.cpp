@@ -0,0 +1,144 @@
+#include "DX12Lib/DrawPacket.h"
+#include <assert.h>
+#include <algorithm>
+#include <cstring>
+
+namespace DX12Lib
+{
+	namespace
+	{
+		// Non-negative floats order like their bit patterns; the top bits are kept.
+		inline uint32_t QuantizeDepth(float depth)
+		{
+			if (!(depth > 0.0f))
+				return 0;
+
+			uint32_t bits;
+			std::memcpy(&bits, &depth, sizeof(bits));
+			return bits >> (32 - DrawKey::DepthBits);
+		}
+
+		inline uint64_t Field(uint32_t value, int bits, int shift)
+		{
+			uint32_t mask = (1u << bits) - 1;
+			assert(value <= mask && "Draw key field out of range");
+			return (uint64_t)(value & mask) << shift;
+		}
+	}
+
+	uint64_t DrawKey::Make(uint32_t pass, uint32_t slot, uint32_t pipeline, uint32_t submesh, uint32_t material, float depth, bool translucent)
+	{
+		return WithDepth(State(pass, slot, pipeline, submesh, material, translucent), depth, translucent);
+	}
+
+	uint64_t DrawKey::State(uint32_t pass, uint32_t slot, uint32_t pipeline, uint32_t submesh, uint32_t material, bool translucent)
+	{
+		uint64_t key = Field(pass, PassBits, PassShift) | Field(slot, SlotBits, SlotShift) | Field(pipeline, PipelineBits, PipelineShift);
+
+		if (!translucent)
+			return key | Field(submesh, SubmeshBits, SubmeshShift) | Field(material, MaterialBits, MaterialShift);
+
+		// The state fields below the pipeline move down to make room for the depth.
+		return key | Field(submesh, SubmeshBits, MaterialBits) | Field(material, MaterialBits, 0);
+	}
+
+	uint64_t DrawKey::WithDepth(uint64_t state, float depth, bool translucent)
+	{
+		uint32_t depthBits = QuantizeDepth(depth);
+
+		if (!translucent)
+			return state | Field(depthBits, DepthBits, DepthShift);
+
+		uint32_t farFirst = ((1u << DepthBits) - 1) - depthBits;
+		return state | Field(farFirst, DepthBits, PipelineShift - DepthBits);
+	}
+
+	uint64_t DrawKey::WithSubmesh(uint64_t key, uint32_t submesh, bool translucent)
+	{
+		int shift = translucent ? MaterialBits : SubmeshShift;
+		uint64_t mask = (uint64_t)((1u << SubmeshBits) - 1) << shift;
+		return (key & ~mask) | Field(submesh, SubmeshBits, shift);
+	}
+
+	DrawPacketSorter::DrawPacketSorter(JobSystem& jobs) :
+		mJobs(jobs)
+	{
+		mCounts.resize(jobs.GetThreadCount());
+	}
+
+	void DrawPacketSorter::Sort(std::vector<DrawPacket>& packets)
+	{
+		mCount = packets.size();
+		if (mCount < 2)
+			return;
+
+		// Bits that differ between any two keys; bytes without any are already sorted.
+		uint64_t keyAnd = ~0ull, keyOr = 0;
+		for (const DrawPacket& packet : packets)
+		{
+			keyAnd &= packet.Key;
+			keyOr |= packet.Key;
+		}
+		uint64_t varying = keyAnd ^ keyOr;
+
+		mScratch.resize(mCount);
+		mPartCount = mCount >= ParallelThreshold ? (unsigned)mCounts.size() : 1;
+
+		DrawPacket* source = packets.data();
+		DrawPacket* destination = mScratch.data();
+
+		for (int shift = 0; shift < 64; shift += 8)
+		{
+			if (((varying >> shift) & 0xff) == 0)
+				continue;
+
+			mSource = source;
+			mDestination = destination;
+			mShift = shift;
+
+			mJobs.ParallelFor(mPartCount, [this](unsigned part) { Histogram(part); });
+
+			// Exclusive prefix over buckets, then over parts within a bucket, keeps it stable.
+			uint32_t offset = 0;
+			for (int bucket = 0; bucket < 256; ++bucket)
+			{
+				for (unsigned part = 0; part < mPartCount; ++part)
+				{
+					uint32_t count = mCounts[part][bucket];
+					mCounts[part][bucket] = offset;
+					offset += count;
+				}
+			}
+
+			mJobs.ParallelFor(mPartCount, [this](unsigned part) { Scatter(part); });
+
+			std::swap(source, destination);
+		}
+
+		if (source != packets.data())
+			packets.swap(mScratch);
+	}
+
+	void DrawPacketSorter::Histogram(unsigned part)
+	{
+		size_t begin = mCount * part / mPartCount;
+		size_t end = mCount * (part + 1) / mPartCount;
+
+		std::array<uint32_t, 256>& counts = mCounts[part];
+		counts.fill(0);
+
+		for (size_t i = begin; i < end; ++i)
+			++counts[(mSource[i].Key >> mShift) & 0xff];
+	}
+
+	void DrawPacketSorter::Scatter(unsigned part)
+	{
+		size_t begin = mCount * part / mPartCount;
+		size_t end = mCount * (part + 1) / mPartCount;
+
+		std::array<uint32_t, 256>& offsets = mCounts[part];
+
+		for (size_t i = begin; i < end; ++i)
+			mDestination[offsets[(mSource[i].Key >> mShift) & 0xff]++] = mSource[i];
+	}
+}
@@ -0,0 +1,360 @@
+#include "DX12Lib/FrustumCulling.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define DX12LIB_CULL_NEON 1
+#include <arm_neon.h>
+#elif defined(__AVX2__)
+#define DX12LIB_CULL_AVX2 1
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define DX12LIB_CULL_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace DX12Lib
+{
+	namespace
+	{
+#if defined(DX12LIB_CULL_AVX2)
+		const size_t BatchSize = 8;
+
+		struct Batch
+		{
+			__m256 CX, CY, CZ, EX, EY, EZ;
+		};
+
+		inline Batch LoadBatch(const BoundsSoA& bounds, size_t i)
+		{
+			return {
+				_mm256_loadu_ps(&bounds.CenterX[i]), _mm256_loadu_ps(&bounds.CenterY[i]), _mm256_loadu_ps(&bounds.CenterZ[i]),
+				_mm256_loadu_ps(&bounds.ExtentX[i]), _mm256_loadu_ps(&bounds.ExtentY[i]), _mm256_loadu_ps(&bounds.ExtentZ[i]) };
+		}
+
+		// Returns one bit per box in the batch that is fully outside some plane.
+		inline uint32_t OutsideBits(const FrustumPlanes& planes, const Batch& b)
+		{
+			__m256 outside = _mm256_setzero_ps();
+			for (int p = 0; p < FrustumPlanes::PlaneCount; ++p)
+			{
+				__m256 nx = _mm256_set1_ps(planes.NormalX[p]);
+				__m256 ny = _mm256_set1_ps(planes.NormalY[p]);
+				__m256 nz = _mm256_set1_ps(planes.NormalZ[p]);
+				__m256 ax = _mm256_set1_ps(fabsf(planes.NormalX[p]));
+				__m256 ay = _mm256_set1_ps(fabsf(planes.NormalY[p]));
+				__m256 az = _mm256_set1_ps(fabsf(planes.NormalZ[p]));
+
+				// Plain multiply and add: AVX2 does not imply FMA, and unfused rounding matches the scalar path.
+				__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, b.CX), _mm256_mul_ps(ny, b.CY)), _mm256_add_ps(_mm256_mul_ps(nz, b.CZ), _mm256_set1_ps(planes.Distance[p])));
+				__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, b.EX), _mm256_mul_ps(ay, b.EY)), _mm256_mul_ps(az, b.EZ));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, radius, _CMP_GT_OQ));
+			}
+
+			return (uint32_t)_mm256_movemask_ps(outside);
+		}
+#elif defined(DX12LIB_CULL_SSE)
+		const size_t BatchSize = 4;
+
+		struct Batch
+		{
+			__m128 CX, CY, CZ, EX, EY, EZ;
+		};
+
+		inline Batch LoadBatch(const BoundsSoA& bounds, size_t i)
+		{
+			return {
+				_mm_loadu_ps(&bounds.CenterX[i]), _mm_loadu_ps(&bounds.CenterY[i]), _mm_loadu_ps(&bounds.CenterZ[i]),
+				_mm_loadu_ps(&bounds.ExtentX[i]), _mm_loadu_ps(&bounds.ExtentY[i]), _mm_loadu_ps(&bounds.ExtentZ[i]) };
+		}
+
+		inline uint32_t OutsideBits(const FrustumPlanes& planes, const Batch& b)
+		{
+			__m128 outside = _mm_setzero_ps();
+			for (int p = 0; p < FrustumPlanes::PlaneCount; ++p)
+			{
+				__m128 nx = _mm_set1_ps(planes.NormalX[p]);
+				__m128 ny = _mm_set1_ps(planes.NormalY[p]);
+				__m128 nz = _mm_set1_ps(planes.NormalZ[p]);
+				__m128 ax = _mm_set1_ps(fabsf(planes.NormalX[p]));
+				__m128 ay = _mm_set1_ps(fabsf(planes.NormalY[p]));
+				__m128 az = _mm_set1_ps(fabsf(planes.NormalZ[p]));
+
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, b.CX), _mm_mul_ps(ny, b.CY)), _mm_add_ps(_mm_mul_ps(nz, b.CZ), _mm_set1_ps(planes.Distance[p])));
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, b.EX), _mm_mul_ps(ay, b.EY)), _mm_mul_ps(az, b.EZ));
+				outside = _mm_or_ps(outside, _mm_cmpgt_ps(dist, radius));
+			}
+
+			return (uint32_t)_mm_movemask_ps(outside);
+		}
+#elif defined(DX12LIB_CULL_NEON)
+		const size_t BatchSize = 4;
+
+		struct Batch
+		{
+			float32x4_t CX, CY, CZ, EX, EY, EZ;
+		};
+
+		inline Batch LoadBatch(const BoundsSoA& bounds, size_t i)
+		{
+			return {
+				vld1q_f32(&bounds.CenterX[i]), vld1q_f32(&bounds.CenterY[i]), vld1q_f32(&bounds.CenterZ[i]),
+				vld1q_f32(&bounds.ExtentX[i]), vld1q_f32(&bounds.ExtentY[i]), vld1q_f32(&bounds.ExtentZ[i]) };
+		}
+
+		inline uint32_t OutsideBits(const FrustumPlanes& planes, const Batch& b)
+		{
+			static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+
+			uint32x4_t outside = vdupq_n_u32(0);
+			for (int p = 0; p < FrustumPlanes::PlaneCount; ++p)
+			{
+				float32x4_t dist = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(planes.Distance[p]), b.CX, planes.NormalX[p]), b.CY, planes.NormalY[p]), b.CZ, planes.NormalZ[p]);
+				float32x4_t radius = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(b.EX, fabsf(planes.NormalX[p])), b.EY, fabsf(planes.NormalY[p])), b.EZ, fabsf(planes.NormalZ[p]));
+				outside = vorrq_u32(outside, vcgtq_f32(dist, radius));
+			}
+
+			return vaddvq_u32(vandq_u32(outside, vld1q_u32(laneBits)));
+		}
+#else
+		const size_t BatchSize = 1;
+
+		struct Batch
+		{
+			float CX, CY, CZ, EX, EY, EZ;
+		};
+
+		inline Batch LoadBatch(const BoundsSoA& bounds, size_t i)
+		{
+			return { bounds.CenterX[i], bounds.CenterY[i], bounds.CenterZ[i], bounds.ExtentX[i], bounds.ExtentY[i], bounds.ExtentZ[i] };
+		}
+
+		inline uint32_t OutsideBits(const FrustumPlanes& planes, const Batch& b)
+		{
+			for (int p = 0; p < FrustumPlanes::PlaneCount; ++p)
+			{
+				float dist = planes.NormalX[p] * b.CX + planes.NormalY[p] * b.CY + planes.NormalZ[p] * b.CZ + planes.Distance[p];
+				float radius = fabsf(planes.NormalX[p]) * b.EX + fabsf(planes.NormalY[p]) * b.EY + fabsf(planes.NormalZ[p]) * b.EZ;
+				if (dist > radius)
+					return 1;
+			}
+
+			return 0;
+		}
+#endif
+
+		const uint32_t BatchMask = (1u << BatchSize) - 1u;
+
+		static_assert(BoundsSoA::Alignment % BatchSize == 0, "BoundsSoA padding must cover a whole batch.");
+		static_assert(32 % BatchSize == 0, "A batch must not straddle two mask words.");
+	}
+
+	FrustumPlanes FrustumPlanes::FromFrustum(const DirectX::BoundingFrustum& frustum)
+	{
+		DirectX::XMVECTOR planes[PlaneCount];
+		frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+
+		FrustumPlanes result;
+		for (int i = 0; i < PlaneCount; ++i)
+		{
+			DirectX::XMFLOAT4 plane;
+			DirectX::XMStoreFloat4(&plane, planes[i]);
+
+			result.NormalX[i] = plane.x;
+			result.NormalY[i] = plane.y;
+			result.NormalZ[i] = plane.z;
+			result.Distance[i] = plane.w;
+		}
+
+		return result;
+	}
+
+	FrustumPlanes FrustumPlanes::FromViewProj(DirectX::FXMMATRIX viewProj)
+	{
+		// Planes of the D3D clip volume (-w <= x,y <= w, 0 <= z <= w) in world space.
+		// DirectXMath uses row vectors, so each plane is a combination of matrix columns.
+		DirectX::XMFLOAT4X4 m;
+		DirectX::XMStoreFloat4x4(&m, viewProj);
+
+		auto column = [&m](int c) { return DirectX::XMFLOAT4(m.m[0][c], m.m[1][c], m.m[2][c], m.m[3][c]); };
+		DirectX::XMFLOAT4 c0 = column(0), c1 = column(1), c2 = column(2), c3 = column(3);
+
+		// Inward facing planes: left, right, bottom, top, near, far.
+		DirectX::XMFLOAT4 inward[PlaneCount] =
+		{
+			DirectX::XMFLOAT4(c3.x + c0.x, c3.y + c0.y, c3.z + c0.z, c3.w + c0.w),
+			DirectX::XMFLOAT4(c3.x - c0.x, c3.y - c0.y, c3.z - c0.z, c3.w - c0.w),
+			DirectX::XMFLOAT4(c3.x + c1.x, c3.y + c1.y, c3.z + c1.z, c3.w + c1.w),
+			DirectX::XMFLOAT4(c3.x - c1.x, c3.y - c1.y, c3.z - c1.z, c3.w - c1.w),
+			c2,
+			DirectX::XMFLOAT4(c3.x - c2.x, c3.y - c2.y, c3.z - c2.z, c3.w - c2.w),
+		};
+
+		FrustumPlanes result;
+		for (int i = 0; i < PlaneCount; ++i)
+		{
+			const DirectX::XMFLOAT4& p = inward[i];
+			float invLength = 1.0f / sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+
+			result.NormalX[i] = -p.x * invLength;
+			result.NormalY[i] = -p.y * invLength;
+			result.NormalZ[i] = -p.z * invLength;
+			result.Distance[i] = -p.w * invLength;
+		}
+
+		return result;
+	}
+
+	FrustumPlanes FrustumPlanes::FromBox(const DirectX::BoundingBox& box)
+	{
+		const DirectX::XMFLOAT3& c = box.Center;
+		const DirectX::XMFLOAT3& e = box.Extents;
+
+		FrustumPlanes result = {};
+		result.NormalX[0] = -1.0f; result.Distance[0] = c.x - e.x;
+		result.NormalX[1] = +1.0f; result.Distance[1] = -(c.x + e.x);
+		result.NormalY[2] = -1.0f; result.Distance[2] = c.y - e.y;
+		result.NormalY[3] = +1.0f; result.Distance[3] = -(c.y + e.y);
+		result.NormalZ[4] = -1.0f; result.Distance[4] = c.z - e.z;
+		result.NormalZ[5] = +1.0f; result.Distance[5] = -(c.z + e.z);
+
+		return result;
+	}
+
+	void BoundsSoA::Clear()
+	{
+		mSize = 0;
+		CenterX.clear(); CenterY.clear(); CenterZ.clear();
+		ExtentX.clear(); ExtentY.clear(); ExtentZ.clear();
+	}
+
+	void BoundsSoA::Reserve(size_t count)
+	{
+		count = (count + Alignment - 1) / Alignment * Alignment;
+		CenterX.reserve(count); CenterY.reserve(count); CenterZ.reserve(count);
+		ExtentX.reserve(count); ExtentY.reserve(count); ExtentZ.reserve(count);
+	}
+
+	void BoundsSoA::Push(const DirectX::BoundingBox& box)
+	{
+		if (mSize == CenterX.size())
+		{
+			// Grow by a whole batch; the padding boxes are degenerate and never read back.
+			size_t padded = mSize + Alignment;
+			CenterX.resize(padded, 0.0f); CenterY.resize(padded, 0.0f); CenterZ.resize(padded, 0.0f);
+			ExtentX.resize(padded, 0.0f); ExtentY.resize(padded, 0.0f); ExtentZ.resize(padded, 0.0f);
+		}
+
+		CenterX[mSize] = box.Center.x;
+		CenterY[mSize] = box.Center.y;
+		CenterZ[mSize] = box.Center.z;
+		ExtentX[mSize] = box.Extents.x;
+		ExtentY[mSize] = box.Extents.y;
+		ExtentZ[mSize] = box.Extents.z;
+		++mSize;
+	}
+
+	void CullBoxesScalar(const FrustumPlanes& planes, const BoundsSoA& bounds, uint32_t* visibleMask)
+	{
+		const size_t count = bounds.Size();
+		memset(visibleMask, 0, CullMaskWordCount(count) * sizeof(uint32_t));
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			bool outside = false;
+			for (int p = 0; p < FrustumPlanes::PlaneCount && !outside; ++p)
+			{
+				float dist = planes.NormalX[p] * bounds.CenterX[i] + planes.NormalY[p] * bounds.CenterY[i] + planes.NormalZ[p] * bounds.CenterZ[i] + planes.Distance[p];
+				float radius = fabsf(planes.NormalX[p]) * bounds.ExtentX[i] + fabsf(planes.NormalY[p]) * bounds.ExtentY[i] + fabsf(planes.NormalZ[p]) * bounds.ExtentZ[i];
+				outside = dist > radius;
+			}
+
+			if (!outside)
+				visibleMask[i / 32] |= 1u << (i % 32);
+		}
+	}
+
+	void CullBoxes(const FrustumPlanes& planes, const BoundsSoA& bounds, uint32_t* visibleMask)
+	{
+		const size_t count = bounds.Size();
+		memset(visibleMask, 0, CullMaskWordCount(count) * sizeof(uint32_t));
+
+		for (size_t i = 0; i < count; i += BatchSize)
+		{
+			uint32_t bits = ~OutsideBits(planes, LoadBatch(bounds, i)) & BatchMask;
+			visibleMask[i / 32] |= bits << (i % 32);
+		}
+
+		// Clear bits written for the padding boxes.
+		if (count % 32)
+			visibleMask[count / 32] &= (1u << (count % 32)) - 1u;
+	}
+
+	void CullBoxesMultiView(const FrustumPlanes* views, int viewCount, const BoundsSoA& bounds, uint32_t* viewMasks)
+	{
+		const size_t count = bounds.Size();
+
+		for (size_t i = 0; i < count; i += BatchSize)
+		{
+			// Each batch is loaded once and tested against every view while it is in registers.
+			Batch batch = LoadBatch(bounds, i);
+
+			uint32_t laneMasks[BatchSize] = {};
+			for (int v = 0; v < viewCount; ++v)
+			{
+				uint32_t visible = ~OutsideBits(views[v], batch) & BatchMask;
+				for (size_t lane = 0; lane < BatchSize; ++lane)
+					laneMasks[lane] |= ((visible >> lane) & 1u) << v;
+			}
+
+			size_t lanes = count - i < BatchSize ? count - i : BatchSize;
+			for (size_t lane = 0; lane < lanes; ++lane)
+				viewMasks[i + lane] = laneMasks[lane];
+		}
+	}
+
+	void CullBoxesCubeFaces(const DirectX::XMFLOAT3& origin, float nearZ, float farZ, const BoundsSoA& bounds, uint8_t* faceMasks)
+	{
+		const size_t count = bounds.Size();
+
+		// Plain loop over the SoA arrays; it has no cross-lane work, so the compiler vectorizes it.
+		for (size_t i = 0; i < count; ++i)
+		{
+			float cx = bounds.CenterX[i] - origin.x;
+			float cy = bounds.CenterY[i] - origin.y;
+			float cz = bounds.CenterZ[i] - origin.z;
+			float ex = bounds.ExtentX[i];
+			float ey = bounds.ExtentY[i];
+			float ez = bounds.ExtentZ[i];
+
+			// For each diagonal pair (a, b), whether a - b and a + b reach above / below zero
+			// somewhere in the box. Every face side plane is one of these.
+			float rxy = ex + ey, rxz = ex + ez, ryz = ey + ez;
+			float dxy = cx - cy, sxy = cx + cy;
+			float dxz = cx - cz, sxz = cx + cz;
+			float dyz = cy - cz, syz = cy + cz;
+
+			bool dxyPos = dxy >= -rxy, dxyNeg = dxy <= rxy, sxyPos = sxy >= -rxy, sxyNeg = sxy <= rxy;
+			bool dxzPos = dxz >= -rxz, dxzNeg = dxz <= rxz, sxzPos = sxz >= -rxz, sxzNeg = sxz <= rxz;
+			bool dyzPos = dyz >= -ryz, dyzNeg = dyz <= ryz, syzPos = syz >= -ryz, syzNeg = syz <= ryz;
+
+			// Near and far planes, per axis direction.
+			bool px = cx + ex >= nearZ && cx - ex <= farZ;
+			bool nx = cx - ex <= -nearZ && cx + ex >= -farZ;
+			bool py = cy + ey >= nearZ && cy - ey <= farZ;
+			bool ny = cy - ey <= -nearZ && cy + ey >= -farZ;
+			bool pz = cz + ez >= nearZ && cz - ez <= farZ;
+			bool nz = cz - ez <= -nearZ && cz + ez >= -farZ;
+
+			uint32_t mask = 0;
+			mask |= (uint32_t)(px && dxyPos && sxyPos && dxzPos && sxzPos) << 0;
+			mask |= (uint32_t)(nx && dxyNeg && sxyNeg && dxzNeg && sxzNeg) << 1;
+			mask |= (uint32_t)(py && dxyNeg && sxyPos && dyzPos && syzPos) << 2;
+			mask |= (uint32_t)(ny && dxyPos && sxyNeg && dyzNeg && syzNeg) << 3;
+			mask |= (uint32_t)(pz && dxzNeg && sxzPos && dyzNeg && syzPos) << 4;
+			mask |= (uint32_t)(nz && dxzPos && sxzNeg && dyzPos && syzNeg) << 5;
+
+			faceMasks[i] = (uint8_t)mask;
+		}
+	}
+}
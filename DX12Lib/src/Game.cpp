@@ -1,14 +1,24 @@
 #include "DX12Lib/Game.h"
+#include <assert.h>
+#include <algorithm>
 #include <chrono>
 #include <d3dcompiler.h>
 #include <DirectXColors.h>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 
 namespace DX12Lib
 {
+	// Baked offline by running the demo with --bake-pvs, only loaded at startup.
+	static const char* const PvsFilename = "assets/scene.pvs";
+
 	Game::Game(HINSTANCE hInstance)
 		: Application(hInstance)
+		, mWorldStreamer(mJobs)
+		, mOcclusionCuller(mJobs)
+		, mDrawList(mJobs)
+		, mIndirectDrawBuilder(mJobs)
 	{
 		// Estimate the scene bounding sphere manually since we know how the scene was constructed.
 		// The grid is the "widest object" with a width of 20 and depth of 30.0f, and centered at
@@ -52,14 +62,20 @@ namespace DX12Lib
 		InitDescriptorHeaps();
 		InitMaterials();
 		InitActors();
+		InitHlods();
+		InitSceneBVH();
+		InitPvs();
+		InitStreaming();
 
 		InitRootSignature();
+		InitCommandSignature();
 		InitSsaoRootSignature();
 		InitPostProcessRootSignature();
 		InitPSOs();
+		InitDrawPasses();
 
 		mSsao = std::make_unique<Ssao>(mDevice.Get(), mCommandList.Get());
-		mSsao->SetPSOs(mPSOs[L"ssao"].Get(), mPSOs[L"ssaoBlur"].Get());
+		mSsao->SetPSOs(mPSOs[PSO_Ssao].Get(), mPSOs[PSO_SsaoBlur].Get());
 
 		InitFrameResources();
 
@@ -84,18 +100,25 @@ namespace DX12Lib
 			WaitForSingleObject(eventHandle, INFINITE);
 			CloseHandle(eventHandle);
 		}
+		mFrameResources[mCurrFrameResourceIndex]->Uploads->Reset();
 
 		OnInput(timer);
 		Tick(timer);
+		UpdateTransforms();
+		UpdateHlods();
+		UpdateStreaming();
 
+		// The shadow view has to be known before culling.
+		UpdateShadowTransform(timer);
+		UpdateVisibility(timer);
+		// Indirect draw arguments carry the skinned constant address.
+		UpdateSkinnedCBs(timer);
 		UpdateInstanceBuffer(timer);
 		UpdateMaterialBuffer(timer);
-		UpdateShadowTransform(timer);
 		UpdateMainPassCB(timer);
 		UpdateShadowPassCB(timer);
 		UpdateCubeMapFacePassCBs(timer);
 		UpdateSsaoPassCB(timer);
-		UpdateSkinnedCBs(timer);
 		//UpdateReflectedPassCB(timer);
 	}
 
@@ -104,16 +127,21 @@ namespace DX12Lib
 		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> cmdListAlloc = mFrameResources[mCurrFrameResourceIndex]->CmdListAlloc;
 
 		ThrowIfFailed(cmdListAlloc->Reset());
-		ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mPSOs[L"opaque"].Get()));
+		ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mPSOs[PSO_Opaque].Get()));
+		mCommandRecorder.SetCommandList(mCommandList.Get());
+		mCommandRecorder.ResetStats();
 
-		mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
+		mCommandRecorder.SetGraphicsRootSignature(ToHandle(mRootSignature.Get()));
 
 		ID3D12DescriptorHeap* descriptorHeaps0[] = { mSrvHeap.Get() };
 		mCommandList->SetDescriptorHeaps(_countof(descriptorHeaps0), descriptorHeaps0);
 
+		auto instanceBuffer = mFrameResources[mCurrFrameResourceIndex]->InstanceBuffer->Resource();
 		auto matBuffer = mFrameResources[mCurrFrameResourceIndex]->MaterialBuffer->Resource();
-		CD3DX12_GPU_DESCRIPTOR_HANDLE skyTexDescriptor(mSrvHeap->GetGPUDescriptorHandleForHeapStart(), mAssetManager.FindTextureIndex(L"skyCubeMap"), mCbvSrvUavDescriptorSize);
+		CD3DX12_GPU_DESCRIPTOR_HANDLE skyTexDescriptor(mSrvHeap->GetGPUDescriptorHandleForHeapStart(), mSkyTexSrvIndex, mCbvSrvUavDescriptorSize);
 
+		// Draws only move the instance index view; the instance slots are shared by all passes.
+		mCommandList->SetGraphicsRootShaderResourceView(RSP_InstanceBuffer, instanceBuffer->GetGPUVirtualAddress());
 		mCommandList->SetGraphicsRootShaderResourceView(RSP_MaterialBuffer, matBuffer->GetGPUVirtualAddress());
 		mCommandList->SetGraphicsRootDescriptorTable(RSP_CubeMap, skyTexDescriptor);
 		mCommandList->SetGraphicsRootDescriptorTable(RSP_AllTextures, mSrvHeap->GetGPUDescriptorHandleForHeapStart());
@@ -123,7 +151,7 @@ namespace DX12Lib
 
 		//RenderNormalsAndDepth();
 		//mCommandList->SetGraphicsRootSignature(mSsaoRootSignature.Get());
-		//mSsao->ComputeSsao(mCommandList.Get(), mFrameResources[mCurrFrameResourceIndex].get(), 3);
+		//mSsao->ComputeSsao(mCommandList.Get(), mSsaoCBAddress, 3);
 		//mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
 
 		RenderSceneToBackbuffer();
@@ -150,7 +178,7 @@ namespace DX12Lib
 		ID3D12DescriptorHeap* descriptorHeaps0[] = { mSrvHeap.Get() };
 		ID3D12DescriptorHeap* descriptorHeaps1[] = { mDynamicCubeMap->GetSRVHeap() };
 		ID3D12DescriptorHeap* descriptorHeaps2[] = { mShadowMap->GetSRVHeap() };
-		CD3DX12_GPU_DESCRIPTOR_HANDLE skyTexDescriptor(mSrvHeap->GetGPUDescriptorHandleForHeapStart(), mAssetManager.FindTextureIndex(L"skyCubeMap"), mCbvSrvUavDescriptorSize);
+		CD3DX12_GPU_DESCRIPTOR_HANDLE skyTexDescriptor(mSrvHeap->GetGPUDescriptorHandleForHeapStart(), mSkyTexSrvIndex, mCbvSrvUavDescriptorSize);
 
 		mCommandList->RSSetViewports(1, &mViewport);
 		mCommandList->RSSetScissorRects(1, &mScissorRect);
@@ -163,8 +191,7 @@ namespace DX12Lib
 
 		mCommandList->OMSetRenderTargets(1, &bbv, true, &dsv);
 
-		auto passCB = mFrameResources[mCurrFrameResourceIndex]->PassCB->Resource();
-		mCommandList->SetGraphicsRootConstantBufferView(RSP_PassCB, passCB->GetGPUVirtualAddress());
+		mCommandList->SetGraphicsRootConstantBufferView(RSP_PassCB, mPassCBAddresses[0]);
 
 		mCommandList->SetDescriptorHeaps(_countof(descriptorHeaps1), descriptorHeaps1);
 		mCommandList->SetGraphicsRootDescriptorTable(RSP_CubeMap, mDynamicCubeMap->GetSRV());
@@ -172,20 +199,11 @@ namespace DX12Lib
 		mCommandList->SetGraphicsRootDescriptorTable(RSP_ShadowMap, mShadowMap->GetSRV());
 		mCommandList->SetDescriptorHeaps(_countof(descriptorHeaps0), descriptorHeaps0);
 
-		mCommandList->SetPipelineState(mPSOs[L"opaque"].Get());
-		RenderActors(mCommandList.Get(), mFrameResources[mCurrFrameResourceIndex].get(), mAssetManager.GetActors(Render_Layer_OpaqueDynamicReflectors));
+		// Reflectors sample the dynamic cube map, everything after them the sky.
+		SubmitDrawPackets(mCommandRecorder, mFrameResources[mCurrFrameResourceIndex].get(), CV_Main, MainSlot_Reflectors, MainSlot_Reflectors);
 		mCommandList->SetGraphicsRootDescriptorTable(RSP_CubeMap, skyTexDescriptor);
 
-		RenderActors(mCommandList.Get(), mFrameResources[mCurrFrameResourceIndex].get(), mAssetManager.GetActors(Render_Layer_Opaque));
-
-		mCommandList->SetPipelineState(mPSOs[L"skinnedOpaque"].Get());
-		RenderActors(mCommandList.Get(), mFrameResources[mCurrFrameResourceIndex].get(), mAssetManager.GetActors(Render_Layer_SKinnedOpaque));
-
-		mCommandList->SetPipelineState(mPSOs[L"debug"].Get());
-		RenderActors(mCommandList.Get(), mFrameResources[mCurrFrameResourceIndex].get(), mAssetManager.GetActors(Render_Layer_Debug));
-
-		mCommandList->SetPipelineState(mPSOs[L"sky"].Get());
-		RenderActors(mCommandList.Get(), mFrameResources[mCurrFrameResourceIndex].get(), mAssetManager.GetActors(Render_Layer_Sky));
+		SubmitDrawPackets(mCommandRecorder, mFrameResources[mCurrFrameResourceIndex].get(), CV_Main, MainSlot_Opaque);
 
 		CD3DX12_RESOURCE_BARRIER barrier3 = CD3DX12_RESOURCE_BARRIER::Transition(backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
 		mCommandList->ResourceBarrier(1, &barrier3);
@@ -213,12 +231,9 @@ namespace DX12Lib
 		mCommandList->OMSetRenderTargets(1, &normalMapRtv, true, &dsv);
 
 		// Bind the constant buffer for this pass.
-		auto passCB = mFrameResources[mCurrFrameResourceIndex]->PassCB->Resource();
-		mCommandList->SetGraphicsRootConstantBufferView(RSP_PassCB, passCB->GetGPUVirtualAddress());
+		mCommandList->SetGraphicsRootConstantBufferView(RSP_PassCB, mPassCBAddresses[0]);
 
-		mCommandList->SetPipelineState(mPSOs[L"drawNormals"].Get());
-
-		RenderActors(mCommandList.Get(), mFrameResources[mCurrFrameResourceIndex].get(), mAssetManager.GetActors(Render_Layer_Opaque));
+		SubmitDrawPackets(mCommandRecorder, mFrameResources[mCurrFrameResourceIndex].get(), CV_Main, MainSlot_Opaque, MainSlot_Opaque, mPSOs[PSO_DrawNormals].Get());
 
 		// Change back to GENERIC_READ so we can read the texture in a shader.
 		CD3DX12_RESOURCE_BARRIER barrier1 = CD3DX12_RESOURCE_BARRIER::Transition(normalMap, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_GENERIC_READ);
@@ -378,6 +393,8 @@ namespace DX12Lib
 
 			tex->SrvHeapIndex = srvHeapIndex++;
 		}
+
+		mSkyTexSrvIndex = mAssetManager.GetTexture(L"skyCubeMap")->SrvHeapIndex;
 	}
 	
 	void Game::InitMaterials()
@@ -454,7 +471,13 @@ namespace DX12Lib
 		meshes.emplace_back(Mesh(L"grid", MeshGenerator::Grid(20.0f, 20.0f, 40, 40)));
 		meshes.emplace_back(Mesh(L"box", MeshGenerator::Box(1.0f, 1.0f, 1.0f, 0)));
 		meshes.emplace_back(Mesh(L"quad", MeshGenerator::Quad(0.0f, 0.0f, 1.0f, 1.0f, 0.0f)));
-		mAssetManager.CreateMeshGroup(L"default", meshes);
+		meshes.emplace_back(Mesh(L"sphere_lod1", MeshGenerator::Sphere(0.5f, 10, 10)));
+		meshes.emplace_back(Mesh(L"sphere_lod2", MeshGenerator::Sphere(0.5f, 6, 5)));
+		meshes.emplace_back(Mesh(L"cylinder_lod1", MeshGenerator::Cylinder(0.5f, 0.3f, 3.0f, 8, 4)));
+		MeshGroup* group = mAssetManager.CreateMeshGroup(L"default", meshes);
+
+		group->DrawArgs[L"sphere"].Lods = { { L"sphere_lod1", 40.0f }, { L"sphere_lod2", 12.0f } };
+		group->DrawArgs[L"cylinder"].Lods = { { L"cylinder_lod1", 20.0f } };
 
 		InitCarMesh();
 		InitSkullMesh();
@@ -483,10 +506,15 @@ namespace DX12Lib
 		actor3->Group = mAssetManager.GetMeshGroup(L"car");
 		actor3->DrawArg = L"car";
 		actor3->RenderLayer = Render_Layer_Opaque;
-		DirectX::XMStoreFloat4x4(&actor3->Instance.World, DirectX::XMMatrixScaling(0.2f, 0.2f, 0.2f) * DirectX::XMMatrixTranslation(3.5f, 0.5f, 0.0f));
 		actor3->Instance.MaterialCBIndex = mAssetManager.GetMaterial(L"gray0")->MatCBIndex;
+		actor3->Occluder = true;
 		//actor3->Hidden = true;
 
+		mCarPivotNode = mTransforms.CreateNode();
+		uint32_t carNode = mTransforms.CreateNode(mCarPivotNode);
+		mTransforms.SetLocal(carNode, DirectX::XMFLOAT3(0.2f, 0.2f, 0.2f), DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), DirectX::XMFLOAT3(3.5f, 0.5f, 0.0f));
+		AttachActor(actor3, carNode);
+
 		auto actor6 = mAssetManager.CreateActor(L"box");
 		actor6->Group = mAssetManager.GetMeshGroup(L"default");
 		actor6->DrawArg = L"box";
@@ -494,6 +522,7 @@ namespace DX12Lib
 		DirectX::XMStoreFloat4x4(&actor6->Instance.World, DirectX::XMMatrixScaling(3.0f, 1.0f, 3.0f) * DirectX::XMMatrixTranslation(0.0f, 0.5f, 0.0f));
 		DirectX::XMStoreFloat4x4(&actor6->Instance.TexTransform, DirectX::XMMatrixScaling(1.0f, 1.0f, 1.0f));
 		actor6->Instance.MaterialCBIndex = mAssetManager.GetMaterial(L"bricks0")->MatCBIndex;
+		actor6->Occluder = true;
 		//actor6->Hidden = true;
 
 		auto actor7 = mAssetManager.CreateActor(L"dynamicSphere");
@@ -511,6 +540,12 @@ namespace DX12Lib
 		actor10->Instance.MaterialCBIndex = mAssetManager.GetMaterial(L"bricks0")->MatCBIndex;
 		actor10->Hidden = true;
 
+		// Reflect to change coordinate system from the RHS the data was exported out as.
+		DirectX::XMFLOAT4 soldierRotation;
+		DirectX::XMStoreFloat4(&soldierRotation, DirectX::XMQuaternionRotationRollPitchYaw(0.0f, DirectX::XM_PI, 0.0f));
+		uint32_t soldierNode = mTransforms.CreateNode();
+		mTransforms.SetLocal(soldierNode, DirectX::XMFLOAT3(0.05f, 0.05f, -0.05f), soldierRotation, DirectX::XMFLOAT3(0.0f, 0.0f, -6.0f));
+
 		for (UINT i = 0; i < mSkinnedMats.size(); ++i)
 		{
 			std::wstring submeshName = L"sm_" + std::to_wstring(i);
@@ -520,17 +555,185 @@ namespace DX12Lib
 			actor->DrawArg = submeshName;
 			actor->RenderLayer = Render_Layer_SKinnedOpaque;
 			actor->Instance.MaterialCBIndex = mAssetManager.GetMaterial(mSkinnedMats[i].Name)->MatCBIndex;
-			// Reflect to change coordinate system from the RHS the data was exported out as.
-			DirectX::XMMATRIX modelScale = DirectX::XMMatrixScaling(0.05f, 0.05f, -0.05f);
-			DirectX::XMMATRIX modelRot = DirectX::XMMatrixRotationY(DirectX::XM_PI);
-			DirectX::XMMATRIX modelOffset = DirectX::XMMatrixTranslation(0.0f, 0.0f, -6.0f);
-			DirectX::XMStoreFloat4x4(&actor->Instance.World, modelScale * modelRot * modelOffset);
+			// Every submesh of the soldier hangs off the same node.
+			AttachActor(actor, soldierNode);
 
 			// All render items for this solider.m3d instance share
 			// the same skinned model instance.
 			actor->SkinnedCBIndex = 0;
 			actor->mSkinnedMesh = mSkinnedModelInst.get();
 		}
+
+		// Layers may have changed since creation, which moves actors between buckets, so
+		// this walks a copy.
+		for (auto actor : mAssetManager.GetActors())
+			mAssetManager.UpdateActor(actor);
+
+		UpdateTransforms();
+	}
+
+	void Game::InitHlods()
+	{
+		const ActorStore& store = mAssetManager.GetActorStore();
+
+		std::vector<HlodSource> sources;
+		std::vector<Actor*> sourceActors;
+
+		for (auto actor : GetStaticActors())
+		{
+			const Submesh* submesh = store.GetSubmesh(actor->Handle);
+			if (submesh == nullptr || !submesh->Collision)
+				continue;
+
+			HlodSource source;
+			source.TriangleVertices = submesh->Collision->GetTriangleVertices();
+			source.TriangleCount = submesh->Collision->GetTriangleCount();
+			source.World = store.GetWorld(actor->Handle);
+			source.Bound = store.GetBound(actor->Handle);
+			source.Material = actor->Instance.MaterialCBIndex;
+			sources.push_back(source);
+			sourceActors.push_back(actor);
+		}
+
+		HlodSettings settings;
+		std::vector<HlodCluster> clusters = HlodBuilder::Build(sources, settings);
+		if (clusters.empty())
+			return;
+
+		std::vector<Mesh> meshes;
+		for (UINT i = 0; i < clusters.size(); ++i)
+			meshes.emplace_back(Mesh(L"hlod_" + std::to_wstring(i), clusters[i].Proxy));
+		MeshGroup* group = mAssetManager.CreateMeshGroup(L"hlod", meshes);
+
+		for (UINT i = 0; i < clusters.size(); ++i)
+		{
+			const HlodCluster& cluster = clusters[i];
+
+			// The proxy is built in world space and waits hidden until the switch picks it.
+			auto proxy = mAssetManager.CreateActor(meshes[i].Name);
+			proxy->Group = group;
+			proxy->DrawArg = meshes[i].Name;
+			proxy->RenderLayer = Render_Layer_Opaque;
+			proxy->Instance.MaterialCBIndex = cluster.Material;
+			proxy->Hidden = true;
+			mAssetManager.UpdateActor(proxy);
+
+			mHlodProxies.push_back(proxy);
+			mHlodMembers.emplace_back();
+			for (uint32_t member : cluster.Members)
+				mHlodMembers.back().push_back(sourceActors[member]);
+
+			mHlodSwitch.AddCluster(cluster.Bound, cluster.SwitchDistance);
+		}
+	}
+
+	std::vector<Actor*> Game::GetStaticActors() const
+	{
+		const ActorStore& store = mAssetManager.GetActorStore();
+
+		// Anything attached to a transform node may move.
+		std::vector<uint8_t> attached(store.Size(), 0);
+		for (auto& actors : mNodeActors)
+		{
+			for (auto a : actors)
+				attached[store.IndexOf(a->Handle)] = 1;
+		}
+
+		std::vector<Actor*> actors;
+		for (auto actor : mAssetManager.GetActorsInLayers(Render_Layer_Opaque))
+		{
+			if (!actor->Hidden && !actor->mSkinnedMesh && !attached[store.IndexOf(actor->Handle)])
+				actors.push_back(actor);
+		}
+		return actors;
+	}
+
+	void Game::UpdateHlods()
+	{
+		mHlodSwitch.Update(mCamera.GetPosition3f());
+
+		for (uint32_t cluster : mHlodSwitch.GetChangedClusters())
+		{
+			bool proxyActive = mHlodSwitch.IsProxyActive(cluster);
+
+			mHlodProxies[cluster]->Hidden = !proxyActive;
+			mAssetManager.UpdateActor(mHlodProxies[cluster]);
+
+			for (auto a : mHlodMembers[cluster])
+			{
+				a->Hidden = proxyActive;
+				mAssetManager.UpdateActor(a);
+			}
+		}
+	}
+
+	void Game::UpdateStreaming()
+	{
+		if (!mWorldStreamer.IsOpen())
+			return;
+
+		mWorldStreamer.Update(mCamera.GetPosition3f());
+
+		std::vector<Actor*> destroyed;
+		for (uint32_t cell : mWorldStreamer.GetUnloadedCells())
+		{
+			for (auto actor : mStreamedActors[cell])
+			{
+				mVisibilityCache.Invalidate(actor->ProxyId);
+				mSceneBVH.DestroyProxy(actor->ProxyId);
+				destroyed.push_back(actor);
+			}
+			mStreamedActors[cell].clear();
+		}
+
+		// Last frame's visible list still points at them.
+		if (!destroyed.empty())
+		{
+			std::sort(destroyed.begin(), destroyed.end());
+			std::vector<ActorView*>& visibleActors = mDrawList.GetVisibleActors();
+			visibleActors.erase(std::remove_if(visibleActors.begin(), visibleActors.end(), [&destroyed](ActorView* a)
+			{
+				return std::binary_search(destroyed.begin(), destroyed.end(), static_cast<Actor*>(a));
+			}), visibleActors.end());
+
+			for (auto actor : destroyed)
+				mAssetManager.DestroyActor(actor);
+		}
+
+		for (uint32_t cell : mWorldStreamer.GetLoadedCells())
+		{
+			const SceneCellView& view = mWorldStreamer.GetCell(cell);
+			for (uint32_t i = 0; i < view.ActorCount; ++i)
+			{
+				const SceneActorRecord& record = view.Actors[i];
+
+				// Records naming assets this build does not have are skipped.
+				auto group = mStreamedGroups.find(record.MeshGroup);
+				auto drawArg = mStreamedDrawArgs.find(record.DrawArg);
+				auto material = mStreamedMaterials.find(record.Material);
+				if (group == mStreamedGroups.end() || drawArg == mStreamedDrawArgs.end() || material == mStreamedMaterials.end()
+					|| group->second->DrawArgs.find(drawArg->second) == group->second->DrawArgs.end())
+					continue;
+
+				auto actor = mAssetManager.CreateActor(GetSceneActorName(record));
+				if (actor == nullptr)
+					continue;
+
+				actor->Group = group->second;
+				actor->DrawArg = drawArg->second;
+				actor->RenderLayer = record.RenderLayer;
+				actor->Instance.World = record.World;
+				actor->Instance.TexTransform = record.TexTransform;
+				actor->Instance.MaterialCBIndex = material->second;
+				actor->Hidden = (record.Flags & Actor_Flag_Hidden) != 0;
+				actor->Occluder = (record.Flags & Actor_Flag_Occluder) != 0;
+				actor->Visible = false;
+				mAssetManager.UpdateActor(actor);
+
+				actor->ProxyId = mSceneBVH.CreateProxy(mAssetManager.GetActorStore().GetBound(actor->Handle), static_cast<ActorView*>(actor));
+				mStreamedActors[cell].push_back(actor);
+			}
+		}
 	}
 
 	void Game::InitRootSignature()
@@ -555,7 +758,7 @@ namespace DX12Lib
 		CD3DX12_DESCRIPTOR_RANGE texTable3[1];
 		texTable3[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, mAssetManager.GetTexturesCount(), 3);
 
-		CD3DX12_ROOT_PARAMETER params[8];
+		CD3DX12_ROOT_PARAMETER params[9];
 		params[0].InitAsShaderResourceView(0, 1); // Instance Buffer
 		params[1].InitAsShaderResourceView(1, 1); // Material Buffer
 		params[2].InitAsConstantBufferView(0);    // Main Constant Buffer
@@ -564,6 +767,7 @@ namespace DX12Lib
 		params[5].InitAsDescriptorTable(1, texTable1, D3D12_SHADER_VISIBILITY_PIXEL); // Shadow Map
 		params[6].InitAsDescriptorTable(1, texTable2, D3D12_SHADER_VISIBILITY_PIXEL); // Ssao Map
 		params[7].InitAsDescriptorTable(1, texTable3, D3D12_SHADER_VISIBILITY_PIXEL); // All Textures
+		params[8].InitAsShaderResourceView(2, 1); // Instance Indices
 
 		auto staticSamplers = GetStaticSamplers();
 
@@ -584,6 +788,48 @@ namespace DX12Lib
 		ThrowIfFailed(mDevice->CreateRootSignature(0, signatureBlob->GetBufferPointer(), signatureBlob->GetBufferSize(), IID_PPV_ARGS(&mRootSignature)));
 	}
 
+	void Game::InitCommandSignature()
+	{
+		static_assert(sizeof(IndirectDrawIndexedArguments) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS), "Draw arguments have to match D3D");
+
+		auto arguments = IndirectDrawBuilder::GetArguments(RSP_InstanceIndices, RSP_SkinnedCB);
+
+		std::array<D3D12_INDIRECT_ARGUMENT_DESC, IndirectDrawBuilder::ArgumentCount> argumentDescs = {};
+		for (size_t i = 0; i < arguments.size(); ++i)
+		{
+			D3D12_INDIRECT_ARGUMENT_DESC& argumentDesc = argumentDescs[i];
+			switch (arguments[i].Type)
+			{
+			case Indirect_Argument_VertexBuffer:
+				argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+				argumentDesc.VertexBuffer.Slot = arguments[i].Index;
+				break;
+			case Indirect_Argument_IndexBuffer:
+				argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+				break;
+			case Indirect_Argument_ShaderResourceView:
+				argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW;
+				argumentDesc.ShaderResourceView.RootParameterIndex = arguments[i].Index;
+				break;
+			case Indirect_Argument_ConstantBufferView:
+				argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW;
+				argumentDesc.ConstantBufferView.RootParameterIndex = arguments[i].Index;
+				break;
+			case Indirect_Argument_DrawIndexed:
+				argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+				break;
+			}
+		}
+
+		D3D12_COMMAND_SIGNATURE_DESC desc = {};
+		desc.ByteStride = IndirectDrawBuilder::ArgumentStride;
+		desc.NumArgumentDescs = (UINT)argumentDescs.size();
+		desc.pArgumentDescs = argumentDescs.data();
+
+		// The signature changes root arguments, so it is tied to the root signature.
+		ThrowIfFailed(mDevice->CreateCommandSignature(&desc, mRootSignature.Get(), IID_PPV_ARGS(&mDrawCommandSignature)));
+	}
+
 	void Game::InitPSOs()
 	{
 		D3D12_INPUT_ELEMENT_DESC inputLayout[] =
@@ -668,7 +914,7 @@ namespace DX12Lib
 		opaquePsoDesc.PS = { reinterpret_cast<BYTE*>(opaquePS->GetBufferPointer()), opaquePS->GetBufferSize() };
 		//opaquePsoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_EQUAL;
 		//opaquePsoDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
-		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&opaquePsoDesc, IID_PPV_ARGS(&mPSOs[L"opaque"])));
+		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&opaquePsoDesc, IID_PPV_ARGS(&mPSOs[PSO_Opaque])));
 
 		//
 		// PSO for skinned pass.
@@ -677,7 +923,7 @@ namespace DX12Lib
 		skinnedOpaquePsoDesc.InputLayout = { skinnedInputLayout, _countof(skinnedInputLayout) };
 		skinnedOpaquePsoDesc.VS = { reinterpret_cast<BYTE*>(skinnedVS->GetBufferPointer()), skinnedVS->GetBufferSize() };
 		skinnedOpaquePsoDesc.PS = { reinterpret_cast<BYTE*>(opaquePS->GetBufferPointer()), opaquePS->GetBufferSize() };
-		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&skinnedOpaquePsoDesc, IID_PPV_ARGS(&mPSOs[L"skinnedOpaque"])));
+		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&skinnedOpaquePsoDesc, IID_PPV_ARGS(&mPSOs[PSO_SkinnedOpaque])));
 
 		//
 		// PSO for sky.
@@ -691,7 +937,7 @@ namespace DX12Lib
 		skyPsoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
 		skyPsoDesc.VS = { reinterpret_cast<BYTE*>(SkyVS->GetBufferPointer()), SkyVS->GetBufferSize() };
 		skyPsoDesc.PS = { reinterpret_cast<BYTE*>(SkyPS->GetBufferPointer()), SkyPS->GetBufferSize() };
-		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&skyPsoDesc, IID_PPV_ARGS(&mPSOs[L"sky"])));
+		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&skyPsoDesc, IID_PPV_ARGS(&mPSOs[PSO_Sky])));
 
 		//
 		// PSO for shadow map pass.
@@ -705,7 +951,7 @@ namespace DX12Lib
 		// Shadow map pass does not have a render target.
 		smapPsoDesc.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
 		smapPsoDesc.NumRenderTargets = 0;
-		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&smapPsoDesc, IID_PPV_ARGS(&mPSOs[L"shadow"])));
+		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&smapPsoDesc, IID_PPV_ARGS(&mPSOs[PSO_Shadow])));
 
 		//
 		// PSO for debug layer.
@@ -713,7 +959,7 @@ namespace DX12Lib
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC debugPsoDesc = basePsoDesc;
 		debugPsoDesc.VS = { reinterpret_cast<BYTE*>(debugVS->GetBufferPointer()), debugVS->GetBufferSize() };
 		debugPsoDesc.PS = { reinterpret_cast<BYTE*>(debugPS->GetBufferPointer()), debugPS->GetBufferSize() };
-		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&debugPsoDesc, IID_PPV_ARGS(&mPSOs[L"debug"])));
+		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&debugPsoDesc, IID_PPV_ARGS(&mPSOs[PSO_Debug])));
 
 		//
 		// PSO for drawing normals.
@@ -725,7 +971,7 @@ namespace DX12Lib
 		drawNormalsPsoDesc.SampleDesc.Count = 1;
 		drawNormalsPsoDesc.SampleDesc.Quality = 0;
 		drawNormalsPsoDesc.DSVFormat = mDepthStencilFormat;
-		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&drawNormalsPsoDesc, IID_PPV_ARGS(&mPSOs[L"drawNormals"])));
+		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&drawNormalsPsoDesc, IID_PPV_ARGS(&mPSOs[PSO_DrawNormals])));
 
 		//
 		// PSO for SSAO.
@@ -742,7 +988,7 @@ namespace DX12Lib
 		ssaoPsoDesc.SampleDesc.Count = 1;
 		ssaoPsoDesc.SampleDesc.Quality = 0;
 		ssaoPsoDesc.DSVFormat = DXGI_FORMAT_UNKNOWN;
-		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&ssaoPsoDesc, IID_PPV_ARGS(&mPSOs[L"ssao"])));
+		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&ssaoPsoDesc, IID_PPV_ARGS(&mPSOs[PSO_Ssao])));
 
 		//
 		// PSO for SSAO blur.
@@ -750,15 +996,181 @@ namespace DX12Lib
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC ssaoBlurPsoDesc = ssaoPsoDesc;
 		ssaoBlurPsoDesc.VS = { reinterpret_cast<BYTE*>(ssaoBlurVS->GetBufferPointer()), ssaoBlurVS->GetBufferSize() };
 		ssaoBlurPsoDesc.PS = { reinterpret_cast<BYTE*>(ssaoBlurPS->GetBufferPointer()), ssaoBlurPS->GetBufferSize() };
-		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&ssaoBlurPsoDesc, IID_PPV_ARGS(&mPSOs[L"ssaoBlur"])));
+		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&ssaoBlurPsoDesc, IID_PPV_ARGS(&mPSOs[PSO_SsaoBlur])));
 	}
 
 	void Game::InitFrameResources()
 	{
 		for (int i = 0; i < gNumFrameResources; ++i)
 		{
-			mFrameResources.push_back(std::make_unique<FrameResource>(mDevice.Get(), 2 + 6, mAssetManager.GetActorsCount(), 1, mAssetManager.GetMaterialsCount()));
+			// Streamed actors come and go, room is kept for as many as may be resident at once.
+			size_t actorCount = mAssetManager.GetActorStore().GetSlotCount();
+			if (mWorldStreamer.IsOpen())
+				actorCount += mWorldStreamer.GetSettings().MaxResidentActors;
+
+			// Instance data has one slot per actor; instance indices are handed out per draw
+			// packet, so an actor can take one in every pass.
+			mFrameResources.push_back(std::make_unique<FrameResource>(mDevice.Get(), actorCount, actorCount * CV_Count, mAssetManager.GetMaterialsCount()));
+		}
+	}
+
+	void Game::InitSceneBVH()
+	{
+		mSceneBVH.Clear();
+
+		for (auto actor : mAssetManager.GetActorsInLayers(Render_Layer_All))
+		{
+			// Actors only become visible once the frustum query reports them.
+			actor->Visible = false;
+
+			if (actor->Group == nullptr)
+				continue;
+
+			actor->ProxyId = mSceneBVH.CreateProxy(mAssetManager.GetActorStore().GetBound(actor->Handle), static_cast<ActorView*>(actor));
+		}
+
+		// Incremental inserts give a usable tree, but a full SAH build is better for the static bulk.
+		mSceneBVH.Rebuild();
+
+		mRayQuery = std::make_unique<RayQuery>(mSceneBVH, [this](void* userData, RayTarget& target)
+		{
+			return ResolveRayTarget(userData, target);
+		});
+	}
+
+	bool Game::ResolveRayTarget(void* userData, RayTarget& target) const
+	{
+		const ActorStore& store = mAssetManager.GetActorStore();
+
+		const ActorView* actor = static_cast<const ActorView*>(userData);
+		if (actor->Hidden)
+			return false;
+
+		const Submesh* submesh = store.GetSubmesh(actor->Handle);
+		if (submesh == nullptr || !submesh->Collision)
+			return false;
+
+		DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&store.GetWorld(actor->Handle));
+		auto worldDeterminant = DirectX::XMMatrixDeterminant(world);
+		DirectX::XMStoreFloat4x4(&target.WorldToLocal, DirectX::XMMatrixInverse(&worldDeterminant, world));
+		target.Mesh = submesh->Collision.get();
+		target.Layers = actor->RenderLayer;
+		return true;
+	}
+
+	std::vector<PvsTarget> Game::InitPvsTargets()
+	{
+		std::vector<PvsTarget> targets;
+		for (auto actor : GetStaticActors())
+		{
+			uint32_t slotIndex = actor->Handle.Index();
+			if (slotIndex >= mPvsTargets.size())
+				mPvsTargets.resize(slotIndex + 1, -1);
+			mPvsTargets[slotIndex] = (int)targets.size();
+
+			PvsTarget target;
+			target.Bound = mAssetManager.GetActorStore().GetBound(actor->Handle);
+			target.UserData = static_cast<ActorView*>(actor);
+			uint64_t meshHash = StringTable::Hash((actor->Group ? actor->Group->Name : std::wstring()) + L"/" + actor->DrawArg);
+			target.Key = PvsTarget::MakeKey(StringTable::Hash(actor->Name), meshHash, target.Bound);
+			targets.push_back(target);
+		}
+		return targets;
+	}
+
+	PvsBakeSettings Game::GetPvsBakeSettings() const
+	{
+		PvsBakeSettings settings;
+		settings.Region = DirectX::BoundingBox(DirectX::XMFLOAT3(mSceneBound.Center.x, 4.0f, mSceneBound.Center.z), DirectX::XMFLOAT3(mSceneBound.Radius, 4.0f, mSceneBound.Radius));
+		return settings;
+	}
+
+	void Game::InitPvs()
+	{
+		std::vector<PvsTarget> targets = InitPvsTargets();
+
+		// A baked file is only good for the same grid and the same static actors, unmoved and
+		// with the same meshes, in the same order. Otherwise the scene runs without a PVS until
+		// it is baked again with --bake-pvs.
+		bool upToDate = mPvs.Load(PvsFilename) && mPvs.MatchesGrid(GetPvsBakeSettings()) && mPvs.GetTargetCount() == targets.size();
+		for (size_t i = 0; upToDate && i < targets.size(); ++i)
+			upToDate = mPvs.GetTargetKeys()[i] == targets[i].Key;
+
+		if (!upToDate)
+		{
+			mPvs.Clear();
+			OutputDebugStringA("assets/scene.pvs is missing or stale, PVS culling is off. Run with --bake-pvs to rebuild it.\n");
+		}
+	}
+
+	bool Game::BakePvs()
+	{
+		std::vector<PvsTarget> targets = InitPvsTargets();
+
+		// Only static geometry may block the rays, anything else moves after the bake.
+		RayQuery staticQuery(mSceneBVH, [this](void* userData, RayTarget& target)
+		{
+			uint32_t slotIndex = static_cast<ActorView*>(userData)->Handle.Index();
+			return slotIndex < mPvsTargets.size() && mPvsTargets[slotIndex] >= 0 && ResolveRayTarget(userData, target);
+		});
+
+		mPvs = PvsBaker::Bake(targets, GetPvsBakeSettings(), [&staticQuery](const RayDesc* rays, size_t count, RayHit* hits)
+		{
+			staticQuery.Trace(rays, count, hits);
+		}, mJobs);
+		mPvsCell = -1;
+		return mPvs.Save(PvsFilename);
+	}
+
+	void Game::InitStreaming()
+	{
+		// The scene built in code is always there, a world file streams in on top of it.
+		if (!mWorldStreamer.Open("assets/world.scene"))
+			return;
+
+		mStreamedActors.resize(mWorldStreamer.GetCellCount());
+
+		for (UINT id = 0; id < mAssetManager.GetMeshGroupsCount(); ++id)
+		{
+			MeshGroup* group = mAssetManager.GetMeshGroupById(id);
+			mStreamedGroups.emplace(StringTable::Hash(group->Name), group);
+			for (const auto& drawArg : group->DrawArgs)
+				mStreamedDrawArgs.emplace(StringTable::Hash(drawArg.first), drawArg.first);
+		}
+
+		for (auto mat : mAssetManager.GetAllMaterials())
+			mStreamedMaterials.emplace(StringTable::Hash(mat->mName), mat->MatCBIndex);
+	}
+
+	void Game::InitDrawPasses()
+	{
+		mDrawList.SetPassSlots(CV_Main, {
+			{ Render_Layer_OpaqueDynamicReflectors, PSO_Opaque, false },
+			{ Render_Layer_Opaque, PSO_Opaque, false },
+			{ Render_Layer_SKinnedOpaque, PSO_SkinnedOpaque, false },
+			{ Render_Layer_Debug, PSO_Debug, false },
+			{ Render_Layer_Sky, PSO_Sky, false },
+		});
+
+		mDrawList.SetPassSlots(CV_Shadow, {
+			{ Render_Layer_Opaque | Render_Layer_OpaqueDynamicReflectors, PSO_Shadow, false },
+		});
+
+		for (UINT i = 0; i < 6; ++i)
+		{
+			mDrawList.SetPassSlots(CV_CubeFace0 + i, {
+				{ Render_Layer_Opaque | Render_Layer_SKinnedOpaque, PSO_Opaque, false },
+				{ Render_Layer_Sky, PSO_Sky, false },
+			});
 		}
+
+		// The sky and debug layers keep the defaults and are never dropped.
+		mLodSelector.SetLayerSettings(Render_Layer_Opaque | Render_Layer_OpaqueDynamicReflectors | Render_Layer_SKinnedOpaque, { 1.5f, 0.1f });
+
+		mLodBias[CV_Main] = 1.0f;
+		mLodBias[CV_Shadow] = 0.5f;
+		for (UINT i = 0; i < 6; ++i)
+			mLodBias[CV_CubeFace0 + i] = 0.5f;
 	}
 
 	void Game::InitSkullMesh()
@@ -892,6 +1304,16 @@ namespace DX12Lib
 		M3DLoader m3dLoader;
 		m3dLoader.LoadM3d(skinnedModelFilename, vertices, indices, mSkinnedSubsets, mSkinnedMats, mSkinnedInfo);
 
+		// The palette is streamed every frame without a bound check, so a skeleton it can't hold
+		// is turned away here. Without materials no soldier actors are created.
+		if (mSkinnedInfo.GetBoneCount() > std::size(SkinnedConstant{}.BoneTransforms))
+		{
+			MessageBox(0, L"assets/models/soldier.m3d has more bones than the skinned constants hold.", 0, 0);
+			mSkinnedSubsets.clear();
+			mSkinnedMats.clear();
+			return;
+		}
+
 		mSkinnedModelInst = std::make_unique<SkinnedMesh>();
 		mSkinnedModelInst->SkinnedInfo = &mSkinnedInfo;
 		mSkinnedModelInst->FinalTransforms.resize(mSkinnedInfo.GetBoneCount());
@@ -1067,12 +1489,9 @@ namespace DX12Lib
 
 	void Game::Tick(const Timer& timer)
 	{
-		DirectX::XMMATRIX scale = DirectX::XMMatrixScaling(0.2f, 0.2f, 0.2f);
-		DirectX::XMMATRIX offset = DirectX::XMMatrixTranslation(3.5f, 0.5f, 0.0f);
-		DirectX::XMMATRIX localRotate = DirectX::XMMatrixRotationY(2.0f * timer.TotalTime());
-		DirectX::XMMATRIX globalRotate = DirectX::XMMatrixRotationY(0.5f * timer.TotalTime());
-		//DirectX::XMStoreFloat4x4(&mAssetManager.GetActor(L"car")->Instance.World, scale * localRotate * offset * globalRotate);
-		DirectX::XMStoreFloat4x4(&mAssetManager.GetActor(L"car")->Instance.World, scale * offset * globalRotate);
+		DirectX::XMFLOAT4 carRotation;
+		DirectX::XMStoreFloat4(&carRotation, DirectX::XMQuaternionRotationRollPitchYaw(0.0f, 0.5f * timer.TotalTime(), 0.0f));
+		mTransforms.SetRotation(mCarPivotNode, carRotation);
 
 		DirectX::XMMATRIX R = DirectX::XMMatrixRotationY(0.1f * timer.DeltaTime());
 		for (int i = 0; i < 3; ++i)
@@ -1083,66 +1502,266 @@ namespace DX12Lib
 		}
 	}
 
-	void Game::UpdateInstanceBuffer(const Timer& timer)
+	void Game::UpdateVisibility(const Timer& timer)
 	{
-		auto currInstanceBuffer = mFrameResources[mCurrFrameResourceIndex]->InstanceBuffer.get();
 		DirectX::XMMATRIX view = mCamera.GetViewMatrix();
-		DirectX::XMVECTOR d = DirectX::XMMatrixDeterminant(view);
-		DirectX::XMMATRIX invView = DirectX::XMMatrixInverse(&d, view);
+		DirectX::XMMATRIX proj = mCamera.GetProjMatrix();
+		mCullViews[CV_Main] = FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(view, proj));
 
-		DirectX::BoundingFrustum worldCamearFrustum;
-		mCameraFrustum.Transform(worldCamearFrustum, invView);
+		DirectX::XMMATRIX lightView = DirectX::XMLoadFloat4x4(&mLightView);
+		DirectX::XMMATRIX lightProj = DirectX::XMLoadFloat4x4(&mLightProj);
+		mCullViews[CV_Shadow] = FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(lightView, lightProj));
 
-		auto actors = mAssetManager.GetActors(Render_Layer_All);
-		UINT instanceOffset = 0;
-		for (auto a : actors)
-		{
-			a->Visible = false;
+		// All faces share the position and lens of the first camera.
+		Camera* cubeCamera = mDynamicCubeMap->GetCamera(0);
+		DirectX::XMFLOAT3 cubeOrigin = cubeCamera->GetPosition3f();
+		float cubeFarZ = cubeCamera->GetFarZ();
+		mCullViews[CV_Cube] = FrustumPlanes::FromBox(DirectX::BoundingBox(cubeOrigin, DirectX::XMFLOAT3(cubeFarZ, cubeFarZ, cubeFarZ)));
+
+		mCubeActors.clear();
+		mCubeBounds.Clear();
+
+		const ActorStore& store = mAssetManager.GetActorStore();
+
+		mDrawList.Cull(mSceneBVH, mVisibilityCache, store, mCullViews.data(), CV_PlaneViewCount, mCamera.GetPosition3f());
+		std::vector<ActorView*>& visibleActors = mDrawList.GetVisibleActors();
 
-			if (a->Hidden || a->Group == nullptr)
+		// The light box test above keeps everything the shadow map can see. Narrow that down
+		// to actors whose shadow can land inside the camera frustum.
+		DirectX::BoundingFrustum cameraFrustumW;
+		DirectX::XMVECTOR viewDeterminant = DirectX::XMMatrixDeterminant(view);
+		DirectX::XMMATRIX invView = DirectX::XMMatrixInverse(&viewDeterminant, view);
+		mCameraFrustum.Transform(cameraFrustumW, invView);
+
+		ShadowCasterVolume casterVolume = BuildShadowCasterVolume(cameraFrustumW, DirectX::XMLoadFloat3(&mLights[0].Direction), lightView, mLightBound);
+
+		for (auto a : visibleActors)
+		{
+			if (!(a->ViewMask & ((1u << CV_Shadow) | (1u << CV_Cube))))
 				continue;
 
-			DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&a->Instance.World);
+			const DirectX::BoundingBox& bound = store.GetBound(a->Handle);
+
+			if ((a->ViewMask & (1u << CV_Shadow)) && !IsShadowCaster(casterVolume, bound))
+				a->ViewMask &= ~(1u << CV_Shadow);
 
-			DirectX::BoundingBox worldBoundingBox;
-			a->Group->DrawArgs[a->DrawArg].Bound.Transform(worldBoundingBox, world);
-			
-			if (worldCamearFrustum.Contains(worldBoundingBox) != DirectX::DISJOINT)
+			if (a->ViewMask & (1u << CV_Cube))
 			{
-				a->Visible = true;
+				mCubeActors.push_back(a);
+				mCubeBounds.Push(bound);
+			}
+		}
 
-				InstanceData data;
-				DirectX::XMStoreFloat4x4(&data.World, DirectX::XMMatrixTranspose(world));
-				DirectX::XMMATRIX texTransform = DirectX::XMLoadFloat4x4(&a->Instance.TexTransform);
-				DirectX::XMStoreFloat4x4(&data.TexTransform, DirectX::XMMatrixTranspose(texTransform));
-				data.MaterialCBIndex = a->Instance.MaterialCBIndex;
+		mCubeFaceMasks.resize(mCubeBounds.Size());
+		CullBoxesCubeFaces(cubeOrigin, cubeCamera->GetNearZ(), cubeFarZ, mCubeBounds, mCubeFaceMasks.data());
 
-				a->InstanceBufferOffset = instanceOffset++;
-				currInstanceBuffer->UploadData(a->InstanceBufferOffset, &data);
+		for (size_t i = 0; i < mCubeActors.size(); ++i)
+		{
+			ActorView* a = mCubeActors[i];
+			a->ViewMask &= ~(1u << CV_Cube);
+			a->ViewMask |= (uint32_t)mCubeFaceMasks[i] << CV_CubeFace0;
+		}
+
+		int pvsCell = mPvs.FindCell(mCamera.GetPosition3f());
+		if (pvsCell != mPvsCell)
+		{
+			mPvsCell = pvsCell;
+			if (pvsCell >= 0)
+				mPvs.DecompressCell(pvsCell, mPvsBits);
+		}
+
+		if (mPvsCell >= 0)
+		{
+			for (auto a : visibleActors)
+			{
+				uint32_t slotIndex = a->Handle.Index();
+				if (slotIndex < mPvsTargets.size() && mPvsTargets[slotIndex] >= 0 && !PvsData::TestBit(mPvsBits, mPvsTargets[slotIndex]))
+					a->ViewMask &= ~(1u << CV_Main);
 			}
-			else
+		}
+
+		mDrawList.FinishCull(CV_Main);
+
+		// The caption is only rebuilt when its numbers change, to keep allocations out of the frame.
+		size_t visibleMain = mDrawList.GetViewActors(CV_Main).size();
+		int skippedPercent = (int)(mVisibilityCache.GetSkippedFraction() * 100.0f);
+		size_t uploadedKB = (mUploadStats.InstanceBytes + mUploadStats.IndexBytes + mUploadStats.MaterialBytes + 1023) / 1024;
+		if (visibleMain != mCaptionVisibleCount || skippedPercent != mCaptionSkippedPercent || uploadedKB != mCaptionUploadedKB)
+		{
+			mCaptionVisibleCount = visibleMain;
+			mCaptionSkippedPercent = skippedPercent;
+			mCaptionUploadedKB = uploadedKB;
+
+			std::wostringstream outs;
+			outs.precision(6);
+			outs << L"DX12Lib" << L"    " << visibleMain << L" actors visible out of " << mAssetManager.GetActorsCount()
+				<< L"    " << skippedPercent << L"% tests skipped"
+				<< L"    " << uploadedKB << L" KB uploaded";
+			mMainWndCaption = outs.str();
+		}
+	}
+
+	void Game::UpdateInstanceBuffer(const Timer& timer)
+	{
+		auto currFrameResource = mFrameResources[mCurrFrameResourceIndex].get();
+
+		UploadDirtyInstances(currFrameResource->InstanceBuffer.get());
+		CullOccludedActors();
+		BuildDrawPackets();
+		BuildDrawBatches(currFrameResource);
+
+		if (mIndirectDraws)
+			BuildIndirectDraws(currFrameResource);
+	}
+
+	void Game::UploadDirtyInstances(UploadBuffer<InstanceData>* instanceBuffer)
+	{
+		const ActorStore& store = mAssetManager.GetActorStore();
+		mUploadStats.InstanceBytes = 0;
+
+		// Slots belong to actors, not draws, so only actors that changed in the last
+		// gNumFrameResources frames are written, once into each frame resource.
+		mAssetManager.FlushDirtyActors([&](Actor* actor)
+		{
+			uint32_t dense = store.IndexOf(actor->Handle);
+
+			InstanceData data;
+			DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&store.GetWorlds()[dense]);
+			DirectX::XMStoreFloat4x4(&data.World, DirectX::XMMatrixTranspose(world));
+			DirectX::XMMATRIX texTransform = DirectX::XMLoadFloat4x4(&actor->Instance.TexTransform);
+			DirectX::XMStoreFloat4x4(&data.TexTransform, DirectX::XMMatrixTranspose(texTransform));
+			data.MaterialCBIndex = store.GetMaterials()[dense];
+
+			instanceBuffer->UploadData(actor->Handle.Index(), &data);
+			mUploadStats.InstanceBytes += sizeof(InstanceData);
+		});
+	}
+
+	void Game::CullOccludedActors()
+	{
+		DirectX::XMMATRIX view = mCamera.GetViewMatrix();
+		DirectX::XMMATRIX proj = mCamera.GetProjMatrix();
+
+		// Only the main view is occlusion culled, the other passes keep their lists.
+		mDrawList.CullOccluded(mOcclusionCuller, mAssetManager.GetActorStore(), DirectX::XMMatrixMultiply(view, proj), CV_Main);
+	}
+
+	void Game::BuildDrawPackets()
+	{
+		DirectX::XMFLOAT3 eyes[CV_Count];
+		eyes[CV_Main] = mCamera.GetPosition3f();
+		eyes[CV_Shadow] = mLightPosW;
+		for (UINT i = 0; i < 6; ++i)
+			eyes[CV_CubeFace0 + i] = mDynamicCubeMap->GetCamera(i)->GetPosition3f();
+
+		LodView lodViews[CV_Count];
+		lodViews[CV_Main] = LodView::Perspective(eyes[CV_Main], mCamera.GetProjMatrix4x4f()(1, 1), (float)mClientHeight, mLodBias[CV_Main]);
+		// The shadow map covers the scene bounding sphere.
+		lodViews[CV_Shadow] = LodView::Ortho(2.0f * mSceneBound.Radius, (float)mShadowMap->GetHeight(), mLodBias[CV_Shadow]);
+		for (UINT i = 0; i < 6; ++i)
+		{
+			UINT face = CV_CubeFace0 + i;
+			lodViews[face] = LodView::Perspective(eyes[face], mDynamicCubeMap->GetCamera(i)->GetProjMatrix4x4f()(1, 1), (float)CubeMapSize, mLodBias[face]);
+		}
+
+		mDrawList.BuildDrawPackets(mAssetManager.GetActorStore(), mLodSelector, eyes, lodViews);
+	}
+
+	void Game::BuildDrawBatches(FrameResource* frameResource)
+	{
+		UploadBuffer<UINT>* indexBuffer = frameResource->InstanceIndexBuffer.get();
+		mUploadStats.IndexBytes = 0;
+
+		mDrawList.BuildBatches(frameResource->InstanceIndices, [&](UINT i, UINT slot)
+		{
+			indexBuffer->UploadData(i, &slot);
+			mUploadStats.IndexBytes += sizeof(UINT);
+		});
+	}
+
+	void Game::BuildIndirectDraws(FrameResource* frameResource)
+	{
+		mIndirectDrawInputs.clear();
+
+		const std::vector<DrawPacket>& packets = mDrawList.GetDrawPackets();
+
+		for (const DrawList::DrawBatch& batch : mDrawList.GetDrawBatches())
+		{
+			const DrawPacket& packet = packets[batch.FirstPacket];
+			const DrawList::CachedDraw* draw = static_cast<const DrawList::CachedDraw*>(packet.Item);
+			const DrawList::CachedLod& lod = draw->Lods[packet.Variant];
+
+			IndirectDrawInput input;
+			// Pass, slot and pipeline, so buckets can be found with the DrawKey::Begin keys.
+			input.BucketKey = packet.Key & ~((1ull << DrawKey::PipelineShift) - 1);
+			input.Pipeline = DrawKey::Pipeline(packet.Key);
+			input.Topology = draw->Topology;
+			input.VertexBuffer = draw->VertexBuffer;
+			input.IndexBuffer = draw->IndexBuffer;
+			input.IndexCount = lod.IndexCount;
+			input.StartIndexLocation = lod.StartIndexLocation;
+			input.BaseVertexLocation = lod.BaseVertexLocation;
+			input.InstanceCount = batch.InstanceCount;
+			input.InstanceOffset = batch.InstanceOffset;
+			input.SkinnedCBIndex = draw->Skinned ? draw->SkinnedCBIndex : IndirectDrawBuilder::NoSkinnedCB;
+			mIndirectDrawInputs.push_back(input);
+		}
+
+		IndirectDrawAddresses addresses;
+		addresses.InstanceIndices = frameResource->InstanceIndexBuffer->Resource()->GetGPUVirtualAddress();
+		addresses.InstanceIndexStride = frameResource->InstanceIndexBuffer->GetElementSizeInBytes();
+		addresses.SkinnedCB = mSkinnedCBAddress;
+		addresses.SkinnedCBStride = CalcConstantBufferByteSize(sizeof(SkinnedConstant));
+
+		mIndirectDrawBuilder.Build(mIndirectDrawInputs, addresses, frameResource->IndirectArgsBuffer->GetMappedData());
+	}
+
+	void Game::AttachActor(Actor* actor, uint32_t node)
+	{
+		if (node >= mNodeActors.size())
+			mNodeActors.resize(node + 1);
+
+		mNodeActors[node].push_back(actor);
+	}
+
+	void Game::UpdateTransforms()
+	{
+		mTransforms.Update();
+
+		// Only actors under a changed node get a new world matrix and bound.
+		for (uint32_t node : mTransforms.GetChangedNodes())
+		{
+			if (node >= mNodeActors.size())
+				continue;
+
+			for (auto actor : mNodeActors[node])
 			{
-				OutputDebugString(L"[");
-				OutputDebugString(std::to_wstring(timer.TotalTime()).c_str());
-				OutputDebugString(L"]\t");
-				OutputDebugString(a->Name.c_str());
-				OutputDebugString(L"\n");
+				actor->Instance.World = mTransforms.GetWorld(node);
+				UpdateActorBound(actor);
 			}
 		}
+	}
 
-		std::wostringstream outs;
-		outs.precision(6);
-		outs << L"DX12Lib" << L"    " << instanceOffset << L" actors visible out of " << mAssetManager.GetActorsCount();
-		mMainWndCaption = outs.str();
+	void Game::UpdateActorBound(Actor* actor)
+	{
+		mAssetManager.UpdateActorTransform(actor);
+
+		if (actor->ProxyId != SceneBVH::NullNode)
+		{
+			mSceneBVH.MoveProxy(actor->ProxyId, mAssetManager.GetActorStore().GetBound(actor->Handle));
+			mVisibilityCache.Invalidate(actor->ProxyId);
+		}
 	}
 
 	void Game::UpdateMaterialBuffer(const Timer& timer)
 	{
 		auto currMatBuffer = mFrameResources[mCurrFrameResourceIndex]->MaterialBuffer.get();
-		auto materials = mAssetManager.GetAllMaterials();
+		mUploadStats.MaterialBytes = 0;
 
-		for (auto mat : materials)
+		for (UINT id = 0; id < mAssetManager.GetMaterialsCount(); ++id)
 		{
+			Material* mat = mAssetManager.GetMaterialById(id);
+
 			// Only update the cbuffer data if the constants have changed.  If the cbuffer
 			// data changes, it needs to be updated for each FrameResource.
 			if (mat->NumFramesDirty > 0)
@@ -1157,6 +1776,7 @@ namespace DX12Lib
 				DirectX::XMStoreFloat4x4(&matData.MatTransform, DirectX::XMMatrixTranspose(matTransform));
 
 				currMatBuffer->UploadData(mat->MatCBIndex, &matData);
+				mUploadStats.MaterialBytes += sizeof(MaterialData);
 
 				// Next FrameResource need to be updated too.
 				mat->NumFramesDirty--;
@@ -1189,6 +1809,7 @@ namespace DX12Lib
 
 		mLightNearZ = n;
 		mLightFarZ = f;
+		mLightBound = DirectX::BoundingBox(sphereCenterLS, DirectX::XMFLOAT3(mSceneBound.Radius, mSceneBound.Radius, mSceneBound.Radius));
 		DirectX::XMMATRIX lightProj = DirectX::XMMatrixOrthographicOffCenterLH(l, r, b, t, n, f);
 
 		// Transform NDC space [-1,+1]^2 to texture space [0,1]^2
@@ -1249,8 +1870,7 @@ namespace DX12Lib
 		mMainPassCB.Lights[1] = mLights[1];
 		mMainPassCB.Lights[2] = mLights[2];
 
-		auto currPassCB = mFrameResources[mCurrFrameResourceIndex]->PassCB.get();
-		currPassCB->UploadData(0, &mMainPassCB);
+		mPassCBAddresses[0] = mFrameResources[mCurrFrameResourceIndex]->Uploads->UploadConstants(mMainPassCB);
 	}
 
 	void Game::UpdateShadowPassCB(const Timer& timer)
@@ -1280,13 +1900,12 @@ namespace DX12Lib
 		mShadowPassCB.NearZ = mLightNearZ;
 		mShadowPassCB.FarZ = mLightFarZ;
 
-		auto currPassCB = mFrameResources[mCurrFrameResourceIndex]->PassCB.get();
-		currPassCB->UploadData(1, &mShadowPassCB);
+		mPassCBAddresses[1] = mFrameResources[mCurrFrameResourceIndex]->Uploads->UploadConstants(mShadowPassCB);
 	}
 
 	void Game::UpdateCubeMapFacePassCBs(const Timer& timer)
 	{
-		auto currPassCB = mFrameResources[mCurrFrameResourceIndex]->PassCB.get();
+		auto uploads = mFrameResources[mCurrFrameResourceIndex]->Uploads.get();
 		
 		for (int i = 0; i < 6; ++i)
 		{
@@ -1322,7 +1941,7 @@ namespace DX12Lib
 			cubeFacePassCB.Lights[1] = mLights[1];
 			cubeFacePassCB.Lights[2] = mLights[2];
 
-			currPassCB->UploadData(2 + i, &cubeFacePassCB);
+			mPassCBAddresses[2 + i] = uploads->UploadConstants(cubeFacePassCB);
 		}
 	}
 
@@ -1342,8 +1961,7 @@ namespace DX12Lib
 		}
 
 		// Reflected pass stored in index 1
-		auto currPassCB = mFrameResources[mCurrFrameResourceIndex]->PassCB.get();
-		currPassCB->UploadData(1, &mReflectedPassCB);
+		mPassCBAddresses[1] = mFrameResources[mCurrFrameResourceIndex]->Uploads->UploadConstants(mReflectedPassCB);
 	}
 
 	void Game::UpdateSsaoPassCB(const Timer& timer)
@@ -1378,63 +1996,67 @@ namespace DX12Lib
 		ssaoCB.OcclusionFadeEnd = 1.0f;
 		ssaoCB.SurfaceEpsilon = 0.05f;
 
-		auto currSsaoCB = mFrameResources[mCurrFrameResourceIndex]->SsaoCB.get();
-		currSsaoCB->UploadData(0, &ssaoCB);
+		mSsaoCBAddress = mFrameResources[mCurrFrameResourceIndex]->Uploads->UploadConstants(ssaoCB);
 	}
 
 	void Game::UpdateSkinnedCBs(const Timer& timer)
 	{
-		auto currSkinnedCB = mFrameResources[mCurrFrameResourceIndex]->SkinnedCB.get();
+		// The model was turned away at load.
+		if (!mSkinnedModelInst)
+			return;
 
 		// We only have one skinned model being animated.
 		mSkinnedModelInst->UpdateSkinnedAnimation(timer.DeltaTime());
 
-		SkinnedConstant skinnedConstant;
-		std::copy(
-			std::begin(mSkinnedModelInst->FinalTransforms),
-			std::end(mSkinnedModelInst->FinalTransforms),
-			&skinnedConstant.BoneTransforms[0]);
-
-		currSkinnedCB->UploadData(0, &skinnedConstant);
+		// The palette is streamed straight from the model, without a copy on the stack. Only the
+		// model's bones are written, so the rest of the palette is left uninitialized; those entries
+		// are never indexed. InitSkinnedMesh made sure they fit.
+		const std::vector<DirectX::XMFLOAT4X4>& transforms = mSkinnedModelInst->FinalTransforms;
+		UploadAllocation skinnedCB = mFrameResources[mCurrFrameResourceIndex]->Uploads->Allocate(sizeof(SkinnedConstant));
+		StreamCopy(skinnedCB.Data, transforms.data(), transforms.size() * sizeof(DirectX::XMFLOAT4X4));
+		mSkinnedCBAddress = skinnedCB.GpuAddress;
 	}
 
-	void Game::RenderActors(ID3D12GraphicsCommandList* cmdList, const FrameResource* frameResource, const std::vector<Actor*>& actors)
+	void Game::SubmitDrawPackets(CommandRecorder& recorder, const FrameResource* frameResource, UINT pass, UINT firstSlot, UINT lastSlot, ID3D12PipelineState* pipelineOverride)
 	{
-		auto elementSizeInBytes = frameResource->InstanceBuffer->GetElementSizeInBytes();
-		auto instanceBuffer = frameResource->InstanceBuffer->Resource();
-		auto skinnedCB = frameResource->SkinnedCB->Resource();
-		UINT skinnedCBByteSize = CalcConstantBufferByteSize(sizeof(SkinnedConstant));
+		// The passes bind other state straight on the list between submits.
+		recorder.Reset();
 
-		for (auto actor : actors)
+		if (mIndirectDraws)
 		{
-			if (actor->Visible == false)
-				continue;
-
-			D3D12_VERTEX_BUFFER_VIEW vbv = actor->Group->VertexBufferView();
-			D3D12_INDEX_BUFFER_VIEW ibv = actor->Group->IndexBufferView();
-
-			cmdList->IASetVertexBuffers(0, 1, &vbv);
-			cmdList->IASetIndexBuffer(&ibv);
-			cmdList->IASetPrimitiveTopology(actor->PrimitiveType);
+			uint64_t beginKey = DrawKey::Begin(pass, firstSlot);
+			uint64_t endKey = lastSlot + 1 < DrawList::MaxSlots ? DrawKey::Begin(pass, lastSlot + 1) : DrawKey::Begin(pass + 1);
 
-			D3D12_GPU_VIRTUAL_ADDRESS address = instanceBuffer->GetGPUVirtualAddress();
-			address += actor->InstanceBufferOffset * elementSizeInBytes;
+			auto bucketLess = [](const IndirectBucket& bucket, uint64_t key) { return bucket.Key < key; };
+			const std::vector<IndirectBucket>& buckets = mIndirectDrawBuilder.GetBuckets();
+			auto firstBucket = std::lower_bound(buckets.begin(), buckets.end(), beginKey, bucketLess);
+			auto lastBucket = std::lower_bound(firstBucket, buckets.end(), endKey, bucketLess);
 
-			cmdList->SetGraphicsRootShaderResourceView(RSP_InstanceBuffer, address);
+			auto argumentBuffer = frameResource->IndirectArgsBuffer->Resource();
 
-			if (actor->mSkinnedMesh != nullptr)
+			for (auto bucket = firstBucket; bucket != lastBucket; ++bucket)
 			{
-				D3D12_GPU_VIRTUAL_ADDRESS skinnedCBAddress = skinnedCB->GetGPUVirtualAddress() + actor->SkinnedCBIndex * skinnedCBByteSize;
-				cmdList->SetGraphicsRootConstantBufferView(RSP_SkinnedCB, skinnedCBAddress);
+				recorder.SetPipelineState(ToHandle(pipelineOverride ? pipelineOverride : mPSOs[bucket->Pipeline].Get()));
+				recorder.SetPrimitiveTopology(bucket->Topology);
+				recorder.ExecuteIndirect(ToHandle(mDrawCommandSignature.Get()), bucket->DrawCount, ToHandle(argumentBuffer.Get()), (UINT64)bucket->FirstDraw * IndirectDrawBuilder::ArgumentStride);
 			}
-			else
-			{
-				cmdList->SetGraphicsRootConstantBufferView(RSP_SkinnedCB, 0);
-			}
-
-			Submesh submesh = actor->Group->DrawArgs[actor->DrawArg];
-			cmdList->DrawIndexedInstanced(submesh.IndexCount, 1, submesh.StartIndexLocation, submesh.BaseVertexLocation, 0);
+			return;
 		}
+
+		std::array<GpuObjectHandle, PSO_Count> pipelines;
+		for (UINT i = 0; i < PSO_Count; ++i)
+			pipelines[i] = ToHandle(mPSOs[i].Get());
+
+		DrawSubmitState state;
+		state.Pipelines = pipelines.data();
+		state.PipelineOverride = ToHandle(pipelineOverride);
+		state.InstanceIndicesParameter = RSP_InstanceIndices;
+		state.InstanceIndices = frameResource->InstanceIndexBuffer->Resource()->GetGPUVirtualAddress();
+		state.InstanceIndexStride = frameResource->InstanceIndexBuffer->GetElementSizeInBytes();
+		state.SkinnedCBParameter = RSP_SkinnedCB;
+		state.SkinnedCB = mSkinnedCBAddress;
+		state.SkinnedCBStride = CalcConstantBufferByteSize(sizeof(SkinnedConstant));
+		mDrawList.Submit(recorder, pass, firstSlot, lastSlot, state);
 	}
 
 	void Game::RenderSceneToCubeMap()
@@ -1448,9 +2070,6 @@ namespace DX12Lib
 		CD3DX12_RESOURCE_BARRIER barrier1 = CD3DX12_RESOURCE_BARRIER::Transition(mDynamicCubeMap->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_RENDER_TARGET);
 		mCommandList->ResourceBarrier(1, &barrier1);
 
-		auto passCB = mFrameResources[mCurrFrameResourceIndex]->PassCB->Resource();
-		UINT passCBByteSizes = CalcConstantBufferByteSize(sizeof(PassConstant));
-
 		for (int i = 0; i < 6; ++i)
 		{
 			D3D12_CPU_DESCRIPTOR_HANDLE cubeRtvHandle = mDynamicCubeMap->GetRTV(i);
@@ -1460,15 +2079,9 @@ namespace DX12Lib
 			mCommandList->ClearDepthStencilView(cubeDsvHandle, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 			mCommandList->OMSetRenderTargets(1, &cubeRtvHandle, true, &cubeDsvHandle);
 
-			D3D12_GPU_VIRTUAL_ADDRESS passCBAddress = passCB->GetGPUVirtualAddress() + (2 + i) * passCBByteSizes;
-			mCommandList->SetGraphicsRootConstantBufferView(RSP_PassCB, passCBAddress);
-
-			RenderActors(mCommandList.Get(), mFrameResources[mCurrFrameResourceIndex].get(), mAssetManager.GetActors(Render_Layer_Opaque | Render_Layer_SKinnedOpaque));
+			mCommandList->SetGraphicsRootConstantBufferView(RSP_PassCB, mPassCBAddresses[2 + i]);
 
-			mCommandList->SetPipelineState(mPSOs[L"sky"].Get());
-			RenderActors(mCommandList.Get(), mFrameResources[mCurrFrameResourceIndex].get(), mAssetManager.GetActors(Render_Layer_Sky));
-
-			mCommandList->SetPipelineState(mPSOs[L"opaque"].Get());
+			SubmitDrawPackets(mCommandRecorder, mFrameResources[mCurrFrameResourceIndex].get(), CV_CubeFace0 + i);
 		}
 
 		CD3DX12_RESOURCE_BARRIER barrier2 = CD3DX12_RESOURCE_BARRIER::Transition(mDynamicCubeMap->GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_GENERIC_READ);
@@ -1492,13 +2105,9 @@ namespace DX12Lib
 		mCommandList->ClearDepthStencilView(hCpuDescriptor, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 		mCommandList->OMSetRenderTargets(0, nullptr, true, &hCpuDescriptor);
 
-		auto passCB = mFrameResources[mCurrFrameResourceIndex]->PassCB->Resource();
-		UINT passCBByteSizes = CalcConstantBufferByteSize(sizeof(PassConstant));
-		D3D12_GPU_VIRTUAL_ADDRESS passCBAddress = passCB->GetGPUVirtualAddress() + passCBByteSizes;
-		mCommandList->SetGraphicsRootConstantBufferView(RSP_PassCB, passCBAddress);
+		mCommandList->SetGraphicsRootConstantBufferView(RSP_PassCB, mPassCBAddresses[1]);
 
-		mCommandList->SetPipelineState(mPSOs[L"shadow"].Get());
-		RenderActors(mCommandList.Get(), mFrameResources[mCurrFrameResourceIndex].get(), mAssetManager.GetActors(Render_Layer_Opaque | Render_Layer_OpaqueDynamicReflectors));
+		SubmitDrawPackets(mCommandRecorder, mFrameResources[mCurrFrameResourceIndex].get(), CV_Shadow);
 
 		CD3DX12_RESOURCE_BARRIER barrier2 = CD3DX12_RESOURCE_BARRIER::Transition(mShadowMap->GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_GENERIC_READ);
 		mCommandList->ResourceBarrier(1, &barrier2);
@@ -1587,91 +2196,34 @@ namespace DX12Lib
 		// Assume nothing is picked to start, so the picked render-item is invisible.
 		mPickedActor->Visible = false;
 
-		auto actors = mAssetManager.GetActors(Render_Layer_All - Render_Layer_Highlight);
-		float distViewMin = FLT_MAX;
-
-		for (auto actor : actors)
-		{
-			TLOG(actor->ToString().c_str());
-			TLOG(L"\n");
+		// The scene is traced in world space, each hit actor's triangles in its local space.
+		DirectX::XMVECTOR rayWorldOrigin = DirectX::XMVector3TransformCoord(rayViewOrigin, invView);
+		DirectX::XMVECTOR rayWorldDir = DirectX::XMVector3Normalize(DirectX::XMVector3TransformNormal(rayViewDir, invView));
 
-			// Skip invisible render-items.
-			if (actor->Visible == false)
-				continue;
+		RayDesc ray;
+		DirectX::XMStoreFloat3(&ray.Origin, rayWorldOrigin);
+		DirectX::XMStoreFloat3(&ray.Direction, rayWorldDir);
+		ray.LayerMask = ~(UINT)Render_Layer_Highlight;
 
-			DirectX::XMVECTOR rayLocalOrigin = DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-			DirectX::XMVECTOR rayLocalDir = DirectX::XMVector3Normalize(DirectX::XMVectorSet(vx, vy, 1.0f, 0.0f));
-
-			DirectX::XMMATRIX W = DirectX::XMLoadFloat4x4(&actor->Instance.World);
-			auto d = DirectX::XMMatrixDeterminant(W);
-			DirectX::XMMATRIX invWorld = XMMatrixInverse(&d, W);
-
-			DirectX::XMMATRIX toView = DirectX::XMMatrixMultiply(W, V);
-			DirectX::XMMATRIX toLocal = DirectX::XMMatrixMultiply(invView, invWorld);
-
-			rayLocalOrigin = DirectX::XMVector3TransformCoord(rayLocalOrigin, toLocal);
-			rayLocalDir = DirectX::XMVector3Normalize(DirectX::XMVector3TransformNormal(rayLocalDir, toLocal));
+		RayHit hit;
+		mRayQuery->Trace(&ray, 1, &hit);
+		if (!hit.IsHit())
+			return;
 
-			auto submesh = actor->Group->DrawArgs[actor->DrawArg];
-			float blah = 0.0f;
-			if (submesh.Bound.Intersects(rayLocalOrigin, rayLocalDir, blah))
-			{
-				float distLocalMin = FLT_MAX;
-
-				// NOTE: For the demo, we know what to cast the vertex/index data to.  If we were mixing
-				// formats, some metadata would be needed to figure out what to cast it to.
-				auto vertices = (Vertex*)actor->Group->VertexBufferCPU->GetBufferPointer();
-				auto indices = (std::uint16_t*)actor->Group->IndexBufferCPU->GetBufferPointer();
-				UINT triCount = submesh.IndexCount / 3;
-
-				// Find the nearest ray/triangle intersection.
-				for (UINT i = 0; i < triCount; ++i)
-				{
-					// Indices for this triangle.
-					UINT i0 = indices[i * 3 + 0];
-					UINT i1 = indices[i * 3 + 1];
-					UINT i2 = indices[i * 3 + 2];
-
-					// Vertices for this triangle.
-					DirectX::XMVECTOR v0 = DirectX::XMLoadFloat3(&vertices[i0].Position);
-					DirectX::XMVECTOR v1 = DirectX::XMLoadFloat3(&vertices[i1].Position);
-					DirectX::XMVECTOR v2 = DirectX::XMLoadFloat3(&vertices[i2].Position);
-
-					// We have to iterate over all the triangles in order to find the nearest intersection.
-					float distLocal = FLT_MAX;
-					if (DirectX::TriangleTests::Intersects(rayLocalOrigin, rayLocalDir, v0, v1, v2, distLocal))
-					{
-						if (distLocal < distLocalMin)
-						{
-							// This is the new nearest picked triangle in the local space.
-							distLocalMin = distLocal;
-
-							v0 = DirectX::XMVector3TransformCoord(v0, toView);
-							v1 = DirectX::XMVector3TransformCoord(v1, toView);
-							v2 = DirectX::XMVector3TransformCoord(v2, toView);
-
-							float distView = FLT_MAX;
-							if (DirectX::TriangleTests::Intersects(rayViewOrigin, rayViewDir, v0, v1, v2, distView))
-							{
-								if (distView < distViewMin)
-								{
-									// This is the new nearest picked triangle in the view space.
-									distViewMin = distView;
-
-									mPickedActor->Visible = true;
-									mPickedActor->Group = actor->Group;
-									mPickedActor->Group->DrawArgs[mPickedActor->DrawArg].IndexCount = 3;
-									mPickedActor->Group->DrawArgs[mPickedActor->DrawArg].BaseVertexLocation = 0;
-									mPickedActor->Group->DrawArgs[mPickedActor->DrawArg].StartIndexLocation = 3 * i;
-									mPickedActor->Instance.World = actor->Instance.World;
-									mPickedActor->Instance.TexTransform = actor->Instance.TexTransform;
-								}
-							}
-						}
-					}
-				}
-			}
-		}
+		Actor* actor = static_cast<Actor*>(static_cast<ActorView*>(hit.UserData));
+		TLOG(actor->ToString().c_str());
+		TLOG(L"\n");
+
+		// Collision triangles keep the order of the submesh indices, so the hit index addresses the draw range directly.
+		const Submesh& submesh = *mAssetManager.GetActorStore().GetSubmesh(actor->Handle);
+		mPickedActor->Visible = true;
+		mPickedActor->Group = actor->Group;
+		mPickedActor->Group->DrawArgs[mPickedActor->DrawArg].IndexCount = 3;
+		mPickedActor->Group->DrawArgs[mPickedActor->DrawArg].BaseVertexLocation = submesh.BaseVertexLocation;
+		mPickedActor->Group->DrawArgs[mPickedActor->DrawArg].StartIndexLocation = submesh.StartIndexLocation + 3 * hit.TriangleIndex;
+		mPickedActor->Instance.World = actor->Instance.World;
+		mPickedActor->Instance.TexTransform = actor->Instance.TexTransform;
+		mAssetManager.UpdateActor(mPickedActor);
 	}
 
 }
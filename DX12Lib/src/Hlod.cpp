@@ -0,0 +1,256 @@
+#include "DX12Lib/Hlod.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace DX12Lib
+{
+	namespace
+	{
+		// Three signed 21 bit grid coordinates in one key.
+		inline uint64_t CellKey(const DirectX::XMFLOAT3& p, float cellSize)
+		{
+			const int64_t bias = 1 << 20;
+			uint64_t x = (uint64_t)((int64_t)std::floor(p.x / cellSize) + bias) & 0x1FFFFF;
+			uint64_t y = (uint64_t)((int64_t)std::floor(p.y / cellSize) + bias) & 0x1FFFFF;
+			uint64_t z = (uint64_t)((int64_t)std::floor(p.z / cellSize) + bias) & 0x1FFFFF;
+			return (x << 42) | (y << 21) | z;
+		}
+
+		inline DirectX::XMVECTOR FaceNormal(const DirectX::XMFLOAT3& p0, const DirectX::XMFLOAT3& p1, const DirectX::XMFLOAT3& p2)
+		{
+			DirectX::XMVECTOR v0 = DirectX::XMLoadFloat3(&p0);
+			DirectX::XMVECTOR e0 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&p1), v0);
+			DirectX::XMVECTOR e1 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&p2), v0);
+			// Not normalized, so larger triangles weigh more in the vertex normals.
+			return DirectX::XMVector3Cross(e0, e1);
+		}
+	}
+
+	std::vector<HlodCluster> HlodBuilder::Build(const std::vector<HlodSource>& sources, const HlodSettings& settings)
+	{
+		std::vector<std::pair<uint64_t, uint32_t>> cells(sources.size());
+		for (uint32_t i = 0; i < sources.size(); ++i)
+			cells[i] = { CellKey(sources[i].Bound.Center, settings.ClusterCellSize), i };
+
+		// Sorting by cell and then source index keeps the output deterministic.
+		std::sort(cells.begin(), cells.end());
+
+		std::vector<HlodCluster> clusters;
+
+		for (size_t begin = 0; begin < cells.size();)
+		{
+			size_t end = begin + 1;
+			while (end < cells.size() && cells[end].first == cells[begin].first)
+				++end;
+
+			if (end - begin >= settings.MinClusterSize)
+			{
+				HlodCluster cluster;
+				cluster.SwitchDistance = settings.SwitchDistance;
+				cluster.Bound = sources[cells[begin].second].Bound;
+
+				uint32_t mostTriangles = 0;
+				for (size_t i = begin; i < end; ++i)
+				{
+					const HlodSource& source = sources[cells[i].second];
+					cluster.Members.push_back(cells[i].second);
+					DirectX::BoundingBox::CreateMerged(cluster.Bound, cluster.Bound, source.Bound);
+
+					if (source.TriangleCount > mostTriangles)
+					{
+						mostTriangles = source.TriangleCount;
+						cluster.Material = source.Material;
+					}
+				}
+
+				MeshData merged = Merge(sources, cluster.Members);
+
+				// The proxy is drawn with 16 bit indices, coarsen until it fits.
+				float weldCellSize = settings.WeldCellSize;
+				cluster.Proxy = Simplify(merged, weldCellSize, settings.TexCoordScale);
+				while (cluster.Proxy.Vertices.size() > 0xFFFF)
+				{
+					weldCellSize *= 2.0f;
+					cluster.Proxy = Simplify(merged, weldCellSize, settings.TexCoordScale);
+				}
+
+				clusters.push_back(std::move(cluster));
+			}
+
+			begin = end;
+		}
+
+		return clusters;
+	}
+
+	MeshData HlodBuilder::Merge(const std::vector<HlodSource>& sources, const std::vector<uint32_t>& members)
+	{
+		MeshData mesh;
+
+		for (uint32_t member : members)
+		{
+			const HlodSource& source = sources[member];
+			DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&source.World);
+
+			for (uint32_t t = 0; t < source.TriangleCount; ++t)
+			{
+				DirectX::XMFLOAT3 p[3];
+				for (int k = 0; k < 3; ++k)
+					DirectX::XMStoreFloat3(&p[k], DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&source.TriangleVertices[t * 3 + k]), world));
+
+				DirectX::XMFLOAT3 normal;
+				DirectX::XMStoreFloat3(&normal, DirectX::XMVector3Normalize(FaceNormal(p[0], p[1], p[2])));
+
+				for (int k = 0; k < 3; ++k)
+				{
+					Vertex v;
+					v.Position = p[k];
+					v.Normal = normal;
+					v.TexCoord = DirectX::XMFLOAT2(0.0f, 0.0f);
+					v.TangentU = DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f);
+
+					mesh.Indices32.push_back((uint32_t)mesh.Vertices.size());
+					mesh.Vertices.push_back(v);
+				}
+			}
+		}
+
+		return mesh;
+	}
+
+	MeshData HlodBuilder::Simplify(const MeshData& mesh, float cellSize, float texCoordScale)
+	{
+		MeshData result;
+
+		// Every vertex collapses into the representative of its grid cell.
+		std::unordered_map<uint64_t, uint32_t> cellVertices;
+		std::vector<uint32_t> remap(mesh.Vertices.size());
+		std::vector<DirectX::XMFLOAT3> sums;
+		std::vector<uint32_t> counts;
+
+		for (size_t i = 0; i < mesh.Vertices.size(); ++i)
+		{
+			const DirectX::XMFLOAT3& p = mesh.Vertices[i].Position;
+			auto inserted = cellVertices.emplace(CellKey(p, cellSize), (uint32_t)sums.size());
+			if (inserted.second)
+			{
+				sums.push_back(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+				counts.push_back(0);
+			}
+
+			uint32_t index = inserted.first->second;
+			remap[i] = index;
+			sums[index].x += p.x;
+			sums[index].y += p.y;
+			sums[index].z += p.z;
+			++counts[index];
+		}
+
+		result.Vertices.resize(sums.size());
+		for (size_t i = 0; i < sums.size(); ++i)
+		{
+			float inv = 1.0f / counts[i];
+			result.Vertices[i].Position = DirectX::XMFLOAT3(sums[i].x * inv, sums[i].y * inv, sums[i].z * inv);
+		}
+
+		std::vector<DirectX::XMFLOAT3> normals(sums.size(), DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+		for (size_t t = 0; t + 2 < mesh.Indices32.size(); t += 3)
+		{
+			uint32_t i0 = remap[mesh.Indices32[t + 0]];
+			uint32_t i1 = remap[mesh.Indices32[t + 1]];
+			uint32_t i2 = remap[mesh.Indices32[t + 2]];
+			if (i0 == i1 || i1 == i2 || i2 == i0)
+				continue;
+
+			result.Indices32.push_back(i0);
+			result.Indices32.push_back(i1);
+			result.Indices32.push_back(i2);
+
+			DirectX::XMVECTOR n = FaceNormal(result.Vertices[i0].Position, result.Vertices[i1].Position, result.Vertices[i2].Position);
+			for (uint32_t index : { i0, i1, i2 })
+				DirectX::XMStoreFloat3(&normals[index], DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&normals[index]), n));
+		}
+
+		for (size_t i = 0; i < result.Vertices.size(); ++i)
+		{
+			Vertex& v = result.Vertices[i];
+
+			DirectX::XMVECTOR n = DirectX::XMLoadFloat3(&normals[i]);
+			if (DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(n)) > 0.0f)
+				DirectX::XMStoreFloat3(&v.Normal, DirectX::XMVector3Normalize(n));
+			else
+				v.Normal = DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);
+
+			// Planar mapping along the dominant normal axis; one material covers the proxy, so
+			// there is no atlas to map into.
+			float ax = std::fabs(v.Normal.x);
+			float ay = std::fabs(v.Normal.y);
+			float az = std::fabs(v.Normal.z);
+			const DirectX::XMFLOAT3& p = v.Position;
+
+			if (ay >= ax && ay >= az)
+			{
+				v.TexCoord = DirectX::XMFLOAT2(p.x * texCoordScale, p.z * texCoordScale);
+				v.TangentU = DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f);
+			}
+			else if (ax >= az)
+			{
+				v.TexCoord = DirectX::XMFLOAT2(p.z * texCoordScale, -p.y * texCoordScale);
+				v.TangentU = DirectX::XMFLOAT3(0.0f, 0.0f, 1.0f);
+			}
+			else
+			{
+				v.TexCoord = DirectX::XMFLOAT2(p.x * texCoordScale, -p.y * texCoordScale);
+				v.TangentU = DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f);
+			}
+		}
+
+		return result;
+	}
+
+	void HlodSwitch::Clear()
+	{
+		mBounds.clear();
+		mSwitchDistances.clear();
+		mProxyActive.clear();
+		mChanged.clear();
+	}
+
+	uint32_t HlodSwitch::AddCluster(const DirectX::BoundingBox& bound, float switchDistance)
+	{
+		mBounds.push_back(bound);
+		mSwitchDistances.push_back(switchDistance);
+		mProxyActive.push_back(0);
+		return (uint32_t)mBounds.size() - 1;
+	}
+
+	void HlodSwitch::Update(const DirectX::XMFLOAT3& eye, float hysteresis)
+	{
+		mChanged.clear();
+
+		for (uint32_t i = 0; i < mBounds.size(); ++i)
+		{
+			// Distance to the nearest point of the bound, zero inside it.
+			const DirectX::BoundingBox& bound = mBounds[i];
+			float dx = std::fabs(eye.x - bound.Center.x) - bound.Extents.x;
+			float dy = std::fabs(eye.y - bound.Center.y) - bound.Extents.y;
+			float dz = std::fabs(eye.z - bound.Center.z) - bound.Extents.z;
+			dx = dx > 0.0f ? dx : 0.0f;
+			dy = dy > 0.0f ? dy : 0.0f;
+			dz = dz > 0.0f ? dz : 0.0f;
+			float distanceSq = dx * dx + dy * dy + dz * dz;
+
+			bool active = mProxyActive[i] != 0;
+			float threshold = mSwitchDistances[i] * (active ? 1.0f - hysteresis : 1.0f + hysteresis);
+			bool proxy = distanceSq > threshold * threshold;
+
+			if (proxy != active)
+			{
+				mProxyActive[i] = proxy ? 1 : 0;
+				mChanged.push_back(i);
+			}
+		}
+	}
+}
@@ -0,0 +1,83 @@
+#include "DX12Lib/IndirectDraw.h"
+
+namespace DX12Lib
+{
+	std::array<IndirectArgument, IndirectDrawBuilder::ArgumentCount> IndirectDrawBuilder::GetArguments(uint32_t instanceIndicesParameter, uint32_t skinnedCBParameter)
+	{
+		// The draw has to come last.
+		return { {
+			{ Indirect_Argument_VertexBuffer, 0 },
+			{ Indirect_Argument_IndexBuffer, 0 },
+			{ Indirect_Argument_ShaderResourceView, instanceIndicesParameter },
+			{ Indirect_Argument_ConstantBufferView, skinnedCBParameter },
+			{ Indirect_Argument_DrawIndexed, 0 },
+		} };
+	}
+
+	IndirectDrawBuilder::IndirectDrawBuilder(JobSystem& jobs) :
+		mJobs(jobs)
+	{
+	}
+
+	void IndirectDrawBuilder::Build(const std::vector<IndirectDrawInput>& inputs, const IndirectDrawAddresses& addresses, IndirectDrawArguments* arguments)
+	{
+		mInputs = inputs.data();
+		mCount = inputs.size();
+		mAddresses = addresses;
+		mArguments = arguments;
+		mPartCount = mCount >= ParallelThreshold ? mJobs.GetThreadCount() : 1;
+
+		if (mCount > 0)
+			mJobs.ParallelFor(mPartCount, [this](unsigned part) { Pack(part); });
+
+		BuildBuckets();
+	}
+
+	void IndirectDrawBuilder::BuildBuckets()
+	{
+		mBuckets.clear();
+
+		for (uint32_t i = 0; i < mCount; ++i)
+		{
+			const IndirectDrawInput& input = mInputs[i];
+
+			if (!mBuckets.empty())
+			{
+				IndirectBucket& bucket = mBuckets.back();
+				if (bucket.Key == input.BucketKey && bucket.Pipeline == input.Pipeline && bucket.Topology == input.Topology)
+				{
+					++bucket.DrawCount;
+					continue;
+				}
+			}
+
+			mBuckets.push_back({ input.BucketKey, input.Pipeline, input.Topology, i, 1 });
+		}
+	}
+
+	void IndirectDrawBuilder::Pack(unsigned part)
+	{
+		size_t begin = mCount * part / mPartCount;
+		size_t end = mCount * (part + 1) / mPartCount;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			const IndirectDrawInput& input = mInputs[i];
+
+			// Written whole, the destination may be write combined.
+			IndirectDrawArguments arguments;
+			arguments.VertexBuffer = input.VertexBuffer;
+			arguments.IndexBuffer = input.IndexBuffer;
+			arguments.InstanceIndices = mAddresses.InstanceIndices + (uint64_t)input.InstanceOffset * mAddresses.InstanceIndexStride;
+			arguments.SkinnedCB = input.SkinnedCBIndex == NoSkinnedCB ? 0 : mAddresses.SkinnedCB + (uint64_t)input.SkinnedCBIndex * mAddresses.SkinnedCBStride;
+			arguments.Draw.IndexCountPerInstance = input.IndexCount;
+			arguments.Draw.InstanceCount = input.InstanceCount;
+			arguments.Draw.StartIndexLocation = input.StartIndexLocation;
+			arguments.Draw.BaseVertexLocation = input.BaseVertexLocation;
+			arguments.Draw.StartInstanceLocation = 0;
+			arguments.Padding = 0;
+
+			mArguments[i] = arguments;
+		}
+	}
+}
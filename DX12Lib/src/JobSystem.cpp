@@ -0,0 +1,141 @@
+#include "DX12Lib/JobSystem.h"
+
+namespace DX12Lib
+{
+	unsigned JobSystem::DefaultWorkerCount()
+	{
+		unsigned cores = std::thread::hardware_concurrency();
+		return cores > 1 ? cores - 1 : 0u;
+	}
+
+	JobSystem::JobSystem(unsigned workerCount)
+	{
+		for (unsigned i = 0; i < workerCount; ++i)
+			mWorkers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQuit = true;
+		}
+		mWake.notify_all();
+
+		// Workers only leave once the queue is empty.
+		for (auto& worker : mWorkers)
+			worker.join();
+	}
+
+	void JobSystem::Run(std::function<void()> task)
+	{
+		if (mWorkers.empty())
+		{
+			task();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQueue.push_back({ nullptr, std::move(task) });
+		}
+		mWake.notify_one();
+	}
+
+	void JobSystem::Dispatch(unsigned partCount, Invoke function, const void* context)
+	{
+		// No point in waking more helpers than there are parts left for them.
+		unsigned helperCount = partCount - 1 < mWorkers.size() ? partCount - 1 : (unsigned)mWorkers.size();
+
+		Job* job;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			if (mFreeJobs.empty())
+			{
+				mJobs.push_back(std::make_unique<Job>());
+				mFreeJobs.push_back(mJobs.back().get());
+			}
+			job = mFreeJobs.back();
+			mFreeJobs.pop_back();
+
+			job->Function = function;
+			job->Context = context;
+			job->PartCount = partCount;
+			job->NextPart.store(0, std::memory_order_relaxed);
+			job->PartsDone.store(0, std::memory_order_relaxed);
+			job->References = 1 + helperCount;
+
+			for (unsigned i = 0; i < helperCount; ++i)
+				mQueue.push_back({ job, nullptr });
+		}
+
+		if (helperCount == mWorkers.size())
+			mWake.notify_all();
+		else
+		{
+			for (unsigned i = 0; i < helperCount; ++i)
+				mWake.notify_one();
+		}
+
+		RunParts(*job);
+
+		// Helpers still busy with a part of ours are waited for without spinning; helpers that
+		// have not started yet find nothing left and only drop their reference.
+		std::unique_lock<std::mutex> lock(mMutex);
+		mJobDone.wait(lock, [job]() { return job->PartsDone.load(std::memory_order_acquire) == job->PartCount; });
+		if (--job->References == 0)
+			mFreeJobs.push_back(job);
+	}
+
+	void JobSystem::RunParts(Job& job)
+	{
+		unsigned part;
+		while ((part = job.NextPart.fetch_add(1, std::memory_order_relaxed)) < job.PartCount)
+		{
+			job.Function(job.Context, part);
+
+			if (job.PartsDone.fetch_add(1, std::memory_order_acq_rel) + 1 == job.PartCount)
+			{
+				// Taking the lock orders the notify after the caller's check of PartsDone.
+				std::lock_guard<std::mutex> lock(mMutex);
+				mJobDone.notify_all();
+			}
+		}
+	}
+
+	void JobSystem::Release(Job* job)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (--job->References == 0)
+			mFreeJobs.push_back(job);
+	}
+
+	void JobSystem::WorkerLoop()
+	{
+		for (;;)
+		{
+			Entry entry;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWake.wait(lock, [this]() { return mQuit || !mQueue.empty(); });
+
+				if (mQueue.empty())
+					return;
+
+				entry = std::move(mQueue.front());
+				mQueue.pop_front();
+			}
+
+			if (entry.Helper)
+			{
+				RunParts(*entry.Helper);
+				Release(entry.Helper);
+			}
+			else
+			{
+				entry.Task();
+			}
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#include "DX12Lib/LinearUploadAllocator.h"
+#include <cassert>
+#include <utility>
+
+namespace DX12Lib
+{
+	LinearUploadAllocator::LinearUploadAllocator(std::unique_ptr<UploadPageSource> pages, size_t pageSize) :
+		mSource(std::move(pages)),
+		mPageSize((pageSize + Alignment - 1) & ~(Alignment - 1)),
+		mCurrent(nullptr)
+	{
+	}
+
+	UploadAllocation LinearUploadAllocator::Allocate(size_t byteSize)
+	{
+		size_t size = (byteSize + Alignment - 1) & ~(Alignment - 1);
+
+		for (;;)
+		{
+			Page* page = mCurrent.load(std::memory_order_acquire);
+			if (page)
+			{
+				size_t offset = page->Offset.fetch_add(size, std::memory_order_relaxed);
+				if (offset + size <= page->Size)
+				{
+					UploadAllocation allocation;
+					allocation.Data = page->Data + offset;
+					allocation.GpuAddress = page->GpuAddress + offset;
+					return allocation;
+				}
+			}
+
+			NextPage(page, size);
+		}
+	}
+
+	void LinearUploadAllocator::NextPage(Page* full, size_t byteSize)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		// Another thread got here first and already moved on.
+		if (mCurrent.load(std::memory_order_relaxed) != full)
+			return;
+
+		// Pages from earlier frames are used again before any new one is created.
+		size_t found = mPagesInUse;
+		while (found < mPages.size() && mPages[found]->Size < byteSize)
+			++found;
+
+		if (found == mPages.size())
+		{
+			auto page = std::make_unique<Page>();
+			page->Size = byteSize > mPageSize ? byteSize : mPageSize;
+
+			UploadAllocation memory = mSource->CreatePage(page->Size);
+			assert(memory.Data && (memory.GpuAddress & (Alignment - 1)) == 0 && "Upload pages have to be aligned");
+			page->Data = memory.Data;
+			page->GpuAddress = memory.GpuAddress;
+			mPages.push_back(std::move(page));
+		}
+
+		std::swap(mPages[mPagesInUse], mPages[found]);
+		Page* next = mPages[mPagesInUse++].get();
+		next->Offset.store(0, std::memory_order_relaxed);
+		mCurrent.store(next, std::memory_order_release);
+	}
+
+	void LinearUploadAllocator::Reset()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mPagesInUse = 0;
+		mCurrent.store(nullptr, std::memory_order_relaxed);
+	}
+
+	size_t LinearUploadAllocator::GetAllocatedBytes() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		size_t bytes = 0;
+		for (size_t i = 0; i < mPagesInUse; ++i)
+		{
+			size_t offset = mPages[i]->Offset.load(std::memory_order_relaxed);
+			bytes += offset < mPages[i]->Size ? offset : mPages[i]->Size;
+		}
+		return bytes;
+	}
+
+	size_t LinearUploadAllocator::GetPageCount() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mPages.size();
+	}
+}
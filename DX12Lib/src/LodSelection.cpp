@@ -0,0 +1,79 @@
+#include "DX12Lib/LodSelection.h"
+#include <cfloat>
+#include <cmath>
+
+namespace DX12Lib
+{
+	LodView LodView::Perspective(const DirectX::XMFLOAT3& eye, float projScaleY, float viewportHeight, float bias)
+	{
+		LodView view;
+		view.Eye = eye;
+		view.PixelScale = 0.5f * viewportHeight * projScaleY;
+		view.Bias = bias;
+		return view;
+	}
+
+	LodView LodView::Ortho(float viewHeight, float viewportHeight, float bias)
+	{
+		LodView view;
+		view.PixelScale = viewportHeight / viewHeight;
+		view.Orthographic = true;
+		view.Bias = bias;
+		return view;
+	}
+
+	float LodSelector::ProjectedPixelRadius(const LodView& view, const DirectX::BoundingBox& box)
+	{
+		const DirectX::XMFLOAT3& e = box.Extents;
+		float radius = std::sqrt(e.x * e.x + e.y * e.y + e.z * e.z);
+
+		if (view.Orthographic)
+			return radius * view.PixelScale * view.Bias;
+
+		float dx = box.Center.x - view.Eye.x;
+		float dy = box.Center.y - view.Eye.y;
+		float dz = box.Center.z - view.Eye.z;
+		float distanceSq = dx * dx + dy * dy + dz * dz;
+
+		if (distanceSq <= radius * radius)
+			return FLT_MAX;
+
+		return radius * view.PixelScale * view.Bias / std::sqrt(distanceSq);
+	}
+
+	int LodSelector::Select(float pixelRadius, const float* switchPixelRadii, int lodCount, const LodLayerSettings& settings, int previousLod)
+	{
+		// A boundary is easier to stay above than to climb back over.
+		float keep = 1.0f - settings.Hysteresis;
+		float enter = 1.0f + settings.Hysteresis;
+
+		for (int i = 0; i + 1 < lodCount; ++i)
+		{
+			bool wasAtOrAbove = previousLod >= 0 && previousLod <= i;
+			if (pixelRadius >= switchPixelRadii[i] * (wasAtOrAbove ? keep : enter))
+				return i;
+		}
+
+		float cull = settings.CullPixelRadius * (previousLod >= 0 ? keep : enter);
+		return pixelRadius >= cull ? lodCount - 1 : -1;
+	}
+
+	void LodSelector::SetLayerSettings(uint32_t layerMask, const LodLayerSettings& settings)
+	{
+		for (int i = 0; i < MaxLayers; ++i)
+		{
+			if (layerMask & (1u << i))
+				mLayers[i] = settings;
+		}
+	}
+
+	const LodLayerSettings& LodSelector::GetLayerSettings(uint32_t layer) const
+	{
+		for (int i = 0; i < MaxLayers; ++i)
+		{
+			if (layer & (1u << i))
+				return mLayers[i];
+		}
+		return mNoLayer;
+	}
+}
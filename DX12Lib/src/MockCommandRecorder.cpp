@@ -0,0 +1,80 @@
+#include "DX12Lib/MockCommandRecorder.h"
+
+namespace DX12Lib
+{
+	void MockCommandRecorder::Clear()
+	{
+		mCommands.clear();
+		for (auto& count : mCounts)
+			count = 0;
+
+		Reset();
+		ResetStats();
+	}
+
+	MockCommandRecorder::Command& MockCommandRecorder::Push(CommandType type)
+	{
+		++mCounts[type];
+		mCommands.emplace_back();
+		mCommands.back().Type = type;
+		return mCommands.back();
+	}
+
+	void MockCommandRecorder::RecordGraphicsRootSignature(GpuObjectHandle rootSignature)
+	{
+		Push(Command_RootSignature).Object = rootSignature;
+	}
+
+	void MockCommandRecorder::RecordPipelineState(GpuObjectHandle pipelineState)
+	{
+		Push(Command_PipelineState).Object = pipelineState;
+	}
+
+	void MockCommandRecorder::RecordVertexBuffer(const VertexBufferBinding& binding)
+	{
+		Push(Command_VertexBuffer).VertexBuffer = binding;
+	}
+
+	void MockCommandRecorder::RecordIndexBuffer(const IndexBufferBinding& binding)
+	{
+		Push(Command_IndexBuffer).IndexBuffer = binding;
+	}
+
+	void MockCommandRecorder::RecordPrimitiveTopology(PrimitiveTopology topology)
+	{
+		Push(Command_PrimitiveTopology).Topology = topology;
+	}
+
+	void MockCommandRecorder::RecordGraphicsRootShaderResourceView(uint32_t rootParameterIndex, GpuVirtualAddress address)
+	{
+		Command& command = Push(Command_RootShaderResourceView);
+		command.RootParameterIndex = rootParameterIndex;
+		command.Address = address;
+	}
+
+	void MockCommandRecorder::RecordGraphicsRootConstantBufferView(uint32_t rootParameterIndex, GpuVirtualAddress address)
+	{
+		Command& command = Push(Command_RootConstantBufferView);
+		command.RootParameterIndex = rootParameterIndex;
+		command.Address = address;
+	}
+
+	void MockCommandRecorder::RecordDrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+	{
+		Command& command = Push(Command_DrawIndexedInstanced);
+		command.IndexCountPerInstance = indexCountPerInstance;
+		command.InstanceCount = instanceCount;
+		command.StartIndexLocation = startIndexLocation;
+		command.BaseVertexLocation = baseVertexLocation;
+		command.StartInstanceLocation = startInstanceLocation;
+	}
+
+	void MockCommandRecorder::RecordExecuteIndirect(GpuObjectHandle commandSignature, uint32_t maxCommandCount, GpuObjectHandle argumentBuffer, uint64_t argumentBufferOffset)
+	{
+		Command& command = Push(Command_ExecuteIndirect);
+		command.Object = commandSignature;
+		command.MaxCommandCount = maxCommandCount;
+		command.ArgumentBuffer = argumentBuffer;
+		command.ArgumentBufferOffset = argumentBufferOffset;
+	}
+}
@@ -0,0 +1,407 @@
+#include "DX12Lib/OcclusionCuller.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define DX12LIB_OCCLUSION_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace DX12Lib
+{
+	namespace
+	{
+		// Point along a clip space edge, used to cut triangles at the near plane.
+		inline DirectX::XMFLOAT4 LerpClip(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b, float t)
+		{
+			return DirectX::XMFLOAT4(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t);
+		}
+
+		// Bit per clip plane the vertex is outside of, used to reject triangles early.
+		inline uint32_t OutCode(const DirectX::XMFLOAT4& v)
+		{
+			uint32_t code = 0;
+			code |= (v.x < -v.w) ? 1u : 0u;
+			code |= (v.x > v.w) ? 2u : 0u;
+			code |= (v.y < -v.w) ? 4u : 0u;
+			code |= (v.y > v.w) ? 8u : 0u;
+			code |= (v.z < 0.0f) ? 16u : 0u;
+			code |= (v.z > v.w) ? 32u : 0u;
+			return code;
+		}
+
+		// Edge function of the edge from (x0, y0) to (x1, y1), positive on the inside of a
+		// counter-clockwise triangle. The constant is taken from the lower endpoint, so the two
+		// triangles sharing an edge get exactly opposite functions.
+		struct Edge
+		{
+			float A, B, C;
+			// Pixel centers exactly on the edge are inside only for top and left edges.
+			bool TopLeft;
+		};
+
+		inline Edge MakeEdge(float x0, float y0, float x1, float y1)
+		{
+			Edge edge;
+			edge.A = y0 - y1;
+			edge.B = x1 - x0;
+
+			bool firstLower = y0 < y1 || (y0 == y1 && x0 < x1);
+			float x = firstLower ? x0 : x1, y = firstLower ? y0 : y1;
+			edge.C = -(edge.A * x + edge.B * y);
+
+			// Screen y points down: the inside lies right of a left edge and below a top edge.
+			edge.TopLeft = edge.A > 0.0f || (edge.A == 0.0f && edge.B > 0.0f);
+			return edge;
+		}
+	}
+
+	OcclusionCuller::OcclusionCuller(JobSystem& jobs) :
+		mJobs(jobs)
+	{
+		DirectX::XMStoreFloat4x4(&mViewProj, DirectX::XMMatrixIdentity());
+
+		int width = Width, height = Height;
+		while (true)
+		{
+			mLevelWidth.push_back(width);
+			mLevelHeight.push_back(height);
+			mDepth.emplace_back((size_t)width * height, 1.0f);
+
+			if (width == 1 && height == 1)
+				break;
+
+			width = (width + 1) / 2;
+			height = (height + 1) / 2;
+		}
+	}
+
+	void OcclusionCuller::BeginFrame(DirectX::FXMMATRIX viewProj)
+	{
+		DirectX::XMStoreFloat4x4(&mViewProj, viewProj);
+
+		mTriangles.clear();
+		for (auto& bin : mBins)
+			bin.clear();
+	}
+
+	void OcclusionCuller::AddOccluder(const void* positions, uint32_t vertexStride, const uint16_t* indices, uint32_t indexCount, int32_t baseVertex, DirectX::FXMMATRIX world)
+	{
+		if (indexCount < 3)
+			return;
+
+		// Transform only the vertex range the indices touch, each vertex once.
+		uint32_t minIndex = UINT32_MAX, maxIndex = 0;
+		for (uint32_t i = 0; i < indexCount; ++i)
+		{
+			minIndex = std::min<uint32_t>(minIndex, indices[i]);
+			maxIndex = std::max<uint32_t>(maxIndex, indices[i]);
+		}
+
+		DirectX::XMMATRIX worldViewProj = DirectX::XMMatrixMultiply(world, DirectX::XMLoadFloat4x4(&mViewProj));
+		const uint8_t* base = static_cast<const uint8_t*>(positions);
+
+		mClipVertices.resize(maxIndex - minIndex + 1);
+		for (uint32_t i = minIndex; i <= maxIndex; ++i)
+		{
+			auto position = reinterpret_cast<const DirectX::XMFLOAT3*>(base + (size_t)(baseVertex + (int32_t)i) * vertexStride);
+			DirectX::XMVECTOR P = DirectX::XMVectorSetW(DirectX::XMLoadFloat3(position), 1.0f);
+			DirectX::XMStoreFloat4(&mClipVertices[i - minIndex], DirectX::XMVector4Transform(P, worldViewProj));
+		}
+
+		for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			const DirectX::XMFLOAT4& v0 = mClipVertices[indices[i + 0] - minIndex];
+			const DirectX::XMFLOAT4& v1 = mClipVertices[indices[i + 1] - minIndex];
+			const DirectX::XMFLOAT4& v2 = mClipVertices[indices[i + 2] - minIndex];
+			AddClippedTriangle(v0, v1, v2);
+		}
+	}
+
+	void OcclusionCuller::AddOccluder(const DirectX::XMFLOAT3* triangleVertices, uint32_t triangleCount, DirectX::FXMMATRIX world)
+	{
+		DirectX::XMMATRIX worldViewProj = DirectX::XMMatrixMultiply(world, DirectX::XMLoadFloat4x4(&mViewProj));
+
+		mClipVertices.resize((size_t)triangleCount * 3);
+		for (size_t i = 0; i < mClipVertices.size(); ++i)
+		{
+			DirectX::XMVECTOR P = DirectX::XMVectorSetW(DirectX::XMLoadFloat3(&triangleVertices[i]), 1.0f);
+			DirectX::XMStoreFloat4(&mClipVertices[i], DirectX::XMVector4Transform(P, worldViewProj));
+		}
+
+		for (uint32_t i = 0; i < triangleCount; ++i)
+			AddClippedTriangle(mClipVertices[i * 3 + 0], mClipVertices[i * 3 + 1], mClipVertices[i * 3 + 2]);
+	}
+
+	void OcclusionCuller::AddClippedTriangle(const DirectX::XMFLOAT4& v0, const DirectX::XMFLOAT4& v1, const DirectX::XMFLOAT4& v2)
+	{
+		uint32_t code0 = OutCode(v0), code1 = OutCode(v1), code2 = OutCode(v2);
+
+		// Entirely outside one plane.
+		if (code0 & code1 & code2)
+			return;
+
+		// Only the near plane needs real clipping, the others are handled by the screen bounds.
+		if (((code0 | code1 | code2) & 16u) == 0)
+		{
+			AddScreenTriangle(v0, v1, v2);
+			return;
+		}
+
+		const DirectX::XMFLOAT4* in[3] = { &v0, &v1, &v2 };
+		DirectX::XMFLOAT4 out[4];
+		int outCount = 0;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const DirectX::XMFLOAT4& a = *in[i];
+			const DirectX::XMFLOAT4& b = *in[(i + 1) % 3];
+
+			if (a.z >= 0.0f)
+				out[outCount++] = a;
+
+			if ((a.z >= 0.0f) != (b.z >= 0.0f))
+				out[outCount++] = LerpClip(a, b, a.z / (a.z - b.z));
+		}
+
+		for (int i = 1; i + 1 < outCount; ++i)
+			AddScreenTriangle(out[0], out[i], out[i + 1]);
+	}
+
+	void OcclusionCuller::AddScreenTriangle(const DirectX::XMFLOAT4& v0, const DirectX::XMFLOAT4& v1, const DirectX::XMFLOAT4& v2)
+	{
+		ScreenTriangle tri;
+		const DirectX::XMFLOAT4* v[3] = { &v0, &v1, &v2 };
+		for (int i = 0; i < 3; ++i)
+		{
+			float invW = 1.0f / v[i]->w;
+			tri.X[i] = (v[i]->x * invW * 0.5f + 0.5f) * Width;
+			tri.Y[i] = (0.5f - v[i]->y * invW * 0.5f) * Height;
+			tri.Z[i] = v[i]->z * invW;
+		}
+
+		// Both windings are occluders; store them all counter-clockwise in screen space.
+		float area = (tri.X[1] - tri.X[0]) * (tri.Y[2] - tri.Y[0]) - (tri.X[2] - tri.X[0]) * (tri.Y[1] - tri.Y[0]);
+		if (fabsf(area) < 1e-6f)
+			return;
+
+		if (area < 0.0f)
+		{
+			std::swap(tri.X[1], tri.X[2]);
+			std::swap(tri.Y[1], tri.Y[2]);
+			std::swap(tri.Z[1], tri.Z[2]);
+		}
+
+		float minX = std::min({ tri.X[0], tri.X[1], tri.X[2] });
+		float maxX = std::max({ tri.X[0], tri.X[1], tri.X[2] });
+		float minY = std::min({ tri.Y[0], tri.Y[1], tri.Y[2] });
+		float maxY = std::max({ tri.Y[0], tri.Y[1], tri.Y[2] });
+
+		int x0 = std::max(0, (int)floorf(minX));
+		int x1 = std::min(Width - 1, (int)ceilf(maxX));
+		int y0 = std::max(0, (int)floorf(minY));
+		int y1 = std::min(Height - 1, (int)ceilf(maxY));
+		if (x0 > x1 || y0 > y1)
+			return;
+
+		uint32_t index = (uint32_t)mTriangles.size();
+		mTriangles.push_back(tri);
+
+		for (int ty = y0 / TileHeight; ty <= y1 / TileHeight; ++ty)
+		{
+			for (int tx = x0 / TileWidth; tx <= x1 / TileWidth; ++tx)
+				mBins[ty * TilesX + tx].push_back(index);
+		}
+	}
+
+	void OcclusionCuller::Render()
+	{
+		mJobs.ParallelFor(TileCount, [this](unsigned tile) { RasterizeTile((int)tile); });
+
+		BuildDepthPyramid();
+	}
+
+	void OcclusionCuller::RasterizeTile(int tile)
+	{
+		const int tileX0 = (tile % TilesX) * TileWidth;
+		const int tileY0 = (tile / TilesX) * TileHeight;
+		float* depth = mDepth[0].data();
+
+		for (int y = tileY0; y < tileY0 + TileHeight; ++y)
+			std::fill(depth + y * Width + tileX0, depth + y * Width + tileX0 + TileWidth, 1.0f);
+
+		for (uint32_t index : mBins[tile])
+		{
+			const ScreenTriangle& tri = mTriangles[index];
+
+			// Edge functions E(p) = A * px + B * py + C, positive inside. Edge i is opposite vertex i.
+			Edge edge0 = MakeEdge(tri.X[1], tri.Y[1], tri.X[2], tri.Y[2]);
+			Edge edge1 = MakeEdge(tri.X[2], tri.Y[2], tri.X[0], tri.Y[0]);
+			Edge edge2 = MakeEdge(tri.X[0], tri.Y[0], tri.X[1], tri.Y[1]);
+			float a0 = edge0.A, b0 = edge0.B, c0 = edge0.C;
+			float a1 = edge1.A, b1 = edge1.B, c1 = edge1.C;
+			float a2 = edge2.A, b2 = edge2.B, c2 = edge2.C;
+
+			// Depth is linear in screen space: z = z0 + (z1 - z0) * E1 / area + (z2 - z0) * E2 / area.
+			float invArea = 1.0f / (c0 + c1 + c2);
+			float dz1 = (tri.Z[1] - tri.Z[0]) * invArea;
+			float dz2 = (tri.Z[2] - tri.Z[0]) * invArea;
+			float za = a1 * dz1 + a2 * dz2;
+			float zb = b1 * dz1 + b2 * dz2;
+			float zc = tri.Z[0] + c1 * dz1 + c2 * dz2;
+
+			int x0 = std::max(tileX0, (int)floorf(std::min({ tri.X[0], tri.X[1], tri.X[2] })));
+			int x1 = std::min(tileX0 + TileWidth - 1, (int)ceilf(std::max({ tri.X[0], tri.X[1], tri.X[2] })));
+			int y0 = std::max(tileY0, (int)floorf(std::min({ tri.Y[0], tri.Y[1], tri.Y[2] })));
+			int y1 = std::min(tileY0 + TileHeight - 1, (int)ceilf(std::max({ tri.Y[0], tri.Y[1], tri.Y[2] })));
+			if (x0 > x1 || y0 > y1)
+				continue;
+
+#if defined(DX12LIB_OCCLUSION_SSE)
+			// Four pixels per step. Tiles are a multiple of four wide, so aligned spans stay inside.
+			x0 &= ~3;
+
+			const __m128 laneOffset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 stepX = _mm_set1_ps(4.0f);
+			const __m128 A0 = _mm_set1_ps(a0), A1 = _mm_set1_ps(a1), A2 = _mm_set1_ps(a2);
+			const __m128 ZA = _mm_set1_ps(za);
+			// All ones for edges that do not own the pixel centers exactly on them.
+			const __m128 exclusive0 = _mm_castsi128_ps(_mm_set1_epi32(edge0.TopLeft ? 0 : -1));
+			const __m128 exclusive1 = _mm_castsi128_ps(_mm_set1_epi32(edge1.TopLeft ? 0 : -1));
+			const __m128 exclusive2 = _mm_castsi128_ps(_mm_set1_epi32(edge2.TopLeft ? 0 : -1));
+
+			for (int y = y0; y <= y1; ++y)
+			{
+				float py = y + 0.5f;
+				__m128 px = _mm_add_ps(_mm_set1_ps((float)x0), laneOffset);
+
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(A0, px), _mm_set1_ps(b0 * py + c0));
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(A1, px), _mm_set1_ps(b1 * py + c1));
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(A2, px), _mm_set1_ps(b2 * py + c2));
+				__m128 z = _mm_add_ps(_mm_mul_ps(ZA, px), _mm_set1_ps(zb * py + zc));
+
+				const __m128 stepE0 = _mm_mul_ps(A0, stepX), stepE1 = _mm_mul_ps(A1, stepX), stepE2 = _mm_mul_ps(A2, stepX);
+				const __m128 stepZ = _mm_mul_ps(ZA, stepX);
+
+				float* row = depth + y * Width;
+				for (int x = x0; x <= x1; x += 4)
+				{
+					// E >= 0, except that E == 0 is outside of an exclusive edge.
+					__m128 on = _mm_or_ps(_mm_and_ps(exclusive0, _mm_cmpeq_ps(e0, zero)),
+						_mm_or_ps(_mm_and_ps(exclusive1, _mm_cmpeq_ps(e1, zero)), _mm_and_ps(exclusive2, _mm_cmpeq_ps(e2, zero))));
+					__m128 inside = _mm_andnot_ps(on, _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero))));
+					if (_mm_movemask_ps(inside))
+					{
+						__m128 old = _mm_loadu_ps(row + x);
+						__m128 nearer = _mm_min_ps(old, z);
+						_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+					}
+
+					e0 = _mm_add_ps(e0, stepE0);
+					e1 = _mm_add_ps(e1, stepE1);
+					e2 = _mm_add_ps(e2, stepE2);
+					z = _mm_add_ps(z, stepZ);
+				}
+			}
+#else
+			for (int y = y0; y <= y1; ++y)
+			{
+				float py = y + 0.5f;
+				float* row = depth + y * Width;
+				for (int x = x0; x <= x1; ++x)
+				{
+					float px = x + 0.5f;
+					float e0 = a0 * px + b0 * py + c0;
+					float e1 = a1 * px + b1 * py + c1;
+					float e2 = a2 * px + b2 * py + c2;
+					if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f)
+						continue;
+					if ((e0 == 0.0f && !edge0.TopLeft) || (e1 == 0.0f && !edge1.TopLeft) || (e2 == 0.0f && !edge2.TopLeft))
+						continue;
+
+					row[x] = std::min(row[x], za * px + zb * py + zc);
+				}
+			}
+#endif
+		}
+	}
+
+	void OcclusionCuller::BuildDepthPyramid()
+	{
+		for (size_t level = 1; level < mDepth.size(); ++level)
+		{
+			const std::vector<float>& src = mDepth[level - 1];
+			std::vector<float>& dst = mDepth[level];
+			int srcWidth = mLevelWidth[level - 1], srcHeight = mLevelHeight[level - 1];
+			int width = mLevelWidth[level], height = mLevelHeight[level];
+
+			for (int y = 0; y < height; ++y)
+			{
+				int sy0 = 2 * y, sy1 = std::min(2 * y + 1, srcHeight - 1);
+				for (int x = 0; x < width; ++x)
+				{
+					int sx0 = 2 * x, sx1 = std::min(2 * x + 1, srcWidth - 1);
+					dst[y * width + x] = std::max(
+						std::max(src[sy0 * srcWidth + sx0], src[sy0 * srcWidth + sx1]),
+						std::max(src[sy1 * srcWidth + sx0], src[sy1 * srcWidth + sx1]));
+				}
+			}
+		}
+	}
+
+	bool OcclusionCuller::IsVisible(const DirectX::BoundingBox& worldBound) const
+	{
+		DirectX::XMFLOAT3 corners[DirectX::BoundingBox::CORNER_COUNT];
+		worldBound.GetCorners(corners);
+		DirectX::XMMATRIX viewProj = DirectX::XMLoadFloat4x4(&mViewProj);
+
+		float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+		float maxX = -FLT_MAX, maxY = -FLT_MAX;
+		for (auto& corner : corners)
+		{
+			DirectX::XMFLOAT4 clip;
+			DirectX::XMStoreFloat4(&clip, DirectX::XMVector4Transform(DirectX::XMVectorSet(corner.x, corner.y, corner.z, 1.0f), viewProj));
+
+			// Crosses the near plane, can't be bounded on screen.
+			if (clip.z < 0.0f || clip.w <= 0.0f)
+				return true;
+
+			float invW = 1.0f / clip.w;
+			float x = (clip.x * invW * 0.5f + 0.5f) * Width;
+			float y = (0.5f - clip.y * invW * 0.5f) * Height;
+
+			minX = std::min(minX, x); maxX = std::max(maxX, x);
+			minY = std::min(minY, y); maxY = std::max(maxY, y);
+			minZ = std::min(minZ, clip.z * invW);
+		}
+
+		// Off screen boxes are left to frustum culling.
+		if (maxX < 0.0f || maxY < 0.0f || minX >= (float)Width || minY >= (float)Height)
+			return true;
+
+		int x0 = std::max(0, (int)floorf(minX));
+		int x1 = std::min(Width - 1, (int)floorf(maxX));
+		int y0 = std::max(0, (int)floorf(minY));
+		int y1 = std::min(Height - 1, (int)floorf(maxY));
+
+		// Coarsest level where the rectangle spans at most 4x4 texels.
+		size_t level = 0;
+		while (level + 1 < mDepth.size() && ((x1 >> level) - (x0 >> level) >= 4 || (y1 >> level) - (y0 >> level) >= 4))
+			++level;
+
+		const std::vector<float>& depth = mDepth[level];
+		int width = mLevelWidth[level];
+		for (int y = y0 >> level; y <= (y1 >> level); ++y)
+		{
+			for (int x = x0 >> level; x <= (x1 >> level); ++x)
+			{
+				if (minZ <= depth[y * width + x])
+					return true;
+			}
+		}
+
+		return false;
+	}
+}
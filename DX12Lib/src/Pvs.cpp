@@ -0,0 +1,280 @@
+#include "DX12Lib/Pvs.h"
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <unordered_map>
+
+namespace DX12Lib
+{
+	namespace
+	{
+		template<typename T>
+		inline void Write(std::ofstream& fout, const T* values, size_t count)
+		{
+			fout.write(reinterpret_cast<const char*>(values), count * sizeof(T));
+		}
+
+		template<typename T>
+		inline bool Read(std::ifstream& fin, T* values, size_t count)
+		{
+			fin.read(reinterpret_cast<char*>(values), count * sizeof(T));
+			return (size_t)fin.gcount() == count * sizeof(T);
+		}
+
+		// FNV-1a, continuing from hash.
+		inline uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; ++i)
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			return hash;
+		}
+	}
+
+	uint64_t PvsTarget::MakeKey(uint64_t nameHash, uint64_t meshHash, const DirectX::BoundingBox& bound)
+	{
+		float box[] = { bound.Center.x, bound.Center.y, bound.Center.z, bound.Extents.x, bound.Extents.y, bound.Extents.z };
+
+		uint64_t key = HashBytes(nameHash, &meshHash, sizeof(meshHash));
+		return HashBytes(key, box, sizeof(box));
+	}
+
+	bool PvsData::Save(const std::string& filename) const
+	{
+		std::ofstream fout(filename, std::ios::binary);
+		if (!fout)
+			return false;
+
+		uint32_t header[] = { Magic, Version };
+		float grid[] = { mOrigin.x, mOrigin.y, mOrigin.z, mCellSize };
+		uint32_t counts[] = { mDims[0], mDims[1], mDims[2], GetTargetCount(), (uint32_t)mData.size() };
+
+		Write(fout, header, std::size(header));
+		Write(fout, grid, std::size(grid));
+		Write(fout, counts, std::size(counts));
+		Write(fout, mTargetKeys.data(), mTargetKeys.size());
+		Write(fout, mCellOffsets.data(), mCellOffsets.size());
+		Write(fout, mData.data(), mData.size());
+
+		return (bool)fout;
+	}
+
+	bool PvsData::Load(const std::string& filename)
+	{
+		Clear();
+
+		std::ifstream fin(filename, std::ios::binary);
+		if (!fin)
+			return false;
+
+		uint32_t header[2];
+		float grid[4];
+		uint32_t counts[5];
+		if (!Read(fin, header, 2) || header[0] != Magic || header[1] != Version)
+			return false;
+		if (!Read(fin, grid, 4) || !Read(fin, counts, 5) || !(grid[3] > 0.0f))
+			return false;
+
+		mOrigin = DirectX::XMFLOAT3(grid[0], grid[1], grid[2]);
+		mCellSize = grid[3];
+		mDims[0] = counts[0];
+		mDims[1] = counts[1];
+		mDims[2] = counts[2];
+
+		mTargetKeys.resize(counts[3]);
+		mCellOffsets.resize((size_t)GetCellCount() + 1);
+		mData.resize(counts[4]);
+
+		bool ok = Read(fin, mTargetKeys.data(), mTargetKeys.size())
+			&& Read(fin, mCellOffsets.data(), mCellOffsets.size())
+			&& Read(fin, mData.data(), mData.size());
+
+		// Offsets have to be ordered and inside the data, cells are decoded without checks.
+		for (size_t i = 0; ok && i + 1 < mCellOffsets.size(); ++i)
+			ok = mCellOffsets[i] <= mCellOffsets[i + 1];
+		ok = ok && mCellOffsets.front() == 0 && mCellOffsets.back() == mData.size();
+
+		if (!ok)
+			Clear();
+		return ok;
+	}
+
+	void PvsData::Clear()
+	{
+		mDims[0] = mDims[1] = mDims[2] = 0;
+		mTargetKeys.clear();
+		mCellOffsets.clear();
+		mData.clear();
+	}
+
+	void PvsData::SetGrid(const PvsBakeSettings& settings)
+	{
+		const DirectX::XMFLOAT3& center = settings.Region.Center;
+		const DirectX::XMFLOAT3& extents = settings.Region.Extents;
+		mOrigin = DirectX::XMFLOAT3(center.x - extents.x, center.y - extents.y, center.z - extents.z);
+		mCellSize = settings.CellSize;
+		mDims[0] = (uint32_t)std::ceil(2.0f * extents.x / settings.CellSize);
+		mDims[1] = (uint32_t)std::ceil(2.0f * extents.y / settings.CellSize);
+		mDims[2] = (uint32_t)std::ceil(2.0f * extents.z / settings.CellSize);
+		for (auto& dim : mDims)
+			dim = dim > 0 ? dim : 1;
+	}
+
+	bool PvsData::MatchesGrid(const PvsBakeSettings& settings) const
+	{
+		// Computed the same way as in the bake, so the comparison can be exact.
+		PvsData expected;
+		expected.SetGrid(settings);
+
+		return mOrigin.x == expected.mOrigin.x && mOrigin.y == expected.mOrigin.y && mOrigin.z == expected.mOrigin.z
+			&& mCellSize == expected.mCellSize
+			&& mDims[0] == expected.mDims[0] && mDims[1] == expected.mDims[1] && mDims[2] == expected.mDims[2];
+	}
+
+	int PvsData::FindCell(const DirectX::XMFLOAT3& position) const
+	{
+		float x = std::floor((position.x - mOrigin.x) / mCellSize);
+		float y = std::floor((position.y - mOrigin.y) / mCellSize);
+		float z = std::floor((position.z - mOrigin.z) / mCellSize);
+
+		if (x < 0.0f || y < 0.0f || z < 0.0f || x >= mDims[0] || y >= mDims[1] || z >= mDims[2])
+			return -1;
+
+		return (int)(((uint32_t)z * mDims[1] + (uint32_t)y) * mDims[0] + (uint32_t)x);
+	}
+
+	void PvsData::DecompressCell(uint32_t cell, std::vector<uint8_t>& bits) const
+	{
+		size_t byteCount = (mTargetKeys.size() + 7) / 8;
+		bits.assign(byteCount, 0);
+
+		size_t out = 0;
+		for (uint32_t i = mCellOffsets[cell]; i < mCellOffsets[cell + 1] && out < byteCount; ++i)
+		{
+			if (mData[i] != 0)
+			{
+				bits[out++] = mData[i];
+				continue;
+			}
+
+			// Zeros are already there.
+			if (++i < mCellOffsets[cell + 1])
+				out += mData[i];
+		}
+	}
+
+	void PvsData::Compress(const uint8_t* bits, size_t byteCount, std::vector<uint8_t>& data)
+	{
+		for (size_t i = 0; i < byteCount;)
+		{
+			if (bits[i] != 0)
+			{
+				data.push_back(bits[i++]);
+				continue;
+			}
+
+			uint8_t run = 0;
+			while (i < byteCount && bits[i] == 0 && run < 255)
+			{
+				++run;
+				++i;
+			}
+			data.push_back(0);
+			data.push_back(run);
+		}
+	}
+
+	PvsData PvsBaker::Bake(const std::vector<PvsTarget>& targets, const PvsBakeSettings& settings, const TraceRays& trace, JobSystem& jobs)
+	{
+		PvsData pvs;
+		pvs.SetGrid(settings);
+
+		std::unordered_map<void*, uint32_t> targetIndices;
+		for (uint32_t t = 0; t < targets.size(); ++t)
+		{
+			pvs.mTargetKeys.push_back(targets[t].Key);
+			targetIndices.emplace(targets[t].UserData, t);
+		}
+
+		uint32_t cellCount = pvs.GetCellCount();
+		size_t byteCount = (targets.size() + 7) / 8;
+		std::vector<std::vector<uint8_t>> cellData(cellCount);
+
+		// One part per cell, the job system balances them over its threads.
+		jobs.ParallelFor(cellCount, [&](unsigned cell)
+		{
+			std::vector<uint8_t> bits(byteCount, 0);
+			std::vector<RayDesc> rays;
+			std::vector<RayHit> hits;
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+			// Seeded per cell, the result does not depend on the thread count.
+			std::mt19937 rng(settings.Seed * 0x9E3779B9u + cell);
+
+			uint32_t x = cell % pvs.mDims[0];
+			uint32_t y = (cell / pvs.mDims[0]) % pvs.mDims[1];
+			uint32_t z = cell / (pvs.mDims[0] * pvs.mDims[1]);
+
+			for (uint32_t s = 0; s < settings.SamplesPerCell; ++s)
+			{
+				RayDesc ray;
+				ray.Origin.x = pvs.mOrigin.x + (x + unit(rng)) * pvs.mCellSize;
+				ray.Origin.y = pvs.mOrigin.y + (y + unit(rng)) * pvs.mCellSize;
+				ray.Origin.z = pvs.mOrigin.z + (z + unit(rng)) * pvs.mCellSize;
+				DirectX::XMVECTOR origin = DirectX::XMLoadFloat3(&ray.Origin);
+
+				rays.clear();
+				for (uint32_t t = 0; t < targets.size(); ++t)
+				{
+					if (bits[t >> 3] & (1u << (t & 7)))
+						continue;
+
+					const DirectX::BoundingBox& bound = targets[t].Bound;
+					if (bound.Contains(origin) != DirectX::DISJOINT)
+					{
+						bits[t >> 3] |= 1u << (t & 7);
+						continue;
+					}
+
+					// The first ray aims at the center, the rest at random points of the bound.
+					for (uint32_t r = 0; r < settings.RaysPerTarget; ++r)
+					{
+						float u = r == 0 ? 0.5f : unit(rng);
+						float v = r == 0 ? 0.5f : unit(rng);
+						float w = r == 0 ? 0.5f : unit(rng);
+						ray.Direction.x = bound.Center.x + (2.0f * u - 1.0f) * bound.Extents.x - ray.Origin.x;
+						ray.Direction.y = bound.Center.y + (2.0f * v - 1.0f) * bound.Extents.y - ray.Origin.y;
+						ray.Direction.z = bound.Center.z + (2.0f * w - 1.0f) * bound.Extents.z - ray.Origin.z;
+						rays.push_back(ray);
+					}
+				}
+
+				if (rays.empty())
+					continue;
+
+				hits.resize(rays.size());
+				trace(rays.data(), rays.size(), hits.data());
+
+				// Whatever a ray hits first is visible, not only the target it aimed at.
+				for (const RayHit& hit : hits)
+				{
+					auto it = targetIndices.find(hit.UserData);
+					if (hit.IsHit() && it != targetIndices.end())
+						bits[it->second >> 3] |= 1u << (it->second & 7);
+				}
+			}
+
+			PvsData::Compress(bits.data(), bits.size(), cellData[cell]);
+		});
+
+		pvs.mCellOffsets.push_back(0);
+		for (const auto& data : cellData)
+		{
+			pvs.mData.insert(pvs.mData.end(), data.begin(), data.end());
+			pvs.mCellOffsets.push_back((uint32_t)pvs.mData.size());
+		}
+
+		return pvs;
+	}
+}
@@ -0,0 +1,124 @@
+#include "DX12Lib/RayQuery.h"
+#include <algorithm>
+
+namespace DX12Lib
+{
+	RayQuery::RayQuery(const SceneBVH& scene, ResolveTarget resolve) :
+		mScene(scene),
+		mResolve(std::move(resolve))
+	{
+	}
+
+	void RayQuery::Trace(const RayDesc* rays, size_t count, RayHit* hits) const
+	{
+		struct Candidate
+		{
+			void* UserData;
+			float Enter;
+			uint32_t Lanes;
+		};
+
+		std::vector<int> stack;
+		std::vector<Candidate> candidates;
+
+		for (size_t first = 0; first < count; first += RayPacket::Size)
+		{
+			const size_t laneCount = std::min<size_t>(RayPacket::Size, count - first);
+
+			// Broad phase per ray; the packet then visits every proxy any of its rays reach.
+			candidates.clear();
+			for (size_t lane = 0; lane < laneCount; ++lane)
+			{
+				const RayDesc& ray = rays[first + lane];
+				hits[first + lane] = RayHit();
+
+				DirectX::XMVECTOR origin = DirectX::XMLoadFloat3(&ray.Origin);
+				DirectX::XMVECTOR direction = DirectX::XMLoadFloat3(&ray.Direction);
+
+				mScene.QueryRay(origin, direction, ray.MaxDistance, stack, [&](void* userData, float enter)
+				{
+					for (auto& candidate : candidates)
+					{
+						if (candidate.UserData == userData)
+						{
+							candidate.Enter = std::min(candidate.Enter, enter);
+							candidate.Lanes |= 1u << lane;
+							return;
+						}
+					}
+
+					candidates.push_back({ userData, enter, 1u << lane });
+				});
+			}
+
+			// Nearest proxies first so the closest hits prune the rest early.
+			std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.Enter < b.Enter; });
+
+			for (auto& candidate : candidates)
+			{
+				RayTarget target;
+				if (!mResolve(candidate.UserData, target) || target.Mesh == nullptr)
+					continue;
+
+				DirectX::XMMATRIX toLocal = DirectX::XMLoadFloat4x4(&target.WorldToLocal);
+
+				RayPacket packet;
+				for (size_t lane = 0; lane < RayPacket::Size; ++lane)
+				{
+					packet.OriginX[lane] = packet.OriginY[lane] = packet.OriginZ[lane] = 0.0f;
+					packet.DirectionX[lane] = packet.DirectionY[lane] = packet.DirectionZ[lane] = 1.0f;
+					packet.MaxDistance[lane] = -1.0f;
+					packet.TriangleIndex[lane] = TriangleBVH::InvalidTriangle;
+
+					if ((candidate.Lanes & (1u << lane)) == 0)
+						continue;
+
+					const RayDesc& ray = rays[first + lane];
+					if ((ray.LayerMask & target.Layers) == 0)
+						continue;
+
+					RayHit& hit = hits[first + lane];
+					if (candidate.Enter > hit.Distance)
+						continue;
+
+					// Unnormalized local direction keeps distances in world units.
+					DirectX::XMFLOAT3 origin, direction;
+					DirectX::XMStoreFloat3(&origin, DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&ray.Origin), toLocal));
+					DirectX::XMStoreFloat3(&direction, DirectX::XMVector3TransformNormal(DirectX::XMLoadFloat3(&ray.Direction), toLocal));
+
+					packet.OriginX[lane] = origin.x;
+					packet.OriginY[lane] = origin.y;
+					packet.OriginZ[lane] = origin.z;
+					packet.DirectionX[lane] = direction.x;
+					packet.DirectionY[lane] = direction.y;
+					packet.DirectionZ[lane] = direction.z;
+					packet.MaxDistance[lane] = std::min(ray.MaxDistance, hit.Distance);
+					packet.Active |= 1u << lane;
+				}
+
+				target.Mesh->IntersectPacket(packet);
+
+				for (size_t lane = 0; lane < RayPacket::Size; ++lane)
+				{
+					if ((packet.Active & (1u << lane)) == 0 || packet.TriangleIndex[lane] == TriangleBVH::InvalidTriangle)
+						continue;
+
+					RayHit& hit = hits[first + lane];
+					hit.UserData = candidate.UserData;
+					hit.Distance = packet.MaxDistance[lane];
+					hit.TriangleIndex = packet.TriangleIndex[lane];
+				}
+			}
+		}
+	}
+
+	std::future<std::vector<RayHit>> RayQuery::TraceAsync(JobSystem& jobs, std::vector<RayDesc> rays) const
+	{
+		return jobs.Async([this, rays = std::move(rays)]()
+		{
+			std::vector<RayHit> hits(rays.size());
+			Trace(rays.data(), rays.size(), hits.data());
+			return hits;
+		});
+	}
+}
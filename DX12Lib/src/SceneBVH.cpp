@@ -0,0 +1,411 @@
+#include "DX12Lib/SceneBVH.h"
+#include <cfloat>
+
+namespace DX12Lib
+{
+	namespace
+	{
+		inline float SurfaceArea(const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max)
+		{
+			float dx = max.x - min.x;
+			float dy = max.y - min.y;
+			float dz = max.z - min.z;
+			return 2.0f * (dx * dy + dy * dz + dz * dx);
+		}
+
+		inline void Merge(const DirectX::XMFLOAT3& aMin, const DirectX::XMFLOAT3& aMax, const DirectX::XMFLOAT3& bMin, const DirectX::XMFLOAT3& bMax, DirectX::XMFLOAT3& outMin, DirectX::XMFLOAT3& outMax)
+		{
+			outMin = DirectX::XMFLOAT3(std::min(aMin.x, bMin.x), std::min(aMin.y, bMin.y), std::min(aMin.z, bMin.z));
+			outMax = DirectX::XMFLOAT3(std::max(aMax.x, bMax.x), std::max(aMax.y, bMax.y), std::max(aMax.z, bMax.z));
+		}
+
+		inline bool Contains(const DirectX::XMFLOAT3& outerMin, const DirectX::XMFLOAT3& outerMax, const DirectX::XMFLOAT3& innerMin, const DirectX::XMFLOAT3& innerMax)
+		{
+			return outerMin.x <= innerMin.x && outerMin.y <= innerMin.y && outerMin.z <= innerMin.z
+				&& outerMax.x >= innerMax.x && outerMax.y >= innerMax.y && outerMax.z >= innerMax.z;
+		}
+
+		inline float Component(const DirectX::XMFLOAT3& v, int axis)
+		{
+			return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+		}
+	}
+
+	int SceneBVH::CreateProxy(const DirectX::BoundingBox& bound, void* userData)
+	{
+		int proxyId = AllocateNode();
+		Node& node = mNodes[proxyId];
+
+		node.Min = DirectX::XMFLOAT3(bound.Center.x - bound.Extents.x - FatMargin, bound.Center.y - bound.Extents.y - FatMargin, bound.Center.z - bound.Extents.z - FatMargin);
+		node.Max = DirectX::XMFLOAT3(bound.Center.x + bound.Extents.x + FatMargin, bound.Center.y + bound.Extents.y + FatMargin, bound.Center.z + bound.Extents.z + FatMargin);
+		node.UserData = userData;
+		node.Height = 0;
+
+		InsertLeaf(proxyId);
+		++mProxyCount;
+
+		return proxyId;
+	}
+
+	void SceneBVH::DestroyProxy(int proxyId)
+	{
+		RemoveLeaf(proxyId);
+		FreeNode(proxyId);
+		--mProxyCount;
+	}
+
+	bool SceneBVH::MoveProxy(int proxyId, const DirectX::BoundingBox& bound)
+	{
+		DirectX::XMFLOAT3 min(bound.Center.x - bound.Extents.x, bound.Center.y - bound.Extents.y, bound.Center.z - bound.Extents.z);
+		DirectX::XMFLOAT3 max(bound.Center.x + bound.Extents.x, bound.Center.y + bound.Extents.y, bound.Center.z + bound.Extents.z);
+
+		Node& node = mNodes[proxyId];
+		if (Contains(node.Min, node.Max, min, max))
+		{
+			// Still inside the fat bound; shrink it only if it became much too large.
+			DirectX::XMFLOAT3 largeMin(min.x - 4.0f * FatMargin, min.y - 4.0f * FatMargin, min.z - 4.0f * FatMargin);
+			DirectX::XMFLOAT3 largeMax(max.x + 4.0f * FatMargin, max.y + 4.0f * FatMargin, max.z + 4.0f * FatMargin);
+			if (Contains(largeMin, largeMax, node.Min, node.Max))
+				return false;
+		}
+
+		RemoveLeaf(proxyId);
+
+		node.Min = DirectX::XMFLOAT3(min.x - FatMargin, min.y - FatMargin, min.z - FatMargin);
+		node.Max = DirectX::XMFLOAT3(max.x + FatMargin, max.y + FatMargin, max.z + FatMargin);
+
+		InsertLeaf(proxyId);
+		return true;
+	}
+
+	void SceneBVH::Rebuild()
+	{
+		std::vector<int> leaves;
+		leaves.reserve(mProxyCount);
+
+		for (int i = 0; i < (int)mNodes.size(); ++i)
+		{
+			if (mNodes[i].Height < 0)
+				continue;
+
+			if (mNodes[i].IsLeaf())
+			{
+				mNodes[i].Parent = NullNode;
+				leaves.push_back(i);
+			}
+			else
+			{
+				FreeNode(i);
+			}
+		}
+
+		mRoot = leaves.empty() ? NullNode : BuildRange(leaves.data(), (int)leaves.size());
+		if (mRoot != NullNode)
+			mNodes[mRoot].Parent = NullNode;
+	}
+
+	void SceneBVH::Clear()
+	{
+		mNodes.clear();
+		mRoot = NullNode;
+		mFreeList = NullNode;
+		mProxyCount = 0;
+	}
+
+	DirectX::BoundingBox SceneBVH::GetFatBound(int proxyId) const
+	{
+		return ToBoundingBox(mNodes[proxyId]);
+	}
+
+	float SceneBVH::GetAreaRatio() const
+	{
+		if (mRoot == NullNode)
+			return 0.0f;
+
+		float rootArea = SurfaceArea(mNodes[mRoot].Min, mNodes[mRoot].Max);
+		float totalArea = 0.0f;
+		for (auto& node : mNodes)
+		{
+			if (node.Height > 0)
+				totalArea += SurfaceArea(node.Min, node.Max);
+		}
+
+		return rootArea > 0.0f ? totalArea / rootArea : 0.0f;
+	}
+
+	int SceneBVH::AllocateNode()
+	{
+		if (mFreeList == NullNode)
+		{
+			mNodes.emplace_back();
+			mFreeList = (int)mNodes.size() - 1;
+			mNodes[mFreeList].Parent = NullNode;
+		}
+
+		int node = mFreeList;
+		mFreeList = mNodes[node].Parent;
+
+		mNodes[node].Parent = NullNode;
+		mNodes[node].Child1 = NullNode;
+		mNodes[node].Child2 = NullNode;
+		mNodes[node].Height = 0;
+		mNodes[node].UserData = nullptr;
+
+		return node;
+	}
+
+	void SceneBVH::FreeNode(int node)
+	{
+		mNodes[node].Parent = mFreeList;
+		mNodes[node].Height = -1;
+		mFreeList = node;
+	}
+
+	void SceneBVH::InsertLeaf(int leaf)
+	{
+		if (mRoot == NullNode)
+		{
+			mRoot = leaf;
+			mNodes[mRoot].Parent = NullNode;
+			return;
+		}
+
+		// Find the best sibling by descending along the cheapest SAH cost.
+		const DirectX::XMFLOAT3 leafMin = mNodes[leaf].Min;
+		const DirectX::XMFLOAT3 leafMax = mNodes[leaf].Max;
+
+		int index = mRoot;
+		while (!mNodes[index].IsLeaf())
+		{
+			const Node& node = mNodes[index];
+
+			float area = SurfaceArea(node.Min, node.Max);
+
+			DirectX::XMFLOAT3 combinedMin, combinedMax;
+			Merge(node.Min, node.Max, leafMin, leafMax, combinedMin, combinedMax);
+			float combinedArea = SurfaceArea(combinedMin, combinedMax);
+
+			// Cost of creating a new parent for this node and the new leaf.
+			float cost = 2.0f * combinedArea;
+
+			// Minimum cost of pushing the leaf further down the tree.
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			auto childCost = [&](int child)
+			{
+				DirectX::XMFLOAT3 mergedMin, mergedMax;
+				Merge(mNodes[child].Min, mNodes[child].Max, leafMin, leafMax, mergedMin, mergedMax);
+
+				float mergedArea = SurfaceArea(mergedMin, mergedMax);
+				if (mNodes[child].IsLeaf())
+					return mergedArea + inheritanceCost;
+
+				return mergedArea - SurfaceArea(mNodes[child].Min, mNodes[child].Max) + inheritanceCost;
+			};
+
+			float cost1 = childCost(node.Child1);
+			float cost2 = childCost(node.Child2);
+
+			if (cost < cost1 && cost < cost2)
+				break;
+
+			index = cost1 < cost2 ? node.Child1 : node.Child2;
+		}
+
+		int sibling = index;
+
+		// Create a new parent.
+		int oldParent = mNodes[sibling].Parent;
+		int newParent = AllocateNode();
+
+		Node& parent = mNodes[newParent];
+		parent.Parent = oldParent;
+		Merge(leafMin, leafMax, mNodes[sibling].Min, mNodes[sibling].Max, parent.Min, parent.Max);
+		parent.Height = mNodes[sibling].Height + 1;
+		parent.Child1 = sibling;
+		parent.Child2 = leaf;
+
+		if (oldParent != NullNode)
+		{
+			if (mNodes[oldParent].Child1 == sibling)
+				mNodes[oldParent].Child1 = newParent;
+			else
+				mNodes[oldParent].Child2 = newParent;
+		}
+		else
+		{
+			mRoot = newParent;
+		}
+
+		mNodes[sibling].Parent = newParent;
+		mNodes[leaf].Parent = newParent;
+
+		RefitAncestors(mNodes[leaf].Parent);
+	}
+
+	void SceneBVH::RemoveLeaf(int leaf)
+	{
+		if (leaf == mRoot)
+		{
+			mRoot = NullNode;
+			return;
+		}
+
+		int parent = mNodes[leaf].Parent;
+		int grandParent = mNodes[parent].Parent;
+		int sibling = mNodes[parent].Child1 == leaf ? mNodes[parent].Child2 : mNodes[parent].Child1;
+
+		if (grandParent != NullNode)
+		{
+			// Destroy parent and connect sibling to grandParent.
+			if (mNodes[grandParent].Child1 == parent)
+				mNodes[grandParent].Child1 = sibling;
+			else
+				mNodes[grandParent].Child2 = sibling;
+
+			mNodes[sibling].Parent = grandParent;
+			FreeNode(parent);
+
+			RefitAncestors(grandParent);
+		}
+		else
+		{
+			mRoot = sibling;
+			mNodes[sibling].Parent = NullNode;
+			FreeNode(parent);
+		}
+
+		mNodes[leaf].Parent = NullNode;
+	}
+
+	void SceneBVH::RefitAncestors(int index)
+	{
+		while (index != NullNode)
+		{
+			Node& node = mNodes[index];
+			const Node& child1 = mNodes[node.Child1];
+			const Node& child2 = mNodes[node.Child2];
+
+			Merge(child1.Min, child1.Max, child2.Min, child2.Max, node.Min, node.Max);
+			node.Height = 1 + std::max(child1.Height, child2.Height);
+
+			index = node.Parent;
+		}
+	}
+
+	int SceneBVH::BuildRange(int* leaves, int count)
+	{
+		if (count == 1)
+			return leaves[0];
+
+		// Bounds of the leaf centroids decide the split axis.
+		DirectX::XMFLOAT3 centroidMin(+FLT_MAX, +FLT_MAX, +FLT_MAX);
+		DirectX::XMFLOAT3 centroidMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (int i = 0; i < count; ++i)
+		{
+			const Node& node = mNodes[leaves[i]];
+			DirectX::XMFLOAT3 c((node.Min.x + node.Max.x) * 0.5f, (node.Min.y + node.Max.y) * 0.5f, (node.Min.z + node.Max.z) * 0.5f);
+			Merge(centroidMin, centroidMax, c, c, centroidMin, centroidMax);
+		}
+
+		DirectX::XMFLOAT3 extent(centroidMax.x - centroidMin.x, centroidMax.y - centroidMin.y, centroidMax.z - centroidMin.z);
+		int axis = 0;
+		if (extent.y > extent.x) axis = 1;
+		if (extent.z > Component(extent, axis)) axis = 2;
+
+		float axisMin = Component(centroidMin, axis);
+		float axisExtent = Component(extent, axis);
+
+		auto centroid = [&](int leaf)
+		{
+			return (Component(mNodes[leaf].Min, axis) + Component(mNodes[leaf].Max, axis)) * 0.5f;
+		};
+
+		int mid = count / 2;
+
+		if (axisExtent > 0.0f)
+		{
+			// Binned SAH: pick the bin boundary with the lowest cost.
+			const int binCount = 12;
+			struct Bin
+			{
+				DirectX::XMFLOAT3 Min = { +FLT_MAX, +FLT_MAX, +FLT_MAX };
+				DirectX::XMFLOAT3 Max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+				int Count = 0;
+			};
+			Bin bins[binCount];
+
+			auto binIndex = [&](int leaf)
+			{
+				int b = (int)((centroid(leaf) - axisMin) / axisExtent * binCount);
+				return std::min(b, binCount - 1);
+			};
+
+			for (int i = 0; i < count; ++i)
+			{
+				Bin& bin = bins[binIndex(leaves[i])];
+				Merge(bin.Min, bin.Max, mNodes[leaves[i]].Min, mNodes[leaves[i]].Max, bin.Min, bin.Max);
+				bin.Count++;
+			}
+
+			// Sweep from the right to get suffix areas.
+			float rightArea[binCount];
+			int rightCount[binCount];
+			Bin accum;
+			for (int b = binCount - 1; b > 0; --b)
+			{
+				Merge(accum.Min, accum.Max, bins[b].Min, bins[b].Max, accum.Min, accum.Max);
+				accum.Count += bins[b].Count;
+				rightArea[b] = accum.Count > 0 ? SurfaceArea(accum.Min, accum.Max) : 0.0f;
+				rightCount[b] = accum.Count;
+			}
+
+			float bestCost = FLT_MAX;
+			int bestSplit = -1;
+			accum = Bin();
+			for (int b = 0; b < binCount - 1; ++b)
+			{
+				Merge(accum.Min, accum.Max, bins[b].Min, bins[b].Max, accum.Min, accum.Max);
+				accum.Count += bins[b].Count;
+
+				if (accum.Count == 0 || rightCount[b + 1] == 0)
+					continue;
+
+				float cost = SurfaceArea(accum.Min, accum.Max) * accum.Count + rightArea[b + 1] * rightCount[b + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestSplit = b;
+				}
+			}
+
+			if (bestSplit >= 0)
+			{
+				int* split = std::partition(leaves, leaves + count, [&](int leaf) { return binIndex(leaf) <= bestSplit; });
+				mid = (int)(split - leaves);
+			}
+			else
+			{
+				std::nth_element(leaves, leaves + mid, leaves + count, [&](int a, int b) { return centroid(a) < centroid(b); });
+			}
+		}
+
+		if (mid == 0 || mid == count)
+			mid = count / 2;
+
+		int child1 = BuildRange(leaves, mid);
+		int child2 = BuildRange(leaves + mid, count - mid);
+
+		int index = AllocateNode();
+		Node& node = mNodes[index];
+		node.Child1 = child1;
+		node.Child2 = child2;
+		Merge(mNodes[child1].Min, mNodes[child1].Max, mNodes[child2].Min, mNodes[child2].Max, node.Min, node.Max);
+		node.Height = 1 + std::max(mNodes[child1].Height, mNodes[child2].Height);
+
+		mNodes[child1].Parent = index;
+		mNodes[child2].Parent = index;
+
+		return index;
+	}
+}
@@ -0,0 +1,180 @@
+#include "DX12Lib/SceneFormat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include "DX12Lib/StringTable.h"
+
+namespace DX12Lib
+{
+	bool FixupSceneCell(uint8_t* blob, size_t size, SceneCellView& view)
+	{
+		if (size < sizeof(SceneCellHeader))
+			return false;
+
+		const SceneCellHeader* header = reinterpret_cast<const SceneCellHeader*>(blob);
+		uint64_t recordsEnd = sizeof(SceneCellHeader) + (uint64_t)header->ActorCount * sizeof(SceneActorRecord);
+		if (header->Magic != SceneCellHeader::MagicValue || recordsEnd > size)
+			return false;
+
+		// Offset first, so that size - NamesOffset cannot wrap around.
+		if (header->NamesOffset < recordsEnd || header->NamesOffset > size || header->NamesSize > size - header->NamesOffset)
+			return false;
+
+		SceneActorRecord* records = reinterpret_cast<SceneActorRecord*>(blob + sizeof(SceneCellHeader));
+		uint64_t namesEnd = header->NamesOffset + header->NamesSize;
+
+		for (uint32_t i = 0; i < header->ActorCount; ++i)
+		{
+			uint64_t offset = records[i].NameOffset;
+			if (offset < header->NamesOffset || offset > namesEnd || (uint64_t)records[i].NameLength * sizeof(char16_t) > namesEnd - offset)
+				return false;
+
+			records[i].Name = reinterpret_cast<const char16_t*>(blob + offset);
+		}
+
+		view.Actors = records;
+		view.ActorCount = header->ActorCount;
+		return true;
+	}
+
+	std::wstring GetSceneActorName(const SceneActorRecord& record)
+	{
+		std::wstring name;
+		name.reserve(record.NameLength);
+
+		for (uint32_t i = 0; i < record.NameLength; ++i)
+		{
+			uint32_t unit = record.Name[i];
+			// A 32 bit wchar_t holds a surrogate pair as one code point.
+			if (sizeof(wchar_t) == 4 && unit >= 0xD800 && unit < 0xDC00 && i + 1 < record.NameLength
+				&& record.Name[i + 1] >= 0xDC00 && record.Name[i + 1] < 0xE000)
+			{
+				unit = 0x10000 + ((unit - 0xD800) << 10) + (record.Name[i + 1] - 0xDC00);
+				++i;
+			}
+			name.push_back((wchar_t)unit);
+		}
+
+		return name;
+	}
+
+	namespace
+	{
+		void AppendUtf16(std::vector<char16_t>& out, const std::wstring& name)
+		{
+			for (wchar_t c : name)
+			{
+				uint32_t codePoint = (uint32_t)c;
+				if (codePoint > 0xFFFF)
+				{
+					codePoint -= 0x10000;
+					out.push_back((char16_t)(0xD800 + (codePoint >> 10)));
+					out.push_back((char16_t)(0xDC00 + (codePoint & 0x3FF)));
+				}
+				else
+				{
+					out.push_back((char16_t)codePoint);
+				}
+			}
+		}
+	}
+
+	bool SceneWriter::Write(const std::string& filename, const std::vector<SceneActorDesc>& actors, float cellSize)
+	{
+		// Bucket by cell, ordered by cell coordinates so the output is deterministic.
+		std::vector<std::pair<uint64_t, uint32_t>> cells(actors.size());
+		for (uint32_t i = 0; i < actors.size(); ++i)
+		{
+			const DirectX::XMFLOAT3& center = actors[i].Bound.Center;
+			uint32_t x = (uint32_t)(int32_t)std::floor(center.x / cellSize);
+			uint32_t z = (uint32_t)(int32_t)std::floor(center.z / cellSize);
+			cells[i] = { ((uint64_t)x << 32) | z, i };
+		}
+		std::stable_sort(cells.begin(), cells.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+		std::vector<SceneCellEntry> entries;
+		std::vector<std::vector<uint8_t>> blobs;
+
+		for (size_t begin = 0; begin < cells.size();)
+		{
+			size_t end = begin + 1;
+			while (end < cells.size() && cells[end].first == cells[begin].first)
+				++end;
+
+			uint32_t actorCount = (uint32_t)(end - begin);
+
+			SceneCellHeader header = {};
+			header.Magic = SceneCellHeader::MagicValue;
+			header.ActorCount = actorCount;
+			header.NamesOffset = sizeof(SceneCellHeader) + (uint64_t)actorCount * sizeof(SceneActorRecord);
+
+			std::vector<SceneActorRecord> records(actorCount);
+			std::vector<char16_t> names;
+
+			SceneCellEntry entry = {};
+			entry.Bound = actors[cells[begin].second].Bound;
+			entry.ActorCount = actorCount;
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				const SceneActorDesc& actor = actors[cells[i].second];
+				SceneActorRecord& record = records[i - begin];
+
+				record = {};
+				record.World = actor.World;
+				record.TexTransform = actor.TexTransform;
+				record.MeshGroup = StringTable::Hash(actor.MeshGroup);
+				record.DrawArg = StringTable::Hash(actor.DrawArg);
+				record.Material = StringTable::Hash(actor.Material);
+				record.RenderLayer = actor.RenderLayer;
+				record.Flags = actor.Flags;
+				record.NameOffset = header.NamesOffset + names.size() * sizeof(char16_t);
+				size_t nameStart = names.size();
+				AppendUtf16(names, actor.Name);
+				record.NameLength = (uint32_t)(names.size() - nameStart);
+
+				DirectX::BoundingBox::CreateMerged(entry.Bound, entry.Bound, actor.Bound);
+			}
+
+			header.NamesSize = names.size() * sizeof(char16_t);
+
+			std::vector<uint8_t> blob(sizeof(SceneCellHeader) + records.size() * sizeof(SceneActorRecord) + header.NamesSize);
+			memcpy(blob.data(), &header, sizeof(header));
+			if (!records.empty())
+				memcpy(blob.data() + sizeof(header), records.data(), records.size() * sizeof(SceneActorRecord));
+			if (!names.empty())
+				memcpy(blob.data() + header.NamesOffset, names.data(), header.NamesSize);
+
+			entry.Size = (uint32_t)blob.size();
+			entries.push_back(entry);
+			blobs.push_back(std::move(blob));
+
+			begin = end;
+		}
+
+		SceneFileHeader fileHeader = {};
+		fileHeader.Magic = SceneFileHeader::MagicValue;
+		fileHeader.Version = SceneFileHeader::CurrentVersion;
+		fileHeader.CellSize = cellSize;
+		fileHeader.CellCount = (uint32_t)entries.size();
+
+		uint64_t offset = sizeof(SceneFileHeader) + entries.size() * sizeof(SceneCellEntry);
+		for (auto& entry : entries)
+		{
+			entry.Offset = offset;
+			offset += entry.Size;
+		}
+
+		std::ofstream fout(filename, std::ios::binary);
+		if (!fout)
+			return false;
+
+		fout.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+		fout.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(SceneCellEntry));
+		for (const auto& blob : blobs)
+			fout.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+
+		return (bool)fout;
+	}
+}
@@ -0,0 +1,130 @@
+#include "DX12Lib/SceneGenerator.h"
+#include <cmath>
+#include <random>
+#include "DX12Lib/ActorStore.h"
+
+namespace DX12Lib
+{
+	namespace
+	{
+		inline uint32_t GetLotsPerBlock(const SceneGeneratorSettings& settings)
+		{
+			return settings.LotsPerSide * settings.LotsPerSide;
+		}
+
+		inline uint32_t GetBlocksPerSide(const SceneGeneratorSettings& settings)
+		{
+			uint32_t lotsPerBlock = GetLotsPerBlock(settings);
+			uint32_t blockCount = (settings.ActorCount + lotsPerBlock - 1) / lotsPerBlock;
+			uint32_t blocksPerSide = (uint32_t)std::ceil(std::sqrt((double)blockCount));
+			return blocksPerSide > 0 ? blocksPerSide : 1;
+		}
+
+		inline float GetBlockPitch(const SceneGeneratorSettings& settings)
+		{
+			return settings.LotsPerSide * settings.LotSize + settings.StreetWidth;
+		}
+	}
+
+	float SceneGenerator::GetExtent(const SceneGeneratorSettings& settings)
+	{
+		if (settings.Distribution == Scene_Distribution_CityGrid)
+			return GetBlocksPerSide(settings) * GetBlockPitch(settings);
+
+		return std::sqrt((float)settings.ActorCount / settings.Density);
+	}
+
+	std::vector<SceneActorDesc> SceneGenerator::Generate(const SceneGeneratorSettings& settings)
+	{
+		std::vector<SceneActorDesc> actors;
+		if (settings.Shapes.empty() || settings.Materials.empty())
+			return actors;
+
+		actors.resize(settings.ActorCount);
+
+		std::mt19937 rng(settings.Seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		float extent = GetExtent(settings);
+		float half = 0.5f * extent;
+
+		std::vector<DirectX::XMFLOAT2> clusters;
+		std::normal_distribution<float> scatter(0.0f, settings.ClusterRadius);
+		if (settings.Distribution == Scene_Distribution_Clustered)
+		{
+			uint32_t clusterCount = settings.ClusterCount ? settings.ClusterCount : settings.ActorCount / 64 + 1;
+			for (uint32_t i = 0; i < clusterCount; ++i)
+				clusters.emplace_back(-half + unit(rng) * extent, -half + unit(rng) * extent);
+		}
+
+		uint32_t lotsPerBlock = GetLotsPerBlock(settings);
+		uint32_t blocksPerSide = GetBlocksPerSide(settings);
+		float blockPitch = GetBlockPitch(settings);
+
+		for (uint32_t i = 0; i < settings.ActorCount; ++i)
+		{
+			SceneActorDesc& actor = actors[i];
+			actor.Name = L"gen_" + std::to_wstring(i);
+			actor.MeshGroup = settings.MeshGroup;
+			actor.Material = settings.Materials[rng() % settings.Materials.size()];
+			actor.RenderLayer = settings.RenderLayer;
+			DirectX::XMStoreFloat4x4(&actor.TexTransform, DirectX::XMMatrixIdentity());
+
+			const SceneGeneratorShape* shape;
+			DirectX::XMMATRIX world;
+
+			if (settings.Distribution == Scene_Distribution_CityGrid)
+			{
+				shape = &settings.Shapes[0];
+
+				uint32_t block = i / lotsPerBlock;
+				uint32_t lot = i % lotsPerBlock;
+				float x = -half + (block % blocksPerSide) * blockPitch + 0.5f * settings.StreetWidth + ((lot % settings.LotsPerSide) + 0.5f) * settings.LotSize;
+				float z = -half + (block / blocksPerSide) * blockPitch + 0.5f * settings.StreetWidth + ((lot / settings.LotsPerSide) + 0.5f) * settings.LotSize;
+
+				// A little gap between neighbouring buildings.
+				const DirectX::XMFLOAT3& extents = shape->Bound.Extents;
+				float footprint = 0.8f * settings.LotSize;
+				float height = settings.MinBuildingHeight + unit(rng) * (settings.MaxBuildingHeight - settings.MinBuildingHeight);
+				float sx = 0.5f * footprint / extents.x;
+				float sy = 0.5f * height / extents.y;
+				float sz = 0.5f * footprint / extents.z;
+
+				world = DirectX::XMMatrixScaling(sx, sy, sz)
+					* DirectX::XMMatrixTranslation(x, -sy * (shape->Bound.Center.y - extents.y), z);
+				actor.Flags = Actor_Flag_Occluder;
+			}
+			else
+			{
+				shape = &settings.Shapes[rng() % settings.Shapes.size()];
+
+				float x, z;
+				if (settings.Distribution == Scene_Distribution_Clustered)
+				{
+					const DirectX::XMFLOAT2& center = clusters[rng() % clusters.size()];
+					x = center.x + scatter(rng);
+					z = center.y + scatter(rng);
+				}
+				else
+				{
+					x = -half + unit(rng) * extent;
+					z = -half + unit(rng) * extent;
+				}
+
+				float scale = settings.MinScale + unit(rng) * (settings.MaxScale - settings.MinScale);
+				float yaw = unit(rng) * DirectX::XM_2PI;
+
+				// Resting on the ground plane.
+				world = DirectX::XMMatrixScaling(scale, scale, scale) * DirectX::XMMatrixRotationY(yaw)
+					* DirectX::XMMatrixTranslation(x, -scale * (shape->Bound.Center.y - shape->Bound.Extents.y), z);
+				actor.Flags = Actor_Flag_None;
+			}
+
+			actor.DrawArg = shape->DrawArg;
+			DirectX::XMStoreFloat4x4(&actor.World, world);
+			shape->Bound.Transform(actor.Bound, world);
+		}
+
+		return actors;
+	}
+}
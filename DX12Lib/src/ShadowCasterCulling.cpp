@@ -0,0 +1,97 @@
+#include "DX12Lib/ShadowCasterCulling.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace DX12Lib
+{
+	ShadowCasterVolume BuildShadowCasterVolume(
+		const DirectX::BoundingFrustum& cameraFrustum,
+		DirectX::FXMVECTOR lightDir,
+		DirectX::CXMMATRIX lightView,
+		const DirectX::BoundingBox& lightBound)
+	{
+		ShadowCasterVolume volume;
+		DirectX::XMStoreFloat4x4(&volume.LightView, lightView);
+
+		// Moving along the light direction only increases the distance to a plane whose
+		// outward normal faces the same way, so a box outside such a plane stays outside
+		// however far it is swept. The other planes can't reject a swept box.
+		FrustumPlanes cameraPlanes = FrustumPlanes::FromFrustum(cameraFrustum);
+		DirectX::XMFLOAT3 l;
+		DirectX::XMStoreFloat3(&l, DirectX::XMVector3Normalize(lightDir));
+
+		for (int p = 0; p < FrustumPlanes::PlaneCount; ++p)
+		{
+			float facing = cameraPlanes.NormalX[p] * l.x + cameraPlanes.NormalY[p] * l.y + cameraPlanes.NormalZ[p] * l.z;
+			if (facing < 0.0f)
+				continue;
+
+			int i = volume.SweptPlaneCount++;
+			volume.SweptPlanes.NormalX[i] = cameraPlanes.NormalX[p];
+			volume.SweptPlanes.NormalY[i] = cameraPlanes.NormalY[p];
+			volume.SweptPlanes.NormalZ[i] = cameraPlanes.NormalZ[p];
+			volume.SweptPlanes.Distance[i] = cameraPlanes.Distance[p];
+		}
+
+		// Receiver region: the light space bound of the camera frustum clipped to the light volume.
+		DirectX::XMFLOAT3 corners[DirectX::BoundingFrustum::CORNER_COUNT];
+		cameraFrustum.GetCorners(corners);
+
+		DirectX::XMVECTOR vMin = DirectX::XMVectorReplicate(+FLT_MAX);
+		DirectX::XMVECTOR vMax = DirectX::XMVectorReplicate(-FLT_MAX);
+		for (auto& corner : corners)
+		{
+			DirectX::XMVECTOR P = DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&corner), lightView);
+			vMin = DirectX::XMVectorMin(vMin, P);
+			vMax = DirectX::XMVectorMax(vMax, P);
+		}
+
+		DirectX::XMFLOAT3 frustumMin, frustumMax;
+		DirectX::XMStoreFloat3(&frustumMin, vMin);
+		DirectX::XMStoreFloat3(&frustumMax, vMax);
+
+		const DirectX::XMFLOAT3& c = lightBound.Center;
+		const DirectX::XMFLOAT3& e = lightBound.Extents;
+
+		volume.ReceiverMin = DirectX::XMFLOAT3(std::max(frustumMin.x, c.x - e.x), std::max(frustumMin.y, c.y - e.y), std::max(frustumMin.z, c.z - e.z));
+		volume.ReceiverMax = DirectX::XMFLOAT3(std::min(frustumMax.x, c.x + e.x), std::min(frustumMax.y, c.y + e.y), std::min(frustumMax.z, c.z + e.z));
+		volume.LightNearZ = c.z - e.z;
+
+		volume.Empty = volume.ReceiverMin.x > volume.ReceiverMax.x
+			|| volume.ReceiverMin.y > volume.ReceiverMax.y
+			|| volume.ReceiverMin.z > volume.ReceiverMax.z;
+
+		return volume;
+	}
+
+	bool IsShadowCaster(const ShadowCasterVolume& volume, const DirectX::BoundingBox& worldBound)
+	{
+		if (volume.Empty)
+			return false;
+
+		for (int p = 0; p < volume.SweptPlaneCount; ++p)
+		{
+			const FrustumPlanes& planes = volume.SweptPlanes;
+			float dist = planes.NormalX[p] * worldBound.Center.x + planes.NormalY[p] * worldBound.Center.y + planes.NormalZ[p] * worldBound.Center.z + planes.Distance[p];
+			float radius = fabsf(planes.NormalX[p]) * worldBound.Extents.x + fabsf(planes.NormalY[p]) * worldBound.Extents.y + fabsf(planes.NormalZ[p]) * worldBound.Extents.z;
+			if (dist > radius)
+				return false;
+		}
+
+		DirectX::BoundingBox lightBound;
+		worldBound.Transform(lightBound, DirectX::XMLoadFloat4x4(&volume.LightView));
+
+		DirectX::XMFLOAT3 casterMin(lightBound.Center.x - lightBound.Extents.x, lightBound.Center.y - lightBound.Extents.y, lightBound.Center.z - lightBound.Extents.z);
+		DirectX::XMFLOAT3 casterMax(lightBound.Center.x + lightBound.Extents.x, lightBound.Center.y + lightBound.Extents.y, lightBound.Center.z + lightBound.Extents.z);
+
+		// The swept caster covers [casterMin.z, +inf) along the light direction.
+		if (casterMax.x < volume.ReceiverMin.x || casterMin.x > volume.ReceiverMax.x)
+			return false;
+
+		if (casterMax.y < volume.ReceiverMin.y || casterMin.y > volume.ReceiverMax.y)
+			return false;
+
+		// Must start in front of the deepest receiver and reach past the shadow map near plane.
+		return casterMin.z <= volume.ReceiverMax.z && casterMax.z >= volume.LightNearZ;
+	}
+}
@@ -80,7 +80,7 @@ namespace DX12Lib
 		RebuildDescriptors(depthStencilBuffer, hCpuSrv, hGpuSrv, hCpuRtv, cbvSrvUavDescriptorSize, rtvDescriptorSize);
 	}
 
-	void Ssao::ComputeSsao(ID3D12GraphicsCommandList* cmdList, FrameResource* currFrame, int blurCount)
+	void Ssao::ComputeSsao(ID3D12GraphicsCommandList* cmdList, D3D12_GPU_VIRTUAL_ADDRESS ssaoCBAddress, int blurCount)
 	{
 		cmdList->RSSetViewports(1, &mViewport);
 		cmdList->RSSetScissorRects(1, &mScissorRect);
@@ -98,7 +98,6 @@ namespace DX12Lib
 		cmdList->OMSetRenderTargets(1, &mhAmbientMap0CpuRtv, true, nullptr);
 
 		// Bind the constant buffer for this pass.
-		auto ssaoCBAddress = currFrame->SsaoCB->Resource()->GetGPUVirtualAddress();
 		cmdList->SetGraphicsRootConstantBufferView(0, ssaoCBAddress);
 		cmdList->SetGraphicsRoot32BitConstant(1, 0, 0);
 
@@ -120,7 +119,7 @@ namespace DX12Lib
 		CD3DX12_RESOURCE_BARRIER barrier1 = CD3DX12_RESOURCE_BARRIER::Transition(mAmbientMap0.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_GENERIC_READ);
 		cmdList->ResourceBarrier(1, &barrier1);
 
-		BlurAmbientMap(cmdList, currFrame, blurCount);
+		BlurAmbientMap(cmdList, ssaoCBAddress, blurCount);
 	}
 
 	void Ssao::InitDescriptorHeap()
@@ -365,11 +364,10 @@ namespace DX12Lib
 		mDevice->CreateRenderTargetView(mAmbientMap1.Get(), &rtvDesc, mhAmbientMap1CpuRtv);
 	}
 
-	void Ssao::BlurAmbientMap(ID3D12GraphicsCommandList* cmdList, FrameResource* currFrame, int blurCount)
+	void Ssao::BlurAmbientMap(ID3D12GraphicsCommandList* cmdList, D3D12_GPU_VIRTUAL_ADDRESS ssaoCBAddress, int blurCount)
 	{
 		cmdList->SetPipelineState(mBlurPso);
 
-		auto ssaoCBAddress = currFrame->SsaoCB->Resource()->GetGPUVirtualAddress();
 		cmdList->SetGraphicsRootConstantBufferView(0, ssaoCBAddress);
 
 		for (int i = 0; i < blurCount; ++i)
@@ -0,0 +1,51 @@
+#include "DX12Lib/StreamCopy.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DX12LIB_STREAM_STORES 1
+#endif
+
+namespace DX12Lib
+{
+	void StreamCopy(void* destination, const void* source, size_t byteSize)
+	{
+#ifdef DX12LIB_STREAM_STORES
+		uint8_t* dst = static_cast<uint8_t*>(destination);
+		const uint8_t* src = static_cast<const uint8_t*>(source);
+
+		// Plain stores up to the first 16 byte boundary of the destination.
+		size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+		if (head > byteSize)
+			head = byteSize;
+		memcpy(dst, src, head);
+		dst += head;
+		src += head;
+		byteSize -= head;
+
+		// Four stores fill a whole 64 byte write-combining buffer.
+		for (; byteSize >= 64; byteSize -= 64, dst += 64, src += 64)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+		}
+
+		for (; byteSize >= 16; byteSize -= 16, dst += 16, src += 16)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+
+		memcpy(dst, src, byteSize);
+
+		// Streaming stores are weakly ordered, they have to land before the GPU is signalled.
+		_mm_sfence();
+#else
+		memcpy(destination, source, byteSize);
+#endif
+	}
+}
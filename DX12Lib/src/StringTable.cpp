@@ -0,0 +1,42 @@
+#include "DX12Lib/StringTable.h"
+
+namespace DX12Lib
+{
+	uint32_t StringTable::Intern(const std::wstring& name)
+	{
+		auto it = mIds.find(name);
+		if (it != mIds.end())
+			return it->second;
+
+		uint32_t id = (uint32_t)mStrings.size();
+		mStrings.push_back(name);
+		mIds.emplace(name, id);
+		return id;
+	}
+
+	uint32_t StringTable::Find(const std::wstring& name) const
+	{
+		auto it = mIds.find(name);
+		if (it != mIds.end())
+			return it->second;
+		return InvalidId;
+	}
+
+	void StringTable::Clear()
+	{
+		mStrings.clear();
+		mIds.clear();
+	}
+
+	uint64_t StringTable::Hash(const std::wstring& name)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (wchar_t c : name)
+		{
+			uint16_t unit = (uint16_t)c;
+			hash = (hash ^ (unit & 0xFF)) * 1099511628211ull;
+			hash = (hash ^ (unit >> 8)) * 1099511628211ull;
+		}
+		return hash;
+	}
+}
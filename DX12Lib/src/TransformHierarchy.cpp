@@ -0,0 +1,145 @@
+#include "DX12Lib/TransformHierarchy.h"
+
+namespace DX12Lib
+{
+	uint32_t TransformHierarchy::CreateNode(uint32_t parent)
+	{
+		uint32_t node = (uint32_t)mParents.size();
+
+		DirectX::XMFLOAT4X4 identity;
+		DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+
+		mParents.push_back(parent);
+		mScales.push_back(DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f));
+		mRotations.push_back(DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+		mTranslations.push_back(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+		mWorlds.push_back(identity);
+		mDirty.push_back(1);
+
+		return node;
+	}
+
+	void TransformHierarchy::Clear()
+	{
+		mParents.clear();
+		mScales.clear();
+		mRotations.clear();
+		mTranslations.clear();
+		mWorlds.clear();
+		mDirty.clear();
+		mChanged.clear();
+	}
+
+	void TransformHierarchy::SetLocal(uint32_t node, const DirectX::XMFLOAT3& scale, const DirectX::XMFLOAT4& rotation, const DirectX::XMFLOAT3& translation)
+	{
+		mScales[node] = scale;
+		mRotations[node] = rotation;
+		mTranslations[node] = translation;
+		mDirty[node] = 1;
+	}
+
+	void TransformHierarchy::SetScale(uint32_t node, const DirectX::XMFLOAT3& scale)
+	{
+		mScales[node] = scale;
+		mDirty[node] = 1;
+	}
+
+	void TransformHierarchy::SetRotation(uint32_t node, const DirectX::XMFLOAT4& rotation)
+	{
+		mRotations[node] = rotation;
+		mDirty[node] = 1;
+	}
+
+	void TransformHierarchy::SetTranslation(uint32_t node, const DirectX::XMFLOAT3& translation)
+	{
+		mTranslations[node] = translation;
+		mDirty[node] = 1;
+	}
+
+	void TransformHierarchy::Update()
+	{
+		mChanged.clear();
+
+		const uint32_t* parents = mParents.data();
+		uint8_t* dirty = mDirty.data();
+		size_t count = mParents.size();
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			// The parent comes first, so its flag is already final.
+			uint32_t parent = parents[i];
+			if (parent != NullNode)
+				dirty[i] |= dirty[parent];
+
+			if (dirty[i] != 0)
+				mChanged.push_back(i);
+		}
+
+		// Locals don't depend on each other. The last batch repeats its last node.
+		size_t changedCount = mChanged.size();
+		for (size_t i = 0; i < changedCount; i += 4)
+		{
+			uint32_t nodes[4];
+			for (size_t lane = 0; lane < 4; ++lane)
+				nodes[lane] = mChanged[i + lane < changedCount ? i + lane : changedCount - 1];
+
+			ComposeLocals(nodes);
+		}
+
+		for (uint32_t node : mChanged)
+		{
+			uint32_t parent = parents[node];
+			if (parent != NullNode)
+			{
+				DirectX::XMMATRIX world = DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&mWorlds[node]), DirectX::XMLoadFloat4x4(&mWorlds[parent]));
+				DirectX::XMStoreFloat4x4(&mWorlds[node], world);
+			}
+
+			dirty[node] = 0;
+		}
+	}
+
+	void TransformHierarchy::ComposeLocals(const uint32_t* nodes)
+	{
+		// Transposing four rows of components gives one component of the four nodes per row.
+		DirectX::XMMATRIX q = DirectX::XMMatrixTranspose(DirectX::XMMATRIX(
+			DirectX::XMLoadFloat4(&mRotations[nodes[0]]), DirectX::XMLoadFloat4(&mRotations[nodes[1]]),
+			DirectX::XMLoadFloat4(&mRotations[nodes[2]]), DirectX::XMLoadFloat4(&mRotations[nodes[3]])));
+		DirectX::XMMATRIX s = DirectX::XMMatrixTranspose(DirectX::XMMATRIX(
+			DirectX::XMLoadFloat3(&mScales[nodes[0]]), DirectX::XMLoadFloat3(&mScales[nodes[1]]),
+			DirectX::XMLoadFloat3(&mScales[nodes[2]]), DirectX::XMLoadFloat3(&mScales[nodes[3]])));
+		DirectX::XMMATRIX t = DirectX::XMMatrixTranspose(DirectX::XMMATRIX(
+			DirectX::XMLoadFloat3(&mTranslations[nodes[0]]), DirectX::XMLoadFloat3(&mTranslations[nodes[1]]),
+			DirectX::XMLoadFloat3(&mTranslations[nodes[2]]), DirectX::XMLoadFloat3(&mTranslations[nodes[3]])));
+
+		// The rotation matrix of a unit quaternion, as XMMatrixRotationQuaternion builds it.
+		DirectX::XMVECTOR x = q.r[0], y = q.r[1], z = q.r[2], w = q.r[3];
+		DirectX::XMVECTOR x2 = DirectX::XMVectorAdd(x, x), y2 = DirectX::XMVectorAdd(y, y), z2 = DirectX::XMVectorAdd(z, z);
+		DirectX::XMVECTOR xx = DirectX::XMVectorMultiply(x, x2), yy = DirectX::XMVectorMultiply(y, y2), zz = DirectX::XMVectorMultiply(z, z2);
+		DirectX::XMVECTOR xy = DirectX::XMVectorMultiply(x, y2), xz = DirectX::XMVectorMultiply(x, z2), yz = DirectX::XMVectorMultiply(y, z2);
+		DirectX::XMVECTOR wx = DirectX::XMVectorMultiply(w, x2), wy = DirectX::XMVectorMultiply(w, y2), wz = DirectX::XMVectorMultiply(w, z2);
+		DirectX::XMVECTOR one = DirectX::XMVectorSplatOne(), zero = DirectX::XMVectorZero();
+
+		// Row i of the rotation scaled by component i of the scale, per node.
+		DirectX::XMVECTOR sx = s.r[0], sy = s.r[1], sz = s.r[2];
+		DirectX::XMMATRIX row0 = DirectX::XMMatrixTranspose(DirectX::XMMATRIX(
+			DirectX::XMVectorMultiply(sx, DirectX::XMVectorSubtract(one, DirectX::XMVectorAdd(yy, zz))),
+			DirectX::XMVectorMultiply(sx, DirectX::XMVectorAdd(xy, wz)),
+			DirectX::XMVectorMultiply(sx, DirectX::XMVectorSubtract(xz, wy)),
+			zero));
+		DirectX::XMMATRIX row1 = DirectX::XMMatrixTranspose(DirectX::XMMATRIX(
+			DirectX::XMVectorMultiply(sy, DirectX::XMVectorSubtract(xy, wz)),
+			DirectX::XMVectorMultiply(sy, DirectX::XMVectorSubtract(one, DirectX::XMVectorAdd(xx, zz))),
+			DirectX::XMVectorMultiply(sy, DirectX::XMVectorAdd(yz, wx)),
+			zero));
+		DirectX::XMMATRIX row2 = DirectX::XMMatrixTranspose(DirectX::XMMATRIX(
+			DirectX::XMVectorMultiply(sz, DirectX::XMVectorAdd(xz, wy)),
+			DirectX::XMVectorMultiply(sz, DirectX::XMVectorSubtract(yz, wx)),
+			DirectX::XMVectorMultiply(sz, DirectX::XMVectorSubtract(one, DirectX::XMVectorAdd(xx, yy))),
+			zero));
+		DirectX::XMMATRIX row3 = DirectX::XMMatrixTranspose(DirectX::XMMATRIX(t.r[0], t.r[1], t.r[2], one));
+
+		for (int lane = 0; lane < 4; ++lane)
+			DirectX::XMStoreFloat4x4(&mWorlds[nodes[lane]], DirectX::XMMATRIX(row0.r[lane], row1.r[lane], row2.r[lane], row3.r[lane]));
+	}
+}
@@ -0,0 +1,496 @@
+#include "DX12Lib/TriangleBVH.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define DX12LIB_RAY_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace DX12Lib
+{
+	namespace
+	{
+		const int MaxStackDepth = 64;
+
+		inline float HalfArea(const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max)
+		{
+			float dx = max.x - min.x, dy = max.y - min.y, dz = max.z - min.z;
+			return dx * dy + dy * dz + dz * dx;
+		}
+
+		inline void Grow(DirectX::XMFLOAT3& min, DirectX::XMFLOAT3& max, const DirectX::XMFLOAT3& pMin, const DirectX::XMFLOAT3& pMax)
+		{
+			min = DirectX::XMFLOAT3(std::min(min.x, pMin.x), std::min(min.y, pMin.y), std::min(min.z, pMin.z));
+			max = DirectX::XMFLOAT3(std::max(max.x, pMax.x), std::max(max.y, pMax.y), std::max(max.z, pMax.z));
+		}
+
+		inline float Axis(const DirectX::XMFLOAT3& v, int axis)
+		{
+			return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+		}
+
+		// Slab test, returns the entry distance or FLT_MAX on a miss.
+		inline float RayBox(const float org[3], const float invD[3], const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max, float maxDistance)
+		{
+			float tMin = 0.0f, tMax = maxDistance;
+			const float boxMin[3] = { min.x, min.y, min.z };
+			const float boxMax[3] = { max.x, max.y, max.z };
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float t0 = (boxMin[axis] - org[axis]) * invD[axis];
+				float t1 = (boxMax[axis] - org[axis]) * invD[axis];
+				if (t0 > t1)
+					std::swap(t0, t1);
+
+				tMin = t0 > tMin ? t0 : tMin;
+				tMax = t1 < tMax ? t1 : tMax;
+			}
+
+			return tMin <= tMax ? tMin : FLT_MAX;
+		}
+
+		// Moller-Trumbore, both faces.
+		inline bool RayTriangle(const float o[3], const float d[3], const DirectX::XMFLOAT3* v, float& t)
+		{
+			const float epsilon = 1e-8f;
+
+			float e1[3] = { v[1].x - v[0].x, v[1].y - v[0].y, v[1].z - v[0].z };
+			float e2[3] = { v[2].x - v[0].x, v[2].y - v[0].y, v[2].z - v[0].z };
+
+			float p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+			float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+			if (fabsf(det) < epsilon)
+				return false;
+
+			float invDet = 1.0f / det;
+			float s[3] = { o[0] - v[0].x, o[1] - v[0].y, o[2] - v[0].z };
+			float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+			if (u < 0.0f || u > 1.0f)
+				return false;
+
+			float q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+			float w = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * invDet;
+			if (w < 0.0f || u + w > 1.0f)
+				return false;
+
+			t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+			return t > 0.0f;
+		}
+	}
+
+	void TriangleBVH::Build(const DirectX::XMFLOAT3* positions, uint32_t vertexStride, const uint32_t* indices, uint32_t indexCount, int32_t baseVertex)
+	{
+		const uint32_t triCount = indexCount / 3;
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(positions);
+
+		std::vector<DirectX::XMFLOAT3> vertices(triCount * 3);
+		mCentroids.resize(triCount);
+		mTriMin.resize(triCount);
+		mTriMax.resize(triCount);
+		mTriangleIds.resize(triCount);
+
+		for (uint32_t i = 0; i < triCount; ++i)
+		{
+			DirectX::XMFLOAT3 min(+FLT_MAX, +FLT_MAX, +FLT_MAX);
+			DirectX::XMFLOAT3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+			for (int k = 0; k < 3; ++k)
+			{
+				size_t vertex = (size_t)(baseVertex + (int32_t)indices[i * 3 + k]);
+				const DirectX::XMFLOAT3& p = *reinterpret_cast<const DirectX::XMFLOAT3*>(base + vertex * vertexStride);
+				vertices[i * 3 + k] = p;
+				Grow(min, max, p, p);
+			}
+
+			mTriMin[i] = min;
+			mTriMax[i] = max;
+			mCentroids[i] = DirectX::XMFLOAT3((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+			mTriangleIds[i] = i;
+		}
+
+		mNodes.clear();
+		mNodes.reserve(triCount > 0 ? 2 * triCount / MaxLeafTriangles + 1 : 0);
+		if (triCount > 0)
+			BuildRange(0, triCount, 0);
+
+		// Store the vertices in leaf order so leaves read them contiguously.
+		mVertices.resize(triCount * 3);
+		for (uint32_t i = 0; i < triCount; ++i)
+		{
+			for (int k = 0; k < 3; ++k)
+				mVertices[i * 3 + k] = vertices[mTriangleIds[i] * 3 + k];
+		}
+
+		if (mNodes.empty())
+		{
+			mBound = DirectX::BoundingBox();
+		}
+		else
+		{
+			const Node& root = mNodes[0];
+			mBound.Center = DirectX::XMFLOAT3((root.Min.x + root.Max.x) * 0.5f, (root.Min.y + root.Max.y) * 0.5f, (root.Min.z + root.Max.z) * 0.5f);
+			mBound.Extents = DirectX::XMFLOAT3((root.Max.x - root.Min.x) * 0.5f, (root.Max.y - root.Min.y) * 0.5f, (root.Max.z - root.Min.z) * 0.5f);
+		}
+
+		mNodes.shrink_to_fit();
+		std::vector<DirectX::XMFLOAT3>().swap(mCentroids);
+		std::vector<DirectX::XMFLOAT3>().swap(mTriMin);
+		std::vector<DirectX::XMFLOAT3>().swap(mTriMax);
+	}
+
+	uint32_t TriangleBVH::BuildRange(uint32_t begin, uint32_t end, int depth)
+	{
+		uint32_t nodeIndex = (uint32_t)mNodes.size();
+		mNodes.push_back(Node());
+
+		DirectX::XMFLOAT3 min(+FLT_MAX, +FLT_MAX, +FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		DirectX::XMFLOAT3 cMin(+FLT_MAX, +FLT_MAX, +FLT_MAX), cMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			uint32_t tri = mTriangleIds[i];
+			Grow(min, max, mTriMin[tri], mTriMax[tri]);
+			Grow(cMin, cMax, mCentroids[tri], mCentroids[tri]);
+		}
+
+		mNodes[nodeIndex].Min = min;
+		mNodes[nodeIndex].Max = max;
+
+		const uint32_t count = end - begin;
+		if (count <= MaxLeafTriangles || depth >= MaxStackDepth - 1)
+		{
+			mNodes[nodeIndex].Start = begin;
+			mNodes[nodeIndex].Count = count;
+			return nodeIndex;
+		}
+
+		// Binned SAH over all three axes.
+		int bestAxis = -1;
+		int bestSplit = 0;
+		float bestCost = FLT_MAX;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float axisMin = Axis(cMin, axis), axisMax = Axis(cMax, axis);
+			if (axisMax - axisMin <= 1e-12f)
+				continue;
+
+			float scale = BinCount / (axisMax - axisMin);
+
+			struct Bin { DirectX::XMFLOAT3 Min, Max; uint32_t Count; };
+			Bin bins[BinCount];
+			for (auto& bin : bins)
+				bin = { DirectX::XMFLOAT3(+FLT_MAX, +FLT_MAX, +FLT_MAX), DirectX::XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX), 0 };
+
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				uint32_t tri = mTriangleIds[i];
+				int b = std::min(BinCount - 1, (int)((Axis(mCentroids[tri], axis) - axisMin) * scale));
+				Grow(bins[b].Min, bins[b].Max, mTriMin[tri], mTriMax[tri]);
+				++bins[b].Count;
+			}
+
+			float rightArea[BinCount];
+			uint32_t rightCount[BinCount];
+			DirectX::XMFLOAT3 accMin(+FLT_MAX, +FLT_MAX, +FLT_MAX), accMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			uint32_t accCount = 0;
+			for (int b = BinCount - 1; b > 0; --b)
+			{
+				Grow(accMin, accMax, bins[b].Min, bins[b].Max);
+				accCount += bins[b].Count;
+				rightArea[b] = accCount ? HalfArea(accMin, accMax) : 0.0f;
+				rightCount[b] = accCount;
+			}
+
+			accMin = DirectX::XMFLOAT3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
+			accMax = DirectX::XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			accCount = 0;
+			for (int b = 0; b < BinCount - 1; ++b)
+			{
+				Grow(accMin, accMax, bins[b].Min, bins[b].Max);
+				accCount += bins[b].Count;
+				if (accCount == 0 || rightCount[b + 1] == 0)
+					continue;
+
+				float cost = HalfArea(accMin, accMax) * accCount + rightArea[b + 1] * rightCount[b + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = b + 1;
+				}
+			}
+		}
+
+		uint32_t mid;
+		if (bestAxis >= 0)
+		{
+			float axisMin = Axis(cMin, bestAxis);
+			float scale = BinCount / (Axis(cMax, bestAxis) - axisMin);
+			auto first = mTriangleIds.begin() + begin;
+			auto split = std::partition(first, mTriangleIds.begin() + end, [&](uint32_t tri)
+			{
+				return std::min(BinCount - 1, (int)((Axis(mCentroids[tri], bestAxis) - axisMin) * scale)) < bestSplit;
+			});
+			mid = (uint32_t)(split - mTriangleIds.begin());
+		}
+		else
+		{
+			// All centroids coincide, any split is as good as another.
+			mid = begin + count / 2;
+		}
+
+		BuildRange(begin, mid, depth + 1);
+		uint32_t right = BuildRange(mid, end, depth + 1);
+
+		mNodes[nodeIndex].Start = right;
+		mNodes[nodeIndex].Count = 0;
+		return nodeIndex;
+	}
+
+	bool TriangleBVH::Intersect(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float& t, uint32_t& triangleIndex, float maxDistance) const
+	{
+		if (mNodes.empty())
+			return false;
+
+		DirectX::XMFLOAT3 o3, d3;
+		DirectX::XMStoreFloat3(&o3, origin);
+		DirectX::XMStoreFloat3(&d3, direction);
+
+		const float o[3] = { o3.x, o3.y, o3.z };
+		const float d[3] = { d3.x, d3.y, d3.z };
+		const float invD[3] = { 1.0f / d[0], 1.0f / d[1], 1.0f / d[2] };
+
+		float closest = maxDistance;
+		uint32_t hitTriangle = InvalidTriangle;
+
+		uint32_t stack[MaxStackDepth];
+		int stackSize = 0;
+
+		if (RayBox(o, invD, mNodes[0].Min, mNodes[0].Max, closest) == FLT_MAX)
+			return false;
+
+		uint32_t nodeIndex = 0;
+		while (true)
+		{
+			const Node& node = mNodes[nodeIndex];
+			if (node.Count > 0)
+			{
+				for (uint32_t i = node.Start; i < node.Start + node.Count; ++i)
+				{
+					float tri;
+					if (RayTriangle(o, d, &mVertices[i * 3], tri) && tri < closest)
+					{
+						closest = tri;
+						hitTriangle = mTriangleIds[i];
+					}
+				}
+			}
+			else
+			{
+				// Visit the nearer child first, the other one may be skipped once a hit is found.
+				uint32_t nearChild = nodeIndex + 1, farChild = node.Start;
+				float tNear = RayBox(o, invD, mNodes[nearChild].Min, mNodes[nearChild].Max, closest);
+				float tFar = RayBox(o, invD, mNodes[farChild].Min, mNodes[farChild].Max, closest);
+				if (tFar < tNear)
+				{
+					std::swap(nearChild, farChild);
+					std::swap(tNear, tFar);
+				}
+
+				if (tNear != FLT_MAX)
+				{
+					if (tFar != FLT_MAX)
+						stack[stackSize++] = farChild;
+
+					nodeIndex = nearChild;
+					continue;
+				}
+			}
+
+			// Pop the next node that can still beat the closest hit.
+			bool found = false;
+			while (stackSize > 0)
+			{
+				nodeIndex = stack[--stackSize];
+				if (RayBox(o, invD, mNodes[nodeIndex].Min, mNodes[nodeIndex].Max, closest) != FLT_MAX)
+				{
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+				break;
+		}
+
+		if (hitTriangle == InvalidTriangle)
+			return false;
+
+		t = closest;
+		triangleIndex = hitTriangle;
+		return true;
+	}
+
+	void TriangleBVH::IntersectPacket(RayPacket& packet) const
+	{
+		if (mNodes.empty() || packet.Active == 0)
+			return;
+
+#if defined(DX12LIB_RAY_SSE)
+		const __m128 ox = _mm_loadu_ps(packet.OriginX), oy = _mm_loadu_ps(packet.OriginY), oz = _mm_loadu_ps(packet.OriginZ);
+		const __m128 dx = _mm_loadu_ps(packet.DirectionX), dy = _mm_loadu_ps(packet.DirectionY), dz = _mm_loadu_ps(packet.DirectionZ);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 idx = _mm_div_ps(one, dx), idy = _mm_div_ps(one, dy), idz = _mm_div_ps(one, dz);
+		const __m128 zero = _mm_setzero_ps();
+
+		const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+		const __m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int)packet.Active), laneBits), laneBits));
+
+		__m128 closest = _mm_loadu_ps(packet.MaxDistance);
+		__m128i hitIds = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packet.TriangleIndex));
+
+		// Inactive lanes never hit anything.
+		closest = _mm_or_ps(_mm_and_ps(active, closest), _mm_andnot_ps(active, _mm_set1_ps(-1.0f)));
+
+		// Entry distances for the lanes that reach the box, FLT_MAX for the rest.
+		auto boxTest = [&](const Node& node) -> __m128
+		{
+			__m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Min.x), ox), idx);
+			__m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Max.x), ox), idx);
+			__m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Min.y), oy), idy);
+			__m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Max.y), oy), idy);
+			__m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Min.z), oz), idz);
+			__m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Max.z), oz), idz);
+
+			__m128 tEnter = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_max_ps(_mm_min_ps(tz0, tz1), zero));
+			__m128 tExit = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_min_ps(_mm_max_ps(tz0, tz1), closest));
+
+			__m128 hit = _mm_cmple_ps(tEnter, tExit);
+			return _mm_or_ps(_mm_and_ps(hit, tEnter), _mm_andnot_ps(hit, _mm_set1_ps(FLT_MAX)));
+		};
+
+		auto minLane = [](__m128 v) -> float
+		{
+			v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+			v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+			return _mm_cvtss_f32(v);
+		};
+
+		uint32_t stack[MaxStackDepth];
+		int stackSize = 0;
+
+		if (minLane(boxTest(mNodes[0])) == FLT_MAX)
+			return;
+
+		uint32_t nodeIndex = 0;
+		while (true)
+		{
+			const Node& node = mNodes[nodeIndex];
+			if (node.Count > 0)
+			{
+				for (uint32_t i = node.Start; i < node.Start + node.Count; ++i)
+				{
+					const DirectX::XMFLOAT3* v = &mVertices[i * 3];
+
+					__m128 e1x = _mm_set1_ps(v[1].x - v[0].x), e1y = _mm_set1_ps(v[1].y - v[0].y), e1z = _mm_set1_ps(v[1].z - v[0].z);
+					__m128 e2x = _mm_set1_ps(v[2].x - v[0].x), e2y = _mm_set1_ps(v[2].y - v[0].y), e2z = _mm_set1_ps(v[2].z - v[0].z);
+
+					__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+					__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+					__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+					__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+					__m128 invDet = _mm_div_ps(one, det);
+
+					__m128 sx = _mm_sub_ps(ox, _mm_set1_ps(v[0].x)), sy = _mm_sub_ps(oy, _mm_set1_ps(v[0].y)), sz = _mm_sub_ps(oz, _mm_set1_ps(v[0].z));
+					__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+
+					__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+					__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+					__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+					__m128 w = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+					__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+					__m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+					__m128 hit = _mm_cmpge_ps(absDet, _mm_set1_ps(1e-8f));
+					hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+					hit = _mm_and_ps(hit, _mm_cmpge_ps(w, zero));
+					hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, w), one));
+					hit = _mm_and_ps(hit, _mm_cmpgt_ps(t, zero));
+					hit = _mm_and_ps(hit, _mm_cmplt_ps(t, closest));
+
+					if (_mm_movemask_ps(hit))
+					{
+						closest = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, closest));
+						__m128i hitMask = _mm_castps_si128(hit);
+						hitIds = _mm_or_si128(_mm_and_si128(hitMask, _mm_set1_epi32((int)mTriangleIds[i])), _mm_andnot_si128(hitMask, hitIds));
+					}
+				}
+			}
+			else
+			{
+				// Near child by the closest lane entry; the packet is coherent, so this is what most lanes want.
+				uint32_t nearChild = nodeIndex + 1, farChild = node.Start;
+				float tNear = minLane(boxTest(mNodes[nearChild]));
+				float tFar = minLane(boxTest(mNodes[farChild]));
+				if (tFar < tNear)
+				{
+					std::swap(nearChild, farChild);
+					std::swap(tNear, tFar);
+				}
+
+				if (tNear != FLT_MAX)
+				{
+					if (tFar != FLT_MAX)
+						stack[stackSize++] = farChild;
+
+					nodeIndex = nearChild;
+					continue;
+				}
+			}
+
+			bool found = false;
+			while (stackSize > 0)
+			{
+				nodeIndex = stack[--stackSize];
+				if (minLane(boxTest(mNodes[nodeIndex])) != FLT_MAX)
+				{
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+				break;
+		}
+
+		// Only lanes that were active get their results written back.
+		__m128 original = _mm_loadu_ps(packet.MaxDistance);
+		_mm_storeu_ps(packet.MaxDistance, _mm_or_ps(_mm_and_ps(active, closest), _mm_andnot_ps(active, original)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(packet.TriangleIndex), hitIds);
+#else
+		for (int lane = 0; lane < RayPacket::Size; ++lane)
+		{
+			if ((packet.Active & (1u << lane)) == 0)
+				continue;
+
+			DirectX::XMVECTOR origin = DirectX::XMVectorSet(packet.OriginX[lane], packet.OriginY[lane], packet.OriginZ[lane], 1.0f);
+			DirectX::XMVECTOR direction = DirectX::XMVectorSet(packet.DirectionX[lane], packet.DirectionY[lane], packet.DirectionZ[lane], 0.0f);
+
+			float t;
+			uint32_t triangle;
+			if (Intersect(origin, direction, t, triangle, packet.MaxDistance[lane]))
+			{
+				packet.MaxDistance[lane] = t;
+				packet.TriangleIndex[lane] = triangle;
+			}
+		}
+#endif
+	}
+
+	size_t TriangleBVH::GetMemorySize() const
+	{
+		return mNodes.size() * sizeof(Node) + mVertices.size() * sizeof(DirectX::XMFLOAT3) + mTriangleIds.size() * sizeof(uint32_t);
+	}
+}
@@ -0,0 +1,152 @@
+#include "DX12Lib/VisibilityCache.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace DX12Lib
+{
+	VisibilityCache::VisibilityCache(uint32_t revalidationPeriod) :
+		mPeriod(std::max(revalidationPeriod, 1u)),
+		mSnapshots(mPeriod)
+	{
+	}
+
+	void VisibilityCache::BeginFrame(const FrustumPlanes* views, int viewCount, const DirectX::XMFLOAT3& eye)
+	{
+		++mFrame;
+		mViews = views;
+		mViewCount = viewCount;
+
+		Snapshot& current = mSnapshots[mFrame % mPeriod];
+		current.Views.assign(views, views + viewCount);
+		current.Eye = eye;
+		current.Frame = mFrame;
+		current.NormalDelta = 0.0f;
+		current.OffsetDelta = 0.0f;
+
+		// For every older snapshot still in use, the largest change of any plane normal and of
+		// any plane offset measured from that snapshot's eye.
+		for (auto& snapshot : mSnapshots)
+		{
+			if (&snapshot == &current || snapshot.Frame == 0 || mFrame - snapshot.Frame >= mPeriod)
+				continue;
+
+			if ((int)snapshot.Views.size() != viewCount)
+			{
+				snapshot.NormalDelta = FLT_MAX;
+				snapshot.OffsetDelta = FLT_MAX;
+				continue;
+			}
+
+			float normalDelta = 0.0f, offsetDelta = 0.0f;
+			const DirectX::XMFLOAT3& e = snapshot.Eye;
+
+			for (int v = 0; v < viewCount; ++v)
+			{
+				const FrustumPlanes& a = snapshot.Views[v];
+				const FrustumPlanes& b = views[v];
+
+				for (int p = 0; p < FrustumPlanes::PlaneCount; ++p)
+				{
+					float dx = b.NormalX[p] - a.NormalX[p];
+					float dy = b.NormalY[p] - a.NormalY[p];
+					float dz = b.NormalZ[p] - a.NormalZ[p];
+					normalDelta = std::max(normalDelta, sqrtf(dx * dx + dy * dy + dz * dz));
+
+					float offsetA = a.NormalX[p] * e.x + a.NormalY[p] * e.y + a.NormalZ[p] * e.z + a.Distance[p];
+					float offsetB = b.NormalX[p] * e.x + b.NormalY[p] * e.y + b.NormalZ[p] * e.z + b.Distance[p];
+					offsetDelta = std::max(offsetDelta, fabsf(offsetB - offsetA));
+				}
+			}
+
+			snapshot.NormalDelta = normalDelta;
+			snapshot.OffsetDelta = offsetDelta;
+		}
+	}
+
+	bool VisibilityCache::Lookup(int key, uint32_t& viewMask)
+	{
+		++mLookups;
+
+		if (key < 0 || key >= (int)mEntries.size())
+			return false;
+
+		const Entry& entry = mEntries[key];
+		if (!entry.Valid || mFrame - entry.Frame >= mPeriod)
+			return false;
+
+		const Snapshot& snapshot = mSnapshots[entry.Frame % mPeriod];
+		if (snapshot.Frame != entry.Frame)
+			return false;
+
+		// dist - radius of any plane moves by at most this much, so no test can have flipped.
+		float dx = entry.Center.x - snapshot.Eye.x;
+		float dy = entry.Center.y - snapshot.Eye.y;
+		float dz = entry.Center.z - snapshot.Eye.z;
+		float drift = snapshot.NormalDelta * (sqrtf(dx * dx + dy * dy + dz * dz) + entry.ExtentLength) + snapshot.OffsetDelta;
+
+		if (entry.Margin <= drift)
+			return false;
+
+		viewMask = entry.ViewMask;
+		++mSkipped;
+		return true;
+	}
+
+	void VisibilityCache::Store(int key, const DirectX::BoundingBox& bound, uint32_t viewMask)
+	{
+		if (key < 0)
+			return;
+
+		if (key >= (int)mEntries.size())
+			mEntries.resize(key + 1);
+
+		const DirectX::XMFLOAT3& c = bound.Center;
+		const DirectX::XMFLOAT3& e = bound.Extents;
+
+		// A visible result holds while every plane keeps the box on its inner side, a culled one
+		// while the plane that rejects it by the most still does.
+		float margin = FLT_MAX;
+		for (int v = 0; v < mViewCount; ++v)
+		{
+			const FrustumPlanes& planes = mViews[v];
+			float inside = FLT_MAX, outside = 0.0f;
+
+			for (int p = 0; p < FrustumPlanes::PlaneCount; ++p)
+			{
+				float dist = planes.NormalX[p] * c.x + planes.NormalY[p] * c.y + planes.NormalZ[p] * c.z + planes.Distance[p];
+				float radius = fabsf(planes.NormalX[p]) * e.x + fabsf(planes.NormalY[p]) * e.y + fabsf(planes.NormalZ[p]) * e.z;
+
+				inside = std::min(inside, radius - dist);
+				outside = std::max(outside, dist - radius);
+			}
+
+			margin = std::min(margin, outside > 0.0f ? outside : inside);
+		}
+
+		Entry& entry = mEntries[key];
+		entry.Center = c;
+		entry.ExtentLength = sqrtf(e.x * e.x + e.y * e.y + e.z * e.z);
+		entry.Margin = margin;
+		entry.Frame = mFrame;
+		entry.ViewMask = viewMask;
+		entry.Valid = true;
+	}
+
+	void VisibilityCache::Invalidate(int key)
+	{
+		if (key >= 0 && key < (int)mEntries.size())
+			mEntries[key].Valid = false;
+	}
+
+	void VisibilityCache::Clear()
+	{
+		mEntries.clear();
+	}
+
+	void VisibilityCache::ResetStats()
+	{
+		mLookups = 0;
+		mSkipped = 0;
+	}
+}
@@ -0,0 +1,234 @@
+#include "DX12Lib/WorldStreamer.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace DX12Lib
+{
+	namespace
+	{
+		// Distance to the nearest point of the bound, zero inside it.
+		inline float DistanceToBound(const DirectX::XMFLOAT3& p, const DirectX::BoundingBox& bound)
+		{
+			float dx = std::fabs(p.x - bound.Center.x) - bound.Extents.x;
+			float dy = std::fabs(p.y - bound.Center.y) - bound.Extents.y;
+			float dz = std::fabs(p.z - bound.Center.z) - bound.Extents.z;
+			dx = dx > 0.0f ? dx : 0.0f;
+			dy = dy > 0.0f ? dy : 0.0f;
+			dz = dz > 0.0f ? dz : 0.0f;
+			return std::sqrt(dx * dx + dy * dy + dz * dz);
+		}
+	}
+
+	WorldStreamer::WorldStreamer(JobSystem& jobs, const StreamingSettings& settings) :
+		mSettings(settings),
+		mJobs(jobs)
+	{
+	}
+
+	WorldStreamer::~WorldStreamer()
+	{
+		Close();
+	}
+
+	bool WorldStreamer::Open(const std::string& filename)
+	{
+		Close();
+
+		std::ifstream fin(filename, std::ios::binary);
+		if (!fin)
+			return false;
+
+		SceneFileHeader header;
+		fin.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (fin.gcount() != sizeof(header) || header.Magic != SceneFileHeader::MagicValue || header.Version != SceneFileHeader::CurrentVersion)
+			return false;
+
+		mEntries.resize(header.CellCount);
+		fin.read(reinterpret_cast<char*>(mEntries.data()), mEntries.size() * sizeof(SceneCellEntry));
+		if ((size_t)fin.gcount() != mEntries.size() * sizeof(SceneCellEntry))
+		{
+			mEntries.clear();
+			return false;
+		}
+
+		mFilename = filename;
+		mCells.resize(mEntries.size());
+		return true;
+	}
+
+	void WorldStreamer::Close()
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mQuit = true;
+			mRequests.clear();
+			mReadsDone.wait(lock, [this]() { return mReaders == 0; });
+			mQuit = false;
+		}
+
+		mFilename.clear();
+		mCompleted.clear();
+		mEntries.clear();
+		mCells.clear();
+		mLoaded.clear();
+		mUnloaded.clear();
+		mResidentBytes = 0;
+		mResidentActors = 0;
+	}
+
+	void WorldStreamer::Update(const DirectX::XMFLOAT3& eye)
+	{
+		mLoaded.clear();
+		mUnloaded.clear();
+
+		std::vector<Completed> completed;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			completed.swap(mCompleted);
+		}
+
+		for (auto& done : completed)
+		{
+			Cell& cell = mCells[done.Cell];
+			if (!done.Ok)
+			{
+				cell.State = Cell_Unloaded;
+				cell.Failed = true;
+				mResidentBytes -= mEntries[done.Cell].Size;
+				mResidentActors -= mEntries[done.Cell].ActorCount;
+				continue;
+			}
+
+			cell.State = Cell_Resident;
+			cell.Blob = std::move(done.Blob);
+			cell.View = done.View;
+			mLoaded.push_back(done.Cell);
+		}
+
+		for (uint32_t i = 0; i < mCells.size(); ++i)
+			mCells[i].Distance = DistanceToBound(eye, mEntries[i].Bound);
+
+		for (uint32_t i = 0; i < mCells.size(); ++i)
+		{
+			if (mCells[i].State == Cell_Resident && mCells[i].Distance > mSettings.UnloadDistance)
+				Unload(i);
+		}
+
+		mCandidates.clear();
+		for (uint32_t i = 0; i < mCells.size(); ++i)
+		{
+			if (mCells[i].State == Cell_Unloaded && !mCells[i].Failed && mCells[i].Distance < mSettings.LoadDistance)
+				mCandidates.push_back(i);
+		}
+		std::sort(mCandidates.begin(), mCandidates.end(), [this](uint32_t a, uint32_t b) { return mCells[a].Distance < mCells[b].Distance; });
+
+		size_t requested = 0;
+		for (uint32_t candidate : mCandidates)
+		{
+			const SceneCellEntry& entry = mEntries[candidate];
+
+			// Make room by dropping resident cells that are farther away than this one.
+			while (mResidentBytes + entry.Size > mSettings.MemoryBudget || mResidentActors + entry.ActorCount > mSettings.MaxResidentActors)
+			{
+				uint32_t farthest = UINT32_MAX;
+				for (uint32_t i = 0; i < mCells.size(); ++i)
+				{
+					const Cell& cell = mCells[i];
+					if (cell.State == Cell_Resident && cell.Distance > mCells[candidate].Distance && (farthest == UINT32_MAX || cell.Distance > mCells[farthest].Distance))
+						farthest = i;
+				}
+
+				if (farthest == UINT32_MAX)
+					break;
+				Unload(farthest);
+			}
+
+			// Candidates are sorted, nothing farther fits either.
+			if (mResidentBytes + entry.Size > mSettings.MemoryBudget || mResidentActors + entry.ActorCount > mSettings.MaxResidentActors)
+				break;
+
+			mCells[candidate].State = Cell_Loading;
+			mResidentBytes += entry.Size;
+			mResidentActors += entry.ActorCount;
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			mRequests.push_back(candidate);
+			++requested;
+		}
+
+		if (requested > 0)
+			StartReads();
+	}
+
+	void WorldStreamer::StartReads()
+	{
+		unsigned maxReaders = mSettings.MaxConcurrentReads > 0 ? mSettings.MaxConcurrentReads : 1;
+
+		unsigned start = 0;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			while (mReaders + start < maxReaders && mReaders + start < mRequests.size())
+				++start;
+			mReaders += start;
+		}
+
+		for (unsigned i = 0; i < start; ++i)
+			mJobs.Run([this]() { ReadCells(); });
+	}
+
+	void WorldStreamer::Unload(uint32_t cell)
+	{
+		Cell& c = mCells[cell];
+		c.State = Cell_Unloaded;
+		c.Blob.reset();
+		c.View = SceneCellView();
+		mResidentBytes -= mEntries[cell].Size;
+		mResidentActors -= mEntries[cell].ActorCount;
+
+		// A cell that arrived in this same update was never seen by the caller.
+		auto it = std::find(mLoaded.begin(), mLoaded.end(), cell);
+		if (it != mLoaded.end())
+			mLoaded.erase(it);
+		else
+			mUnloaded.push_back(cell);
+	}
+
+	void WorldStreamer::ReadCells()
+	{
+		// One handle per task, so reads don't share a file position.
+		std::ifstream fin(mFilename, std::ios::binary);
+
+		for (;;)
+		{
+			uint32_t cell;
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (mQuit || mRequests.empty())
+				{
+					// Close may be waiting for the last reader.
+					if (--mReaders == 0)
+						mReadsDone.notify_all();
+					return;
+				}
+
+				cell = mRequests.front();
+				mRequests.pop_front();
+			}
+
+			const SceneCellEntry& entry = mEntries[cell];
+
+			Completed done;
+			done.Cell = cell;
+			done.Blob = std::make_unique<uint8_t[]>(entry.Size);
+
+			fin.clear();
+			fin.seekg((std::streamoff)entry.Offset);
+			fin.read(reinterpret_cast<char*>(done.Blob.get()), entry.Size);
+			done.Ok = (size_t)fin.gcount() == entry.Size && FixupSceneCell(done.Blob.get(), entry.Size, done.View);
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			mCompleted.push_back(std::move(done));
+		}
+	}
+}
@@ -29,6 +29,8 @@ Texture2D gTextureMaps[15] : register(t3);
 
 StructuredBuffer<InstanceData> gInstances : register(t0, space1);
 StructuredBuffer<MaterialData> gMaterials : register(t1, space1);
+// Per instance, the slot of its actor in gInstances.
+StructuredBuffer<uint> gInstanceIndices : register(t2, space1);
 
 SamplerState gsamPointWrap : register(s0);
 SamplerState gsamPointClamp : register(s1);
@@ -26,7 +26,7 @@ struct VertexOut
 
 VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
-	InstanceData instanceData = gInstances[instanceID];
+	InstanceData instanceData = gInstances[gInstanceIndices[instanceID]];
     VertexOut vout;
 	
 #ifdef SKINNED
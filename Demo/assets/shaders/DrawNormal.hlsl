@@ -24,7 +24,7 @@ struct VertexOut
 VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
 	VertexOut vout = (VertexOut) 0.0f;
-    InstanceData instanceData = gInstances[instanceID];
+    InstanceData instanceData = gInstances[gInstanceIndices[instanceID]];
 	
 	// Fetch the material data.
     MaterialData matData = gMaterials[instanceData.MaterialIndex];
@@ -19,7 +19,7 @@ struct VertexOut
 
 VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
-	InstanceData instanceData = gInstances[instanceID];
+	InstanceData instanceData = gInstances[gInstanceIndices[instanceID]];
 	VertexOut vout = (VertexOut) 0.0f;
 
 	MaterialData matData = gMaterials[instanceData.MaterialIndex];
@@ -16,7 +16,7 @@ struct VertexOut
 
 VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
-	InstanceData instanceData = gInstances[instanceID];
+	InstanceData instanceData = gInstances[gInstanceIndices[instanceID]];
 
 	VertexOut vout;
 	vout.PositionL = vin.PositionL;
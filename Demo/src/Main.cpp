@@ -7,6 +7,10 @@ int CALLBACK wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance
 		DX12Lib::Game game(hInstance);
 		if (game.Init())
 		{
+			// Bakes assets/scene.pvs for the scene as built, then exits.
+			if (wcsstr(lpCmdLine, L"--bake-pvs") != nullptr)
+				return game.BakePvs() ? 0 : 1;
+
 			return game.Run();
 		}
 	}
@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "DX12Lib/ActorStore.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	// The store only keeps actor pointers, it never follows them.
+	Actor* FakeActor(uint32_t id) { return reinterpret_cast<Actor*>((uintptr_t)(id + 1) * 16); }
+
+	std::wstring NameOf(uint32_t id) { return L"actor" + std::to_wstring(id); }
+
+	// What the store should hold, keyed by the id each actor was created with.
+	struct Model
+	{
+		std::unordered_map<uint32_t, ActorHandle> Live;
+		std::vector<ActorHandle> Dead;
+	};
+
+	void CheckAgainstModel(const ActorStore& store, const Model& model)
+	{
+		CHECK(store.Size() == model.Live.size());
+
+		for (const auto& entry : model.Live)
+		{
+			ActorHandle handle = entry.second;
+			REQUIRE(store.IsValid(handle));
+			CHECK(store.Find(NameOf(entry.first)) == handle);
+
+			uint32_t dense = store.IndexOf(handle);
+			REQUIRE(dense < store.Size());
+			CHECK(store.HandleAt(dense) == handle);
+			CHECK(store.GetActors()[dense] == FakeActor(entry.first));
+			// Columns move with the actor when others are swapped into holes.
+			CHECK(store.GetMaterials()[dense] == entry.first);
+			CHECK(handle.Index() < store.GetSlotCount());
+		}
+
+		for (ActorHandle handle : model.Dead)
+			CHECK(!store.IsValid(handle));
+	}
+}
+
+TEST_CASE(ActorStore, HandlesFollowActorsThroughChurn)
+{
+	Tests::Random random(1);
+	ActorStore store;
+	Model model;
+	uint32_t nextId = 0;
+
+	for (int step = 0; step < 20000; ++step)
+	{
+		if (model.Live.empty() || random.Uint(0, 9) < 6)
+		{
+			uint32_t id = nextId++;
+			ActorHandle handle = store.Create(FakeActor(id), NameOf(id));
+			REQUIRE(!handle.IsNull());
+			store.SetMaterial(handle, id);
+			model.Live[id] = handle;
+		}
+		else
+		{
+			auto it = model.Live.begin();
+			std::advance(it, random.Uint(0, (uint32_t)model.Live.size() - 1));
+			store.Destroy(it->second);
+			model.Dead.push_back(it->second);
+			model.Live.erase(it);
+		}
+
+		if (step % 1000 == 0)
+			CheckAgainstModel(store, model);
+	}
+
+	CheckAgainstModel(store, model);
+
+	// Destroying twice, or through a stale handle, does nothing.
+	size_t size = store.Size();
+	store.Destroy(model.Dead.front());
+	store.Destroy(ActorHandle());
+	CHECK(store.Size() == size);
+}
+
+TEST_CASE(ActorStore, StaleHandlesNeverResolve)
+{
+	ActorStore store;
+	CHECK(!store.IsValid(ActorHandle()));
+
+	// One slot reused many times: every earlier handle stays dead and none is ever null,
+	// even as the 8 bit generation wraps.
+	std::vector<ActorHandle> earlier;
+	for (uint32_t i = 0; i < 600; ++i)
+	{
+		ActorHandle handle = store.Create(FakeActor(i), L"reused");
+		REQUIRE(!handle.IsNull());
+		CHECK(handle.Index() == 0);
+		CHECK(handle.Generation() != 0);
+		CHECK(store.IsValid(handle));
+
+		// Generations run through 1 to 255, so the last 254 handles of the slot all differ.
+		for (size_t j = earlier.size() >= 254 ? earlier.size() - 254 : 0; j < earlier.size(); ++j)
+		{
+			CHECK(earlier[j] != handle);
+			CHECK(!store.IsValid(earlier[j]));
+		}
+
+		store.Destroy(handle);
+		CHECK(!store.IsValid(handle));
+		earlier.push_back(handle);
+	}
+}
+
+TEST_CASE(ActorStore, NamesAreUnique)
+{
+	ActorStore store;
+	ActorHandle first = store.Create(FakeActor(0), L"crate");
+	CHECK(!first.IsNull());
+	CHECK(store.Create(FakeActor(1), L"crate").IsNull());
+	CHECK(store.Size() == 1);
+
+	// The name is free again once its actor is gone.
+	store.Destroy(first);
+	CHECK(store.Find(L"crate").IsNull());
+	ActorHandle second = store.Create(FakeActor(1), L"crate");
+	CHECK(!second.IsNull());
+	CHECK(second != first);
+	CHECK(store.Find(L"crate") == second);
+
+	store.Clear();
+	CHECK(store.Size() == 0);
+	CHECK(!store.IsValid(second));
+	CHECK(store.Find(L"crate").IsNull());
+
+	// Actors created after a Clear reuse the slots under new generations.
+	ActorHandle third = store.Create(FakeActor(2), L"crate");
+	CHECK(!third.IsNull());
+	CHECK(third.Index() == second.Index());
+	CHECK(third != second);
+	CHECK(store.IsValid(third));
+	CHECK(!store.IsValid(second));
+	CHECK(store.Find(L"crate") == third);
+}
+
+TEST_CASE(ActorStore, LayerRangesYieldEveryMatchOnce)
+{
+	Tests::Random random(2);
+	ActorStore store;
+	std::unordered_map<uint32_t, ActorHandle> live;
+	std::unordered_map<uint32_t, uint32_t> layers;
+	const uint32_t layerValues[] = { 0x0, 0x1, 0x2, 0x4, 0x3, 0x8, 0x10 | 0x1 };
+	uint32_t nextId = 0;
+
+	for (int step = 0; step < 5000; ++step)
+	{
+		uint32_t action = random.Uint(0, 9);
+		if (live.empty() || action < 5)
+		{
+			uint32_t id = nextId++;
+			live[id] = store.Create(FakeActor(id), NameOf(id));
+			layers[id] = 0;
+		}
+		else
+		{
+			auto it = live.begin();
+			std::advance(it, random.Uint(0, (uint32_t)live.size() - 1));
+			if (action < 8)
+			{
+				uint32_t layer = layerValues[random.Uint(0, 6)];
+				store.SetLayer(it->second, layer);
+				layers[it->first] = layer;
+			}
+			else
+			{
+				store.Destroy(it->second);
+				layers.erase(it->first);
+				live.erase(it);
+			}
+		}
+
+		if (step % 250 != 0)
+			continue;
+
+		for (uint32_t mask : { ActorStore::AllLayers, 0x0u, 0x1u, 0x2u | 0x4u, 0x8u, 0x10u, 0x20u })
+		{
+			std::unordered_map<Actor*, int> seen;
+			size_t yielded = 0;
+			for (Actor* actor : store.GetActorsInLayers(mask))
+			{
+				++seen[actor];
+				++yielded;
+			}
+
+			size_t expected = 0;
+			for (const auto& entry : layers)
+			{
+				bool matches = ActorStore::Matches(entry.second, mask);
+				expected += matches ? 1 : 0;
+				CHECK(seen[FakeActor(entry.first)] == (matches ? 1 : 0));
+			}
+
+			CHECK(store.GetActorsInLayers(mask).Size() == expected);
+			CHECK(yielded == expected);
+		}
+
+		// The buckets hold every actor once, under its exact layer.
+		size_t bucketed = 0;
+		for (const ActorStore::LayerBucket& bucket : store.GetLayerBuckets())
+		{
+			CHECK(bucket.Actors.size() == bucket.Handles.size());
+			for (ActorHandle handle : bucket.Handles)
+				CHECK(store.GetLayers()[store.IndexOf(handle)] == bucket.Layer);
+			bucketed += bucket.Actors.size();
+		}
+		CHECK(bucketed == store.Size());
+	}
+}
+
+TEST_CASE(ActorStore, LayerUnionsDontAllocate)
+{
+	ActorStore store;
+	const uint32_t layerValues[] = { 0x1, 0x2, 0x100, 0x400, 0x800, 0x1000 };
+	for (uint32_t id = 0; id < 3000; ++id)
+	{
+		ActorHandle handle = store.Create(FakeActor(id), NameOf(id));
+		store.SetLayer(handle, layerValues[id % 6]);
+	}
+	ActorHandle mover = store.Find(NameOf(0));
+
+	// The unions a demo frame walks: two per cube face, the shadow casters and the main pass.
+	const uint32_t masks[] = { 0x1 | 0x100 | 0x800, 0x400, 0x1 | 0x400, ActorStore::AllLayers };
+	auto frame = [&](uint32_t index)
+	{
+		// One actor moves between two buckets, as a layer change in the game would.
+		store.SetLayer(mover, index % 2 ? 0x2 : 0x1);
+
+		size_t visited = 0;
+		for (uint32_t face = 0; face < 6; ++face)
+		{
+			for (uint32_t pass = 0; pass < 2; ++pass)
+			{
+				for (Actor* actor : store.GetActorsInLayers(masks[pass]))
+					visited += actor ? 1 : 0;
+			}
+		}
+		for (uint32_t m = 2; m < 4; ++m)
+		{
+			for (Actor* actor : store.GetActorsInLayers(masks[m]))
+				visited += actor ? 1 : 0;
+			visited += store.GetActorsInLayers(masks[m]).Size();
+		}
+		return visited;
+	};
+
+	size_t stayed = frame(0);
+	size_t moved = frame(1);
+	// Out of 0x1, the mover drops from the six cube face walks of the first union and from
+	// the shadow union, counted once iterating and once by Size.
+	CHECK(moved == stayed - 6 - 2);
+
+	uint64_t allocations = Tests::GetAllocationCount();
+	size_t visited = 0;
+	for (uint32_t index = 2; index < 102; ++index)
+		visited += frame(index);
+	CHECK(Tests::GetAllocationCount() == allocations);
+
+	CHECK(visited == 50 * stayed + 50 * moved);
+}
+
+TEST_CASE(ActorStore, RevisionsNeverRepeat)
+{
+	ActorStore store;
+	std::vector<uint32_t> revisions;
+
+	// A reused slot whose generation wraps hands out an earlier handle again; a draw cached
+	// under that handle must still see a new revision.
+	ActorHandle firstHandle;
+	uint32_t firstRevision = 0;
+	for (uint32_t i = 0; i < 300; ++i)
+	{
+		ActorHandle handle = store.Create(FakeActor(i), L"reused");
+		if (i == 0)
+		{
+			firstHandle = handle;
+			firstRevision = store.GetRevision(handle);
+		}
+		else if (handle == firstHandle)
+		{
+			CHECK(store.GetRevision(handle) != firstRevision);
+		}
+
+		revisions.push_back(store.GetRevision(handle));
+		store.SetMaterial(handle, i % 3 + 1);
+		revisions.push_back(store.GetRevision(handle));
+		store.Destroy(handle);
+	}
+
+	std::sort(revisions.begin(), revisions.end());
+	CHECK(std::adjacent_find(revisions.begin(), revisions.end()) == revisions.end());
+
+	// Nor after Clear.
+	store.Clear();
+	ActorHandle handle = store.Create(FakeActor(0), L"reused");
+	CHECK(!std::binary_search(revisions.begin(), revisions.end(), store.GetRevision(handle)));
+}
+
+TEST_CASE(ActorStore, RevisionsMoveOnlyWithDrawState)
+{
+	ActorStore store;
+	ActorHandle handle = store.Create(FakeActor(0), L"crate");
+	ActorHandle other = store.Create(FakeActor(1), L"barrel");
+	uint32_t otherRevision = store.GetRevision(other);
+
+	// Setting what is already set changes nothing.
+	uint32_t revision = store.GetRevision(handle);
+	store.SetMaterial(handle, 0);
+	store.SetLayer(handle, 0);
+	store.SetFlags(handle, Actor_Flag_None);
+	store.SetMesh(handle, nullptr, nullptr);
+	CHECK(store.GetRevision(handle) == revision);
+
+	// Moving is not a draw state change either.
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMStoreFloat4x4(&world, DirectX::XMMatrixTranslation(1.0f, 2.0f, 3.0f));
+	store.SetTransform(handle, world, DirectX::BoundingBox(DirectX::XMFLOAT3(1.0f, 2.0f, 3.0f), DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f)));
+	CHECK(store.GetRevision(handle) == revision);
+
+	store.SetMaterial(handle, 4);
+	CHECK(store.GetRevision(handle) != revision);
+	revision = store.GetRevision(handle);
+
+	store.SetLayer(handle, 0x2);
+	CHECK(store.GetRevision(handle) != revision);
+	revision = store.GetRevision(handle);
+
+	store.SetFlags(handle, Actor_Flag_Occluder);
+	CHECK(store.GetRevision(handle) != revision);
+	revision = store.GetRevision(handle);
+
+	store.SetMesh(handle, nullptr, reinterpret_cast<const Submesh*>(FakeActor(5)));
+	CHECK(store.GetRevision(handle) != revision);
+
+	// The revision travels with the actor when another one is destroyed before it.
+	CHECK(store.GetRevision(other) == otherRevision);
+	store.Destroy(handle);
+	CHECK(store.GetRevision(other) == otherRevision);
+}
+
+TEST_CASE(ActorStore, DirtyActorsFlushOncePerFrameResource)
+{
+	// gNumFrameResources of the renderer.
+	const uint32_t frameCount = 3;
+
+	ActorStore store;
+	std::vector<ActorHandle> handles;
+	for (uint32_t id = 0; id < 4; ++id)
+		handles.push_back(store.Create(FakeActor(id), NameOf(id)));
+
+	std::unordered_map<uint32_t, uint32_t> writes;
+	auto flush = [&]()
+	{
+		store.FlushDirty([&](ActorHandle handle)
+		{
+			CHECK(store.IsValid(handle));
+			++writes[handle.Value];
+		});
+	};
+
+	// Marking twice in one frame still writes once per frame resource.
+	store.MarkDirty(handles[0], frameCount);
+	store.MarkDirty(handles[0], frameCount);
+	store.MarkDirty(handles[1], frameCount);
+	CHECK(store.GetDirtyCount() == 2);
+	for (uint32_t frame = 0; frame < frameCount + 2; ++frame)
+		flush();
+	CHECK(writes[handles[0].Value] == frameCount);
+	CHECK(writes[handles[1].Value] == frameCount);
+	CHECK(writes.count(handles[2].Value) == 0);
+	CHECK(store.GetDirtyCount() == 0);
+
+	// Changed again one frame into the ring: the count starts over from there.
+	writes.clear();
+	store.MarkDirty(handles[2], frameCount);
+	flush();
+	store.MarkDirty(handles[2], frameCount);
+	for (uint32_t frame = 0; frame < frameCount + 2; ++frame)
+		flush();
+	CHECK(writes[handles[2].Value] == 1 + frameCount);
+	CHECK(store.GetDirtyCount() == 0);
+
+	// Destroyed while dirty: gone from the list, the others keep their counts.
+	writes.clear();
+	for (ActorHandle handle : handles)
+		store.MarkDirty(handle, frameCount);
+	flush();
+	store.Destroy(handles[1]);
+	CHECK(store.GetDirtyCount() == 3);
+
+	// A new actor in the freed slot starts clean.
+	ActorHandle reused = store.Create(FakeActor(9), NameOf(9));
+	CHECK(reused.Index() == handles[1].Index());
+	CHECK(store.GetDirtyCount() == 3);
+
+	for (uint32_t frame = 0; frame < frameCount + 2; ++frame)
+		flush();
+	CHECK(writes[handles[0].Value] == frameCount);
+	CHECK(writes[handles[1].Value] == 1);
+	CHECK(writes[handles[2].Value] == frameCount);
+	CHECK(writes[handles[3].Value] == frameCount);
+	CHECK(writes.count(reused.Value) == 0);
+
+	// Clear drops the rest.
+	store.MarkDirty(handles[0], frameCount);
+	store.Clear();
+	CHECK(store.GetDirtyCount() == 0);
+	writes.clear();
+	flush();
+	CHECK(writes.empty());
+}
@@ -0,0 +1,243 @@
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include "DX12Lib/DrawList.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	// Actors in a row along x, every one inside a box view around the origin, drawn through a
+	// DrawList the way Game drives it but without a device.
+	struct Scene
+	{
+		ActorStore Store;
+		SubmeshMap Submeshes;
+		std::deque<ActorView> Actors;
+		SceneBVH Tree;
+		VisibilityCache Cache;
+		LodSelector Selector;
+		JobSystem Jobs;
+		DrawList List;
+
+		std::vector<uint32_t> Indices;
+		std::vector<std::pair<uint32_t, uint32_t>> Writes;
+
+		Scene() : Jobs(0), List(Jobs)
+		{
+			const wchar_t* names[] = { L"box", L"sphere" };
+			for (uint32_t i = 0; i < 2; ++i)
+			{
+				Submesh& submesh = Submeshes[names[i]];
+				submesh.Id = i;
+				submesh.IndexCount = 36 * (i + 1);
+				submesh.StartIndexLocation = 100 * i;
+				submesh.Bound = DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(0.5f, 0.5f, 0.5f));
+			}
+		}
+
+		ActorView& Add(const wchar_t* drawArg, uint32_t layer, uint32_t material, uint32_t flags = Actor_Flag_None)
+		{
+			Actors.emplace_back();
+			ActorView& actor = Actors.back();
+			actor.Handle = Store.Create(nullptr, L"actor" + std::to_wstring(Actors.size()));
+			actor.RenderLayer = layer;
+			actor.VertexBuffer = { 0x10000, 4096, 32 };
+			actor.IndexBuffer = { 0x80000, 1024, Index_Format_Uint16 };
+			actor.Submeshes = &Submeshes;
+			actor.SkinnedCBIndex = (flags & Actor_Flag_Skinned) ? (uint32_t)Actors.size() : (uint32_t)-1;
+
+			float x = 2.0f * Actors.size();
+			DirectX::XMFLOAT4X4 world;
+			DirectX::XMStoreFloat4x4(&world, DirectX::XMMatrixTranslation(x, 0.0f, 0.0f));
+			DirectX::BoundingBox bound(DirectX::XMFLOAT3(x, 0.0f, 0.0f), DirectX::XMFLOAT3(0.5f, 0.5f, 0.5f));
+
+			Store.SetMesh(actor.Handle, nullptr, &Submeshes.at(drawArg));
+			Store.SetMaterial(actor.Handle, material);
+			Store.SetLayer(actor.Handle, layer);
+			Store.SetFlags(actor.Handle, flags);
+			Store.SetTransform(actor.Handle, world, bound);
+
+			actor.ProxyId = Tree.CreateProxy(bound, &actor);
+			return actor;
+		}
+
+		// Culls, builds packets and batches for viewCount views that all see everything.
+		void Frame(uint32_t viewCount = 1)
+		{
+			FrustumPlanes views[DrawList::MaxViews];
+			DirectX::XMFLOAT3 eyes[DrawList::MaxViews];
+			LodView lodViews[DrawList::MaxViews];
+			for (uint32_t v = 0; v < viewCount; ++v)
+			{
+				views[v] = FrustumPlanes::FromBox(DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(1000.0f, 1000.0f, 1000.0f)));
+				eyes[v] = DirectX::XMFLOAT3(0.0f, 0.0f, -10.0f);
+				lodViews[v] = LodView::Ortho(100.0f, 1000.0f);
+			}
+
+			List.Cull(Tree, Cache, Store, views, viewCount, eyes[0]);
+			List.FinishCull(0);
+			List.BuildDrawPackets(Store, Selector, eyes, lodViews);
+
+			if (Indices.size() < List.GetDrawPackets().size())
+				Indices.resize(List.GetDrawPackets().size(), (uint32_t)-1);
+
+			Writes.clear();
+			List.BuildBatches(Indices, [this](uint32_t i, uint32_t slot) { Writes.push_back({ i, slot }); });
+		}
+
+		const DrawList::CachedDraw& DrawOf(uint32_t packet) const
+		{
+			return *static_cast<const DrawList::CachedDraw*>(List.GetDrawPackets()[packet].Item);
+		}
+	};
+
+	// Batches cover the packets in order, without gaps, each with its own run of indices.
+	void CheckCoverage(const Scene& scene)
+	{
+		uint32_t next = 0;
+		for (const DrawList::DrawBatch& batch : scene.List.GetDrawBatches())
+		{
+			CHECK(batch.FirstPacket == next);
+			CHECK(batch.InstanceOffset == batch.FirstPacket);
+			CHECK(batch.InstanceCount > 0);
+			next += batch.InstanceCount;
+		}
+		CHECK(next == scene.List.GetDrawPackets().size());
+	}
+}
+
+TEST_CASE(DrawList, SamePipelineAndSubmeshMerge)
+{
+	Scene scene;
+	scene.List.SetPassSlots(0, { { 0x1, 0, false } });
+
+	// Materials live in the instance data, so they don't split a batch.
+	for (uint32_t i = 0; i < 4; ++i)
+		scene.Add(L"box", 0x1, i);
+	for (uint32_t i = 0; i < 3; ++i)
+		scene.Add(L"sphere", 0x1, 3 - i);
+	scene.Frame();
+
+	const std::vector<DrawList::DrawBatch>& batches = scene.List.GetDrawBatches();
+	REQUIRE(batches.size() == 2);
+	CHECK(batches[0].InstanceCount == 4);
+	CHECK(batches[1].InstanceCount == 3);
+	CheckCoverage(scene);
+
+	for (const DrawList::DrawBatch& batch : batches)
+	{
+		for (uint32_t i = batch.FirstPacket; i < batch.FirstPacket + batch.InstanceCount; ++i)
+			CHECK(scene.DrawOf(i).Lods[0].SubmeshId == scene.DrawOf(batch.FirstPacket).Lods[0].SubmeshId);
+	}
+	CHECK(scene.DrawOf(batches[0].FirstPacket).Lods[0].IndexCount == 36);
+	CHECK(scene.DrawOf(batches[1].FirstPacket).Lods[0].IndexCount == 72);
+}
+
+TEST_CASE(DrawList, SkinnedActorsNeverMerge)
+{
+	Scene scene;
+	scene.List.SetPassSlots(0, { { 0x1, 0, false } });
+
+	// One state throughout; the materials only fix the order: plain, skinned, plain.
+	for (uint32_t i = 0; i < 2; ++i)
+		scene.Add(L"box", 0x1, 0);
+	for (uint32_t i = 0; i < 3; ++i)
+		scene.Add(L"box", 0x1, 1, Actor_Flag_Skinned);
+	for (uint32_t i = 0; i < 2; ++i)
+		scene.Add(L"box", 0x1, 2);
+	scene.Frame();
+
+	const std::vector<DrawList::DrawBatch>& batches = scene.List.GetDrawBatches();
+	REQUIRE(batches.size() == 5);
+	const uint32_t counts[] = { 2, 1, 1, 1, 2 };
+	for (size_t b = 0; b < batches.size(); ++b)
+	{
+		CHECK(batches[b].InstanceCount == counts[b]);
+
+		const DrawList::CachedDraw& draw = scene.DrawOf(batches[b].FirstPacket);
+		CHECK(draw.Skinned == (b >= 1 && b <= 3));
+		if (draw.Skinned)
+			CHECK(draw.SkinnedCBIndex == scene.Actors[draw.Handle.Index()].SkinnedCBIndex);
+	}
+	CheckCoverage(scene);
+}
+
+TEST_CASE(DrawList, PassSlotChangeSplits)
+{
+	Scene scene;
+
+	// Two slots with the same pipeline, in two passes.
+	std::vector<PassSlot> slots = { { 0x1, 0, false }, { 0x2, 0, false } };
+	scene.List.SetPassSlots(0, slots);
+	scene.List.SetPassSlots(1, slots);
+
+	for (uint32_t i = 0; i < 3; ++i)
+		scene.Add(L"box", 0x1, 0);
+	for (uint32_t i = 0; i < 3; ++i)
+		scene.Add(L"box", 0x2, 0);
+	// Both bits: the first matching slot takes it.
+	scene.Add(L"box", 0x3, 0);
+	scene.Frame(2);
+
+	const std::vector<DrawList::DrawBatch>& batches = scene.List.GetDrawBatches();
+	const std::vector<DrawPacket>& packets = scene.List.GetDrawPackets();
+	REQUIRE(batches.size() == 4);
+	const uint32_t counts[] = { 4, 3, 4, 3 };
+	for (uint32_t b = 0; b < 4; ++b)
+	{
+		CHECK(batches[b].InstanceCount == counts[b]);
+		CHECK(DrawKey::Pass(packets[batches[b].FirstPacket].Key) == b / 2);
+		CHECK(DrawKey::Slot(packets[batches[b].FirstPacket].Key) == b % 2);
+	}
+	CheckCoverage(scene);
+}
+
+TEST_CASE(DrawList, InstanceIndicesOnlyRewriteMovedEntries)
+{
+	Tests::Random random(1);
+	Scene scene;
+	scene.List.SetPassSlots(0, { { 0x1, 0, false } });
+
+	for (uint32_t i = 0; i < 40; ++i)
+	{
+		const wchar_t* drawArg = random.Uint(0, 1) ? L"box" : L"sphere";
+		scene.Add(drawArg, 0x1, random.Uint(0, 7));
+	}
+
+	// The first frame writes every entry.
+	scene.Frame();
+	size_t packetCount = scene.List.GetDrawPackets().size();
+	REQUIRE(packetCount == 40);
+	CHECK(scene.Writes.size() == packetCount);
+	for (size_t w = 0; w < scene.Writes.size(); ++w)
+		CHECK(scene.Writes[w].first == w && scene.Writes[w].second == scene.DrawOf((uint32_t)w).Handle.Index());
+
+	// Nothing moved, nothing is written.
+	scene.Frame();
+	CHECK(scene.Writes.empty());
+
+	// New materials reorder some packets; only the entries another actor lands on change.
+	for (uint32_t k = 0; k < 4; ++k)
+		scene.Store.SetMaterial(scene.Actors[random.Uint(0, 39)].Handle, random.Uint(8, 15));
+
+	std::vector<uint32_t> before = scene.Indices;
+	scene.Frame();
+	CHECK(!scene.Writes.empty() && scene.Writes.size() < packetCount);
+
+	size_t changed = 0;
+	for (uint32_t i = 0; i < packetCount; ++i)
+	{
+		uint32_t slot = scene.DrawOf(i).Handle.Index();
+		CHECK(scene.Indices[i] == slot);
+		changed += before[i] != slot ? 1 : 0;
+	}
+	CHECK(scene.Writes.size() == changed);
+	for (const auto& write : scene.Writes)
+	{
+		CHECK(before[write.first] != write.second);
+		CHECK(scene.Indices[write.first] == write.second);
+	}
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <vector>
+#include "DX12Lib/DrawPacket.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	// Few distinct states and coarse depths, so many keys repeat and stability matters. Item
+	// records the original position.
+	std::vector<DrawPacket> RandomPackets(size_t count, Tests::Random& random)
+	{
+		std::vector<DrawPacket> packets(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			bool translucent = random.Uint(0, 3) == 0;
+			float depth = (float)random.Uint(0, 50) * 4.0f;
+			packets[i].Key = DrawKey::Make(random.Uint(0, 2), random.Uint(0, 3), random.Uint(0, 5), random.Uint(0, 200), random.Uint(0, 30), depth, translucent);
+			packets[i].Item = reinterpret_cast<void*>(i);
+			packets[i].Variant = random.Uint(0, 3);
+		}
+		return packets;
+	}
+
+	bool SameOrder(const std::vector<DrawPacket>& a, const std::vector<DrawPacket>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			if (a[i].Key != b[i].Key || a[i].Item != b[i].Item || a[i].Variant != b[i].Variant)
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST_CASE(DrawPacket, RadixSortMatchesStableSort)
+{
+	Tests::Random random(1);
+
+	for (unsigned workers : { 0u, 3u })
+	{
+		JobSystem jobs(workers);
+		DrawPacketSorter sorter(jobs);
+
+		// Both sides of the parallel threshold, and the trivial sizes.
+		for (size_t count : { (size_t)0, (size_t)1, (size_t)2, (size_t)1000, DrawPacketSorter::ParallelThreshold - 1, DrawPacketSorter::ParallelThreshold * 3 + 17 })
+		{
+			std::vector<DrawPacket> packets = RandomPackets(count, random);
+			std::vector<DrawPacket> expected = packets;
+			std::stable_sort(expected.begin(), expected.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.Key < b.Key; });
+
+			sorter.Sort(packets);
+			CHECK(SameOrder(packets, expected));
+
+			// Sorting again keeps the order; every byte is constant or already in order.
+			sorter.Sort(packets);
+			CHECK(SameOrder(packets, expected));
+		}
+	}
+}
+
+TEST_CASE(DrawPacket, KeysOrderPassesSlotsAndDepth)
+{
+	// Pass first, then slot, then pipeline, whatever the rest.
+	CHECK(DrawKey::Make(0, 3, 63, 65535, 1023, 1e9f) < DrawKey::Make(1, 0, 0, 0, 0, 0.0f));
+	CHECK(DrawKey::Make(2, 1, 63, 65535, 1023, 1e9f) < DrawKey::Make(2, 2, 0, 0, 0, 0.0f));
+	CHECK(DrawKey::Make(2, 1, 4, 65535, 1023, 1e9f, true) < DrawKey::Make(2, 1, 5, 0, 0, 0.0f));
+	CHECK(DrawKey::Begin(2, 1) <= DrawKey::Make(2, 1, 0, 0, 0, 0.0f));
+	CHECK(DrawKey::Make(2, 0, 63, 65535, 1023, 1e9f) < DrawKey::Begin(2, 1));
+
+	// Opaque: grouped by state, front to back inside a state.
+	CHECK(DrawKey::Make(0, 0, 1, 7, 3, 100.0f) < DrawKey::Make(0, 0, 1, 8, 0, 1.0f));
+	CHECK(DrawKey::Make(0, 0, 1, 7, 3, 1.0f) < DrawKey::Make(0, 0, 1, 7, 3, 2.0f));
+	CHECK(DrawKey::Make(0, 0, 1, 7, 3, 0.0f) < DrawKey::Make(0, 0, 1, 7, 3, 1e-6f));
+
+	// Translucent: back to front before state.
+	CHECK(DrawKey::Make(0, 1, 1, 900, 900, 50.0f, true) < DrawKey::Make(0, 1, 1, 0, 0, 10.0f, true));
+
+	uint64_t key = DrawKey::Make(5, 6, 7, 300, 40, 12.5f);
+	CHECK(DrawKey::Pass(key) == 5);
+	CHECK(DrawKey::Slot(key) == 6);
+	CHECK(DrawKey::Pipeline(key) == 7);
+	CHECK(DrawKey::WithDepth(DrawKey::State(5, 6, 7, 300, 40), 12.5f) == key);
+
+	for (bool translucent : { false, true })
+	{
+		uint64_t fine = DrawKey::Make(1, 2, 3, 10, 20, 30.0f, translucent);
+		uint64_t coarse = DrawKey::Make(1, 2, 3, 11, 20, 30.0f, translucent);
+		CHECK(DrawKey::WithSubmesh(fine, 11, translucent) == coarse);
+		CHECK(DrawKey::WithSubmesh(coarse, 10, translucent) == fine);
+	}
+}
@@ -0,0 +1,288 @@
+#include <vector>
+#include "DX12Lib/FrustumCulling.h"
+#include "DX12Lib/MeshData.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	BoundsSoA RandomBounds(size_t count, Tests::Random& random)
+	{
+		BoundsSoA bounds;
+		for (size_t i = 0; i < count; ++i)
+		{
+			DirectX::XMFLOAT3 center(random.Float(-150.0f, 150.0f), random.Float(-40.0f, 40.0f), random.Float(-150.0f, 150.0f));
+			DirectX::XMFLOAT3 extents(random.Float(0.05f, 4.0f), random.Float(0.05f, 4.0f), random.Float(0.05f, 4.0f));
+			bounds.Push(DirectX::BoundingBox(center, extents));
+		}
+		return bounds;
+	}
+
+	DirectX::BoundingBox GetBox(const BoundsSoA& bounds, size_t i)
+	{
+		return DirectX::BoundingBox(
+			DirectX::XMFLOAT3(bounds.CenterX[i], bounds.CenterY[i], bounds.CenterZ[i]),
+			DirectX::XMFLOAT3(bounds.ExtentX[i], bounds.ExtentY[i], bounds.ExtentZ[i]));
+	}
+
+	DirectX::XMMATRIX RandomView(Tests::Random& random)
+	{
+		DirectX::XMVECTOR eye = DirectX::XMVectorSet(random.Float(-100.0f, 100.0f), random.Float(0.0f, 30.0f), random.Float(-100.0f, 100.0f), 1.0f);
+		DirectX::XMVECTOR forward = DirectX::XMVectorSet(random.Float(-1.0f, 1.0f), random.Float(-0.5f, 0.2f), random.Float(-1.0f, 1.0f), 0.0f);
+		return DirectX::XMMatrixLookToLH(eye, DirectX::XMVector3Normalize(forward), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	}
+
+	// Perspective and orthographic views in turn, as the camera and the shadow pass use them.
+	FrustumPlanes RandomViewProj(Tests::Random& random, int index)
+	{
+		DirectX::XMMATRIX proj = index % 2 == 0 ?
+			DirectX::XMMatrixPerspectiveFovLH(random.Float(0.5f, 1.5f), random.Float(1.0f, 2.0f), 1.0f, random.Float(50.0f, 300.0f)) :
+			DirectX::XMMatrixOrthographicOffCenterLH(-60.0f, 60.0f, -40.0f, 40.0f, 0.0f, 200.0f);
+		return FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(RandomView(random), proj));
+	}
+
+	// The layers the cube map faces draw, as Game::InitDrawPasses sets them up.
+	enum DemoLayer
+	{
+		Demo_Layer_Opaque,
+		Demo_Layer_Reflector,
+		Demo_Layer_Skinned,
+		Demo_Layer_Debug,
+		Demo_Layer_Sky,
+	};
+
+	struct DemoActor
+	{
+		DemoLayer Layer;
+		bool Hidden;
+		DirectX::BoundingBox Bound;
+	};
+
+	// A submesh's bound placed by its actor's world matrix, the way AssetManager does it.
+	DirectX::BoundingBox PlaceBound(const DirectX::BoundingBox& local, DirectX::FXMMATRIX world)
+	{
+		DirectX::BoundingBox bound;
+		local.Transform(bound, world);
+		return bound;
+	}
+
+	DirectX::BoundingBox PlaceMesh(const MeshData& data, DirectX::FXMMATRIX world)
+	{
+		DirectX::BoundingBox local;
+		DirectX::BoundingBox::CreateFromPoints(local, data.Vertices.size(), &data.Vertices[0].Position, sizeof(Vertex));
+		return PlaceBound(local, world);
+	}
+
+	// The actors of Game::InitActors where the scene starts, with the meshes of InitMeshes.
+	std::vector<DemoActor> DemoActors()
+	{
+		std::vector<DemoActor> actors;
+		actors.push_back({ Demo_Layer_Sky, false, PlaceMesh(MeshGenerator::Sphere(0.5f, 20, 20), DirectX::XMMatrixScaling(5000.0f, 5000.0f, 5000.0f)) });
+		actors.push_back({ Demo_Layer_Opaque, false, PlaceMesh(MeshGenerator::Grid(20.0f, 20.0f, 40, 40), DirectX::XMMatrixIdentity()) });
+
+		// The bound of assets/models/car.txt, on its node before the pivot starts turning.
+		DirectX::BoundingBox car(DirectX::XMFLOAT3(-0.00003f, -0.48143f, -0.24073f), DirectX::XMFLOAT3(2.54857f, 1.92617f, 5.99988f));
+		actors.push_back({ Demo_Layer_Opaque, false, PlaceBound(car, DirectX::XMMatrixScaling(0.2f, 0.2f, 0.2f) * DirectX::XMMatrixTranslation(3.5f, 0.5f, 0.0f)) });
+
+		actors.push_back({ Demo_Layer_Opaque, false, PlaceMesh(MeshGenerator::Box(1.0f, 1.0f, 1.0f, 0), DirectX::XMMatrixScaling(3.0f, 1.0f, 3.0f) * DirectX::XMMatrixTranslation(0.0f, 0.5f, 0.0f)) });
+		actors.push_back({ Demo_Layer_Reflector, false, PlaceMesh(MeshGenerator::Sphere(0.5f, 20, 20), DirectX::XMMatrixScaling(2.0f, 2.0f, 2.0f) * DirectX::XMMatrixTranslation(0.0f, 2.0f, 0.0f)) });
+		actors.push_back({ Demo_Layer_Debug, true, PlaceMesh(MeshGenerator::Quad(0.0f, 0.0f, 1.0f, 1.0f, 0.0f), DirectX::XMMatrixIdentity()) });
+
+		// The soldier's submeshes keep the default bound, placed by the node they share.
+		DirectX::XMMATRIX soldier = DirectX::XMMatrixScaling(0.05f, 0.05f, -0.05f) * DirectX::XMMatrixRotationRollPitchYaw(0.0f, DirectX::XM_PI, 0.0f) * DirectX::XMMatrixTranslation(0.0f, 0.0f, -6.0f);
+		for (int i = 0; i < 5; ++i)
+			actors.push_back({ Demo_Layer_Skinned, false, PlaceBound(DirectX::BoundingBox(), soldier) });
+		return actors;
+	}
+}
+
+TEST_CASE(FrustumCulling, CullBoxesMatchesScalar)
+{
+	Tests::Random random(1);
+
+	// Sizes off the batch width too, so the padded tail is covered.
+	for (size_t count : { 0, 1, 7, 31, 33, 1003 })
+	{
+		BoundsSoA bounds = RandomBounds(count, random);
+
+		for (int view = 0; view < 8; ++view)
+		{
+			FrustumPlanes planes = RandomViewProj(random, view);
+
+			std::vector<uint32_t> simd(CullMaskWordCount(count), 0);
+			std::vector<uint32_t> scalar(CullMaskWordCount(count), 0);
+			CullBoxes(planes, bounds, simd.data());
+			CullBoxesScalar(planes, bounds, scalar.data());
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				CHECK(IsBitSet(simd.data(), i) == IsBitSet(scalar.data(), i));
+
+				DirectX::BoundingBox box = GetBox(bounds, i);
+				CHECK(IsBitSet(simd.data(), i) == (ClassifyBox(planes, box.Center, box.Extents) != DirectX::DISJOINT));
+			}
+		}
+	}
+}
+
+TEST_CASE(FrustumCulling, NeverRejectsWhatBoundingFrustumKeeps)
+{
+	Tests::Random random(2);
+	BoundsSoA bounds = RandomBounds(4000, random);
+
+	for (int round = 0; round < 8; ++round)
+	{
+		DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(random.Float(0.5f, 1.5f), random.Float(1.0f, 2.0f), 1.0f, random.Float(50.0f, 300.0f));
+		DirectX::XMMATRIX view = RandomView(random);
+		DirectX::XMVECTOR viewDeterminant = DirectX::XMMatrixDeterminant(view);
+
+		DirectX::BoundingFrustum frustum;
+		DirectX::BoundingFrustum(proj).Transform(frustum, DirectX::XMMatrixInverse(&viewDeterminant, view));
+
+		// Both ways of building the planes must stay conservative.
+		FrustumPlanes planeSets[] = { FrustumPlanes::FromFrustum(frustum), FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(view, proj)) };
+		for (const FrustumPlanes& planes : planeSets)
+		{
+			std::vector<uint32_t> mask(CullMaskWordCount(bounds.Size()), 0);
+			CullBoxes(planes, bounds, mask.data());
+
+			size_t kept = 0;
+			size_t exact = 0;
+			for (size_t i = 0; i < bounds.Size(); ++i)
+			{
+				bool inFrustum = frustum.Contains(GetBox(bounds, i)) != DirectX::DISJOINT;
+				if (inFrustum)
+					CHECK(IsBitSet(mask.data(), i));
+
+				kept += IsBitSet(mask.data(), i) ? 1 : 0;
+				exact += inFrustum ? 1 : 0;
+			}
+
+			// Only boxes near the edges may be kept in excess, not a whole other region.
+			CHECK(kept <= exact + exact / 4 + 8);
+		}
+	}
+}
+
+TEST_CASE(FrustumCulling, MultiViewMatchesOneViewAtATime)
+{
+	Tests::Random random(3);
+	BoundsSoA bounds = RandomBounds(1500, random);
+
+	for (int viewCount : { 1, 2, 5, MaxCullViews })
+	{
+		std::vector<FrustumPlanes> views;
+		for (int v = 0; v < viewCount; ++v)
+			views.push_back(RandomViewProj(random, v));
+
+		std::vector<uint32_t> viewMasks(bounds.Size(), 0);
+		CullBoxesMultiView(views.data(), viewCount, bounds, viewMasks.data());
+
+		for (int v = 0; v < viewCount; ++v)
+		{
+			std::vector<uint32_t> mask(CullMaskWordCount(bounds.Size()), 0);
+			CullBoxes(views[v], bounds, mask.data());
+
+			for (size_t i = 0; i < bounds.Size(); ++i)
+				CHECK(((viewMasks[i] >> v) & 1u) == (IsBitSet(mask.data(), i) ? 1u : 0u));
+		}
+
+		// Bits past the views stay clear.
+		if (viewCount < MaxCullViews)
+		{
+			for (uint32_t viewMask : viewMasks)
+				CHECK((viewMask >> viewCount) == 0);
+		}
+	}
+}
+
+TEST_CASE(FrustumCulling, BoxPlanesKeepOverlappingBoxes)
+{
+	Tests::Random random(4);
+	BoundsSoA bounds = RandomBounds(2000, random);
+
+	DirectX::BoundingBox region(DirectX::XMFLOAT3(20.0f, 0.0f, -30.0f), DirectX::XMFLOAT3(40.0f, 10.0f, 25.0f));
+	FrustumPlanes planes = FrustumPlanes::FromBox(region);
+
+	std::vector<uint32_t> mask(CullMaskWordCount(bounds.Size()), 0);
+	CullBoxes(planes, bounds, mask.data());
+
+	// Against an axis aligned box the plane test is exact.
+	for (size_t i = 0; i < bounds.Size(); ++i)
+		CHECK(IsBitSet(mask.data(), i) == region.Intersects(GetBox(bounds, i)));
+}
+
+TEST_CASE(FrustumCulling, CubeFacesMatchFaceFrustums)
+{
+	Tests::Random random(5);
+	BoundsSoA bounds = RandomBounds(3000, random);
+
+	const DirectX::XMFLOAT3 origin(5.0f, 2.0f, -10.0f);
+	const float nearZ = 0.5f;
+	const float farZ = 80.0f;
+
+	std::vector<uint8_t> faceMasks(bounds.Size(), 0);
+	CullBoxesCubeFaces(origin, nearZ, farZ, bounds, faceMasks.data());
+
+	// The face cameras of a cube map, in CubeMapFace order.
+	const DirectX::XMFLOAT3 looks[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	const DirectX::XMFLOAT3 ups[6] = { { 0, 1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { 0, 1, 0 }, { 0, 1, 0 } };
+
+	DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(0.5f * DirectX::XM_PI, 1.0f, nearZ, farZ);
+	size_t kept = 0;
+
+	for (int face = 0; face < 6; ++face)
+	{
+		DirectX::XMMATRIX view = DirectX::XMMatrixLookToLH(DirectX::XMLoadFloat3(&origin), DirectX::XMLoadFloat3(&looks[face]), DirectX::XMLoadFloat3(&ups[face]));
+		FrustumPlanes planes = FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(view, proj));
+
+		for (size_t i = 0; i < bounds.Size(); ++i)
+		{
+			DirectX::BoundingBox box = GetBox(bounds, i);
+			bool visible = ClassifyBox(planes, box.Center, box.Extents) != DirectX::DISJOINT;
+			CHECK(((faceMasks[i] >> face) & 1u) == (visible ? 1u : 0u));
+			kept += visible ? 1 : 0;
+		}
+	}
+
+	CHECK(kept > 0);
+}
+
+TEST_CASE(FrustumCulling, DemoCubeFaceDrawCounts)
+{
+	std::vector<DemoActor> actors = DemoActors();
+
+	// The dynamic cube map camera of Game::Init, with the lens of CubeRenderTarget.
+	const DirectX::XMFLOAT3 origin(0.0f, 2.0f, 0.0f);
+	const float nearZ = 1.0f;
+	const float farZ = 1000.0f;
+
+	BoundsSoA bounds;
+	for (const DemoActor& actor : actors)
+		bounds.Push(actor.Bound);
+
+	std::vector<uint8_t> faceMasks(bounds.Size(), 0);
+	CullBoxesCubeFaces(origin, nearZ, farZ, bounds, faceMasks.data());
+
+	// The faces draw opaque, skinned and sky; the mirror sphere is what they render for.
+	uint32_t draws[6] = {};
+	for (size_t i = 0; i < actors.size(); ++i)
+	{
+		DemoLayer layer = actors[i].Layer;
+		if (actors[i].Hidden || (layer != Demo_Layer_Opaque && layer != Demo_Layer_Skinned && layer != Demo_Layer_Sky))
+			continue;
+
+		for (int face = 0; face < 6; ++face)
+			draws[face] += (faceMasks[i] >> face) & 1u;
+	}
+
+	// +X sees the car, -Z the soldier, +Y only the sky; the grid and the box reach every side
+	// face and the one looking down.
+	const uint32_t expected[6] = { 4, 3, 1, 3, 3, 8 };
+	for (int face = 0; face < 6; ++face)
+		CHECK(draws[face] == expected[face]);
+
+	// The sky surrounds the camera and is drawn by every face.
+	CHECK(faceMasks[0] == 0x3f);
+}
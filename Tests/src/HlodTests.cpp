@@ -0,0 +1,168 @@
+#include <vector>
+#include "DX12Lib/Hlod.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	// A unit cube as a triangle soup, three positions per triangle.
+	std::vector<DirectX::XMFLOAT3> CubeTriangles()
+	{
+		const DirectX::XMFLOAT3 c[8] = {
+			{ -0.5f, -0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f },
+			{ -0.5f, -0.5f, 0.5f }, { 0.5f, -0.5f, 0.5f }, { 0.5f, 0.5f, 0.5f }, { -0.5f, 0.5f, 0.5f } };
+		const int faces[6][4] = { { 0, 3, 2, 1 }, { 4, 5, 6, 7 }, { 0, 4, 7, 3 }, { 1, 2, 6, 5 }, { 0, 1, 5, 4 }, { 3, 7, 6, 2 } };
+
+		std::vector<DirectX::XMFLOAT3> triangles;
+		for (const auto& f : faces)
+		{
+			for (int k : { f[0], f[1], f[2], f[0], f[2], f[3] })
+				triangles.push_back(c[k]);
+		}
+		return triangles;
+	}
+
+	HlodSource CubeAt(const std::vector<DirectX::XMFLOAT3>& cube, float x, float z, float scale, uint32_t material)
+	{
+		HlodSource source;
+		source.TriangleVertices = cube.data();
+		source.TriangleCount = (uint32_t)cube.size() / 3;
+		DirectX::XMStoreFloat4x4(&source.World, DirectX::XMMatrixMultiply(DirectX::XMMatrixScaling(scale, scale, scale), DirectX::XMMatrixTranslation(x, 0.0f, z)));
+		source.Bound = DirectX::BoundingBox(DirectX::XMFLOAT3(x, 0.0f, z), DirectX::XMFLOAT3(0.5f * scale, 0.5f * scale, 0.5f * scale));
+		source.Material = material;
+		return source;
+	}
+}
+
+TEST_CASE(Hlod, SwitchFlipsOnceEachWayWithHysteresis)
+{
+	HlodSwitch hlod;
+	uint32_t closeCluster = hlod.AddCluster(DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(10.0f, 5.0f, 10.0f)), 100.0f);
+	uint32_t distantCluster = hlod.AddCluster(DirectX::BoundingBox(DirectX::XMFLOAT3(500.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(10.0f, 5.0f, 10.0f)), 100.0f);
+	CHECK(hlod.Size() == 2);
+	CHECK(!hlod.IsProxyActive(closeCluster));
+	CHECK(!hlod.IsProxyActive(distantCluster));
+
+	// The first update switches the distant cluster only.
+	hlod.Update(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+	CHECK(!hlod.IsProxyActive(closeCluster));
+	CHECK(hlod.IsProxyActive(distantCluster));
+	CHECK(hlod.GetChangedClusters() == std::vector<uint32_t>{ distantCluster });
+
+	// Walking out along +Z: the distance to the bound is z - 10, the proxy takes over past 110.
+	int flips = 0;
+	for (float z = 0.0f; z < 200.0f; z += 0.5f)
+	{
+		hlod.Update(DirectX::XMFLOAT3(0.0f, 0.0f, z));
+		for (uint32_t cluster : hlod.GetChangedClusters())
+		{
+			CHECK(cluster == closeCluster);
+			CHECK(z - 10.0f > 110.0f - 0.5f);
+			CHECK(z - 10.0f <= 110.0f + 0.5f);
+			++flips;
+		}
+	}
+	CHECK(flips == 1);
+	CHECK(hlod.IsProxyActive(closeCluster));
+
+	// Jitter around the switch distance changes nothing.
+	for (int frame = 0; frame < 20; ++frame)
+	{
+		hlod.Update(DirectX::XMFLOAT3(0.0f, 0.0f, 10.0f + (frame % 2 == 0 ? 95.0f : 105.0f)));
+		CHECK(hlod.GetChangedClusters().empty());
+	}
+
+	// Walking back, the members return below 90.
+	flips = 0;
+	for (float z = 200.0f; z > 0.0f; z -= 0.5f)
+	{
+		hlod.Update(DirectX::XMFLOAT3(0.0f, 0.0f, z));
+		for (uint32_t cluster : hlod.GetChangedClusters())
+		{
+			CHECK(cluster == closeCluster);
+			CHECK(z - 10.0f <= 90.0f);
+			CHECK(z - 10.0f > 90.0f - 0.5f);
+			++flips;
+		}
+	}
+	CHECK(flips == 1);
+	CHECK(!hlod.IsProxyActive(closeCluster));
+
+	hlod.Clear();
+	CHECK(hlod.Size() == 0);
+}
+
+TEST_CASE(Hlod, BuildClustersByCell)
+{
+	std::vector<DirectX::XMFLOAT3> cube = CubeTriangles();
+	std::vector<HlodSource> sources;
+
+	// Three cubes in one cell, two in another and one alone.
+	sources.push_back(CubeAt(cube, 5.0f, 5.0f, 1.0f, 1));
+	sources.push_back(CubeAt(cube, 15.0f, 5.0f, 1.0f, 1));
+	sources.push_back(CubeAt(cube, 25.0f, 25.0f, 1.0f, 2));
+	sources.push_back(CubeAt(cube, 45.0f, 5.0f, 1.0f, 3));
+	sources.push_back(CubeAt(cube, 75.0f, 35.0f, 1.0f, 3));
+	sources.push_back(CubeAt(cube, 5.0f, 85.0f, 1.0f, 4));
+
+	HlodSettings settings;
+	settings.ClusterCellSize = 40.0f;
+	settings.WeldCellSize = 0.1f;
+	std::vector<HlodCluster> clusters = HlodBuilder::Build(sources, settings);
+	REQUIRE(clusters.size() == 2);
+
+	std::vector<int> clustered(sources.size(), 0);
+	for (const HlodCluster& cluster : clusters)
+	{
+		CHECK(cluster.Members.size() >= settings.MinClusterSize);
+		CHECK(cluster.SwitchDistance == settings.SwitchDistance);
+
+		for (uint32_t member : cluster.Members)
+		{
+			++clustered[member];
+			CHECK(cluster.Bound.Contains(sources[member].Bound) == DirectX::CONTAINS);
+		}
+
+		// Cubes apart from each other keep all their corners and faces at a fine weld.
+		CHECK(cluster.Proxy.Vertices.size() == 8 * cluster.Members.size());
+		CHECK(cluster.Proxy.Indices32.size() == 36 * cluster.Members.size());
+	}
+
+	CHECK(clusters[0].Members == std::vector<uint32_t>({ 0, 1, 2 }));
+	// Members tie on triangle count, so the first one's material is kept.
+	CHECK(clusters[0].Material == 1);
+	CHECK(clusters[1].Members == std::vector<uint32_t>({ 3, 4 }));
+	CHECK(clustered[5] == 0);
+}
+
+TEST_CASE(Hlod, SimplifyWeldsAndDropsCollapsedTriangles)
+{
+	std::vector<DirectX::XMFLOAT3> cube = CubeTriangles();
+	std::vector<HlodSource> sources = { CubeAt(cube, 0.0f, 0.0f, 1.0f, 0) };
+	MeshData merged = HlodBuilder::Merge(sources, { 0 });
+	CHECK(merged.Vertices.size() == 36);
+	CHECK(merged.Indices32.size() == 36);
+
+	// A fine grid only welds the shared corners.
+	MeshData fine = HlodBuilder::Simplify(merged, 0.1f, 1.0f);
+	CHECK(fine.Vertices.size() == 8);
+	CHECK(fine.Indices32.size() == 36);
+	for (const Vertex& v : fine.Vertices)
+	{
+		// Corner normals point away from the center.
+		float outward = v.Normal.x * v.Position.x + v.Normal.y * v.Position.y + v.Normal.z * v.Position.z;
+		CHECK(outward > 0.0f);
+	}
+
+	// A cell holding the whole cube collapses it to a point and every triangle with it.
+	for (Vertex& v : merged.Vertices)
+	{
+		v.Position.x += 5.0f;
+		v.Position.y += 5.0f;
+		v.Position.z += 5.0f;
+	}
+	MeshData collapsed = HlodBuilder::Simplify(merged, 10.0f, 1.0f);
+	CHECK(collapsed.Vertices.size() == 1);
+	CHECK(collapsed.Indices32.empty());
+}
@@ -0,0 +1,169 @@
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "DX12Lib/IndirectDraw.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	IndirectDrawInput MakeInput(uint64_t key, uint32_t pipeline, PrimitiveTopology topology)
+	{
+		IndirectDrawInput input = {};
+		input.BucketKey = key;
+		input.Pipeline = pipeline;
+		input.Topology = topology;
+		input.SkinnedCBIndex = IndirectDrawBuilder::NoSkinnedCB;
+		return input;
+	}
+
+	std::vector<IndirectDrawInput> RandomInputs(size_t count, Tests::Random& random)
+	{
+		std::vector<IndirectDrawInput> inputs;
+		uint64_t key = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			key += random.Uint(0, 3) == 0 ? 1 : 0;
+			IndirectDrawInput input = MakeInput(key, random.Uint(0, 2), random.Uint(0, 1) ? Primitive_Topology_TriangleList : Primitive_Topology_TriangleStrip);
+			input.VertexBuffer = { 0x10000ull * random.Uint(1, 50), random.Uint(1, 1 << 20), 48 };
+			input.IndexBuffer = { 0x20000000ull + 0x1000ull * random.Uint(1, 50), random.Uint(1, 1 << 20), random.Uint(0, 1) ? Index_Format_Uint16 : Index_Format_Uint32 };
+			input.IndexCount = random.Uint(3, 60000);
+			input.StartIndexLocation = random.Uint(0, 100000);
+			input.BaseVertexLocation = (int32_t)random.Uint(0, 20000) - 10000;
+			input.InstanceCount = random.Uint(1, 64);
+			input.InstanceOffset = random.Uint(0, 100000);
+			input.SkinnedCBIndex = random.Uint(0, 3) == 0 ? random.Uint(0, 7) : IndirectDrawBuilder::NoSkinnedCB;
+			inputs.push_back(input);
+		}
+		return inputs;
+	}
+
+	IndirectDrawAddresses MakeAddresses()
+	{
+		IndirectDrawAddresses addresses;
+		addresses.InstanceIndices = 0x40000000ull;
+		addresses.InstanceIndexStride = 4;
+		addresses.SkinnedCB = 0x80000000ull;
+		addresses.SkinnedCBStride = 6400;
+		return addresses;
+	}
+}
+
+TEST_CASE(IndirectDraw, ArgumentsFollowTheRecordLayout)
+{
+	auto arguments = IndirectDrawBuilder::GetArguments(3, 5);
+	CHECK(arguments[0].Type == Indirect_Argument_VertexBuffer && arguments[0].Index == 0);
+	CHECK(arguments[1].Type == Indirect_Argument_IndexBuffer);
+	CHECK(arguments[2].Type == Indirect_Argument_ShaderResourceView && arguments[2].Index == 3);
+	CHECK(arguments[3].Type == Indirect_Argument_ConstantBufferView && arguments[3].Index == 5);
+	CHECK(arguments[4].Type == Indirect_Argument_DrawIndexed);
+
+	// The record fields sit where the D3D12 argument buffer expects them.
+	CHECK(offsetof(IndirectDrawArguments, VertexBuffer) == 0);
+	CHECK(offsetof(IndirectDrawArguments, IndexBuffer) == 16);
+	CHECK(offsetof(IndirectDrawArguments, InstanceIndices) == 32);
+	CHECK(offsetof(IndirectDrawArguments, SkinnedCB) == 40);
+	CHECK(offsetof(IndirectDrawArguments, Draw) == 48);
+}
+
+TEST_CASE(IndirectDraw, PackComputesAddressesAndDrawArguments)
+{
+	Tests::Random random(1);
+	std::vector<IndirectDrawInput> inputs = RandomInputs(500, random);
+	IndirectDrawAddresses addresses = MakeAddresses();
+
+	JobSystem jobs(2);
+	IndirectDrawBuilder builder(jobs);
+	std::vector<IndirectDrawArguments> arguments(inputs.size());
+	builder.Build(inputs, addresses, arguments.data());
+
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		const IndirectDrawInput& input = inputs[i];
+		const IndirectDrawArguments& packed = arguments[i];
+
+		CHECK(packed.VertexBuffer.Location == input.VertexBuffer.Location);
+		CHECK(packed.VertexBuffer.SizeInBytes == input.VertexBuffer.SizeInBytes);
+		CHECK(packed.VertexBuffer.StrideInBytes == input.VertexBuffer.StrideInBytes);
+		CHECK(packed.IndexBuffer.Location == input.IndexBuffer.Location);
+		CHECK(packed.IndexBuffer.SizeInBytes == input.IndexBuffer.SizeInBytes);
+		CHECK(packed.IndexBuffer.Format == input.IndexBuffer.Format);
+
+		CHECK(packed.InstanceIndices == addresses.InstanceIndices + (uint64_t)input.InstanceOffset * addresses.InstanceIndexStride);
+		if (input.SkinnedCBIndex == IndirectDrawBuilder::NoSkinnedCB)
+			CHECK(packed.SkinnedCB == 0);
+		else
+			CHECK(packed.SkinnedCB == addresses.SkinnedCB + (uint64_t)input.SkinnedCBIndex * addresses.SkinnedCBStride);
+
+		CHECK(packed.Draw.IndexCountPerInstance == input.IndexCount);
+		CHECK(packed.Draw.InstanceCount == input.InstanceCount);
+		CHECK(packed.Draw.StartIndexLocation == input.StartIndexLocation);
+		CHECK(packed.Draw.BaseVertexLocation == input.BaseVertexLocation);
+		CHECK(packed.Draw.StartInstanceLocation == 0);
+		CHECK(packed.Padding == 0);
+	}
+}
+
+TEST_CASE(IndirectDraw, ParallelPackMatchesSerial)
+{
+	Tests::Random random(2);
+	std::vector<IndirectDrawInput> inputs = RandomInputs(3 * IndirectDrawBuilder::ParallelThreshold + 17, random);
+
+	JobSystem serialJobs(0);
+	JobSystem parallelJobs(3);
+	IndirectDrawBuilder serial(serialJobs);
+	IndirectDrawBuilder parallel(parallelJobs);
+
+	// Filled with different garbage, so a record nobody wrote shows up.
+	std::vector<IndirectDrawArguments> serialArguments(inputs.size()), parallelArguments(inputs.size());
+	memset(static_cast<void*>(serialArguments.data()), 0xAB, serialArguments.size() * sizeof(IndirectDrawArguments));
+	memset(static_cast<void*>(parallelArguments.data()), 0xCD, parallelArguments.size() * sizeof(IndirectDrawArguments));
+
+	serial.Build(inputs, MakeAddresses(), serialArguments.data());
+	parallel.Build(inputs, MakeAddresses(), parallelArguments.data());
+
+	CHECK(memcmp(serialArguments.data(), parallelArguments.data(), inputs.size() * sizeof(IndirectDrawArguments)) == 0);
+	CHECK(serial.GetBuckets().size() == parallel.GetBuckets().size());
+}
+
+TEST_CASE(IndirectDraw, BucketsMergeOnlyEqualState)
+{
+	std::vector<IndirectDrawInput> inputs = {
+		MakeInput(1, 0, Primitive_Topology_TriangleList),
+		MakeInput(1, 0, Primitive_Topology_TriangleList),
+		MakeInput(1, 0, Primitive_Topology_TriangleList),
+		// Another topology, then another pipeline, then another key.
+		MakeInput(1, 0, Primitive_Topology_TriangleStrip),
+		MakeInput(1, 2, Primitive_Topology_TriangleStrip),
+		MakeInput(1, 2, Primitive_Topology_TriangleStrip),
+		MakeInput(4, 2, Primitive_Topology_TriangleStrip),
+		// The state of the first bucket again, under a later key.
+		MakeInput(5, 0, Primitive_Topology_TriangleList),
+	};
+
+	JobSystem jobs(0);
+	IndirectDrawBuilder builder(jobs);
+	std::vector<IndirectDrawArguments> arguments(inputs.size());
+	builder.Build(inputs, MakeAddresses(), arguments.data());
+
+	const std::vector<IndirectBucket>& buckets = builder.GetBuckets();
+	REQUIRE(buckets.size() == 5);
+
+	const uint32_t firstDraws[] = { 0, 3, 4, 6, 7 };
+	const uint32_t drawCounts[] = { 3, 1, 2, 1, 1 };
+	for (size_t b = 0; b < buckets.size(); ++b)
+	{
+		CHECK(buckets[b].FirstDraw == firstDraws[b]);
+		CHECK(buckets[b].DrawCount == drawCounts[b]);
+
+		const IndirectDrawInput& first = inputs[buckets[b].FirstDraw];
+		CHECK(buckets[b].Key == first.BucketKey);
+		CHECK(buckets[b].Pipeline == first.Pipeline);
+		CHECK(buckets[b].Topology == first.Topology);
+	}
+
+	// An empty frame leaves no buckets behind.
+	builder.Build({}, MakeAddresses(), arguments.data());
+	CHECK(builder.GetBuckets().empty());
+}
@@ -0,0 +1,80 @@
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "DX12Lib/JobSystem.h"
+#include "Test.h"
+
+using namespace DX12Lib;
+
+TEST_CASE(JobSystem, ParallelForRunsEveryPartOnce)
+{
+	for (unsigned workers : { 0u, 1u, 4u })
+	{
+		JobSystem jobs(workers);
+		CHECK(jobs.GetThreadCount() == workers + 1);
+
+		for (unsigned partCount : { 0u, 1u, 7u, 64u, 1000u })
+		{
+			std::vector<std::atomic<int>> runs(partCount);
+			for (auto& run : runs)
+				run = 0;
+
+			jobs.ParallelFor(partCount, [&runs](unsigned part) { ++runs[part]; });
+
+			for (auto& run : runs)
+				CHECK(run == 1);
+		}
+	}
+}
+
+TEST_CASE(JobSystem, NestedAndConcurrentCallsFinish)
+{
+	JobSystem jobs(3);
+	std::atomic<int> total(0);
+
+	// Jobs inside jobs must not deadlock, even with every worker busy.
+	jobs.ParallelFor(8, [&](unsigned)
+	{
+		jobs.ParallelFor(16, [&](unsigned) { ++total; });
+	});
+	CHECK(total == 8 * 16);
+
+	// ParallelFor from several threads at once.
+	total = 0;
+	std::vector<std::thread> callers;
+	for (int i = 0; i < 4; ++i)
+		callers.emplace_back([&]() { jobs.ParallelFor(100, [&](unsigned) { ++total; }); });
+	for (auto& caller : callers)
+		caller.join();
+	CHECK(total == 4 * 100);
+}
+
+TEST_CASE(JobSystem, TasksReturnResultsAndErrors)
+{
+	std::atomic<int> ran(0);
+	{
+		JobSystem jobs(2);
+
+		std::future<int> answer = jobs.Async([]() { return 42; });
+		CHECK(answer.get() == 42);
+
+		std::future<void> failure = jobs.Async([]() { throw std::runtime_error("read failed"); });
+		bool thrown = false;
+		try
+		{
+			failure.get();
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+		CHECK(thrown);
+
+		for (int i = 0; i < 50; ++i)
+			jobs.Run([&ran]() { ++ran; });
+	}
+
+	// The destructor runs what is still queued.
+	CHECK(ran == 50);
+}
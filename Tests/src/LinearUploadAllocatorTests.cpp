@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "DX12Lib/LinearUploadAllocator.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	const size_t Alignment = LinearUploadAllocator::Alignment;
+	// Page n starts at n times this, so an address tells its page.
+	const GpuVirtualAddress PageStride = 0x100000000ull;
+
+	// Pages in host memory, with made up GPU addresses.
+	class HostPageSource : public UploadPageSource
+	{
+	public:
+		UploadAllocation CreatePage(size_t byteSize) override
+		{
+			mMemory.emplace_back(byteSize + Alignment);
+			uintptr_t start = reinterpret_cast<uintptr_t>(mMemory.back().data());
+
+			UploadAllocation page;
+			page.Data = mMemory.back().data() + (Alignment - start % Alignment) % Alignment;
+			page.GpuAddress = PageStride * mMemory.size();
+			Pages.push_back(page);
+			Sizes.push_back(byteSize);
+			return page;
+		}
+
+		std::vector<UploadAllocation> Pages;
+		std::vector<size_t> Sizes;
+
+	private:
+		std::deque<std::vector<uint8_t>> mMemory;
+	};
+
+	struct Allocator
+	{
+		HostPageSource* Source;
+		LinearUploadAllocator Uploads;
+
+		explicit Allocator(size_t pageSize) : Allocator(std::make_unique<HostPageSource>(), pageSize) {}
+
+		// The page an allocation came from, checked against its CPU pointer.
+		bool InPage(const UploadAllocation& allocation, size_t byteSize) const
+		{
+			size_t page = (size_t)(allocation.GpuAddress / PageStride) - 1;
+			if (page >= Source->Pages.size())
+				return false;
+			size_t offset = (size_t)(allocation.GpuAddress - Source->Pages[page].GpuAddress);
+			return allocation.Data == Source->Pages[page].Data + offset && offset + byteSize <= Source->Sizes[page];
+		}
+
+	private:
+		Allocator(std::unique_ptr<HostPageSource> source, size_t pageSize) : Source(source.get()), Uploads(std::move(source), pageSize) {}
+	};
+
+	struct Range
+	{
+		GpuVirtualAddress Start;
+		size_t Size;
+		uint8_t* Data;
+		uint8_t Tag;
+	};
+}
+
+TEST_CASE(LinearUploadAllocator, AllocationsAreAligned)
+{
+	Tests::Random random(1);
+	Allocator allocator(4096);
+
+	for (uint32_t i = 0; i < 500; ++i)
+	{
+		size_t size = random.Uint(1, 700);
+		UploadAllocation allocation = allocator.Uploads.Allocate(size);
+		CHECK(allocation.GpuAddress % Alignment == 0);
+		CHECK(reinterpret_cast<uintptr_t>(allocation.Data) % Alignment == 0);
+		CHECK(allocator.InPage(allocation, size));
+	}
+
+	// Even the smallest allocation takes a whole constant buffer slot.
+	allocator.Uploads.Reset();
+	allocator.Uploads.Allocate(1);
+	CHECK(allocator.Uploads.GetAllocatedBytes() == Alignment);
+	CHECK(allocator.Uploads.Allocate(1).GpuAddress == allocator.Source->Pages[0].GpuAddress + Alignment);
+}
+
+TEST_CASE(LinearUploadAllocator, ConcurrentAllocationsDontOverlap)
+{
+	const uint32_t threadCount = 4;
+	const uint32_t allocationCount = 3000;
+
+	// Small pages, so the threads race on chaining new ones as well.
+	Allocator allocator(4096);
+
+	std::vector<std::vector<Range>> ranges(threadCount);
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&allocator, &ranges, t]()
+			{
+				Tests::Random random(10 + t);
+				for (uint32_t i = 0; i < allocationCount; ++i)
+				{
+					// Now and then one larger than a page.
+					size_t size = random.Uint(0, 50) == 0 ? random.Uint(4097, 9000) : random.Uint(1, 1000);
+					UploadAllocation allocation = allocator.Uploads.Allocate(size);
+
+					uint8_t tag = (uint8_t)(t * 61 + i);
+					std::fill(allocation.Data, allocation.Data + size, tag);
+					ranges[t].push_back({ allocation.GpuAddress, size, allocation.Data, tag });
+				}
+			});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+
+	std::vector<Range> all;
+	size_t requested = 0;
+	for (const std::vector<Range>& own : ranges)
+	{
+		for (const Range& range : own)
+		{
+			all.push_back(range);
+			requested += (range.Size + Alignment - 1) & ~(Alignment - 1);
+		}
+	}
+	REQUIRE(all.size() == threadCount * allocationCount);
+
+	std::sort(all.begin(), all.end(), [](const Range& a, const Range& b) { return a.Start < b.Start; });
+	for (size_t i = 0; i < all.size(); ++i)
+	{
+		UploadAllocation allocation;
+		allocation.Data = all[i].Data;
+		allocation.GpuAddress = all[i].Start;
+		CHECK(allocator.InPage(allocation, all[i].Size));
+		if (i + 1 < all.size())
+			CHECK(all[i].Start + all[i].Size <= all[i + 1].Start);
+
+		// No other thread wrote over it.
+		CHECK(std::all_of(all[i].Data, all[i].Data + all[i].Size, [&](uint8_t byte) { return byte == all[i].Tag; }));
+	}
+
+	CHECK(allocator.Uploads.GetAllocatedBytes() >= requested);
+	CHECK(allocator.Uploads.GetPageCount() == allocator.Source->Pages.size());
+}
+
+TEST_CASE(LinearUploadAllocator, OversizeAllocationsGetTheirOwnPage)
+{
+	Allocator allocator(4096);
+
+	UploadAllocation small = allocator.Uploads.Allocate(100);
+	UploadAllocation large = allocator.Uploads.Allocate(10000);
+	REQUIRE(allocator.Source->Pages.size() == 2);
+
+	// The page is as large as the rounded up allocation, which starts it.
+	CHECK(allocator.Source->Sizes[0] == 4096);
+	CHECK(allocator.Source->Sizes[1] == 10240);
+	CHECK(small.GpuAddress == allocator.Source->Pages[0].GpuAddress);
+	CHECK(large.GpuAddress == allocator.Source->Pages[1].GpuAddress);
+	CHECK(allocator.InPage(large, 10000));
+
+	// Exactly a page still fits a regular one.
+	allocator.Uploads.Allocate(4096);
+	CHECK(allocator.Source->Sizes.back() == 4096);
+}
+
+TEST_CASE(LinearUploadAllocator, PagesAreReusedAfterReset)
+{
+	Tests::Random random(2);
+	std::vector<size_t> sizes;
+	for (uint32_t i = 0; i < 200; ++i)
+		sizes.push_back(random.Uint(0, 20) == 0 ? random.Uint(5000, 12000) : random.Uint(1, 1500));
+
+	Allocator allocator(4096);
+	std::vector<GpuVirtualAddress> first;
+	for (size_t size : sizes)
+		first.push_back(allocator.Uploads.Allocate(size).GpuAddress);
+
+	size_t pageCount = allocator.Uploads.GetPageCount();
+	size_t allocated = allocator.Uploads.GetAllocatedBytes();
+	CHECK(pageCount > 1);
+
+	for (uint32_t frame = 0; frame < 3; ++frame)
+	{
+		allocator.Uploads.Reset();
+		CHECK(allocator.Uploads.GetAllocatedBytes() == 0);
+
+		// The same frame again runs through the same pages in the same order.
+		for (size_t i = 0; i < sizes.size(); ++i)
+			CHECK(allocator.Uploads.Allocate(sizes[i]).GpuAddress == first[i]);
+		CHECK(allocator.Uploads.GetAllocatedBytes() == allocated);
+		CHECK(allocator.Source->Pages.size() == pageCount);
+	}
+
+	// A lighter frame needs fewer of them and creates none.
+	allocator.Uploads.Reset();
+	for (size_t i = 0; i < sizes.size() / 2; ++i)
+		allocator.Uploads.Allocate(sizes[i]);
+	CHECK(allocator.Source->Pages.size() == pageCount);
+}
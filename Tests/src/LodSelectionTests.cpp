@@ -0,0 +1,131 @@
+#include <cfloat>
+#include <cmath>
+#include "DX12Lib/LodSelection.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	// Four levels switching at 100, 50 and 20 pixels, culled below 5.
+	const float SwitchRadii[3] = { 100.0f, 50.0f, 20.0f };
+	const int LodCount = 4;
+
+	LodLayerSettings Settings(float hysteresis)
+	{
+		LodLayerSettings settings;
+		settings.CullPixelRadius = 5.0f;
+		settings.Hysteresis = hysteresis;
+		return settings;
+	}
+}
+
+TEST_CASE(LodSelection, WithoutHysteresisBoundariesAreExact)
+{
+	LodLayerSettings settings = Settings(0.0f);
+	for (int previous = -1; previous < LodCount; ++previous)
+	{
+		CHECK(LodSelector::Select(FLT_MAX, SwitchRadii, LodCount, settings, previous) == 0);
+		CHECK(LodSelector::Select(100.0f, SwitchRadii, LodCount, settings, previous) == 0);
+		CHECK(LodSelector::Select(99.0f, SwitchRadii, LodCount, settings, previous) == 1);
+		CHECK(LodSelector::Select(50.0f, SwitchRadii, LodCount, settings, previous) == 1);
+		CHECK(LodSelector::Select(20.0f, SwitchRadii, LodCount, settings, previous) == 2);
+		CHECK(LodSelector::Select(19.0f, SwitchRadii, LodCount, settings, previous) == 3);
+		CHECK(LodSelector::Select(5.0f, SwitchRadii, LodCount, settings, previous) == 3);
+		CHECK(LodSelector::Select(4.9f, SwitchRadii, LodCount, settings, previous) == -1);
+	}
+
+	// A single level is drawn until culled.
+	CHECK(LodSelector::Select(6.0f, nullptr, 1, settings, -1) == 0);
+	CHECK(LodSelector::Select(4.0f, nullptr, 1, settings, 0) == -1);
+}
+
+TEST_CASE(LodSelection, HysteresisStopsFlickerAtBoundaries)
+{
+	LodLayerSettings settings = Settings(0.1f);
+
+	// Jitter of 5% around every boundary, including the cull radius, never changes the pick.
+	const float boundaries[4] = { 100.0f, 50.0f, 20.0f, 5.0f };
+	for (float boundary : boundaries)
+	{
+		int lod = LodSelector::Select(boundary, SwitchRadii, LodCount, settings, -1);
+		int first = lod;
+		for (int frame = 0; frame < 50; ++frame)
+		{
+			float radius = boundary * (frame % 2 == 0 ? 0.95f : 1.05f);
+			lod = LodSelector::Select(radius, SwitchRadii, LodCount, settings, lod);
+			CHECK(lod == first);
+		}
+	}
+
+	// Moving clearly past a boundary still switches, both ways.
+	CHECK(LodSelector::Select(85.0f, SwitchRadii, LodCount, settings, 0) == 1);
+	CHECK(LodSelector::Select(115.0f, SwitchRadii, LodCount, settings, 1) == 0);
+	CHECK(LodSelector::Select(4.0f, SwitchRadii, LodCount, settings, 3) == -1);
+	CHECK(LodSelector::Select(6.0f, SwitchRadii, LodCount, settings, -1) == 3);
+}
+
+TEST_CASE(LodSelection, LevelsChangeMonotonically)
+{
+	LodLayerSettings settings = Settings(0.1f);
+
+	// Culled ranks as the coarsest level of all.
+	auto coarseness = [](int lod) { return lod < 0 ? LodCount : lod; };
+
+	// Zooming out only ever picks coarser levels, zooming in only finer ones.
+	int lod = LodSelector::Select(300.0f, SwitchRadii, LodCount, settings, -1);
+	CHECK(lod == 0);
+	for (float radius = 300.0f; radius > 1.0f; radius *= 0.97f)
+	{
+		int next = LodSelector::Select(radius, SwitchRadii, LodCount, settings, lod);
+		CHECK(coarseness(next) >= coarseness(lod));
+		lod = next;
+	}
+	CHECK(lod == -1);
+
+	for (float radius = 1.0f; radius < 300.0f; radius *= 1.03f)
+	{
+		int next = LodSelector::Select(radius, SwitchRadii, LodCount, settings, lod);
+		CHECK(coarseness(next) <= coarseness(lod));
+		lod = next;
+	}
+	CHECK(lod == 0);
+}
+
+TEST_CASE(LodSelection, ProjectedRadiusFollowsDistance)
+{
+	DirectX::BoundingBox box(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(1.0f, 2.0f, 2.0f));
+	float radius = 3.0f;
+
+	LodView closeView = LodView::Perspective(DirectX::XMFLOAT3(0.0f, 0.0f, -30.0f), 2.0f, 1000.0f);
+	LodView distantView = LodView::Perspective(DirectX::XMFLOAT3(0.0f, 0.0f, -60.0f), 2.0f, 1000.0f);
+	CHECK(fabsf(LodSelector::ProjectedPixelRadius(closeView, box) - radius * 1000.0f / 30.0f) < 1e-2f);
+	CHECK(fabsf(LodSelector::ProjectedPixelRadius(closeView, box) - 2.0f * LodSelector::ProjectedPixelRadius(distantView, box)) < 1e-2f);
+
+	LodView biased = LodView::Perspective(closeView.Eye, 2.0f, 1000.0f, 0.5f);
+	CHECK(fabsf(LodSelector::ProjectedPixelRadius(biased, box) - 0.5f * LodSelector::ProjectedPixelRadius(closeView, box)) < 1e-2f);
+
+	// Inside the bounding sphere the finest level is always wanted.
+	LodView inside = LodView::Perspective(DirectX::XMFLOAT3(0.5f, 0.0f, 0.0f), 2.0f, 1000.0f);
+	CHECK(LodSelector::ProjectedPixelRadius(inside, box) == FLT_MAX);
+
+	// Orthographic views do not care where the eye is.
+	LodView ortho = LodView::Ortho(300.0f, 2048.0f);
+	CHECK(fabsf(LodSelector::ProjectedPixelRadius(ortho, box) - radius * 2048.0f / 300.0f) < 1e-3f);
+}
+
+TEST_CASE(LodSelection, LayersUseTheirLowestBit)
+{
+	LodSelector selector;
+	LodLayerSettings grass = Settings(0.2f);
+	LodLayerSettings rocks = Settings(0.05f);
+	rocks.CullPixelRadius = 1.0f;
+
+	selector.SetLayerSettings(0x1 | 0x4, grass);
+	selector.SetLayerSettings(0x2, rocks);
+
+	CHECK(selector.GetLayerSettings(0x4).Hysteresis == 0.2f);
+	CHECK(selector.GetLayerSettings(0x2 | 0x4).CullPixelRadius == 1.0f);
+	CHECK(selector.GetLayerSettings(0x8).CullPixelRadius == 0.0f);
+	CHECK(selector.GetLayerSettings(0).CullPixelRadius == 0.0f);
+}
@@ -0,0 +1,98 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include "Test.h"
+
+namespace
+{
+	std::atomic<uint64_t> gAllocations(0);
+}
+
+void* operator new(size_t size)
+{
+	++gAllocations;
+
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+	struct TestCase
+	{
+		const char* Suite;
+		const char* Name;
+		Tests::TestFunction Function;
+	};
+
+	// Filled by the registrars during static initialization, so it has to be a function local.
+	std::vector<TestCase>& GetTestCases()
+	{
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+
+	int gFailures = 0;
+}
+
+namespace Tests
+{
+	Registrar::Registrar(const char* suite, const char* name, TestFunction function)
+	{
+		GetTestCases().push_back({ suite, name, function });
+	}
+
+	void ReportFailure(const char* file, int line, const char* expression)
+	{
+		std::printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+		++gFailures;
+	}
+
+	uint64_t GetAllocationCount()
+	{
+		return gAllocations;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int run = 0;
+	int failed = 0;
+
+	for (const TestCase& test : GetTestCases())
+	{
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; ++i)
+			selected |= std::strcmp(argv[i], test.Suite) == 0;
+		if (!selected)
+			continue;
+
+		int failuresBefore = gFailures;
+		test.Function();
+		++run;
+
+		bool passed = gFailures == failuresBefore;
+		if (!passed)
+			++failed;
+		std::printf("%s %s.%s\n", passed ? "[  OK  ]" : "[FAILED]", test.Suite, test.Name);
+	}
+
+	std::printf("%d tests, %d failed\n", run, failed);
+
+	// A suite name that matches nothing is a mistake in the test list, not a pass.
+	return failed == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,376 @@
+#include <cmath>
+#include <deque>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include "DX12Lib/DrawList.h"
+#include "DX12Lib/MockCommandRecorder.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	using Command = MockCommandRecorder::Command;
+
+	// The Render_Layer values and pipeline state ids the demo uses.
+	enum DemoLayer : uint32_t
+	{
+		Layer_Opaque = 0x1,
+		Layer_SkinnedOpaque = 0x100,
+		Layer_DynamicReflectors = 0x400,
+		Layer_Sky = 0x800,
+		Layer_Debug = 0x1000,
+	};
+
+	enum DemoPipeline : uint32_t
+	{
+		Pipeline_Opaque,
+		Pipeline_SkinnedOpaque,
+		Pipeline_Sky,
+		Pipeline_Shadow,
+		Pipeline_Debug,
+		Pipeline_Count,
+	};
+
+	const uint32_t View_Main = 0;
+	const uint32_t View_Shadow = 1;
+
+	const uint32_t InstanceIndicesParameter = 8;
+	const uint32_t SkinnedCBParameter = 3;
+
+	VertexBufferBinding GroupVertices(uint32_t group) { return { 0x10000ull * (group + 1), 4096, 32 }; }
+	IndexBufferBinding GroupIndices(uint32_t group) { return { 0x80000ull * (group + 1), 1024, Index_Format_Uint16 }; }
+
+	struct DemoGroup
+	{
+		uint32_t Index = 0;
+		SubmeshMap Submeshes;
+	};
+
+	// The actors of Game::InitActors with the pass slots of Game::InitDrawPasses, run through
+	// DrawList without a device. Submesh ids follow the order the demo creates its groups in:
+	// default, car, skull, soldier.
+	struct DemoScene
+	{
+		DemoGroup Default, Car, Soldier;
+		ActorStore Store;
+		std::deque<ActorView> Actors;
+		SceneBVH Tree;
+		VisibilityCache Cache;
+		LodSelector Selector;
+		JobSystem Jobs;
+		DrawList List;
+		std::vector<uint32_t> Indices;
+		GpuObjectHandle Pipelines[Pipeline_Count];
+
+		DemoScene() : Jobs(0), List(Jobs)
+		{
+			uint32_t id = 0;
+			AddSubmeshes(Default, 0, { L"sphere", L"cylinder", L"grid", L"box", L"quad", L"sphere_lod1", L"sphere_lod2", L"cylinder_lod1" }, id);
+			AddSubmeshes(Car, 1, { L"car" }, id);
+			++id;
+			AddSubmeshes(Soldier, 3, { L"sm_0", L"sm_1", L"sm_2", L"sm_3", L"sm_4" }, id);
+			Default.Submeshes[L"sphere"].Lods = { { L"sphere_lod1", 40.0f }, { L"sphere_lod2", 12.0f } };
+			Default.Submeshes[L"cylinder"].Lods = { { L"cylinder_lod1", 20.0f } };
+
+			for (uint32_t i = 0; i < Pipeline_Count; ++i)
+				Pipelines[i] = { i + 1 };
+
+			List.SetPassSlots(View_Main, {
+				{ Layer_DynamicReflectors, Pipeline_Opaque, false },
+				{ Layer_Opaque, Pipeline_Opaque, false },
+				{ Layer_SkinnedOpaque, Pipeline_SkinnedOpaque, false },
+				{ Layer_Debug, Pipeline_Debug, false },
+				{ Layer_Sky, Pipeline_Sky, false },
+			});
+			List.SetPassSlots(View_Shadow, { { Layer_Opaque | Layer_DynamicReflectors, Pipeline_Shadow, false } });
+
+			Add(Default, L"sphere", Layer_Sky, 0, DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), 2500.0f);
+			Add(Default, L"grid", Layer_Opaque, 1, DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), 10.0f);
+			Add(Car, L"car", Layer_Opaque, 2, DirectX::XMFLOAT3(3.5f, 0.5f, 0.0f), 1.0f);
+			Add(Default, L"box", Layer_Opaque, 3, DirectX::XMFLOAT3(0.0f, 0.5f, 0.0f), 1.5f);
+			Add(Default, L"sphere", Layer_DynamicReflectors, 4, DirectX::XMFLOAT3(0.0f, 2.0f, 0.0f), 1.0f);
+			Add(Default, L"quad", Layer_Debug, 3, DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), 0.5f).Hidden = true;
+
+			// Every submesh of the soldier shares one bone palette.
+			for (uint32_t i = 0; i < 5; ++i)
+			{
+				ActorView& actor = Add(Soldier, (L"sm_" + std::to_wstring(i)).c_str(), Layer_SkinnedOpaque, 5 + i, DirectX::XMFLOAT3(0.0f, 2.0f, -6.0f), 2.0f, Actor_Flag_Skinned);
+				actor.SkinnedCBIndex = 0;
+			}
+		}
+
+		static void AddSubmeshes(DemoGroup& group, uint32_t index, std::initializer_list<const wchar_t*> names, uint32_t& id)
+		{
+			group.Index = index;
+			for (const wchar_t* name : names)
+			{
+				Submesh& submesh = group.Submeshes[name];
+				submesh.Id = id++;
+				submesh.IndexCount = 36 + 6 * submesh.Id;
+				submesh.StartIndexLocation = 1000 * submesh.Id;
+			}
+		}
+
+		ActorView& Add(DemoGroup& group, const wchar_t* drawArg, uint32_t layer, uint32_t material, const DirectX::XMFLOAT3& center, float extent, uint32_t flags = Actor_Flag_None)
+		{
+			Actors.emplace_back();
+			ActorView& actor = Actors.back();
+			actor.Handle = Store.Create(nullptr, L"actor" + std::to_wstring(Actors.size()));
+			actor.RenderLayer = layer;
+			actor.VertexBuffer = GroupVertices(group.Index);
+			actor.IndexBuffer = GroupIndices(group.Index);
+			actor.Submeshes = &group.Submeshes;
+
+			DirectX::XMFLOAT4X4 world;
+			DirectX::XMStoreFloat4x4(&world, DirectX::XMMatrixTranslation(center.x, center.y, center.z));
+			DirectX::BoundingBox bound(center, DirectX::XMFLOAT3(extent, extent, extent));
+
+			Store.SetMesh(actor.Handle, nullptr, &group.Submeshes.at(drawArg));
+			Store.SetMaterial(actor.Handle, material);
+			Store.SetLayer(actor.Handle, layer);
+			Store.SetFlags(actor.Handle, flags);
+			Store.SetTransform(actor.Handle, world, bound);
+
+			actor.ProxyId = Tree.CreateProxy(bound, &actor);
+			return actor;
+		}
+
+		// Both views see the whole scene, up close so every actor draws its finest level.
+		void Frame()
+		{
+			FrustumPlanes views[2];
+			DirectX::XMFLOAT3 eyes[2];
+			LodView lodViews[2];
+			for (uint32_t v = 0; v < 2; ++v)
+			{
+				views[v] = FrustumPlanes::FromBox(DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(5000.0f, 5000.0f, 5000.0f)));
+				eyes[v] = DirectX::XMFLOAT3(0.0f, 3.0f, -15.0f);
+				lodViews[v] = LodView::Ortho(20.0f, 1080.0f);
+			}
+
+			List.Cull(Tree, Cache, Store, views, 2, eyes[View_Main]);
+			List.FinishCull(View_Main);
+			List.BuildDrawPackets(Store, Selector, eyes, lodViews);
+
+			if (Indices.size() < List.GetDrawPackets().size())
+				Indices.resize(List.GetDrawPackets().size(), (uint32_t)-1);
+			List.BuildBatches(Indices, [](uint32_t, uint32_t) {});
+		}
+
+		DrawSubmitState SubmitState() const
+		{
+			DrawSubmitState state;
+			state.Pipelines = Pipelines;
+			state.InstanceIndicesParameter = InstanceIndicesParameter;
+			state.InstanceIndices = 0x400000;
+			state.InstanceIndexStride = 4;
+			state.SkinnedCBParameter = SkinnedCBParameter;
+			state.SkinnedCB = 0x800000;
+			state.SkinnedCBStride = 6144;
+			return state;
+		}
+
+		// The batches of a range of slots, in the order Submit records them.
+		std::vector<DrawList::DrawBatch> Batches(uint32_t pass, uint32_t firstSlot, uint32_t lastSlot) const
+		{
+			std::vector<DrawList::DrawBatch> batches;
+			for (const DrawList::DrawBatch& batch : List.GetDrawBatches())
+			{
+				uint64_t key = List.GetDrawPackets()[batch.FirstPacket].Key;
+				if (DrawKey::Pass(key) == pass && DrawKey::Slot(key) >= firstSlot && DrawKey::Slot(key) <= lastSlot)
+					batches.push_back(batch);
+			}
+			return batches;
+		}
+	};
+
+	// Replays one submit: every state command changes something, and every draw sees the
+	// state of its batch.
+	void CheckStream(const MockCommandRecorder& recorder, const DemoScene& scene, const std::vector<DrawList::DrawBatch>& batches)
+	{
+		DrawSubmitState state = scene.SubmitState();
+
+		Command last[MockCommandRecorder::Command_Count] = {};
+		bool seen[MockCommandRecorder::Command_Count] = {};
+		size_t drawIndex = 0;
+		for (const Command& command : recorder.GetCommands())
+		{
+			switch (command.Type)
+			{
+			case MockCommandRecorder::Command_PipelineState:
+				CHECK(!seen[command.Type] || last[command.Type].Object != command.Object);
+				break;
+			case MockCommandRecorder::Command_VertexBuffer:
+				CHECK(!seen[command.Type] || last[command.Type].VertexBuffer.Location != command.VertexBuffer.Location);
+				break;
+			case MockCommandRecorder::Command_IndexBuffer:
+				CHECK(!seen[command.Type] || last[command.Type].IndexBuffer.Location != command.IndexBuffer.Location);
+				break;
+			case MockCommandRecorder::Command_RootShaderResourceView:
+			case MockCommandRecorder::Command_RootConstantBufferView:
+				CHECK(!seen[command.Type] || last[command.Type].Address != command.Address);
+				break;
+			case MockCommandRecorder::Command_DrawIndexedInstanced:
+			{
+				REQUIRE(drawIndex < batches.size());
+				const DrawList::DrawBatch& batch = batches[drawIndex++];
+				const DrawPacket& packet = scene.List.GetDrawPackets()[batch.FirstPacket];
+				const DrawList::CachedDraw& draw = *static_cast<const DrawList::CachedDraw*>(packet.Item);
+
+				CHECK(command.IndexCountPerInstance == draw.Lods[packet.Variant].IndexCount);
+				CHECK(command.StartIndexLocation == draw.Lods[packet.Variant].StartIndexLocation);
+				CHECK(command.InstanceCount == batch.InstanceCount);
+				CHECK(last[MockCommandRecorder::Command_PipelineState].Object == scene.Pipelines[DrawKey::Pipeline(packet.Key)]);
+				CHECK(last[MockCommandRecorder::Command_VertexBuffer].VertexBuffer.Location == draw.VertexBuffer.Location);
+				CHECK(last[MockCommandRecorder::Command_IndexBuffer].IndexBuffer.Location == draw.IndexBuffer.Location);
+				CHECK(last[MockCommandRecorder::Command_RootShaderResourceView].Address == state.InstanceIndices + batch.InstanceOffset * state.InstanceIndexStride);
+				CHECK(last[MockCommandRecorder::Command_RootConstantBufferView].Address == (draw.Skinned ? state.SkinnedCB : 0));
+				break;
+			}
+			default:
+				break;
+			}
+
+			last[command.Type] = command;
+			seen[command.Type] = true;
+		}
+		CHECK(drawIndex == batches.size());
+	}
+}
+
+TEST_CASE(MockCommandRecorder, DemoSceneBatchesDropRedundantState)
+{
+	DemoScene scene;
+	MockCommandRecorder recorder;
+	DrawSubmitState state = scene.SubmitState();
+
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		scene.Frame();
+
+		// Game draws the reflectors on their own, then the rest of the main pass, and resets
+		// the recorder before each submit.
+		recorder.Clear();
+		scene.List.Submit(recorder, View_Main, 0, 0, state);
+		CheckStream(recorder, scene, scene.Batches(View_Main, 0, 0));
+
+		// The dynamic sphere: everything once.
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_DrawIndexedInstanced) == 1);
+		CHECK(recorder.GetStats().Issued == 7);
+		CHECK(recorder.GetStats().Filtered == 0);
+
+		recorder.Clear();
+		scene.List.Submit(recorder, View_Main, 1, DrawList::MaxSlots - 1, state);
+		CheckStream(recorder, scene, scene.Batches(View_Main, 1, DrawList::MaxSlots - 1));
+
+		// Grid, box and car, the five soldier submeshes unbatched, then the sky. The hidden
+		// debug quad draws nothing.
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_DrawIndexedInstanced) == 9);
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_PipelineState) == 3);
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_VertexBuffer) == 4);
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_IndexBuffer) == 4);
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_PrimitiveTopology) == 1);
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_RootShaderResourceView) == 9);
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_RootConstantBufferView) == 3);
+		CHECK(recorder.GetStats().Issued == 33);
+		CHECK(recorder.GetStats().Filtered == 9 * 7 - 33);
+
+		// The shadow pass: sphere, grid, box and car under one pipeline.
+		recorder.Clear();
+		scene.List.Submit(recorder, View_Shadow, 0, DrawList::MaxSlots - 1, state);
+		CheckStream(recorder, scene, scene.Batches(View_Shadow, 0, DrawList::MaxSlots - 1));
+
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_DrawIndexedInstanced) == 4);
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_PipelineState) == 1);
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_VertexBuffer) == 2);
+		CHECK(recorder.GetCount(MockCommandRecorder::Command_RootConstantBufferView) == 1);
+		CHECK(recorder.GetStats().Issued == 15);
+	}
+}
+
+TEST_CASE(MockCommandRecorder, ShadowsAreDroppedWhenStateIsLost)
+{
+	MockCommandRecorder recorder;
+	VertexBufferBinding vertices = GroupVertices(0);
+
+	recorder.SetGraphicsRootSignature({ 7 });
+	recorder.SetGraphicsRootConstantBufferView(0, 0x1000);
+	recorder.SetVertexBuffer(vertices);
+
+	// A new root signature unbinds the root views but not the buffers.
+	recorder.SetGraphicsRootSignature({ 8 });
+	recorder.SetGraphicsRootConstantBufferView(0, 0x1000);
+	recorder.SetVertexBuffer(vertices);
+	CHECK(recorder.GetCount(MockCommandRecorder::Command_RootConstantBufferView) == 2);
+	CHECK(recorder.GetCount(MockCommandRecorder::Command_VertexBuffer) == 1);
+
+	// Indirect arguments may rebind buffers and root views, but not the pipeline.
+	recorder.SetPipelineState({ 1 });
+	recorder.ExecuteIndirect({ 9 }, 16, { 10 }, 0);
+	recorder.SetPipelineState({ 1 });
+	recorder.SetVertexBuffer(vertices);
+	recorder.SetGraphicsRootConstantBufferView(0, 0x1000);
+	CHECK(recorder.GetCount(MockCommandRecorder::Command_PipelineState) == 1);
+	CHECK(recorder.GetCount(MockCommandRecorder::Command_VertexBuffer) == 2);
+	CHECK(recorder.GetCount(MockCommandRecorder::Command_RootConstantBufferView) == 3);
+
+	// Reset forgets everything; Clear also drops the stream.
+	recorder.Reset();
+	recorder.SetPipelineState({ 1 });
+	CHECK(recorder.GetCount(MockCommandRecorder::Command_PipelineState) == 2);
+
+	recorder.Clear();
+	CHECK(recorder.GetCommands().empty());
+	CHECK(recorder.GetStats().Issued == 0);
+	recorder.SetPipelineState({ 1 });
+	CHECK(recorder.GetCount(MockCommandRecorder::Command_PipelineState) == 1);
+}
+
+TEST_CASE(MockCommandRecorder, DemoFramesDontAllocateAfterWarmup)
+{
+	DemoScene scene;
+	MockCommandRecorder recorder;
+	DrawSubmitState state = scene.SubmitState();
+	ActorView& car = scene.Actors[2];
+	uint64_t written = 0;
+
+	// Every stage Game runs without a device: the car drives around, its slot is flushed to
+	// the instance data, then both views are culled, sorted, batched and submitted.
+	auto frame = [&](int index)
+	{
+		float angle = 0.05f * index;
+		DirectX::XMFLOAT3 center(3.5f * std::cos(angle), 0.5f, 3.5f * std::sin(angle));
+		DirectX::XMFLOAT4X4 world;
+		DirectX::XMStoreFloat4x4(&world, DirectX::XMMatrixTranslation(center.x, center.y, center.z));
+		DirectX::BoundingBox bound(center, DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+		scene.Store.SetTransform(car.Handle, world, bound);
+		scene.Store.MarkDirty(car.Handle, 3);
+		scene.Tree.MoveProxy(car.ProxyId, bound);
+		scene.Cache.Invalidate(car.ProxyId);
+		scene.Store.FlushDirty([&](ActorHandle) { ++written; });
+
+		scene.Frame();
+
+		recorder.Clear();
+		scene.List.Submit(recorder, View_Main, 0, 0, state);
+		scene.List.Submit(recorder, View_Main, 1, DrawList::MaxSlots - 1, state);
+		scene.List.Submit(recorder, View_Shadow, 0, DrawList::MaxSlots - 1, state);
+	};
+
+	// Warm-up sizes the packet, batch and command arrays, and the visibility cache sizes one
+	// view snapshot per frame of its revalidation period.
+	int warmup = (int)scene.Cache.GetRevalidationPeriod() + 1;
+	for (int index = 0; index < warmup; ++index)
+		frame(index);
+
+	uint64_t allocations = Tests::GetAllocationCount();
+	for (int index = warmup; index < warmup + 60; ++index)
+		frame(index);
+	CHECK(Tests::GetAllocationCount() == allocations);
+
+	CHECK(written == (uint64_t)warmup + 60);
+	CHECK(recorder.GetCount(MockCommandRecorder::Command_DrawIndexedInstanced) == 1 + 9 + 4);
+}
@@ -0,0 +1,140 @@
+#include <vector>
+#include "DX12Lib/OcclusionCuller.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	// Clip space position of a screen point for an identity view-projection. The points used
+	// here are chosen so the round trip back to screen space is exact.
+	DirectX::XMFLOAT3 FromScreen(float x, float y, float z)
+	{
+		return DirectX::XMFLOAT3(x / OcclusionCuller::Width * 2.0f - 1.0f, 1.0f - y / OcclusionCuller::Height * 2.0f, z);
+	}
+
+	size_t CoveredPixels(const OcclusionCuller& culler)
+	{
+		size_t covered = 0;
+		for (int i = 0; i < OcclusionCuller::Width * OcclusionCuller::Height; ++i)
+			covered += culler.GetDepth()[i] < 1.0f ? 1 : 0;
+		return covered;
+	}
+
+	size_t Rasterize(OcclusionCuller& culler, const std::vector<DirectX::XMFLOAT3>& triangles)
+	{
+		culler.BeginFrame(DirectX::XMMatrixIdentity());
+		culler.AddOccluder(triangles.data(), (uint32_t)triangles.size() / 3, DirectX::XMMatrixIdentity());
+		culler.Render();
+		return CoveredPixels(culler);
+	}
+
+	// A camera at the origin looking down +Z, and a wall across the view at z = 20.
+	DirectX::XMMATRIX CameraViewProj()
+	{
+		return DirectX::XMMatrixPerspectiveFovLH(0.8f, 16.0f / 9.0f, 0.5f, 200.0f);
+	}
+
+	std::vector<DirectX::XMFLOAT3> Wall(float halfWidth, float height, float z)
+	{
+		DirectX::XMFLOAT3 a(-halfWidth, -height, z), b(halfWidth, -height, z), c(halfWidth, height, z), d(-halfWidth, height, z);
+		return { a, b, c, a, c, d };
+	}
+}
+
+TEST_CASE(OcclusionCuller, SharedEdgesCoverEveryPixelOnce)
+{
+	JobSystem jobs(2);
+	OcclusionCuller culler(jobs);
+
+	// A 12 x 9 pixel rectangle with its corners and diagonal on pixel centers. The diagonal
+	// passes exactly through two pixel centers, which must go to one triangle only.
+	DirectX::XMFLOAT3 a = FromScreen(10.5f, 4.5f, 0.5f);
+	DirectX::XMFLOAT3 b = FromScreen(22.5f, 4.5f, 0.5f);
+	DirectX::XMFLOAT3 c = FromScreen(22.5f, 13.5f, 0.5f);
+	DirectX::XMFLOAT3 d = FromScreen(10.5f, 13.5f, 0.5f);
+
+	size_t first = Rasterize(culler, { a, b, c });
+	size_t second = Rasterize(culler, { a, c, d });
+	size_t both = Rasterize(culler, { a, b, c, a, c, d });
+
+	// Centers on the left and top edges are in, those on the right and bottom edges are out.
+	CHECK(both == 12 * 9);
+	CHECK(first + second == both);
+
+	// Winding does not matter.
+	CHECK(Rasterize(culler, { a, c, b, a, d, c }) == both);
+}
+
+TEST_CASE(OcclusionCuller, IndexedAndUnindexedOccludersMatch)
+{
+	JobSystem jobs(2);
+	OcclusionCuller culler(jobs);
+	DirectX::XMMATRIX world = DirectX::XMMatrixRotationY(0.3f);
+
+	const DirectX::XMFLOAT3 positions[4] = { { -6.0f, -3.0f, 20.0f }, { 6.0f, -3.0f, 20.0f }, { 6.0f, 3.0f, 25.0f }, { -6.0f, 3.0f, 25.0f } };
+	const uint16_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+	std::vector<DirectX::XMFLOAT3> triangles;
+	for (uint16_t index : indices)
+		triangles.push_back(positions[index]);
+
+	culler.BeginFrame(CameraViewProj());
+	culler.AddOccluder(positions, sizeof(DirectX::XMFLOAT3), indices, 6, 0, world);
+	culler.Render();
+	std::vector<float> indexed(culler.GetDepth(), culler.GetDepth() + OcclusionCuller::Width * OcclusionCuller::Height);
+
+	culler.BeginFrame(CameraViewProj());
+	culler.AddOccluder(triangles.data(), 2, world);
+	culler.Render();
+
+	CHECK(CoveredPixels(culler) > 0);
+	CHECK(std::vector<float>(culler.GetDepth(), culler.GetDepth() + OcclusionCuller::Width * OcclusionCuller::Height) == indexed);
+}
+
+TEST_CASE(OcclusionCuller, SameDepthOnAnyThreadCount)
+{
+	Tests::Random random(1);
+	std::vector<DirectX::XMFLOAT3> triangles;
+	for (int i = 0; i < 3 * 400; ++i)
+		triangles.push_back(DirectX::XMFLOAT3(random.Float(-40.0f, 40.0f), random.Float(-20.0f, 20.0f), random.Float(5.0f, 150.0f)));
+
+	std::vector<float> depths[2];
+	unsigned workerCounts[2] = { 0, 3 };
+	for (int run = 0; run < 2; ++run)
+	{
+		JobSystem jobs(workerCounts[run]);
+		OcclusionCuller culler(jobs);
+		culler.BeginFrame(CameraViewProj());
+		culler.AddOccluder(triangles.data(), (uint32_t)triangles.size() / 3, DirectX::XMMatrixIdentity());
+		culler.Render();
+		depths[run].assign(culler.GetDepth(), culler.GetDepth() + OcclusionCuller::Width * OcclusionCuller::Height);
+	}
+
+	CHECK(depths[0] == depths[1]);
+}
+
+TEST_CASE(OcclusionCuller, WallHidesOnlyWhatIsBehindIt)
+{
+	JobSystem jobs(2);
+	OcclusionCuller culler(jobs);
+
+	std::vector<DirectX::XMFLOAT3> wall = Wall(10.0f, 5.0f, 20.0f);
+	culler.BeginFrame(CameraViewProj());
+	culler.AddOccluder(wall.data(), 2, DirectX::XMMatrixIdentity());
+	culler.Render();
+
+	DirectX::XMFLOAT3 unit(1.0f, 1.0f, 1.0f);
+	CHECK(!culler.IsVisible(DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 40.0f), unit)));
+	CHECK(!culler.IsVisible(DirectX::BoundingBox(DirectX::XMFLOAT3(4.0f, -2.0f, 100.0f), DirectX::XMFLOAT3(3.0f, 2.0f, 3.0f))));
+
+	// In front of the wall, sticking out above it, beside it, and across the near plane.
+	CHECK(culler.IsVisible(DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 10.0f), unit)));
+	CHECK(culler.IsVisible(DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 10.0f, 40.0f), unit)));
+	CHECK(culler.IsVisible(DirectX::BoundingBox(DirectX::XMFLOAT3(30.0f, 0.0f, 40.0f), unit)));
+	CHECK(culler.IsVisible(DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), unit)));
+
+	// Nothing rendered, nothing hidden.
+	culler.BeginFrame(CameraViewProj());
+	culler.Render();
+	CHECK(culler.IsVisible(DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 40.0f), unit)));
+}
@@ -0,0 +1,252 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "DX12Lib/Pvs.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	// A maze of two rooms along x, split by a wall at x = 0 with a doorway at |z| < 2. The
+	// walls reach far above and below the grid, so nothing is seen over or under them.
+	struct Maze
+	{
+		static const uint32_t WallSouth = 0;
+		static const uint32_t WallNorth = 1;
+		static const uint32_t LeftBox = 2;
+		static const uint32_t DoorwayBox = 3;
+
+		std::vector<PvsTarget> Targets;
+		PvsBakeSettings Settings;
+
+		Maze()
+		{
+			Add(DirectX::XMFLOAT3(0.0f, 2.0f, -11.0f), DirectX::XMFLOAT3(0.5f, 12.0f, 9.0f));
+			Add(DirectX::XMFLOAT3(0.0f, 2.0f, 11.0f), DirectX::XMFLOAT3(0.5f, 12.0f, 9.0f));
+			Add(DirectX::XMFLOAT3(-18.0f, 2.0f, -8.0f), DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f));
+			Add(DirectX::XMFLOAT3(18.0f, 2.0f, 0.0f), DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+			// Cells of 4 units, 10 along x, 1 along y and 5 along z; the doorway is the
+			// middle row.
+			Settings.Region = DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 2.0f, 0.0f), DirectX::XMFLOAT3(20.0f, 2.0f, 10.0f));
+			Settings.CellSize = 4.0f;
+			Settings.SamplesPerCell = 8;
+			Settings.RaysPerTarget = 8;
+		}
+
+		void Add(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents)
+		{
+			PvsTarget target;
+			target.Bound = DirectX::BoundingBox(center, extents);
+			target.UserData = reinterpret_cast<void*>(Targets.size() + 1);
+			target.Key = PvsTarget::MakeKey(Targets.size(), 0, target.Bound);
+			Targets.push_back(target);
+		}
+
+		// Closest hit against the solid target boxes.
+		void Trace(const RayDesc* rays, size_t count, RayHit* hits) const
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				DirectX::XMVECTOR origin = DirectX::XMLoadFloat3(&rays[i].Origin);
+				DirectX::XMVECTOR direction = DirectX::XMLoadFloat3(&rays[i].Direction);
+				float length = DirectX::XMVectorGetX(DirectX::XMVector3Length(direction));
+				direction = DirectX::XMVectorScale(direction, 1.0f / length);
+
+				hits[i] = RayHit();
+				for (const PvsTarget& target : Targets)
+				{
+					float dist;
+					if (target.Bound.Intersects(origin, direction, dist) && dist / length <= rays[i].MaxDistance && dist / length < hits[i].Distance)
+					{
+						hits[i].UserData = target.UserData;
+						hits[i].Distance = dist / length;
+					}
+				}
+			}
+		}
+
+		PvsData Bake(JobSystem& jobs) const
+		{
+			return PvsBaker::Bake(Targets, Settings, [this](const RayDesc* rays, size_t count, RayHit* hits)
+			{
+				Trace(rays, count, hits);
+			}, jobs);
+		}
+	};
+
+	bool Sees(const PvsData& pvs, const DirectX::XMFLOAT3& position, uint32_t target)
+	{
+		int cell = pvs.FindCell(position);
+		CHECK(cell >= 0);
+		if (cell < 0)
+			return false;
+
+		std::vector<uint8_t> bits;
+		pvs.DecompressCell((uint32_t)cell, bits);
+		return PvsData::TestBit(bits, target);
+	}
+
+	std::vector<std::vector<uint8_t>> DecompressAll(const PvsData& pvs)
+	{
+		std::vector<std::vector<uint8_t>> cells(pvs.GetCellCount());
+		for (uint32_t cell = 0; cell < pvs.GetCellCount(); ++cell)
+			pvs.DecompressCell(cell, cells[cell]);
+		return cells;
+	}
+}
+
+TEST_CASE(Pvs, MazeWallsHideTheOtherRoom)
+{
+	JobSystem jobs(2);
+	Maze maze;
+	PvsData pvs = maze.Bake(jobs);
+
+	REQUIRE(pvs.GetCellCount() == 10 * 1 * 5);
+	CHECK(pvs.GetTargetCount() == maze.Targets.size());
+	CHECK(pvs.MatchesGrid(maze.Settings));
+
+	// The left room, away from the cells the wall passes through, always sees the box in it.
+	for (float x = -18.0f; x < -4.0f; x += 4.0f)
+	{
+		for (float z = -8.0f; z < 10.0f; z += 4.0f)
+			CHECK(Sees(pvs, DirectX::XMFLOAT3(x, 2.0f, z), Maze::LeftBox));
+	}
+
+	// Every line from the cell across from the doorway to the center of the box behind it
+	// passes through the doorway, so the first ray of every sample gets there.
+	CHECK(Sees(pvs, DirectX::XMFLOAT3(-10.0f, 2.0f, 0.0f), Maze::DoorwayBox));
+	CHECK(Sees(pvs, DirectX::XMFLOAT3(-10.0f, 2.0f, 0.0f), Maze::WallNorth));
+	CHECK(Sees(pvs, DirectX::XMFLOAT3(-10.0f, 2.0f, 0.0f), Maze::WallSouth));
+
+	// From the far corners the wall covers the whole box, no ray can reach it.
+	CHECK(!Sees(pvs, DirectX::XMFLOAT3(-18.0f, 2.0f, 8.0f), Maze::DoorwayBox));
+	CHECK(!Sees(pvs, DirectX::XMFLOAT3(-18.0f, 2.0f, -8.0f), Maze::DoorwayBox));
+
+	// Outside the grid there is no cell to ask.
+	CHECK(pvs.FindCell(DirectX::XMFLOAT3(-20.5f, 2.0f, 0.0f)) == -1);
+	CHECK(pvs.FindCell(DirectX::XMFLOAT3(0.0f, 4.5f, 0.0f)) == -1);
+	CHECK(pvs.FindCell(DirectX::XMFLOAT3(0.0f, 2.0f, 10.0f)) == -1);
+	CHECK(pvs.FindCell(DirectX::XMFLOAT3(-20.0f, 0.0f, -10.0f)) == 0);
+}
+
+TEST_CASE(Pvs, BakeIgnoresTheWorkerCount)
+{
+	Maze maze;
+
+	JobSystem serial(0);
+	JobSystem parallel(3);
+	PvsData a = maze.Bake(serial);
+	PvsData b = maze.Bake(parallel);
+
+	CHECK(a.GetDataSize() == b.GetDataSize());
+	CHECK(DecompressAll(a) == DecompressAll(b));
+}
+
+TEST_CASE(Pvs, SaveLoadRoundTrip)
+{
+	const char* filename = "PvsTests.pvs";
+
+	JobSystem jobs(2);
+	Maze maze;
+	PvsData baked = maze.Bake(jobs);
+	REQUIRE(baked.Save(filename));
+
+	PvsData loaded;
+	REQUIRE(loaded.Load(filename));
+	CHECK(loaded.MatchesGrid(maze.Settings));
+	CHECK(loaded.GetTargetKeys() == baked.GetTargetKeys());
+	CHECK(loaded.GetDataSize() == baked.GetDataSize());
+	CHECK(DecompressAll(loaded) == DecompressAll(baked));
+
+	// Another grid or a moved target no longer matches.
+	PvsBakeSettings finer = maze.Settings;
+	finer.CellSize = 2.0f;
+	CHECK(!loaded.MatchesGrid(finer));
+
+	DirectX::BoundingBox moved = maze.Targets[Maze::LeftBox].Bound;
+	moved.Center.x += 0.5f;
+	CHECK(PvsTarget::MakeKey(Maze::LeftBox, 0, moved) != loaded.GetTargetKeys()[Maze::LeftBox]);
+
+	// A truncated file or another version is refused and leaves the data empty.
+	std::vector<char> bytes;
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+	}
+
+	std::ofstream(filename, std::ios::binary).write(bytes.data(), bytes.size() - 1);
+	CHECK(!loaded.Load(filename));
+	CHECK(loaded.GetCellCount() == 0 && loaded.GetTargetCount() == 0);
+
+	bytes[4] = (char)(PvsData::Version + 1);
+	std::ofstream(filename, std::ios::binary).write(bytes.data(), bytes.size());
+	CHECK(!loaded.Load(filename));
+
+	std::remove(filename);
+}
+
+TEST_CASE(Pvs, CompressedCellsDecodeExactly)
+{
+	const char* filename = "PvsTests.pvs";
+
+	// More than 255 zero bytes in a row, so runs have to be split, and a target count that
+	// leaves the last byte partly used.
+	const uint32_t targetCount = 2999;
+	const size_t byteCount = (targetCount + 7) / 8;
+
+	Tests::Random random(5);
+	std::vector<std::vector<uint8_t>> cells;
+	cells.push_back(std::vector<uint8_t>(byteCount, 0));
+	cells.push_back(std::vector<uint8_t>(byteCount, 0xFF));
+	for (int density : { 1, 20, 200 })
+	{
+		std::vector<uint8_t> bits(byteCount, 0);
+		for (uint32_t t = 0; t < targetCount; ++t)
+		{
+			if (random.Uint(0, 999) < (uint32_t)density)
+				bits[t >> 3] |= 1u << (t & 7);
+		}
+		cells.push_back(bits);
+	}
+	cells[1].back() = 0x7F;
+
+	// Written by hand with the documented layout: a 5 x 1 x 1 grid of unit cells.
+	std::vector<uint32_t> offsets = { 0 };
+	std::vector<uint8_t> data;
+	for (const auto& bits : cells)
+	{
+		PvsData::Compress(bits.data(), bits.size(), data);
+		offsets.push_back((uint32_t)data.size());
+	}
+	CHECK(data.size() < 4 * byteCount);
+
+	std::vector<uint64_t> keys(targetCount);
+	for (uint32_t t = 0; t < targetCount; ++t)
+		keys[t] = t * 31ull;
+
+	{
+		uint32_t header[] = { PvsData::Magic, PvsData::Version };
+		float grid[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		uint32_t counts[] = { (uint32_t)cells.size(), 1, 1, targetCount, (uint32_t)data.size() };
+
+		std::ofstream fout(filename, std::ios::binary);
+		fout.write(reinterpret_cast<const char*>(header), sizeof(header));
+		fout.write(reinterpret_cast<const char*>(grid), sizeof(grid));
+		fout.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+		fout.write(reinterpret_cast<const char*>(keys.data()), keys.size() * sizeof(uint64_t));
+		fout.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+		fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+
+	PvsData pvs;
+	REQUIRE(pvs.Load(filename));
+	std::remove(filename);
+
+	CHECK(pvs.GetTargetKeys() == keys);
+	REQUIRE(pvs.GetCellCount() == cells.size());
+	CHECK(DecompressAll(pvs) == cells);
+	CHECK(pvs.FindCell(DirectX::XMFLOAT3(3.5f, 0.5f, 0.5f)) == 3);
+}
@@ -0,0 +1,192 @@
+#include <cmath>
+#include <vector>
+#include "DX12Lib/RayQuery.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	// One mesh placed several times, rotated, scaled and moved, each instance with a layer of
+	// its own.
+	struct Scene
+	{
+		std::vector<DirectX::XMFLOAT3> Positions;
+		std::vector<uint32_t> Indices;
+		TriangleBVH Mesh;
+
+		std::vector<RayTarget> Targets;
+		SceneBVH Tree;
+
+		explicit Scene(Tests::Random& random)
+		{
+			for (uint32_t i = 0; i < 200; ++i)
+			{
+				DirectX::XMFLOAT3 center(random.Float(-4.0f, 4.0f), random.Float(-4.0f, 4.0f), random.Float(-4.0f, 4.0f));
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					Indices.push_back((uint32_t)Positions.size());
+					Positions.push_back(DirectX::XMFLOAT3(center.x + random.Float(-1.5f, 1.5f), center.y + random.Float(-1.5f, 1.5f), center.z + random.Float(-1.5f, 1.5f)));
+				}
+			}
+			Mesh.Build(Positions.data(), sizeof(DirectX::XMFLOAT3), Indices.data(), (uint32_t)Indices.size());
+
+			const uint32_t instanceCount = 12;
+			Targets.resize(instanceCount);
+			for (uint32_t i = 0; i < instanceCount; ++i)
+			{
+				DirectX::XMMATRIX world = DirectX::XMMatrixMultiply(
+					DirectX::XMMatrixMultiply(DirectX::XMMatrixScaling(random.Float(0.5f, 2.0f), random.Float(0.5f, 2.0f), random.Float(0.5f, 2.0f)), DirectX::XMMatrixRotationY(random.Float(0.0f, 6.0f))),
+					DirectX::XMMatrixTranslation(random.Float(-20.0f, 20.0f), random.Float(-5.0f, 5.0f), random.Float(-20.0f, 20.0f)));
+
+				RayTarget& target = Targets[i];
+				target.Mesh = &Mesh;
+				target.Layers = 1u << (i % 3);
+				DirectX::XMStoreFloat4x4(&target.WorldToLocal, DirectX::XMMatrixInverse(nullptr, world));
+
+				DirectX::BoundingBox bound;
+				Mesh.GetBound().Transform(bound, world);
+				Tree.CreateProxy(bound, ToUserData(i));
+			}
+			Tree.Rebuild();
+		}
+
+		static void* ToUserData(size_t index) { return reinterpret_cast<void*>(index + 1); }
+		static size_t FromUserData(void* userData) { return reinterpret_cast<size_t>(userData) - 1; }
+
+		RayQuery::ResolveTarget Resolver() const
+		{
+			return [this](void* userData, RayTarget& target)
+			{
+				target = Targets[FromUserData(userData)];
+				return true;
+			};
+		}
+
+		// Every instance in turn, without the scene tree or packets.
+		RayHit Reference(const RayDesc& ray) const
+		{
+			RayHit closest;
+			for (size_t i = 0; i < Targets.size(); ++i)
+			{
+				if ((ray.LayerMask & Targets[i].Layers) == 0)
+					continue;
+
+				DirectX::XMMATRIX toLocal = DirectX::XMLoadFloat4x4(&Targets[i].WorldToLocal);
+				DirectX::XMVECTOR origin = DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&ray.Origin), toLocal);
+				DirectX::XMVECTOR direction = DirectX::XMVector3TransformNormal(DirectX::XMLoadFloat3(&ray.Direction), toLocal);
+
+				float t;
+				uint32_t triangle;
+				float maxDistance = closest.Distance < ray.MaxDistance ? closest.Distance : ray.MaxDistance;
+				if (Mesh.Intersect(origin, direction, t, triangle, maxDistance))
+				{
+					closest.UserData = ToUserData(i);
+					closest.Distance = t;
+					closest.TriangleIndex = triangle;
+				}
+			}
+			return closest;
+		}
+	};
+
+	std::vector<RayDesc> RandomRays(Tests::Random& random, size_t count)
+	{
+		std::vector<RayDesc> rays(count);
+		for (RayDesc& ray : rays)
+		{
+			ray.Origin = DirectX::XMFLOAT3(random.Float(-30.0f, 30.0f), random.Float(-10.0f, 10.0f), random.Float(-30.0f, 30.0f));
+			DirectX::XMFLOAT3 target(random.Float(-20.0f, 20.0f), random.Float(-5.0f, 5.0f), random.Float(-20.0f, 20.0f));
+
+			// Unnormalized, so distances are in units of the direction's length.
+			float scale = random.Float(0.05f, 0.2f);
+			ray.Direction = DirectX::XMFLOAT3((target.x - ray.Origin.x) * scale, (target.y - ray.Origin.y) * scale, (target.z - ray.Origin.z) * scale);
+
+			uint32_t kind = random.Uint(0, 3);
+			ray.MaxDistance = kind == 0 ? random.Float(2.0f, 8.0f) : FLT_MAX;
+			ray.LayerMask = kind == 1 ? 1u << random.Uint(0, 2) : ~0u;
+		}
+		return rays;
+	}
+
+	void CheckHits(const Scene& scene, const std::vector<RayDesc>& rays, const std::vector<RayHit>& hits)
+	{
+		int hitCount = 0;
+		for (size_t i = 0; i < rays.size(); ++i)
+		{
+			RayHit expected = scene.Reference(rays[i]);
+
+			CHECK(hits[i].IsHit() == expected.IsHit());
+			if (hits[i].IsHit() && expected.IsHit())
+			{
+				CHECK(hits[i].UserData == expected.UserData);
+				CHECK(hits[i].TriangleIndex == expected.TriangleIndex);
+				CHECK(std::fabs(hits[i].Distance - expected.Distance) <= 1e-4f * expected.Distance);
+				CHECK((rays[i].LayerMask & scene.Targets[Scene::FromUserData(hits[i].UserData)].Layers) != 0);
+				++hitCount;
+			}
+		}
+
+		CHECK(hitCount > (int)rays.size() / 10);
+	}
+}
+
+TEST_CASE(RayQuery, TraceMatchesEveryInstanceInTurn)
+{
+	Tests::Random random(1);
+	Scene scene(random);
+	RayQuery query(scene.Tree, scene.Resolver());
+
+	// Not a multiple of the packet size, the last packet is partly empty.
+	std::vector<RayDesc> rays = RandomRays(random, 2003);
+	std::vector<RayHit> hits(rays.size());
+	query.Trace(rays.data(), rays.size(), hits.data());
+
+	CheckHits(scene, rays, hits);
+}
+
+TEST_CASE(RayQuery, UnresolvedProxiesAreNeverHit)
+{
+	Tests::Random random(2);
+	Scene scene(random);
+
+	// The instances on layer bit 2 are left out by the resolver instead of the ray mask.
+	RayQuery query(scene.Tree, [&scene](void* userData, RayTarget& target)
+	{
+		target = scene.Targets[Scene::FromUserData(userData)];
+		return target.Layers != 4u;
+	});
+
+	std::vector<RayDesc> rays = RandomRays(random, 1000);
+	for (RayDesc& ray : rays)
+		ray.LayerMask = ~0u;
+
+	std::vector<RayHit> hits(rays.size());
+	query.Trace(rays.data(), rays.size(), hits.data());
+
+	// The same as masking those instances out of every ray.
+	for (RayDesc& ray : rays)
+		ray.LayerMask = 3u;
+	CheckHits(scene, rays, hits);
+}
+
+TEST_CASE(RayQuery, TraceAsyncMatchesTrace)
+{
+	Tests::Random random(3);
+	Scene scene(random);
+	RayQuery query(scene.Tree, scene.Resolver());
+	JobSystem jobs(2);
+
+	std::vector<RayDesc> rays = RandomRays(random, 500);
+	std::vector<RayHit> hits(rays.size());
+	query.Trace(rays.data(), rays.size(), hits.data());
+
+	std::vector<RayHit> asyncHits = query.TraceAsync(jobs, rays).get();
+	REQUIRE(asyncHits.size() == hits.size());
+	for (size_t i = 0; i < hits.size(); ++i)
+	{
+		CHECK(asyncHits[i].UserData == hits[i].UserData);
+		CHECK(asyncHits[i].Distance == hits[i].Distance);
+		CHECK(asyncHits[i].TriangleIndex == hits[i].TriangleIndex);
+	}
+}
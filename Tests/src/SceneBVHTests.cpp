@@ -0,0 +1,205 @@
+#include <vector>
+#include "DX12Lib/SceneBVH.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	struct Scene
+	{
+		std::vector<DirectX::BoundingBox> Bounds;
+		std::vector<int> Proxies;
+		std::vector<bool> Alive;
+		SceneBVH Tree;
+
+		Scene(size_t count, Tests::Random& random)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				Bounds.push_back(RandomBox(random));
+				Proxies.push_back(Tree.CreateProxy(Bounds.back(), ToUserData(i)));
+				Alive.push_back(true);
+			}
+		}
+
+		static DirectX::BoundingBox RandomBox(Tests::Random& random)
+		{
+			DirectX::XMFLOAT3 center(random.Float(-100.0f, 100.0f), random.Float(-20.0f, 20.0f), random.Float(-100.0f, 100.0f));
+			DirectX::XMFLOAT3 extents(random.Float(0.1f, 3.0f), random.Float(0.1f, 3.0f), random.Float(0.1f, 3.0f));
+			return DirectX::BoundingBox(center, extents);
+		}
+
+		static void* ToUserData(size_t index) { return reinterpret_cast<void*>(index + 1); }
+		static size_t FromUserData(void* userData) { return reinterpret_cast<size_t>(userData) - 1; }
+	};
+
+	std::vector<FrustumPlanes> MakeViews()
+	{
+		DirectX::XMVECTOR eye = DirectX::XMVectorSet(-20.0f, 10.0f, -90.0f, 1.0f);
+		DirectX::XMMATRIX view = DirectX::XMMatrixLookToLH(eye, DirectX::XMVectorSet(0.3f, -0.1f, 1.0f, 0.0f), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(0.8f, 1.6f, 1.0f, 150.0f);
+
+		DirectX::XMMATRIX lightView = DirectX::XMMatrixLookAtLH(DirectX::XMVectorSet(50.0f, 80.0f, 50.0f, 1.0f), DirectX::XMVectorZero(), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		DirectX::XMMATRIX lightProj = DirectX::XMMatrixOrthographicOffCenterLH(-40.0f, 40.0f, -40.0f, 40.0f, 0.0f, 200.0f);
+
+		return {
+			FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(view, proj)),
+			FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(lightView, lightProj)),
+			FrustumPlanes::FromBox(DirectX::BoundingBox(DirectX::XMFLOAT3(30.0f, 0.0f, 30.0f), DirectX::XMFLOAT3(25.0f, 25.0f, 25.0f))),
+		};
+	}
+
+	// Every live proxy whose exact bound touches a view is reported once with that view's bit,
+	// and the bits only claim what the fattened leaf bound supports.
+	void CheckQueryViews(Scene& scene, const std::vector<FrustumPlanes>& views)
+	{
+		std::vector<int> reported(scene.Bounds.size(), 0);
+		std::vector<uint32_t> masks(scene.Bounds.size(), 0);
+
+		scene.Tree.QueryViews(views.data(), (int)views.size(), [&](void* userData, uint32_t intersectMask, uint32_t insideMask)
+		{
+			size_t i = Scene::FromUserData(userData);
+			++reported[i];
+			masks[i] = intersectMask | insideMask;
+			CHECK((intersectMask & insideMask) == 0);
+
+			DirectX::BoundingBox fat = scene.Tree.GetFatBound(scene.Proxies[i]);
+			for (int v = 0; v < (int)views.size(); ++v)
+			{
+				DirectX::ContainmentType fatResult = ClassifyBox(views[v], fat.Center, fat.Extents);
+				if (insideMask & (1u << v))
+					CHECK(fatResult == DirectX::CONTAINS);
+				if (intersectMask & (1u << v))
+					CHECK(fatResult != DirectX::DISJOINT);
+			}
+		});
+
+		for (size_t i = 0; i < scene.Bounds.size(); ++i)
+		{
+			if (!scene.Alive[i])
+			{
+				CHECK(reported[i] == 0);
+				continue;
+			}
+
+			CHECK(reported[i] <= 1);
+			for (int v = 0; v < (int)views.size(); ++v)
+			{
+				const DirectX::BoundingBox& box = scene.Bounds[i];
+				if (ClassifyBox(views[v], box.Center, box.Extents) != DirectX::DISJOINT)
+					CHECK(masks[i] & (1u << v));
+			}
+		}
+	}
+}
+
+TEST_CASE(SceneBVH, QueryViewsReportsEveryVisibleProxy)
+{
+	Tests::Random random(1);
+	Scene scene(3000, random);
+	CheckQueryViews(scene, MakeViews());
+
+	scene.Tree.Rebuild();
+	CHECK(scene.Tree.GetProxyCount() == 3000);
+	CheckQueryViews(scene, MakeViews());
+}
+
+TEST_CASE(SceneBVH, MovesAndDestroysKeepQueriesExact)
+{
+	Tests::Random random(2);
+	Scene scene(2000, random);
+	scene.Tree.Rebuild();
+
+	for (int round = 0; round < 4; ++round)
+	{
+		for (size_t i = 0; i < scene.Bounds.size(); ++i)
+		{
+			if (!scene.Alive[i] || random.Uint(0, 3) != 0)
+				continue;
+
+			// Mostly small steps that stay inside the fattened leaf, some jumps across the scene.
+			DirectX::BoundingBox& box = scene.Bounds[i];
+			if (random.Uint(0, 4) == 0)
+			{
+				box = Scene::RandomBox(random);
+			}
+			else
+			{
+				box.Center.x += random.Float(-0.05f, 0.05f);
+				box.Center.z += random.Float(-0.05f, 0.05f);
+			}
+			scene.Tree.MoveProxy(scene.Proxies[i], box);
+		}
+
+		for (int k = 0; k < 50; ++k)
+		{
+			size_t i = random.Uint(0, (uint32_t)scene.Bounds.size() - 1);
+			if (scene.Alive[i])
+			{
+				scene.Tree.DestroyProxy(scene.Proxies[i]);
+				scene.Alive[i] = false;
+			}
+		}
+
+		CheckQueryViews(scene, MakeViews());
+	}
+
+	int alive = 0;
+	for (bool a : scene.Alive)
+		alive += a ? 1 : 0;
+	CHECK(scene.Tree.GetProxyCount() == alive);
+}
+
+TEST_CASE(SceneBVH, QueryFrustumMatchesLinearLoop)
+{
+	Tests::Random random(3);
+	Scene scene(3000, random);
+
+	DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(0.8f, 1.6f, 1.0f, 150.0f);
+	DirectX::BoundingFrustum frustum;
+	DirectX::BoundingFrustum(proj).Transform(frustum, DirectX::XMMatrixTranslation(0.0f, 0.0f, -120.0f));
+
+	std::vector<int> reported(scene.Bounds.size(), 0);
+	scene.Tree.QueryFrustum(frustum, [&](void* userData, bool)
+	{
+		++reported[Scene::FromUserData(userData)];
+	});
+
+	// The loop the tree replaced tested every actor bound; the tree must find at least those.
+	for (size_t i = 0; i < scene.Bounds.size(); ++i)
+	{
+		CHECK(reported[i] <= 1);
+		if (frustum.Contains(scene.Bounds[i]) != DirectX::DISJOINT)
+			CHECK(reported[i] == 1);
+	}
+}
+
+TEST_CASE(SceneBVH, QueryRayFindsEveryHitBox)
+{
+	Tests::Random random(4);
+	Scene scene(2000, random);
+	scene.Tree.Rebuild();
+
+	for (int ray = 0; ray < 200; ++ray)
+	{
+		DirectX::XMVECTOR origin = DirectX::XMVectorSet(random.Float(-120.0f, 120.0f), random.Float(-30.0f, 30.0f), random.Float(-120.0f, 120.0f), 1.0f);
+		DirectX::XMVECTOR direction = DirectX::XMVector3Normalize(DirectX::XMVectorSet(random.Float(-1.0f, 1.0f), random.Float(-0.3f, 0.3f), random.Float(-1.0f, 1.0f), 0.0f));
+		const float maxDist = 150.0f;
+
+		std::vector<int> reported(scene.Bounds.size(), 0);
+		scene.Tree.QueryRay(origin, direction, maxDist, [&](void* userData, float)
+		{
+			++reported[Scene::FromUserData(userData)];
+		});
+
+		for (size_t i = 0; i < scene.Bounds.size(); ++i)
+		{
+			CHECK(reported[i] <= 1);
+
+			float dist;
+			if (scene.Bounds[i].Intersects(origin, direction, dist) && dist <= maxDist)
+				CHECK(reported[i] == 1);
+		}
+	}
+}
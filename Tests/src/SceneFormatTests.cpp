@@ -0,0 +1,201 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <vector>
+#include "DX12Lib/SceneFormat.h"
+#include "DX12Lib/StringTable.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	const float CellSize = 32.0f;
+
+	std::vector<SceneActorDesc> RandomActors(size_t count, Tests::Random& random)
+	{
+		// Names outside ASCII, one of them outside the basic plane, so the UTF-16 path matters.
+		const std::wstring prefixes[] = { L"crate", L"Stra\u00DFe", L"\u6728", L"smile\U0001F600" };
+
+		std::vector<SceneActorDesc> actors(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			SceneActorDesc& actor = actors[i];
+			actor.Name = prefixes[i % 4] + std::to_wstring(i);
+			actor.MeshGroup = L"group" + std::to_wstring(i % 5);
+			actor.DrawArg = L"mesh" + std::to_wstring(i % 7);
+			actor.Material = L"material" + std::to_wstring(i % 3);
+			actor.RenderLayer = 1u << (i % 4);
+			actor.Flags = (uint32_t)i & 3;
+
+			DirectX::XMFLOAT3 center(random.Float(-100.0f, 100.0f), random.Float(0.0f, 10.0f), random.Float(-100.0f, 100.0f));
+			DirectX::XMStoreFloat4x4(&actor.World, DirectX::XMMatrixTranslation(center.x, center.y, center.z));
+			DirectX::XMStoreFloat4x4(&actor.TexTransform, DirectX::XMMatrixScaling(random.Float(1.0f, 4.0f), random.Float(1.0f, 4.0f), 1.0f));
+			actor.Bound = DirectX::BoundingBox(center, DirectX::XMFLOAT3(random.Float(0.5f, 8.0f), random.Float(0.5f, 8.0f), random.Float(0.5f, 8.0f)));
+		}
+		return actors;
+	}
+
+	struct SceneFile
+	{
+		SceneFileHeader Header;
+		std::vector<SceneCellEntry> Entries;
+		std::vector<std::vector<uint8_t>> Blobs;
+
+		// The same reads the streamer makes: the header, the cell table, then one blob per cell.
+		bool Read(const std::string& filename)
+		{
+			std::ifstream fin(filename, std::ios::binary);
+			std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+			if (bytes.size() < sizeof(Header))
+				return false;
+
+			memcpy(&Header, bytes.data(), sizeof(Header));
+			Entries.resize(Header.CellCount);
+			memcpy(Entries.data(), bytes.data() + sizeof(Header), Entries.size() * sizeof(SceneCellEntry));
+
+			for (const SceneCellEntry& entry : Entries)
+			{
+				if (entry.Offset + entry.Size > bytes.size())
+					return false;
+				Blobs.emplace_back(bytes.begin() + entry.Offset, bytes.begin() + entry.Offset + entry.Size);
+			}
+			return true;
+		}
+	};
+
+	// Merged bounds go through center and extents, so their faces may round inward a little.
+	bool Covers(const DirectX::BoundingBox& outer, const DirectX::BoundingBox& inner)
+	{
+		const float slack = 1e-4f;
+		return std::fabs(inner.Center.x - outer.Center.x) + inner.Extents.x <= outer.Extents.x + slack
+			&& std::fabs(inner.Center.y - outer.Center.y) + inner.Extents.y <= outer.Extents.y + slack
+			&& std::fabs(inner.Center.z - outer.Center.z) + inner.Extents.z <= outer.Extents.z + slack;
+	}
+
+	bool Fixup(std::vector<uint8_t> blob)
+	{
+		SceneCellView view;
+		return FixupSceneCell(blob.data(), blob.size(), view);
+	}
+
+	template<typename T>
+	void Patch(std::vector<uint8_t>& blob, size_t offset, T value)
+	{
+		memcpy(blob.data() + offset, &value, sizeof(value));
+	}
+}
+
+TEST_CASE(SceneFormat, WriteAndFixupRoundTrip)
+{
+	const char* filename = "SceneFormatTests.scene";
+
+	Tests::Random random(1);
+	std::vector<SceneActorDesc> actors = RandomActors(300, random);
+	REQUIRE(SceneWriter::Write(filename, actors, CellSize));
+
+	SceneFile file;
+	bool read = file.Read(filename);
+	std::remove(filename);
+	REQUIRE(read);
+
+	CHECK(file.Header.Magic == SceneFileHeader::MagicValue);
+	CHECK(file.Header.Version == SceneFileHeader::CurrentVersion);
+	CHECK(file.Header.CellSize == CellSize);
+
+	std::map<std::wstring, size_t> byName;
+	for (size_t i = 0; i < actors.size(); ++i)
+		byName.emplace(actors[i].Name, i);
+
+	std::vector<int> seen(actors.size(), 0);
+	std::map<std::pair<int, int>, int> cellOf;
+
+	for (uint32_t cell = 0; cell < file.Header.CellCount; ++cell)
+	{
+		SceneCellView view;
+		REQUIRE(FixupSceneCell(file.Blobs[cell].data(), file.Blobs[cell].size(), view));
+		CHECK(view.ActorCount == file.Entries[cell].ActorCount);
+
+		for (uint32_t a = 0; a < view.ActorCount; ++a)
+		{
+			const SceneActorRecord& record = view.Actors[a];
+			auto it = byName.find(GetSceneActorName(record));
+			REQUIRE(it != byName.end());
+			const SceneActorDesc& actor = actors[it->second];
+			++seen[it->second];
+
+			CHECK(record.MeshGroup == StringTable::Hash(actor.MeshGroup));
+			CHECK(record.DrawArg == StringTable::Hash(actor.DrawArg));
+			CHECK(record.Material == StringTable::Hash(actor.Material));
+			CHECK(record.RenderLayer == actor.RenderLayer);
+			CHECK(record.Flags == actor.Flags);
+			CHECK(memcmp(&record.World, &actor.World, sizeof(record.World)) == 0);
+			CHECK(memcmp(&record.TexTransform, &actor.TexTransform, sizeof(record.TexTransform)) == 0);
+
+			// One cell per grid square, and its bound covers every actor in it.
+			std::pair<int, int> square((int)std::floor(actor.Bound.Center.x / CellSize), (int)std::floor(actor.Bound.Center.z / CellSize));
+			CHECK(cellOf.emplace(square, (int)cell).first->second == (int)cell);
+			CHECK(Covers(file.Entries[cell].Bound, actor.Bound));
+		}
+	}
+
+	for (int count : seen)
+		CHECK(count == 1);
+	CHECK(cellOf.size() == file.Header.CellCount);
+}
+
+TEST_CASE(SceneFormat, CorruptCellsAreRefused)
+{
+	const char* filename = "SceneFormatTests.scene";
+
+	Tests::Random random(2);
+	std::vector<SceneActorDesc> actors = RandomActors(6, random);
+	for (SceneActorDesc& actor : actors)
+		actor.Bound.Center = DirectX::XMFLOAT3(1.0f, 0.0f, 1.0f);
+	REQUIRE(SceneWriter::Write(filename, actors, CellSize));
+
+	SceneFile file;
+	bool read = file.Read(filename);
+	std::remove(filename);
+	REQUIRE(read && file.Header.CellCount == 1);
+
+	const std::vector<uint8_t>& blob = file.Blobs[0];
+	REQUIRE(Fixup(blob));
+
+	// Every truncation, each copied to a buffer of its own size so reads past it are caught.
+	for (size_t size = 0; size < blob.size(); ++size)
+		CHECK(!Fixup(std::vector<uint8_t>(blob.begin(), blob.begin() + size)));
+
+	std::vector<uint8_t> broken = blob;
+	Patch<uint32_t>(broken, offsetof(SceneCellHeader, Magic), 0);
+	CHECK(!Fixup(broken));
+
+	// Names past the blob, with the records pointing there, must not wrap the size check around.
+	broken = blob;
+	Patch<uint64_t>(broken, offsetof(SceneCellHeader, NamesOffset), blob.size() + 64);
+	for (size_t record = 0; record < actors.size(); ++record)
+		Patch<uint64_t>(broken, sizeof(SceneCellHeader) + record * sizeof(SceneActorRecord) + offsetof(SceneActorRecord, NameOffset), blob.size() + 64);
+	CHECK(!Fixup(broken));
+
+	broken = blob;
+	Patch<uint32_t>(broken, offsetof(SceneCellHeader, ActorCount), 1000);
+	CHECK(!Fixup(broken));
+
+	const size_t lastRecord = sizeof(SceneCellHeader) + 5 * sizeof(SceneActorRecord);
+
+	broken = blob;
+	Patch<uint64_t>(broken, lastRecord + offsetof(SceneActorRecord, NameOffset), blob.size() + 2);
+	CHECK(!Fixup(broken));
+
+	broken = blob;
+	Patch<uint64_t>(broken, lastRecord + offsetof(SceneActorRecord, NameOffset), 0);
+	CHECK(!Fixup(broken));
+
+	broken = blob;
+	Patch<uint32_t>(broken, lastRecord + offsetof(SceneActorRecord, NameLength), 0x7FFFFFFF);
+	CHECK(!Fixup(broken));
+}
@@ -0,0 +1,127 @@
+#include <vector>
+#include "DX12Lib/ShadowCasterCulling.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	struct ShadowSetup
+	{
+		DirectX::BoundingFrustum Camera;
+		DirectX::XMFLOAT3 LightDir;
+		DirectX::XMFLOAT4X4 LightView;
+		DirectX::BoundingBox LightBound;
+
+		ShadowCasterVolume Build() const
+		{
+			return BuildShadowCasterVolume(Camera, DirectX::XMLoadFloat3(&LightDir), DirectX::XMLoadFloat4x4(&LightView), LightBound);
+		}
+	};
+
+	// A camera looking down +Z from above the ground and a slanted light whose ortho volume
+	// covers the start of the camera frustum.
+	ShadowSetup MakeSetup(float lightSize)
+	{
+		ShadowSetup setup;
+
+		DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(0.9f, 1.6f, 1.0f, 120.0f);
+		DirectX::XMMATRIX view = DirectX::XMMatrixLookToLH(DirectX::XMVectorSet(0.0f, 10.0f, -50.0f, 1.0f), DirectX::XMVectorSet(0.0f, -0.2f, 1.0f, 0.0f), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		DirectX::XMVECTOR viewDeterminant = DirectX::XMMatrixDeterminant(view);
+		DirectX::BoundingFrustum(proj).Transform(setup.Camera, DirectX::XMMatrixInverse(&viewDeterminant, view));
+
+		DirectX::XMVECTOR lightDir = DirectX::XMVector3Normalize(DirectX::XMVectorSet(0.3f, -1.0f, 0.4f, 0.0f));
+		DirectX::XMStoreFloat3(&setup.LightDir, lightDir);
+
+		DirectX::XMVECTOR target = DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+		DirectX::XMVECTOR lightPos = DirectX::XMVectorSubtract(target, DirectX::XMVectorScale(lightDir, 200.0f));
+		DirectX::XMStoreFloat4x4(&setup.LightView, DirectX::XMMatrixLookToLH(lightPos, lightDir, DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)));
+		setup.LightBound = DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 200.0f), DirectX::XMFLOAT3(lightSize, lightSize, 200.0f));
+
+		return setup;
+	}
+
+	DirectX::BoundingBox RandomBox(Tests::Random& random)
+	{
+		DirectX::XMFLOAT3 center(random.Float(-150.0f, 150.0f), random.Float(-20.0f, 120.0f), random.Float(-150.0f, 150.0f));
+		DirectX::XMFLOAT3 extents(random.Float(0.5f, 5.0f), random.Float(0.5f, 5.0f), random.Float(0.5f, 5.0f));
+		return DirectX::BoundingBox(center, extents);
+	}
+
+	// Slides the box down the light and reports whether it ever overlaps the camera frustum
+	// inside the light volume, starting in front of the shadow map near plane.
+	bool SweepReachesReceivers(const ShadowSetup& setup, const DirectX::BoundingBox& box)
+	{
+		DirectX::XMMATRIX lightView = DirectX::XMLoadFloat4x4(&setup.LightView);
+
+		DirectX::BoundingBox start;
+		box.Transform(start, lightView);
+		if (start.Center.z + start.Extents.z < setup.LightBound.Center.z - setup.LightBound.Extents.z)
+			return false;
+
+		for (float t = 0.0f; t <= 400.0f; t += 0.5f)
+		{
+			DirectX::BoundingBox moved = box;
+			moved.Center.x += setup.LightDir.x * t;
+			moved.Center.y += setup.LightDir.y * t;
+			moved.Center.z += setup.LightDir.z * t;
+
+			DirectX::BoundingBox lightSpace;
+			moved.Transform(lightSpace, lightView);
+			if (setup.Camera.Contains(moved) != DirectX::DISJOINT && setup.LightBound.Intersects(lightSpace))
+				return true;
+		}
+		return false;
+	}
+}
+
+TEST_CASE(ShadowCasterCulling, KeepsEveryCasterThatReachesTheView)
+{
+	Tests::Random random(1);
+	ShadowSetup setup = MakeSetup(80.0f);
+	ShadowCasterVolume volume = setup.Build();
+	REQUIRE(!volume.Empty);
+
+	size_t casters = 0;
+	size_t reaching = 0;
+	for (int i = 0; i < 2000; ++i)
+	{
+		DirectX::BoundingBox box = RandomBox(random);
+		bool caster = IsShadowCaster(volume, box);
+		bool reaches = SweepReachesReceivers(setup, box);
+		if (reaches)
+			CHECK(caster);
+
+		casters += caster ? 1 : 0;
+		reaching += reaches ? 1 : 0;
+	}
+
+	// The test must actually cull, and the sweep must have found casters to check.
+	CHECK(reaching > 0);
+	CHECK(casters < 2000 / 2);
+}
+
+TEST_CASE(ShadowCasterCulling, RejectsBoxesBelowAndBehind)
+{
+	ShadowSetup setup = MakeSetup(80.0f);
+	ShadowCasterVolume volume = setup.Build();
+	REQUIRE(!volume.Empty);
+
+	// Inside the view it shadows at least itself; above it, up the light, it shadows the view.
+	CHECK(IsShadowCaster(volume, DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 2.0f, 0.0f), DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f))));
+	CHECK(IsShadowCaster(volume, DirectX::BoundingBox(DirectX::XMFLOAT3(-12.0f, 40.0f, -16.0f), DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f))));
+
+	// Far behind the camera, and down the light beyond the far plane.
+	CHECK(!IsShadowCaster(volume, DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 2.0f, -120.0f), DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f))));
+	CHECK(!IsShadowCaster(volume, DirectX::BoundingBox(DirectX::XMFLOAT3(60.0f, -150.0f, 120.0f), DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f))));
+}
+
+TEST_CASE(ShadowCasterCulling, DisjointLightVolumeCastsNothing)
+{
+	ShadowSetup setup = MakeSetup(80.0f);
+	setup.LightBound.Center.x = 1000.0f;
+
+	ShadowCasterVolume volume = setup.Build();
+	CHECK(volume.Empty);
+	CHECK(!IsShadowCaster(volume, DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 2.0f, 0.0f), DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f))));
+}
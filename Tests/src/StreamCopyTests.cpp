@@ -0,0 +1,61 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "DX12Lib/StreamCopy.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	// Bytes around the copy that must come out untouched.
+	const size_t Guard = 64;
+
+	// Copies byteSize bytes between the given offsets with both StreamCopy and memcpy, over
+	// destinations filled with the same pattern, and compares the whole buffers.
+	bool MatchesMemcpy(const std::vector<uint8_t>& source, size_t sourceOffset, size_t destinationOffset, size_t byteSize)
+	{
+		std::vector<uint8_t> streamed(Guard + destinationOffset + byteSize + Guard);
+		for (size_t i = 0; i < streamed.size(); ++i)
+			streamed[i] = (uint8_t)(0xA5 ^ i);
+		std::vector<uint8_t> expected = streamed;
+
+		StreamCopy(streamed.data() + Guard + destinationOffset, source.data() + sourceOffset, byteSize);
+		memcpy(expected.data() + Guard + destinationOffset, source.data() + sourceOffset, byteSize);
+		return streamed == expected;
+	}
+}
+
+TEST_CASE(StreamCopy, MatchesMemcpyAtEveryAlignment)
+{
+	Tests::Random random(1);
+	std::vector<uint8_t> source(4096 + 64);
+	for (uint8_t& byte : source)
+		byte = (uint8_t)random.Uint(0, 255);
+
+	// Every head and tail length around the 16 byte stores and 64 byte blocks.
+	for (size_t sourceOffset = 0; sourceOffset < 16; ++sourceOffset)
+	{
+		for (size_t destinationOffset = 0; destinationOffset < 16; ++destinationOffset)
+		{
+			for (size_t byteSize = 0; byteSize <= 160; ++byteSize)
+				CHECK(MatchesMemcpy(source, sourceOffset, destinationOffset, byteSize));
+		}
+	}
+}
+
+TEST_CASE(StreamCopy, MatchesMemcpyOverRandomSizes)
+{
+	Tests::Random random(2);
+	std::vector<uint8_t> source(1 << 20);
+	for (uint8_t& byte : source)
+		byte = (uint8_t)random.Uint(0, 255);
+
+	for (uint32_t i = 0; i < 300; ++i)
+	{
+		size_t sourceOffset = random.Uint(0, 63);
+		size_t destinationOffset = random.Uint(0, 63);
+		size_t byteSize = random.Uint(0, (uint32_t)(source.size() - sourceOffset));
+		CHECK(MatchesMemcpy(source, sourceOffset, destinationOffset, byteSize));
+	}
+}
@@ -0,0 +1,40 @@
+#include <string>
+#include "DX12Lib/StringTable.h"
+#include "Test.h"
+
+using namespace DX12Lib;
+
+TEST_CASE(StringTable, IdsAreDenseInFirstSeenOrder)
+{
+	StringTable table;
+	CHECK(table.Intern(L"stone") == 0);
+	CHECK(table.Intern(L"grass") == 1);
+	CHECK(table.Intern(L"stone") == 0);
+	CHECK(table.Intern(L"") == 2);
+	CHECK(table.Intern(L"Stone") == 3);
+	CHECK(table.Size() == 4);
+
+	CHECK(table.Find(L"grass") == 1);
+	CHECK(table.Find(L"water") == StringTable::InvalidId);
+	CHECK(table.GetString(0) == L"stone");
+	CHECK(table.GetString(2).empty());
+
+	for (uint32_t i = 0; i < 1000; ++i)
+		CHECK(table.Intern(L"name" + std::to_wstring(i)) == 4 + i);
+	for (uint32_t i = 0; i < 1000; ++i)
+		CHECK(table.GetString(table.Find(L"name" + std::to_wstring(i))) == L"name" + std::to_wstring(i));
+
+	table.Clear();
+	CHECK(table.Size() == 0);
+	CHECK(table.Find(L"stone") == StringTable::InvalidId);
+	CHECK(table.Intern(L"grass") == 0);
+}
+
+TEST_CASE(StringTable, HashIsFnv1aOverUtf16)
+{
+	// Reference values of 64 bit FNV-1a over the UTF-16LE bytes. Baked files depend on them.
+	CHECK(StringTable::Hash(L"") == 0xcbf29ce484222325ull);
+	CHECK(StringTable::Hash(L"a") == 0x089be207b544f1e4ull);
+	CHECK(StringTable::Hash(L"crate") == 0xede57e319edb2ce4ull);
+	CHECK(StringTable::Hash(L"M\u00FCnchen\u4E2D") == 0x17dde2bc3fc4ef21ull);
+}
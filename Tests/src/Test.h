@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <random>
+
+// A minimal test harness: TEST_CASE registers a function under a suite, CHECK records a failure
+// and carries on, REQUIRE records it and leaves the test. Main runs the suites named on the
+// command line, or all of them.
+namespace Tests
+{
+	using TestFunction = void (*)();
+
+	struct Registrar
+	{
+		Registrar(const char* suite, const char* name, TestFunction function);
+	};
+
+	void ReportFailure(const char* file, int line, const char* expression);
+
+	// Calls to operator new so far, from any thread. Compare it around code that must not
+	// allocate.
+	uint64_t GetAllocationCount();
+
+	// Deterministic values for randomized tests, so a failure reproduces.
+	class Random
+	{
+	public:
+		explicit Random(uint32_t seed = 1) : mEngine(seed) {}
+
+		inline float Float(float low, float high) { return std::uniform_real_distribution<float>(low, high)(mEngine); }
+		inline uint32_t Uint(uint32_t low, uint32_t high) { return std::uniform_int_distribution<uint32_t>(low, high)(mEngine); }
+
+	private:
+		std::mt19937 mEngine;
+	};
+}
+
+#define TEST_CASE(suite, name) \
+	static void suite##_##name(); \
+	static const Tests::Registrar suite##_##name##_Registrar(#suite, #name, &suite##_##name); \
+	static void suite##_##name()
+
+#define CHECK(expression) \
+	do { if (!(expression)) Tests::ReportFailure(__FILE__, __LINE__, #expression); } while (0)
+
+#define REQUIRE(expression) \
+	do { if (!(expression)) { Tests::ReportFailure(__FILE__, __LINE__, #expression); return; } } while (0)
@@ -0,0 +1,153 @@
+#include <cmath>
+#include <vector>
+#include "DX12Lib/TransformHierarchy.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	struct Local
+	{
+		DirectX::XMFLOAT3 Scale;
+		DirectX::XMFLOAT4 Rotation;
+		DirectX::XMFLOAT3 Translation;
+	};
+
+	Local RandomLocal(Tests::Random& random)
+	{
+		Local local;
+		local.Scale = DirectX::XMFLOAT3(random.Float(0.5f, 1.5f), random.Float(0.5f, 1.5f), random.Float(0.5f, 1.5f));
+		DirectX::XMVECTOR rotation = DirectX::XMVectorSet(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(0.1f, 1.0f));
+		DirectX::XMStoreFloat4(&local.Rotation, DirectX::XMVector4Normalize(rotation));
+		local.Translation = DirectX::XMFLOAT3(random.Float(-3.0f, 3.0f), random.Float(-3.0f, 3.0f), random.Float(-3.0f, 3.0f));
+		return local;
+	}
+
+	// A forest of nodes with their locals, and the world matrices one multiply at a time.
+	struct Forest
+	{
+		TransformHierarchy Hierarchy;
+		std::vector<Local> Locals;
+
+		Forest(uint32_t nodeCount, Tests::Random& random)
+		{
+			for (uint32_t i = 0; i < nodeCount; ++i)
+			{
+				// A few roots, the rest hang below an earlier node.
+				uint32_t parent = i == 0 || random.Uint(0, 9) == 0 ? TransformHierarchy::NullNode : random.Uint(0, i - 1);
+				Hierarchy.CreateNode(parent);
+				Locals.push_back(RandomLocal(random));
+				Set(i, Locals.back());
+			}
+		}
+
+		void Set(uint32_t node, const Local& local)
+		{
+			Locals[node] = local;
+			Hierarchy.SetLocal(node, local.Scale, local.Rotation, local.Translation);
+		}
+
+		DirectX::XMMATRIX ExpectedWorld(uint32_t node) const
+		{
+			const Local& local = Locals[node];
+			DirectX::XMMATRIX world = DirectX::XMMatrixMultiply(
+				DirectX::XMMatrixMultiply(DirectX::XMMatrixScaling(local.Scale.x, local.Scale.y, local.Scale.z), DirectX::XMMatrixRotationQuaternion(DirectX::XMLoadFloat4(&local.Rotation))),
+				DirectX::XMMatrixTranslation(local.Translation.x, local.Translation.y, local.Translation.z));
+
+			uint32_t parent = Hierarchy.GetParent(node);
+			return parent == TransformHierarchy::NullNode ? world : DirectX::XMMatrixMultiply(world, ExpectedWorld(parent));
+		}
+
+		void CheckWorlds() const
+		{
+			for (uint32_t node = 0; node < Hierarchy.Size(); ++node)
+			{
+				DirectX::XMFLOAT4X4 expected;
+				DirectX::XMStoreFloat4x4(&expected, ExpectedWorld(node));
+				const DirectX::XMFLOAT4X4& world = Hierarchy.GetWorld(node);
+
+				float error = 0.0f;
+				for (int r = 0; r < 4; ++r)
+				{
+					for (int c = 0; c < 4; ++c)
+						error = std::fmax(error, std::fabs(world.m[r][c] - expected.m[r][c]) / (1.0f + std::fabs(expected.m[r][c])));
+				}
+				CHECK(error < 1e-4f);
+			}
+		}
+
+		bool IsBelow(uint32_t node, const std::vector<bool>& marked) const
+		{
+			for (; node != TransformHierarchy::NullNode; node = Hierarchy.GetParent(node))
+			{
+				if (marked[node])
+					return true;
+			}
+			return false;
+		}
+	};
+}
+
+TEST_CASE(TransformHierarchy, WorldsMatchParentProducts)
+{
+	Tests::Random random(1);
+
+	// Not a multiple of the four lanes of the local pass.
+	Forest forest(1003, random);
+	forest.Hierarchy.Update();
+
+	CHECK(forest.Hierarchy.GetChangedNodes().size() == 1003);
+	forest.CheckWorlds();
+}
+
+TEST_CASE(TransformHierarchy, OnlyDirtySubtreesRecompute)
+{
+	Tests::Random random(2);
+	Forest forest(600, random);
+	forest.Hierarchy.Update();
+
+	forest.Hierarchy.Update();
+	CHECK(forest.Hierarchy.GetChangedNodes().empty());
+
+	for (int round = 0; round < 10; ++round)
+	{
+		std::vector<bool> touched(forest.Hierarchy.Size(), false);
+		uint32_t touchCount = random.Uint(1, 7);
+		for (uint32_t k = 0; k < touchCount; ++k)
+		{
+			uint32_t node = random.Uint(0, (uint32_t)forest.Hierarchy.Size() - 1);
+			Local local = forest.Locals[node];
+
+			// Each setter on its own marks the node.
+			switch (k % 3)
+			{
+			case 0: local.Translation.y += 1.0f; forest.Hierarchy.SetTranslation(node, local.Translation); break;
+			case 1: local.Scale.x *= 1.1f; forest.Hierarchy.SetScale(node, local.Scale); break;
+			default: local.Rotation = RandomLocal(random).Rotation; forest.Hierarchy.SetRotation(node, local.Rotation); break;
+			}
+			forest.Locals[node] = local;
+			touched[node] = true;
+		}
+
+		forest.Hierarchy.Update();
+
+		// Exactly the touched nodes and everything below them, parents first.
+		const std::vector<uint32_t>& changed = forest.Hierarchy.GetChangedNodes();
+		std::vector<bool> reported(forest.Hierarchy.Size(), false);
+		for (size_t i = 0; i < changed.size(); ++i)
+		{
+			CHECK(!reported[changed[i]]);
+			reported[changed[i]] = true;
+
+			uint32_t parent = forest.Hierarchy.GetParent(changed[i]);
+			if (parent != TransformHierarchy::NullNode && forest.IsBelow(parent, touched))
+				CHECK(reported[parent]);
+		}
+
+		for (uint32_t node = 0; node < forest.Hierarchy.Size(); ++node)
+			CHECK(reported[node] == forest.IsBelow(node, touched));
+
+		forest.CheckWorlds();
+	}
+}
@@ -0,0 +1,168 @@
+#include <cmath>
+#include <vector>
+#include "DX12Lib/TriangleBVH.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	// Small triangles scattered through a 10 unit cube, indexed, behind a few vertices that
+	// only the base vertex skips.
+	struct Mesh
+	{
+		static const int32_t BaseVertex = 7;
+
+		std::vector<DirectX::XMFLOAT3> Positions;
+		std::vector<uint32_t> Indices;
+		TriangleBVH Tree;
+
+		Mesh(uint32_t triangleCount, Tests::Random& random)
+		{
+			Positions.resize(BaseVertex, DirectX::XMFLOAT3(1e6f, 1e6f, 1e6f));
+			for (uint32_t i = 0; i < triangleCount; ++i)
+			{
+				DirectX::XMFLOAT3 center(random.Float(-5.0f, 5.0f), random.Float(-5.0f, 5.0f), random.Float(-5.0f, 5.0f));
+				for (int corner = 0; corner < 3; ++corner)
+					Positions.push_back(DirectX::XMFLOAT3(center.x + random.Float(-1.0f, 1.0f), center.y + random.Float(-1.0f, 1.0f), center.z + random.Float(-1.0f, 1.0f)));
+
+				// Corners out of order, so the index list is not the identity.
+				uint32_t first = 3 * i;
+				Indices.insert(Indices.end(), { first + 2, first, first + 1 });
+			}
+
+			Tree.Build(Positions.data(), sizeof(DirectX::XMFLOAT3), Indices.data(), (uint32_t)Indices.size(), BaseVertex);
+		}
+
+		// Moller-Trumbore over every triangle, both faces.
+		bool BruteForce(const DirectX::XMFLOAT3& o, const DirectX::XMFLOAT3& d, float maxDistance, float& closest, uint32_t& triangle) const
+		{
+			closest = maxDistance;
+			triangle = TriangleBVH::InvalidTriangle;
+
+			for (uint32_t i = 0; i < Indices.size() / 3; ++i)
+			{
+				DirectX::XMVECTOR v0 = DirectX::XMLoadFloat3(&Positions[BaseVertex + Indices[3 * i]]);
+				DirectX::XMVECTOR e1 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&Positions[BaseVertex + Indices[3 * i + 1]]), v0);
+				DirectX::XMVECTOR e2 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&Positions[BaseVertex + Indices[3 * i + 2]]), v0);
+				DirectX::XMVECTOR direction = DirectX::XMLoadFloat3(&d);
+
+				DirectX::XMVECTOR p = DirectX::XMVector3Cross(direction, e2);
+				float det = DirectX::XMVectorGetX(DirectX::XMVector3Dot(e1, p));
+				if (std::fabs(det) < 1e-8f)
+					continue;
+
+				DirectX::XMVECTOR s = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&o), v0);
+				float u = DirectX::XMVectorGetX(DirectX::XMVector3Dot(s, p)) / det;
+				DirectX::XMVECTOR q = DirectX::XMVector3Cross(s, e1);
+				float v = DirectX::XMVectorGetX(DirectX::XMVector3Dot(direction, q)) / det;
+				float t = DirectX::XMVectorGetX(DirectX::XMVector3Dot(e2, q)) / det;
+
+				if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < closest)
+				{
+					closest = t;
+					triangle = i;
+				}
+			}
+
+			return triangle != TriangleBVH::InvalidTriangle;
+		}
+	};
+
+	// From outside the mesh toward a point inside, with an unnormalized direction.
+	void RandomRay(Tests::Random& random, DirectX::XMFLOAT3& origin, DirectX::XMFLOAT3& direction)
+	{
+		origin = DirectX::XMFLOAT3(random.Float(-15.0f, 15.0f), random.Float(-15.0f, 15.0f), random.Float(-15.0f, 15.0f));
+		DirectX::XMFLOAT3 target(random.Float(-5.0f, 5.0f), random.Float(-5.0f, 5.0f), random.Float(-5.0f, 5.0f));
+		float scale = random.Float(0.5f, 2.0f);
+		direction = DirectX::XMFLOAT3((target.x - origin.x) * scale, (target.y - origin.y) * scale, (target.z - origin.z) * scale);
+	}
+}
+
+TEST_CASE(TriangleBVH, IntersectMatchesBruteForce)
+{
+	Tests::Random random(1);
+	Mesh mesh(500, random);
+	REQUIRE(mesh.Tree.GetTriangleCount() == 500);
+
+	int hitCount = 0;
+	for (int ray = 0; ray < 1000; ++ray)
+	{
+		DirectX::XMFLOAT3 origin, direction;
+		RandomRay(random, origin, direction);
+		float maxDistance = ray % 2 ? FLT_MAX : random.Float(0.2f, 1.0f);
+
+		float expected, t;
+		uint32_t expectedTriangle, triangle;
+		bool expectedHit = mesh.BruteForce(origin, direction, maxDistance, expected, expectedTriangle);
+		bool hit = mesh.Tree.Intersect(DirectX::XMLoadFloat3(&origin), DirectX::XMLoadFloat3(&direction), t, triangle, maxDistance);
+
+		CHECK(hit == expectedHit);
+		if (hit && expectedHit)
+		{
+			CHECK(std::fabs(t - expected) <= 1e-4f * expected);
+			CHECK(triangle == expectedTriangle);
+			++hitCount;
+		}
+	}
+
+	// Enough of the rays hit for the comparison to mean something.
+	CHECK(hitCount > 200);
+}
+
+TEST_CASE(TriangleBVH, PacketMatchesSingleRays)
+{
+	Tests::Random random(2);
+	Mesh mesh(500, random);
+
+	for (int round = 0; round < 300; ++round)
+	{
+		RayPacket packet;
+		packet.Active = random.Uint(1, 15);
+
+		for (int lane = 0; lane < RayPacket::Size; ++lane)
+		{
+			DirectX::XMFLOAT3 origin, direction;
+			RandomRay(random, origin, direction);
+			packet.OriginX[lane] = origin.x;
+			packet.OriginY[lane] = origin.y;
+			packet.OriginZ[lane] = origin.z;
+			packet.DirectionX[lane] = direction.x;
+			packet.DirectionY[lane] = direction.y;
+			packet.DirectionZ[lane] = direction.z;
+			packet.MaxDistance[lane] = lane == 3 ? 0.5f : FLT_MAX;
+			packet.TriangleIndex[lane] = TriangleBVH::InvalidTriangle;
+		}
+
+		RayPacket traced = packet;
+		mesh.Tree.IntersectPacket(traced);
+
+		for (int lane = 0; lane < RayPacket::Size; ++lane)
+		{
+			// Lanes left out keep what they had.
+			if ((packet.Active & (1u << lane)) == 0)
+			{
+				CHECK(traced.MaxDistance[lane] == packet.MaxDistance[lane]);
+				CHECK(traced.TriangleIndex[lane] == TriangleBVH::InvalidTriangle);
+				continue;
+			}
+
+			float t;
+			uint32_t triangle;
+			DirectX::XMVECTOR origin = DirectX::XMVectorSet(packet.OriginX[lane], packet.OriginY[lane], packet.OriginZ[lane], 1.0f);
+			DirectX::XMVECTOR direction = DirectX::XMVectorSet(packet.DirectionX[lane], packet.DirectionY[lane], packet.DirectionZ[lane], 0.0f);
+			bool hit = mesh.Tree.Intersect(origin, direction, t, triangle, packet.MaxDistance[lane]);
+
+			CHECK(hit == (traced.TriangleIndex[lane] != TriangleBVH::InvalidTriangle));
+			if (hit)
+			{
+				CHECK(traced.TriangleIndex[lane] == triangle);
+				CHECK(std::fabs(traced.MaxDistance[lane] - t) <= 1e-4f * t);
+			}
+			else
+			{
+				CHECK(traced.MaxDistance[lane] == packet.MaxDistance[lane]);
+			}
+		}
+	}
+}
@@ -0,0 +1,144 @@
+#include <vector>
+#include "DX12Lib/VisibilityCache.h"
+#include "Test.h"
+
+namespace
+{
+	using namespace DX12Lib;
+
+	const int ViewCount = 2;
+
+	struct Views
+	{
+		FrustumPlanes Planes[ViewCount];
+		DirectX::XMFLOAT3 Eye;
+	};
+
+	// A camera turning slowly on the spot as it walks along X, and a fixed shadow view.
+	Views MakeViews(float time)
+	{
+		Views views;
+		views.Eye = DirectX::XMFLOAT3(time * 0.3f, 5.0f, 0.0f);
+
+		DirectX::XMVECTOR forward = DirectX::XMVectorSet(sinf(time * 0.02f), -0.1f, cosf(time * 0.02f), 0.0f);
+		DirectX::XMMATRIX view = DirectX::XMMatrixLookToLH(DirectX::XMLoadFloat3(&views.Eye), forward, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(0.8f, 1.6f, 1.0f, 150.0f);
+		views.Planes[0] = FrustumPlanes::FromViewProj(DirectX::XMMatrixMultiply(view, proj));
+		views.Planes[1] = FrustumPlanes::FromBox(DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 60.0f), DirectX::XMFLOAT3(50.0f, 30.0f, 50.0f)));
+		return views;
+	}
+
+	uint32_t ExactMask(const Views& views, const DirectX::BoundingBox& box)
+	{
+		uint32_t mask = 0;
+		for (int v = 0; v < ViewCount; ++v)
+		{
+			if (ClassifyBox(views.Planes[v], box.Center, box.Extents) != DirectX::DISJOINT)
+				mask |= 1u << v;
+		}
+		return mask;
+	}
+
+	std::vector<DirectX::BoundingBox> RandomBoxes(size_t count, Tests::Random& random)
+	{
+		std::vector<DirectX::BoundingBox> boxes;
+		for (size_t i = 0; i < count; ++i)
+		{
+			DirectX::XMFLOAT3 center(random.Float(-150.0f, 150.0f), random.Float(-10.0f, 20.0f), random.Float(-50.0f, 200.0f));
+			DirectX::XMFLOAT3 extents(random.Float(0.2f, 3.0f), random.Float(0.2f, 3.0f), random.Float(0.2f, 3.0f));
+			boxes.push_back(DirectX::BoundingBox(center, extents));
+		}
+		return boxes;
+	}
+}
+
+TEST_CASE(VisibilityCache, CachedMasksStayExactAsTheCameraMoves)
+{
+	Tests::Random random(1);
+	std::vector<DirectX::BoundingBox> boxes = RandomBoxes(3000, random);
+	VisibilityCache cache(8);
+
+	for (int frame = 0; frame < 120; ++frame)
+	{
+		Views views = MakeViews((float)frame);
+		cache.BeginFrame(views.Planes, ViewCount, views.Eye);
+
+		for (int i = 0; i < (int)boxes.size(); ++i)
+		{
+			// Some boxes move now and then, and must be invalidated when they do.
+			if (i % 50 == frame % 50)
+			{
+				boxes[i].Center.x += random.Float(-2.0f, 2.0f);
+				cache.Invalidate(i);
+			}
+
+			uint32_t exact = ExactMask(views, boxes[i]);
+			uint32_t cached;
+			if (cache.Lookup(i, cached))
+				CHECK(cached == exact);
+			else
+				cache.Store(i, boxes[i], exact);
+		}
+	}
+
+	// The camera moves little per frame, so most results are reused.
+	CHECK(cache.GetSkippedFraction() > 0.5f);
+	CHECK(cache.GetSkippedCount() <= cache.GetLookupCount());
+}
+
+TEST_CASE(VisibilityCache, ResultsAreRetestedEveryPeriod)
+{
+	VisibilityCache cache(4);
+	Views views = MakeViews(0.0f);
+	DirectX::BoundingBox box(DirectX::XMFLOAT3(0.0f, 5.0f, 40.0f), DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+	cache.BeginFrame(views.Planes, ViewCount, views.Eye);
+	uint32_t mask;
+	CHECK(!cache.Lookup(0, mask));
+	cache.Store(0, box, ExactMask(views, box));
+
+	// The views stand still: reused until the period runs out, then retested.
+	for (uint32_t frame = 1; frame < cache.GetRevalidationPeriod(); ++frame)
+	{
+		cache.BeginFrame(views.Planes, ViewCount, views.Eye);
+		CHECK(cache.Lookup(0, mask));
+		CHECK(mask == ExactMask(views, box));
+	}
+
+	cache.BeginFrame(views.Planes, ViewCount, views.Eye);
+	CHECK(!cache.Lookup(0, mask));
+}
+
+TEST_CASE(VisibilityCache, InvalidationAndViewChangesForceRetests)
+{
+	VisibilityCache cache(8);
+	Views views = MakeViews(0.0f);
+	DirectX::BoundingBox box(DirectX::XMFLOAT3(0.0f, 5.0f, 40.0f), DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f));
+	uint32_t mask;
+
+	cache.BeginFrame(views.Planes, ViewCount, views.Eye);
+	cache.Store(0, box, ExactMask(views, box));
+	cache.Store(1, box, ExactMask(views, box));
+
+	cache.BeginFrame(views.Planes, ViewCount, views.Eye);
+	cache.Invalidate(1);
+	CHECK(cache.Lookup(0, mask));
+	CHECK(!cache.Lookup(1, mask));
+	CHECK(!cache.Lookup(2, mask));
+	CHECK(!cache.Lookup(-1, mask));
+
+	// A different number of views makes every older result unusable.
+	cache.BeginFrame(views.Planes, 1, views.Eye);
+	CHECK(!cache.Lookup(0, mask));
+
+	// So does a camera that turned around.
+	cache.BeginFrame(views.Planes, ViewCount, views.Eye);
+	cache.Store(0, box, ExactMask(views, box));
+	Views turned = MakeViews(150.0f);
+	cache.BeginFrame(turned.Planes, ViewCount, turned.Eye);
+	CHECK(!cache.Lookup(0, mask));
+
+	cache.Clear();
+	cache.BeginFrame(views.Planes, ViewCount, views.Eye);
+	CHECK(!cache.Lookup(0, mask));
+}